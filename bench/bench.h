@@ -0,0 +1,18 @@
+﻿//
+// Engine-free navigation benchmark for E-Bot
+// Only built by the EBOT_BENCH CMake option, never part of the plugin
+//
+
+#pragma once
+
+// fills g_engfuncs and g_pGlobals with stand alone versions, must run before anything touches the engine
+extern void BenchInitEngine(const char* modName, const char* mapName);
+
+// overrides a cvar after the plugin registered its own, false if there is no such cvar
+extern bool BenchSetCvar(const char* name, const char* value);
+
+// traces and point contents are answered from a height field made of the loaded waypoints
+extern void BenchBuildHeightField(void);
+
+extern void BenchSetTime(const float time);
+extern uint32_t BenchGetTraceCount(void);
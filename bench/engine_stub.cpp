@@ -0,0 +1,347 @@
+﻿//
+// Engine-free navigation benchmark for E-Bot
+// The engine side we need to load waypoints and search paths, nothing else is expected to be called
+//
+
+#include <core.h>
+#include "bench.h"
+
+static globalvars_t s_globals{};
+static char s_strings[256]{}; // string base, the map name lives at offset 1
+static char s_modName[64]{};
+static uint32_t s_traceCount{};
+
+// registered cvars, the plugin keeps the cvar_t itself and reads value and string from it
+struct BenchCvar
+{
+	cvar_t* var;
+	char string[256];
+};
+
+static BenchCvar s_cvars[512]{};
+static int s_numCvars{};
+
+static BenchCvar* FindCvar(const char* name)
+{
+	int i;
+	for (i = 0; i < s_numCvars; i++)
+	{
+		if (!cstrcmp(s_cvars[i].var->name, name))
+			return &s_cvars[i];
+	}
+
+	return nullptr;
+}
+
+static void SetCvarString(BenchCvar* cvar, const char* value)
+{
+	cstrncpy(cvar->string, value, sizeof(cvar->string) - 1);
+	cvar->var->string = cvar->string;
+	cvar->var->value = static_cast<float>(atof(cvar->string));
+}
+
+// floor height of 32 unit cells around the waypoints, cells without a waypoint are solid
+constexpr int Const_BenchCell = 32;
+constexpr int Const_BenchCells = 8192 / Const_BenchCell; // a full 8192 unit map on each axis
+static float* s_floor{};
+
+static inline bool GetFloor(const float x, const float y, float& floor)
+{
+	const int cx = static_cast<int>((x + 4096.0f) / Const_BenchCell);
+	const int cy = static_cast<int>((y + 4096.0f) / Const_BenchCell);
+	if (!s_floor || cx < 0 || cy < 0 || cx >= Const_BenchCells || cy >= Const_BenchCells)
+		return false;
+
+	floor = s_floor[cy * Const_BenchCells + cx];
+	return floor != FLT_MAX;
+}
+
+void BenchBuildHeightField(void)
+{
+	if (!s_floor)
+		s_floor = new float[Const_BenchCells * Const_BenchCells];
+
+	int i, x, y, cx, cy;
+	for (i = 0; i < Const_BenchCells * Const_BenchCells; i++)
+		s_floor[i] = FLT_MAX;
+
+	// a waypoint stands 36 units above the ground, 18 when crouched, and makes its radius walkable
+	for (i = 0; i < g_numWaypoints; i++)
+	{
+		const Path* path = g_waypoint->GetPath(i);
+		const float floor = path->origin.z - ((path->flags & WAYPOINT_CROUCH) ? 18.0f : 36.0f);
+		const int reach = cmax(static_cast<int>(path->radius), Const_BenchCell) / Const_BenchCell;
+
+		cx = static_cast<int>((path->origin.x + 4096.0f) / Const_BenchCell);
+		cy = static_cast<int>((path->origin.y + 4096.0f) / Const_BenchCell);
+		for (y = cy - reach; y <= cy + reach; y++)
+		{
+			for (x = cx - reach; x <= cx + reach; x++)
+			{
+				if (x < 0 || y < 0 || x >= Const_BenchCells || y >= Const_BenchCells)
+					continue;
+
+				float& cell = s_floor[y * Const_BenchCells + x];
+				if (floor < cell)
+					cell = floor;
+			}
+		}
+	}
+}
+
+// walks the segment in 8 unit steps, blocked once the bottom of the hull goes under the floor by more than a step
+static void TraceHeightField(const float* v1, const float* v2, const float bottom, TraceResult* ptr)
+{
+	s_traceCount++;
+	cmemset(ptr, 0, sizeof(TraceResult));
+
+	const Vector start(v1[0], v1[1], v1[2]);
+	const Vector end(v2[0], v2[1], v2[2]);
+	const Vector delta = end - start;
+	const int steps = cmax(static_cast<int>(delta.GetLength() / 8.0f), 1);
+
+	int i;
+	float floor, fraction, last = 0.0f;
+	for (i = 0; i <= steps; i++)
+	{
+		fraction = static_cast<float>(i) / static_cast<float>(steps);
+		const Vector point = start + delta * fraction;
+		if (!GetFloor(point.x, point.y, floor) || point.z + bottom < floor - 18.0f)
+		{
+			if (!i)
+			{
+				ptr->fStartSolid = 1;
+				ptr->fAllSolid = 1;
+			}
+
+			ptr->flFraction = last;
+			ptr->vecEndPos = start + delta * last;
+			ptr->vecPlaneNormal = Vector(0.0f, 0.0f, 1.0f);
+			return;
+		}
+
+		last = fraction;
+	}
+
+	ptr->flFraction = 1.0f;
+	ptr->vecEndPos = end;
+	ptr->fInOpen = 1;
+}
+
+static void Stub_TraceLine(const float* v1, const float* v2, int, edict_t*, TraceResult* ptr)
+{
+	TraceHeightField(v1, v2, 0.0f, ptr);
+}
+
+static void Stub_TraceHull(const float* v1, const float* v2, int, int hullNumber, edict_t*, TraceResult* ptr)
+{
+	static const float bottoms[4] = { 0.0f, -36.0f, -36.0f, -18.0f };
+	TraceHeightField(v1, v2, bottoms[hullNumber & 3], ptr);
+}
+
+static int Stub_PointContents(const float* origin)
+{
+	float floor;
+	if (!GetFloor(origin[0], origin[1], floor) || origin[2] < floor)
+		return CONTENTS_SOLID;
+
+	return CONTENTS_EMPTY;
+}
+
+static void Stub_MakeVectors(const float* angles)
+{
+	const Vector v(angles[0], angles[1], angles[2]);
+	v.BuildVectors(&s_globals.v_forward, &s_globals.v_right, &s_globals.v_up);
+}
+
+static void Stub_AngleVectors(const float* angles, float* forward, float* right, float* up)
+{
+	Vector f, r, u;
+	const Vector v(angles[0], angles[1], angles[2]);
+	v.BuildVectors(&f, &r, &u);
+	if (forward)
+		cmemcpy(forward, &f.x, sizeof(float) * 3);
+
+	if (right)
+		cmemcpy(right, &r.x, sizeof(float) * 3);
+
+	if (up)
+		cmemcpy(up, &u.x, sizeof(float) * 3);
+}
+
+static void Stub_CVarRegister(cvar_t* cvar)
+{
+	if (!cvar || FindCvar(cvar->name) || s_numCvars >= static_cast<int>(sizeof(s_cvars) / sizeof(s_cvars[0])))
+		return;
+
+	BenchCvar& slot = s_cvars[s_numCvars++];
+	slot.var = cvar;
+	SetCvarString(&slot, cvar->string ? cvar->string : "");
+}
+
+static cvar_t* Stub_CVarGetPointer(const char* name)
+{
+	BenchCvar* cvar = FindCvar(name);
+	return cvar ? cvar->var : nullptr;
+}
+
+static float Stub_CVarGetFloat(const char* name)
+{
+	BenchCvar* cvar = FindCvar(name);
+	return cvar ? cvar->var->value : 0.0f;
+}
+
+static const char* Stub_CVarGetString(const char* name)
+{
+	BenchCvar* cvar = FindCvar(name);
+	return cvar ? cvar->string : "";
+}
+
+static void Stub_CVarSetString(const char* name, const char* value)
+{
+	BenchCvar* cvar = FindCvar(name);
+	if (cvar)
+		SetCvarString(cvar, value);
+}
+
+static void Stub_CVarSetFloat(const char* name, float value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%f", value);
+	Stub_CVarSetString(name, buffer);
+}
+
+// messages go to stderr, stdout only carries the results
+static void Stub_ServerPrint(const char* message)
+{
+	fputs(message, stderr);
+}
+
+static void Stub_AlertMessage(ALERT_TYPE, const char* format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+}
+
+static void Stub_GetGameDir(char* dir)
+{
+	cstrcpy(dir, s_modName);
+}
+
+static float Stub_Time(void)
+{
+	return s_globals.time;
+}
+
+static int32 Stub_RandomLong(int32 low, int32 high)
+{
+	return crandomint(low, high);
+}
+
+static float Stub_RandomFloat(float low, float high)
+{
+	return crandomfloat(low, high);
+}
+
+static edict_t* Stub_FindEntity(edict_t*, const char*, const char*)
+{
+	return nullptr;
+}
+
+static edict_t* Stub_FindEntityInSphere(edict_t*, const float*, float)
+{
+	return nullptr;
+}
+
+static edict_t* Stub_EntityOfIndex(int)
+{
+	return nullptr;
+}
+
+static int Stub_EntityOffset(const edict_t*)
+{
+	return 0;
+}
+
+static int Stub_Dedicated(void)
+{
+	return 1;
+}
+
+static int Stub_Precache(const char*)
+{
+	return 0;
+}
+
+static void Stub_ServerCommand(char*)
+{
+}
+
+static void Stub_ServerExecute(void)
+{
+}
+
+void BenchInitEngine(const char* modName, const char* mapName)
+{
+	cstrncpy(s_modName, modName, sizeof(s_modName) - 1);
+	cstrncpy(&s_strings[1], mapName, sizeof(s_strings) - 2);
+
+	s_globals.mapname = 1;
+	s_globals.pStringBase = s_strings;
+	s_globals.maxClients = 32;
+	s_globals.maxEntities = 1024;
+	s_globals.time = 1.0f;
+	s_globals.frametime = 0.01f;
+	g_pGlobals = &s_globals;
+
+	g_engfuncs.pfnTraceLine = Stub_TraceLine;
+	g_engfuncs.pfnTraceHull = Stub_TraceHull;
+	g_engfuncs.pfnPointContents = Stub_PointContents;
+	g_engfuncs.pfnMakeVectors = Stub_MakeVectors;
+	g_engfuncs.pfnAngleVectors = Stub_AngleVectors;
+	g_engfuncs.pfnCVarRegister = Stub_CVarRegister;
+	g_engfuncs.pfnCVarGetPointer = Stub_CVarGetPointer;
+	g_engfuncs.pfnCVarGetFloat = Stub_CVarGetFloat;
+	g_engfuncs.pfnCVarGetString = Stub_CVarGetString;
+	g_engfuncs.pfnCVarSetFloat = Stub_CVarSetFloat;
+	g_engfuncs.pfnCVarSetString = Stub_CVarSetString;
+	g_engfuncs.pfnServerPrint = Stub_ServerPrint;
+	g_engfuncs.pfnAlertMessage = Stub_AlertMessage;
+	g_engfuncs.pfnGetGameDir = Stub_GetGameDir;
+	g_engfuncs.pfnTime = Stub_Time;
+	g_engfuncs.pfnRandomLong = Stub_RandomLong;
+	g_engfuncs.pfnRandomFloat = Stub_RandomFloat;
+	g_engfuncs.pfnFindEntityByString = Stub_FindEntity;
+	g_engfuncs.pfnFindEntityInSphere = Stub_FindEntityInSphere;
+	g_engfuncs.pfnPEntityOfEntIndex = Stub_EntityOfIndex;
+	g_engfuncs.pfnEntOffsetOfPEntity = Stub_EntityOffset;
+	g_engfuncs.pfnIsDedicatedServer = Stub_Dedicated;
+	g_engfuncs.pfnPrecacheModel = Stub_Precache;
+	g_engfuncs.pfnPrecacheSound = Stub_Precache;
+	g_engfuncs.pfnServerCommand = Stub_ServerCommand;
+	g_engfuncs.pfnServerExecute = Stub_ServerExecute;
+
+	engine->PushRegisteredConVarsToEngine();
+}
+
+bool BenchSetCvar(const char* name, const char* value)
+{
+	BenchCvar* cvar = FindCvar(name);
+	if (!cvar)
+		return false;
+
+	SetCvarString(cvar, value);
+	return true;
+}
+
+void BenchSetTime(const float time)
+{
+	s_globals.time = time;
+}
+
+uint32_t BenchGetTraceCount(void)
+{
+	return s_traceCount;
+}
@@ -0,0 +1,943 @@
+﻿//
+// Engine-free navigation benchmark for E-Bot
+//
+// usage: ebot_navbench --map <name> [--root <hlds dir>] [--mod cstrike] [--pairs 2000] [--points 20000]
+//                      [--loads 20] [--seed 1] [--generate <size>] [--save] [--cvar <name> <value>]...
+//        ebot_navbench --replay <file> [--root <hlds dir>] [--mod cstrike] [--map <name>] [--cvar <name> <value>]...
+//
+// Loads <root>/<mod>/addons/ebot/waypoints/<map>.ewp (and the .nav next to it if there is one) and
+// prints one JSON object per benchmark on stdout, times are in microseconds. --generate writes a
+// size x size grid map first, so the numbers can be compared without any map files. --save rewrites
+// the waypoint file with the same content to time the saves
+//
+// --replay issues the queries of an "ebot record" file again, on the map it was recorded on, and
+// prints their times and how many results still match the recording
+//
+
+#include <core.h>
+#include <algorithm>
+#include <unistd.h>
+#include "bench.h"
+
+// reproducible picks that don't move the plugin's own random state
+static uint32_t s_seed = 1;
+static inline uint32_t NextRandom(void)
+{
+	s_seed ^= s_seed << 13;
+	s_seed ^= s_seed >> 17;
+	s_seed ^= s_seed << 5;
+	return s_seed;
+}
+
+static inline int RandomIndex(const int count)
+{
+	return static_cast<int>(NextRandom() % static_cast<uint32_t>(count));
+}
+
+// one sample per run, summarized as a JSON line
+class Samples
+{
+private:
+	double* m_times{};
+	int m_count{};
+	int m_capacity{};
+	uint64_t m_start{};
+	uint32_t m_traceStart{};
+	uint32_t m_traces{}; // made inside the timed runs
+public:
+	explicit Samples(const int capacity) : m_capacity(cmax(capacity, 1))
+	{
+		m_times = new double[m_capacity];
+	}
+
+	~Samples(void) { delete[] m_times; }
+
+	inline void Begin(void)
+	{
+		m_traceStart = BenchGetTraceCount();
+		m_start = Profiler::Now();
+	}
+
+	inline void End(void)
+	{
+		m_traces += BenchGetTraceCount() - m_traceStart;
+		if (m_count < m_capacity)
+			m_times[m_count++] = static_cast<double>(Profiler::Now() - m_start) * 0.001;
+	}
+
+	void Print(const char* bench, const char* variant, const char* extra = "")
+	{
+		double total = 0.0;
+		int i;
+		for (i = 0; i < m_count; i++)
+			total += m_times[i];
+
+		std::sort(m_times, m_times + m_count);
+		const double p50 = m_count ? m_times[m_count / 2] : 0.0;
+		const double p99 = m_count ? m_times[cmin(m_count - 1, (m_count * 99) / 100)] : 0.0;
+		const double max = m_count ? m_times[m_count - 1] : 0.0;
+
+		printf("{\"bench\":\"%s\",\"variant\":\"%s\",\"map\":\"%s\",\"waypoints\":%d,\"runs\":%d,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f,\"traces\":%u%s}\n",
+			bench, variant, GetMapName(), g_numWaypoints, m_count, m_count ? total / m_count : 0.0, p50, p99, max, m_traces, extra);
+		fflush(stdout);
+	}
+};
+
+// grid of size x size waypoints 64 units apart, every waypoint linked to its eight neighbours
+static bool GenerateGrid(const int size)
+{
+	const int count = size * size;
+	if (size < 2 || count > Const_MaxWaypoints)
+		return false;
+
+	g_waypoint->Initialize();
+	g_waypoint->m_paths.Resize(count, true);
+	g_numWaypoints = count;
+
+	int x, y, dx, dy, slot;
+	Path path;
+	for (y = 0; y < size; y++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			path = Path{};
+			path.origin = Vector(static_cast<float>(x - size / 2) * 64.0f, static_cast<float>(y - size / 2) * 64.0f, 36.0f);
+			path.radius = 32;
+			path.flags = 0;
+
+			// a few mission points so every policy has somewhere to go
+			if (!(RandomIndex(97)))
+				path.flags |= WAYPOINT_GOAL;
+			else if (!(RandomIndex(61)))
+				path.flags |= (RandomIndex(2) ? WAYPOINT_TERRORIST : WAYPOINT_COUNTER);
+
+			for (slot = 0; slot < Const_MaxPathIndex; slot++)
+				path.index[slot] = -1;
+
+			slot = 0;
+			for (dy = -1; dy <= 1; dy++)
+			{
+				for (dx = -1; dx <= 1; dx++)
+				{
+					if ((!dx && !dy) || x + dx < 0 || y + dy < 0 || x + dx >= size || y + dy >= size)
+						continue;
+
+					path.index[slot++] = static_cast<int16_t>((y + dy) * size + x + dx);
+				}
+			}
+
+			g_waypoint->m_paths.Push(path);
+		}
+	}
+
+	char dir[1024];
+	FormatBuffer(dir, "%s", GetWaypointDir());
+	CreatePath(dir);
+	return g_waypoint->Save();
+}
+
+static void WaitForPathMatrix(void)
+{
+	Samples samples(1);
+	samples.Begin();
+	while (g_waypoint->IsBuildingPathMatrix())
+	{
+		g_jobPool.Sync();
+		g_waypoint->UpdatePathMatrix();
+	}
+
+	samples.End();
+	samples.Print("path_matrix", g_waypoint->HasPathMatrix() ? "built" : "unavailable");
+}
+
+// traced in one go here, a server spreads it over frames and resumes it from the .ewv file
+static void WaitForVisibility(void)
+{
+	const bool loaded = g_waypoint->HasVisibility();
+	BenchSetCvar("ebot_visibility_build_ms", "100000");
+
+	Samples samples(1);
+	samples.Begin();
+	while (g_waypoint->IsBuildingVisibility())
+		g_waypoint->UpdateVisibility();
+
+	samples.End();
+	samples.Print("visibility_table", loaded ? "loaded" : (g_waypoint->HasVisibility() ? "built" : "unavailable"));
+	BenchSetCvar("ebot_visibility_build_ms", "0.5");
+}
+
+static long GetFileSize(const char* fileName)
+{
+	FILE* fp = fopen(fileName, "rb");
+	if (!fp)
+		return 0;
+
+	fseek(fp, 0, SEEK_END);
+	const long size = ftell(fp);
+	fclose(fp);
+	return size;
+}
+
+static void BenchLoad(const int loads)
+{
+	const long size = GetFileSize(g_waypoint->CheckSubfolderFile());
+	char extra[64];
+	snprintf(extra, sizeof(extra), ",\"bytes\":%ld", size);
+
+	Samples samples(loads);
+	int i;
+	for (i = 0; i < loads; i++)
+	{
+		samples.Begin();
+		g_waypoint->Load();
+		samples.End();
+
+		// the first load of a new file builds the tables, time that on its own
+		if (g_waypoint->IsBuildingPathMatrix())
+			WaitForPathMatrix();
+	}
+
+	samples.Print("waypoint_load", "ewp", extra);
+}
+
+static void BenchSave(const int saves)
+{
+	Samples samples(saves);
+	int i;
+	for (i = 0; i < saves; i++)
+	{
+		samples.Begin();
+		g_waypoint->Save();
+		samples.End();
+
+		if (g_waypoint->IsBuildingPathMatrix())
+			WaitForPathMatrix();
+	}
+
+	samples.Print("waypoint_save", "ewp");
+}
+
+// built once into its own slot like the plugin's bot pool, never destroyed since ~Bot talks to the engine
+alignas(64) static uint8_t s_botStorage[sizeof(Bot)];
+static entvars_t s_botVars{};
+
+static Bot* GetBenchBot(void)
+{
+	static Bot* bot = nullptr;
+	if (!bot)
+	{
+		bot = new(s_botStorage) Bot(&s_botVars);
+
+		// same start size as a bot joining, the searches grow it on demand
+		bot->m_navNode.Init(static_cast<int16_t>((g_numWaypoints / 2) + 32));
+	}
+
+	bot->m_index = 1;
+	bot->m_team = Team::Counter;
+	return bot;
+}
+
+static void PlaceBot(Bot* bot, const int index)
+{
+	bot->pev->origin = g_waypoint->GetPath(index)->origin;
+	bot->m_avgDeathOrigin = bot->pev->origin + Vector(4096.0f, 4096.0f, 0.0f);
+	bot->m_currentWaypointIndex = index;
+}
+
+static void BenchPaths(const int pairs, const char* variant, const int personality, const bool zombie)
+{
+	Bot* bot = GetBenchBot();
+	bot->m_personality = personality;
+	SetGameMode(zombie ? GameMode::ZombiePlague : GameMode::Original);
+
+	Samples samples(pairs);
+	int i, src, dest, found = 0, length = 0;
+	for (i = 0; i < pairs; i++)
+	{
+		src = RandomIndex(g_numWaypoints);
+		dest = RandomIndex(g_numWaypoints);
+		if (src == dest)
+			continue;
+
+		PlaceBot(bot, src);
+		bot->m_navNode.Clear();
+
+		samples.Begin();
+		if (!bot->SearchPath(src, dest, nullptr))
+		{
+			while (!bot->ContinuePath())
+				;
+		}
+
+		samples.End();
+		if (!bot->m_navNode.IsEmpty())
+		{
+			found++;
+			length += bot->m_navNode.Length();
+		}
+	}
+
+	char extra[96];
+	snprintf(extra, sizeof(extra), ",\"found\":%d,\"avg_length\":%.1f", found, found ? static_cast<float>(length) / found : 0.0f);
+	samples.Print("find_path", variant, extra);
+	SetGameMode(GameMode::Original);
+}
+
+// the bomb site case, everyone heads to one of a few goals, the flow fields should take over after the first bots
+static void BenchSharedGoals(const int pairs, const bool flow)
+{
+	Bot* bot = GetBenchBot();
+	bot->m_personality = Personality::Normal;
+	BenchSetCvar("ebot_flowfield", flow ? "1" : "0");
+	g_flowFields.Reset();
+
+	int goals[4], i;
+	for (i = 0; i < 4; i++)
+		goals[i] = RandomIndex(g_numWaypoints);
+
+	Samples samples(pairs);
+	int src, dest, found = 0, length = 0;
+	for (i = 0; i < pairs; i++)
+	{
+		src = RandomIndex(g_numWaypoints);
+		dest = goals[i & 3];
+		if (src == dest)
+			continue;
+
+		PlaceBot(bot, src);
+		bot->m_index = 1 + (i % 32);
+		bot->m_navNode.Clear();
+
+		samples.Begin();
+		if (!bot->SearchPath(src, dest, nullptr))
+		{
+			while (!bot->ContinuePath())
+				;
+		}
+
+		samples.End();
+		if (!bot->m_navNode.IsEmpty() && bot->m_navNode.Last() == dest)
+		{
+			found++;
+			length += bot->m_navNode.Length();
+		}
+	}
+
+	char extra[96];
+	snprintf(extra, sizeof(extra), ",\"found\":%d,\"avg_length\":%.1f", found, found ? static_cast<float>(length) / found : 0.0f);
+	samples.Print("find_path", flow ? "shared_goal_flow" : "shared_goal_astar", extra);
+	BenchSetCvar("ebot_flowfield", "1");
+	g_flowFields.Reset();
+}
+
+// a bot stuck on its way, the blocked waypoint is in the middle of the path it had
+static void BenchStuckPaths(const int pairs, const bool repair)
+{
+	Bot* bot = GetBenchBot();
+	bot->m_personality = Personality::Normal;
+	BenchSetCvar("ebot_path_repair", repair ? "1" : "0");
+
+	Samples samples(pairs);
+	int i, src, dest, blocked, found = 0, length = 0;
+	for (i = 0; i < pairs; i++)
+	{
+		src = RandomIndex(g_numWaypoints);
+		dest = RandomIndex(g_numWaypoints);
+		if (src == dest)
+			continue;
+
+		// the path the bot was following, not timed
+		PlaceBot(bot, src);
+		bot->m_isStuck = false;
+		bot->m_navNode.Clear();
+		if (!bot->SearchPath(src, dest, nullptr))
+		{
+			while (!bot->ContinuePath())
+				;
+		}
+
+		if (bot->m_navNode.Length() < 4 || bot->m_navNode.Last() != dest)
+			continue;
+
+		blocked = bot->m_navNode.Get(bot->m_navNode.Length() / 2);
+		src = bot->m_navNode.Get(bot->m_navNode.Length() / 2 - 1);
+
+		// what CheckStuck leaves behind
+		PlaceBot(bot, src);
+		bot->m_isStuck = true;
+		bot->m_stuckArea = g_waypoint->GetPath(blocked)->origin;
+		bot->m_navNode.Clear();
+
+		samples.Begin();
+		if (!bot->SearchPath(src, dest, nullptr))
+		{
+			while (!bot->ContinuePath())
+				;
+		}
+
+		samples.End();
+		if (!bot->m_navNode.IsEmpty() && bot->m_navNode.Last() == dest)
+		{
+			found++;
+			length += bot->m_navNode.Length();
+		}
+	}
+
+	char extra[96];
+	snprintf(extra, sizeof(extra), ",\"found\":%d,\"avg_length\":%.1f", found, found ? static_cast<float>(length) / found : 0.0f);
+	samples.Print("find_path", repair ? "stuck_repair" : "stuck_full", extra);
+	BenchSetCvar("ebot_path_repair", "1");
+	bot->m_isStuck = false;
+}
+
+static void BenchShortestPaths(const int pairs)
+{
+	Bot* bot = GetBenchBot();
+	Samples samples(pairs);
+	int i, src, dest;
+	for (i = 0; i < pairs; i++)
+	{
+		src = RandomIndex(g_numWaypoints);
+		dest = RandomIndex(g_numWaypoints);
+		if (src == dest)
+			continue;
+
+		PlaceBot(bot, src);
+		samples.Begin();
+		bot->SearchShortestPath(src, dest);
+		samples.End();
+	}
+
+	samples.Print("find_path", "shortest");
+}
+
+static void BenchEscapePaths(const int pairs)
+{
+	Bot* bot = GetBenchBot();
+	Samples samples(pairs);
+	int i, src;
+	for (i = 0; i < pairs; i++)
+	{
+		src = RandomIndex(g_numWaypoints);
+		PlaceBot(bot, src);
+
+		samples.Begin();
+		bot->SearchEscapePath(src, g_waypoint->GetPath(RandomIndex(g_numWaypoints))->origin);
+		samples.End();
+	}
+
+	samples.Print("find_path", "escape");
+}
+
+// owns the whole recording, events are walked twice, once to size the samples and once to replay them
+class Replay
+{
+private:
+	uint8_t* m_data{};
+	long m_size{};
+public:
+	RecordHeader header{};
+
+	~Replay(void) { delete[] m_data; }
+
+	bool Load(const char* fileName)
+	{
+		FILE* fp = fopen(fileName, "rb");
+		if (!fp)
+			return false;
+
+		fseek(fp, 0, SEEK_END);
+		m_size = ftell(fp) - static_cast<long>(sizeof(header));
+		fseek(fp, 0, SEEK_SET);
+
+		bool valid = m_size >= 0 && fread(&header, sizeof(header), 1, fp) == 1 && header.magic == Const_RecordMagic && header.version == Const_RecordVersion;
+		if (valid)
+		{
+			m_data = new uint8_t[m_size + 1];
+			valid = !m_size || fread(m_data, static_cast<size_t>(m_size), 1, fp) == 1;
+		}
+
+		fclose(fp);
+		header.mapName[sizeof(header.mapName) - 1] = '\0';
+		return valid;
+	}
+
+	// calls visit(event, payload) for every whole event
+	template <typename Visit> void Walk(Visit visit) const
+	{
+		long offset = 0;
+		RecordEvent event;
+		while (offset + static_cast<long>(sizeof(event)) <= m_size)
+		{
+			cmemcpy(&event, m_data + offset, sizeof(event));
+			offset += sizeof(event);
+			if (offset + event.size > m_size)
+				break;
+
+			visit(event, m_data + offset);
+			offset += event.size;
+		}
+	}
+};
+
+template <typename T> inline T ReadRecord(const RecordEvent& event, const uint8_t* payload)
+{
+	T record{};
+	cmemcpy(&record, payload, cmin(static_cast<int>(sizeof(T)), static_cast<int>(event.size)));
+	return record;
+}
+
+static void BenchReplay(const Replay& replay)
+{
+	int counts[Record_Count]{};
+	replay.Walk([&](const RecordEvent& event, const uint8_t*)
+	{
+		if (event.type < Record_Count)
+			counts[event.type]++;
+	});
+
+	Samples paths(counts[Record_Path]), shortest(counts[Record_Shortest]), escape(counts[Record_Escape]);
+	Samples nearest(counts[Record_Nearest]), visibility(counts[Record_Visibility]);
+	Samples total(1);
+
+	// searches finish right away here, the result waits for the recorded one of the same bot
+	RecordPathResult pending[32]{};
+	bool hasPending[32]{};
+	int pathMatch = 0, pathMiss = 0, pathEnemy = 0, nearestMatch = 0, nearestMiss = 0, nearestEntity = 0, visibilityMatch = 0;
+
+	Bot* bot = GetBenchBot();
+	TraceResult tr{};
+	total.Begin();
+	replay.Walk([&](const RecordEvent& event, const uint8_t* payload)
+	{
+		const int slot = event.slot < 32 ? event.slot : 0;
+		switch (event.type)
+		{
+		case Record_Frame:
+		{
+			BenchSetTime(ReadRecord<RecordFrame>(event, payload).time);
+			break;
+		}
+		case Record_Path:
+		{
+			const RecordPath record = ReadRecord<RecordPath>(event, payload);
+			if (!IsValidWaypoint(record.srcIndex) || !IsValidWaypoint(record.destIndex) || record.cost < 0 || record.cost >= static_cast<int8_t>(PathCost::Num))
+				break;
+
+			bot->m_index = slot + 1;
+			bot->m_team = record.team;
+			bot->m_isZombieBot = record.isZombie != 0;
+			bot->pev->origin = record.origin;
+			bot->m_avgDeathOrigin = record.deathOrigin;
+			bot->m_currentWaypointIndex = record.srcIndex;
+			bot->m_navNode.Clear();
+			pathEnemy += record.hasEnemy;
+
+			paths.Begin();
+			if (!bot->BeginPath(static_cast<PathCost>(record.cost), record.srcIndex, record.destIndex, record.seed, record.stuckIndex, nullptr, record.hasHostage != 0))
+			{
+				while (!bot->ContinuePath())
+					;
+			}
+
+			paths.End();
+			pending[slot].length = bot->m_navNode.Length();
+			pending[slot].last = pending[slot].length ? bot->m_navNode.Last() : -1;
+			hasPending[slot] = true;
+			break;
+		}
+		case Record_PathResult:
+		{
+			if (!hasPending[slot])
+				break;
+
+			const RecordPathResult record = ReadRecord<RecordPathResult>(event, payload);
+			if (record.length == pending[slot].length && record.last == pending[slot].last)
+				pathMatch++;
+			else
+				pathMiss++;
+
+			hasPending[slot] = false;
+			break;
+		}
+		case Record_Shortest:
+		{
+			const RecordShortest record = ReadRecord<RecordShortest>(event, payload);
+			if (!IsValidWaypoint(record.srcIndex) || !IsValidWaypoint(record.destIndex))
+				break;
+
+			bot->m_index = slot + 1;
+			shortest.Begin();
+			bot->SearchShortestPath(record.srcIndex, record.destIndex);
+			shortest.End();
+			break;
+		}
+		case Record_Escape:
+		{
+			const RecordEscape record = ReadRecord<RecordEscape>(event, payload);
+			if (!IsValidWaypoint(record.srcIndex))
+				break;
+
+			bot->m_index = slot + 1;
+			escape.Begin();
+			bot->SearchEscapePath(record.srcIndex, record.dangerOrigin);
+			escape.End();
+			break;
+		}
+		case Record_Nearest:
+		{
+			const RecordNearest record = ReadRecord<RecordNearest>(event, payload);
+			nearest.Begin();
+			const int result = g_waypoint->FindNearest(record.origin, record.minDistance, record.flags, nullptr, reinterpret_cast<int*>(-2), record.mode);
+			nearest.End();
+
+			if (record.hasEntity)
+				nearestEntity++;
+			else if (result == record.result)
+				nearestMatch++;
+			else
+				nearestMiss++;
+
+			break;
+		}
+		case Record_Visibility:
+		{
+			const RecordVisibility record = ReadRecord<RecordVisibility>(event, payload);
+			visibility.Begin();
+			TraceLine(record.start, record.end, true, record.ignoreGlass != 0, nullptr, &tr);
+			visibility.End();
+
+			const bool visible = static_cast<VisPoint>(record.point) == VisPoint::Eyes ? tr.flFraction == 1.0f : tr.flFraction > 0.98f;
+			visibilityMatch += visible == (record.visible != 0);
+			break;
+		}
+		}
+	});
+
+	total.End();
+
+	char extra[128];
+	snprintf(extra, sizeof(extra), ",\"match\":%d,\"mismatch\":%d,\"with_enemy\":%d", pathMatch, pathMiss, pathEnemy);
+	paths.Print("replay_path", "recorded", extra);
+	shortest.Print("replay_path", "shortest");
+	escape.Print("replay_path", "escape");
+
+	snprintf(extra, sizeof(extra), ",\"match\":%d,\"mismatch\":%d,\"with_entity\":%d", nearestMatch, nearestMiss, nearestEntity);
+	nearest.Print("replay_nearest", "recorded", extra);
+
+	// the height field only roughly stands in for the map geometry, the match count is a hint
+	snprintf(extra, sizeof(extra), ",\"match\":%d", visibilityMatch);
+	visibility.Print("replay_visibility", "heightfield", extra);
+
+	snprintf(extra, sizeof(extra), ",\"frames\":%d,\"seed\":%u", counts[Record_Frame], replay.header.seed);
+	total.Print("replay", "total", extra);
+}
+
+static Vector GetRandomPoint(void)
+{
+	const Vector origin = g_waypoint->GetPath(RandomIndex(g_numWaypoints))->origin;
+	return origin + Vector(static_cast<float>(RandomIndex(513) - 256), static_cast<float>(RandomIndex(513) - 256), static_cast<float>(RandomIndex(65) - 32));
+}
+
+static void BenchQueries(const int points)
+{
+	int i, found = 0;
+	{
+		Samples samples(points);
+		for (i = 0; i < points; i++)
+		{
+			const Vector origin = GetRandomPoint();
+			samples.Begin();
+			found += IsValidWaypoint(g_waypoint->FindNearest(origin));
+			samples.End();
+		}
+
+		char extra[48];
+		snprintf(extra, sizeof(extra), ",\"found\":%d", found);
+		samples.Print("find_nearest", "default", extra);
+	}
+
+	int hold[64], count, total = 0;
+	Samples samples(points);
+	for (i = 0; i < points; i++)
+	{
+		const Vector origin = GetRandomPoint();
+		count = 64;
+		samples.Begin();
+		g_waypoint->FindInRadius(origin, 256.0f, hold, &count);
+		samples.End();
+		total += count + 1;
+	}
+
+	char extra[48];
+	snprintf(extra, sizeof(extra), ",\"avg_found\":%.1f", points ? static_cast<float>(total) / points : 0.0f);
+	samples.Print("find_in_radius", "256", extra);
+}
+
+// what the searches and the aiming pay for a waypoint to waypoint check, a trace or a bit of the table
+static void BenchVisibility(const int points)
+{
+	if (!g_waypoint->HasVisibility())
+		return;
+
+	Samples traces(points);
+	Samples lookups(points);
+	TraceResult tr{};
+	int i, src, dest, visible = 0, agree = 0;
+	bool traced, table;
+	for (i = 0; i < points; i++)
+	{
+		src = RandomIndex(g_numWaypoints);
+		dest = RandomIndex(g_numWaypoints);
+
+		const Path* srcPath = g_waypoint->GetPath(src);
+		const Path* destPath = g_waypoint->GetPath(dest);
+		const Vector start = srcPath->origin + Vector(0.0f, 0.0f, (srcPath->flags & WAYPOINT_CROUCH) ? 12.0f : 17.0f);
+		const Vector end = destPath->origin + Vector(0.0f, 0.0f, (destPath->flags & WAYPOINT_CROUCH) ? 12.0f : 17.0f);
+
+		traces.Begin();
+		TraceLine(start, end, true, true, nullptr, &tr);
+		traces.End();
+		traced = src == dest || tr.flFraction >= 1.0f;
+
+		lookups.Begin();
+		table = g_waypoint->IsVisibleWaypoint(src, dest);
+		lookups.End();
+
+		visible += table;
+		agree += table == traced;
+	}
+
+	char extra[96];
+	snprintf(extra, sizeof(extra), ",\"visible\":%d,\"agree\":%d", visible, agree);
+	traces.Print("waypoint_visibility", "trace");
+	lookups.Print("waypoint_visibility", "table", extra);
+}
+
+static float RandomFloat(const float min, const float max)
+{
+	return min + (max - min) * static_cast<float>(NextRandom() & 0xffff) / 65535.0f;
+}
+
+// a full server of bots turning and moving, the scalar lanes against the four wide solve
+static void BenchAim(const int frames)
+{
+	static AimBatch input, scalar, batch;
+
+	Samples scalarSamples(frames);
+	Samples batchSamples(frames);
+	float maxError = 0.0f;
+	int i, slot;
+	for (i = 0; i < frames; i++)
+	{
+		for (slot = 0; slot < 32; slot++)
+		{
+			input.m_lookX[slot] = RandomFloat(-2048.0f, 2048.0f);
+			input.m_lookY[slot] = RandomFloat(-2048.0f, 2048.0f);
+			input.m_lookZ[slot] = RandomFloat(-512.0f, 512.0f);
+			input.m_punchX[slot] = RandomFloat(-2.0f, 2.0f);
+			input.m_punchY[slot] = RandomFloat(-2.0f, 2.0f);
+			input.m_angleX[slot] = RandomFloat(-89.0f, 89.0f);
+			input.m_angleY[slot] = RandomFloat(-180.0f, 180.0f);
+			input.m_pitchVel[slot] = RandomFloat(-400.0f, 400.0f);
+			input.m_yawVel[slot] = RandomFloat(-400.0f, 400.0f);
+			input.m_skill[slot] = static_cast<float>(RandomIndex(100) + 1);
+			input.m_delta[slot] = RandomFloat(0.001f, 0.05f);
+			input.m_moveX[slot] = RandomFloat(-256.0f, 256.0f);
+			input.m_moveY[slot] = RandomFloat(-256.0f, 256.0f);
+			input.m_moveZ[slot] = RandomFloat(-64.0f, 64.0f);
+		}
+
+		input.m_face = input.m_move = 0xffffffffu;
+		scalar = input;
+		batch = input;
+
+		scalarSamples.Begin();
+		for (slot = 0; slot < 32; slot++)
+		{
+			scalar.SolveFace(slot);
+			scalar.SolveMove(slot);
+		}
+
+		scalarSamples.End();
+
+		batchSamples.Begin();
+		batch.Solve();
+		batchSamples.End();
+
+		for (slot = 0; slot < 32; slot++)
+		{
+			maxError = cmaxf(maxError, cabsf(AngleNormalize(scalar.m_angleX[slot] - batch.m_angleX[slot])));
+			maxError = cmaxf(maxError, cabsf(AngleNormalize(scalar.m_angleY[slot] - batch.m_angleY[slot])));
+			maxError = cmaxf(maxError, cabsf(scalar.m_yawVel[slot] - batch.m_yawVel[slot]) * 0.05f);
+			maxError = cmaxf(maxError, cabsf(AngleNormalize(scalar.m_moveX[slot] - batch.m_moveX[slot])));
+			maxError = cmaxf(maxError, cabsf(AngleNormalize(scalar.m_moveY[slot] - batch.m_moveY[slot])));
+		}
+	}
+
+	char extra[64];
+	snprintf(extra, sizeof(extra), ",\"max_error_deg\":%.6f", maxError);
+	scalarSamples.Print("aim_32_bots", "scalar");
+	batchSamples.Print("aim_32_bots", "batch", extra);
+}
+
+static void BenchNavMesh(const int loads, const int pairs)
+{
+	char navFile[1024];
+	FormatBuffer(navFile, "%s/addons/ebot/navigations/%s.nav", GetModName(), GetMapName());
+	if (!TryFileOpen(navFile))
+		return;
+
+	Samples load(loads);
+	int i;
+	for (i = 0; i < loads; i++)
+	{
+		load.Begin();
+		g_navmesh->LoadNav();
+		load.End();
+	}
+
+	load.Print("nav_load", "nav");
+	if (g_numNavAreas < 2)
+		return;
+
+	PathNode corridor;
+	Samples samples(pairs);
+	int found = 0;
+	for (i = 0; i < pairs; i++)
+	{
+		corridor.Clear();
+		samples.Begin();
+		found += g_navmesh->FindPath(RandomIndex(g_numNavAreas), RandomIndex(g_numNavAreas), corridor);
+		samples.End();
+	}
+
+	char extra[48];
+	snprintf(extra, sizeof(extra), ",\"found\":%d", found);
+	samples.Print("nav_find_path", "default", extra);
+}
+
+int main(int argc, char** argv)
+{
+	const char* root = ".";
+	const char* mod = "cstrike";
+	const char* map = nullptr;
+	const char* replayFile = nullptr;
+	int pairs = 2000, points = 20000, loads = 20, generate = 0;
+	bool save = false;
+
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (!cstrcmp(argv[i], "--save"))
+			save = true;
+		else if (i + 1 >= argc)
+			break;
+		else if (!cstrcmp(argv[i], "--root"))
+			root = argv[++i];
+		else if (!cstrcmp(argv[i], "--mod"))
+			mod = argv[++i];
+		else if (!cstrcmp(argv[i], "--map"))
+			map = argv[++i];
+		else if (!cstrcmp(argv[i], "--pairs"))
+			pairs = catoi(argv[++i]);
+		else if (!cstrcmp(argv[i], "--points"))
+			points = catoi(argv[++i]);
+		else if (!cstrcmp(argv[i], "--loads"))
+			loads = catoi(argv[++i]);
+		else if (!cstrcmp(argv[i], "--seed"))
+			s_seed = cmax(catoi(argv[++i]), 1);
+		else if (!cstrcmp(argv[i], "--generate"))
+			generate = catoi(argv[++i]);
+		else if (!cstrcmp(argv[i], "--replay"))
+			replayFile = argv[++i];
+		else if (!cstrcmp(argv[i], "--cvar"))
+			i += 2; // applied once the cvars are registered
+	}
+
+	// loaded before the chdir, so the file name is relative to where we started
+	Replay replay;
+	if (replayFile)
+	{
+		if (!replay.Load(replayFile))
+		{
+			fprintf(stderr, "%s is not an ebot recording\n", replayFile);
+			return 1;
+		}
+
+		if (!map)
+			map = replay.header.mapName;
+	}
+
+	if (IsNullString(map) || chdir(root))
+	{
+		fprintf(stderr, "usage: %s --map <name> [--root <hlds dir>] [--mod cstrike] [--pairs n] [--points n] [--loads n] [--seed n] [--generate size] [--save] [--cvar name value]\n", argv[0]);
+		fprintf(stderr, "       %s --replay <file> [--root <hlds dir>] [--mod cstrike] [--map name] [--cvar name value]\n", argv[0]);
+		return 1;
+	}
+
+	BenchInitEngine(mod, map);
+
+	// searches run in one go, the slicing only matters for a live server
+	BenchSetCvar("ebot_path_slice_nodes", "32767");
+	BenchSetCvar("ebot_download_waypoints", "0");
+	BenchSetCvar("ebot_analyze_auto_start", "0");
+	for (i = 1; i + 2 < argc; i++)
+	{
+		if (cstrcmp(argv[i], "--cvar"))
+			continue;
+
+		if (!BenchSetCvar(argv[i + 1], argv[i + 2]))
+			fprintf(stderr, "unknown cvar %s\n", argv[i + 1]);
+
+		i += 2;
+	}
+
+	if (generate && !GenerateGrid(generate))
+	{
+		fprintf(stderr, "unable to generate a %dx%d waypoint grid\n", generate, generate);
+		return 1;
+	}
+
+	if (!g_waypoint->Load() || g_numWaypoints < 2)
+	{
+		fprintf(stderr, "unable to load %s\n", g_waypoint->CheckSubfolderFile());
+		return 1;
+	}
+
+	WaitForPathMatrix();
+	BenchBuildHeightField();
+	WaitForVisibility();
+
+	if (replayFile)
+	{
+		if (replay.header.numWaypoints != g_numWaypoints)
+			fprintf(stderr, "recorded with %d waypoints, %s has %d\n", replay.header.numWaypoints, GetMapName(), g_numWaypoints);
+
+		BenchReplay(replay);
+		g_jobPool.Stop();
+		return 0;
+	}
+
+	BenchLoad(loads);
+	if (save)
+		BenchSave(cmax(loads / 4, 1));
+
+	BenchPaths(pairs, "normal", Personality::Normal, false);
+	BenchPaths(pairs, "careful", Personality::Careful, false);
+	BenchPaths(pairs, "rusher", Personality::Rusher, false);
+	BenchPaths(pairs, "human", Personality::Normal, true);
+	BenchSharedGoals(pairs, false);
+	BenchSharedGoals(pairs, true);
+	BenchStuckPaths(pairs, false);
+	BenchStuckPaths(pairs, true);
+	BenchShortestPaths(pairs);
+	BenchEscapePaths(pairs);
+	BenchQueries(points);
+	BenchVisibility(points);
+	BenchAim(points);
+	BenchNavMesh(loads, pairs);
+
+	g_jobPool.Stop();
+	return 0;
+}
@@ -46,8 +46,8 @@ inline float crandomfloat(const float min, const float max)
 // faster, less range because of 32 bit intager, used as a pathfinding seed to randomize every bot's. if all bots goes on same way its not realistic and boring :)
 inline float crandomfloatfast(int& seed, float& min, float& max)
 {
-	seed = (214013 * seed + 2531011);
-	return ((seed >> 16) & 32767) * (max - min) * 0.0000305185f + min;
+	seed = static_cast<int>(214013u * static_cast<uint32_t>(seed) + 2531011u); // unsigned, signed overflow let the optimizer drop the mask
+	return ((static_cast<uint32_t>(seed) >> 16) & 32767) * (max - min) * 0.0000305185f + min;
 }
 
 inline bool chanceof(const int number)
@@ -130,6 +130,7 @@ extern float ccosf(const float value);
 extern float csinf(const float value);
 extern void csincosf(const float radians, float& sine, float& cosine);
 extern float catan2f(const float x, const float y);
+extern void catan2f4(const float* y, const float* x, float* result); // four lanes at once, every array aligned to 16
 extern float ctanf(const float value);
 
 // https://martin.ankerl.com/2012/01/25/optimized-approximative-pow-in-c-and-cpp/
@@ -168,6 +169,13 @@ inline int cabs(const int value)
 	return value;
 }
 
+inline int cpopcount(uint32_t value)
+{
+	value = value - ((value >> 1) & 0x55555555u);
+	value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+	return static_cast<int>((((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
 inline float cceilf(const float value)
 {
 	float result = static_cast<float>(static_cast<int>(value));
@@ -327,7 +335,7 @@ inline void cstrncpy(char* dest, const char* src, const int count)
 	for (; cache < count; cache++, destPtr++)
 		*destPtr = '\0';
 
-	destPtr[count] = '\0';
+	*destPtr = '\0';
 }
 
 inline void cmemcpy(void* dest, const void* src, const int size)
@@ -340,6 +348,21 @@ inline void cmemcpy(void* dest, const void* src, const int size)
 		dest2[cache] = src2[cache];
 }
 
+inline int cmemcmp(const void* first, const void* second, const int size)
+{
+	const unsigned char* first2 = static_cast<const unsigned char*>(first);
+	const unsigned char* second2 = static_cast<const unsigned char*>(second);
+
+	int cache;
+	for (cache = 0; cache < size; cache++)
+	{
+		if (first2[cache] != second2[cache])
+			return first2[cache] - second2[cache];
+	}
+
+	return 0;
+}
+
 inline void cmemset(void* dest, const int value, const int count)
 {
 	unsigned char* ptr = static_cast<unsigned char*>(dest);
@@ -764,6 +787,9 @@ inline void cswap(T& a, T& b)
 	b = temp;
 }
 
+// counts the allocation against the current memory tag, see memstats.h
+extern void MemoryCountAllocation(const size_t bytes);
+
 // useful on systems with low/bad memory
 template <typename T>
 inline T* safeloc(const size_t size)
@@ -776,6 +802,7 @@ inline T* safeloc(const size_t size)
 			break;
 	}
 
+	MemoryCountAllocation(sizeof(T) * size);
 	return any;
 }
 
@@ -783,12 +810,17 @@ inline T* safeloc(const size_t size)
 template <typename T>
 inline void safeloc(T*& any, const size_t size)
 {
+	if (any)
+		return;
+
 	while (!any)
 	{
 		any = new(std::nothrow) T[size]{};
 		if (any)
 			break;
 	}
+
+	MemoryCountAllocation(sizeof(T) * size);
 }
 
 template <typename T>
@@ -810,6 +842,8 @@ inline void safereloc(T*& any, const size_t oldSize, const size_t newSize)
 		else
 			max = oldSize;
 
+		MemoryCountAllocation(sizeof(T) * newSize);
+
 		size_t i;
 		for (i = 0; i < max; i++)
 			new_array[i] = any[i];
@@ -826,6 +860,8 @@ inline void safereloc(T*& any, const size_t oldSize, const size_t newSize)
 			if (any)
 				break;
 		}
+
+		MemoryCountAllocation(sizeof(T) * newSize);
 	}
 }
 
@@ -892,11 +928,21 @@ public:
 		return Push(&element, autoSize);
 	}
 
+	// grows the storage without touching the size, so a known count costs one allocation
+	inline bool Reserve(const int16_t capacity)
+	{
+		if (capacity <= m_capacity)
+			return true;
+
+		return Resize(capacity, false);
+	}
+
 	inline bool Push(const T* element, const bool autoSize = true)
 	{
 		if (m_size >= m_capacity)
 		{
-			if (!autoSize || !Resize(m_size + 1, false))
+			// double the storage, growing by one each time made filling a list O(N^2)
+			if (!autoSize || m_size >= INT16_MAX || !Resize(static_cast<int16_t>(cclamp(m_capacity * 2, 8, INT16_MAX)), false))
 				return false;
 		}
 
@@ -963,6 +1009,13 @@ public:
 			cswap(m_array[i], m_array[val - i]);
 	}
 
+	// drops everything from size on, used after compacting in place
+	inline void Truncate(const int16_t size)
+	{
+		if (size >= 0 && size < m_size)
+			m_size = size;
+	}
+
 	inline T Pop(void)
 	{
 		const T element = m_array[m_size - 1];
@@ -340,4 +340,373 @@ public:
         Compressor compressor;
         return compressor.InternalEncode(fileName, header, headerSize, buffer, bufferSize);
     }
-};
\ No newline at end of file
+};
+
+// lz4 style block codec, blocks are packed independently so the data can be fed and read in chunks
+#define STREAM_BLOCK 65536
+#define STREAM_HASH_BITS 12
+#define STREAM_MINMATCH 4
+#define STREAM_LASTLITERALS 5
+#define STREAM_MFLIMIT 12
+
+// every block is prefixed with this, packed size equal to raw size means the block is stored
+struct StreamBlockHeader
+{
+    uint32_t rawSize{};
+    uint32_t packedSize{};
+};
+
+class StreamCodec
+{
+private:
+    static inline uint32_t Read32(const uint8_t* data)
+    {
+        uint32_t value;
+        cmemcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static inline uint32_t Hash(const uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - STREAM_HASH_BITS);
+    }
+
+    static inline bool PutLength(uint8_t* dst, int& op, const int capacity, int length)
+    {
+        while (length >= 255)
+        {
+            if (op >= capacity)
+                return false;
+
+            dst[op++] = 255;
+            length -= 255;
+        }
+
+        if (op >= capacity)
+            return false;
+
+        dst[op++] = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    static inline bool GetLength(const uint8_t* src, int& ip, const int size, int& length)
+    {
+        uint8_t add;
+        do
+        {
+            if (ip >= size)
+                return false;
+
+            add = src[ip++];
+            length += add;
+        } while (add == 255);
+
+        return true;
+    }
+
+    static inline bool PutSequence(uint8_t* dst, int& op, const int capacity, const uint8_t* literals, const int literalLength, const int offset, const int matchLength)
+    {
+        if (op >= capacity)
+            return false;
+
+        const int token = op++;
+        dst[token] = static_cast<uint8_t>(cmin(literalLength, 15) << 4);
+        if (literalLength >= 15 && !PutLength(dst, op, capacity, literalLength - 15))
+            return false;
+
+        if (op + literalLength > capacity)
+            return false;
+
+        cmemcpy(dst + op, literals, literalLength);
+        op += literalLength;
+
+        // last sequence has literals only
+        if (!matchLength)
+            return true;
+
+        if (op + 2 > capacity)
+            return false;
+
+        dst[op++] = static_cast<uint8_t>(offset & 0xff);
+        dst[op++] = static_cast<uint8_t>(offset >> 8);
+
+        const int length = matchLength - STREAM_MINMATCH;
+        dst[token] |= static_cast<uint8_t>(cmin(length, 15));
+        if (length >= 15 && !PutLength(dst, op, capacity, length - 15))
+            return false;
+
+        return true;
+    }
+
+public:
+    // packs up to STREAM_BLOCK bytes, returns the packed size or 0 when it doesn't fit in capacity
+    static int EncodeBlock(const uint8_t* src, const int size, uint8_t* dst, const int capacity, uint16_t* table)
+    {
+        cmemset(table, 0, sizeof(uint16_t) << STREAM_HASH_BITS);
+
+        int ip = 0, anchor = 0, op = 0, ref, length;
+        uint32_t sequence, hash;
+        const int limit = size - STREAM_MFLIMIT;
+        const int matchLimit = size - STREAM_LASTLITERALS;
+
+        while (ip < limit)
+        {
+            sequence = Read32(src + ip);
+            hash = Hash(sequence);
+            ref = table[hash];
+            table[hash] = static_cast<uint16_t>(ip);
+
+            if (ref >= ip || Read32(src + ref) != sequence)
+            {
+                // skip faster through data that doesn't match
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+            {
+                ip--;
+                ref--;
+            }
+
+            length = STREAM_MINMATCH;
+            while (ip + length < matchLimit && src[ip + length] == src[ref + length])
+                length++;
+
+            if (!PutSequence(dst, op, capacity, src + anchor, ip - anchor, ip - ref, length))
+                return 0;
+
+            ip += length;
+            anchor = ip;
+        }
+
+        if (!PutSequence(dst, op, capacity, src + anchor, size - anchor, 0, 0))
+            return 0;
+
+        return op;
+    }
+
+    // returns the unpacked size, or -1 when the block is damaged
+    static int DecodeBlock(const uint8_t* src, const int size, uint8_t* dst, const int capacity)
+    {
+        int ip = 0, op = 0, token, length, offset, i;
+        while (ip < size)
+        {
+            token = src[ip++];
+            length = token >> 4;
+            if (length == 15 && !GetLength(src, ip, size, length))
+                return -1;
+
+            if (ip + length > size || op + length > capacity)
+                return -1;
+
+            cmemcpy(dst + op, src + ip, length);
+            ip += length;
+            op += length;
+
+            if (ip >= size)
+                break;
+
+            if (ip + 2 > size)
+                return -1;
+
+            offset = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+            if (!offset || offset > op)
+                return -1;
+
+            length = token & 15;
+            if (length == 15 && !GetLength(src, ip, size, length))
+                return -1;
+
+            length += STREAM_MINMATCH;
+            if (op + length > capacity)
+                return -1;
+
+            // matches can overlap the output
+            for (i = 0; i < length; i++)
+                dst[op + i] = dst[op - offset + i];
+
+            op += length;
+        }
+
+        return op;
+    }
+
+    // unpacks a whole stream from memory, returns the unpacked size or -1
+    static int64_t Unpack(const uint8_t* src, const size_t size, uint8_t* dst, const size_t capacity)
+    {
+        StreamBlockHeader block;
+        size_t ip = 0, op = 0;
+        while (ip + sizeof(StreamBlockHeader) <= size)
+        {
+            cmemcpy(&block, src + ip, sizeof(StreamBlockHeader));
+            ip += sizeof(StreamBlockHeader);
+
+            if (block.rawSize > STREAM_BLOCK || block.packedSize > block.rawSize || ip + block.packedSize > size || op + block.rawSize > capacity)
+                return -1;
+
+            if (block.packedSize == block.rawSize)
+                cmemcpy(dst + op, src + ip, block.rawSize);
+            else if (DecodeBlock(src + ip, static_cast<int>(block.packedSize), dst + op, static_cast<int>(block.rawSize)) != static_cast<int>(block.rawSize))
+                return -1;
+
+            ip += block.packedSize;
+            op += block.rawSize;
+        }
+
+        if (ip != size)
+            return -1;
+
+        return static_cast<int64_t>(op);
+    }
+};
+
+// feed chunks of any size, full blocks are packed and written to the file as they fill up
+class StreamCompressor
+{
+private:
+    File* m_fp{};
+    bool m_failed{};
+    int m_used{};
+    size_t m_rawSize{};
+    size_t m_packedSize{};
+
+    uint8_t m_block[STREAM_BLOCK]{};
+    uint8_t m_packed[STREAM_BLOCK]{};
+    uint16_t m_table[1 << STREAM_HASH_BITS]{};
+
+    bool Flush(void)
+    {
+        if (!m_used || m_failed)
+            return !m_failed;
+
+        StreamBlockHeader block;
+        block.rawSize = static_cast<uint32_t>(m_used);
+        block.packedSize = static_cast<uint32_t>(StreamCodec::EncodeBlock(m_block, m_used, m_packed, m_used - 1, m_table));
+
+        const uint8_t* data = m_packed;
+        if (!block.packedSize)
+        {
+            block.packedSize = block.rawSize;
+            data = m_block;
+        }
+
+        if (m_fp->Write(&block, sizeof(block), 1) != 1 || m_fp->Write(const_cast<uint8_t*>(data), static_cast<int>(block.packedSize), 1) != 1)
+            m_failed = true;
+
+        m_rawSize += block.rawSize;
+        m_packedSize += sizeof(block) + block.packedSize;
+        m_used = 0;
+        return !m_failed;
+    }
+
+public:
+    void Begin(File* fp)
+    {
+        m_fp = fp;
+        m_failed = !fp || !fp->IsValid();
+        m_used = 0;
+        m_rawSize = 0;
+        m_packedSize = 0;
+    }
+
+    bool Write(const void* data, const int size)
+    {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+        int left = size, count;
+        while (left > 0 && !m_failed)
+        {
+            count = cmin(left, STREAM_BLOCK - m_used);
+            cmemcpy(m_block + m_used, src, count);
+            m_used += count;
+            src += count;
+            left -= count;
+
+            if (m_used == STREAM_BLOCK)
+                Flush();
+        }
+
+        return !m_failed;
+    }
+
+    // writes the last partial block, the file stays open
+    bool Finish(void)
+    {
+        return Flush();
+    }
+
+    size_t GetRawSize(void) const { return m_rawSize; }
+    size_t GetPackedSize(void) const { return m_packedSize; }
+};
+
+// reads a stream written by StreamCompressor back in chunks of any size
+class StreamDecompressor
+{
+private:
+    File* m_fp{};
+    bool m_failed{};
+    int m_size{};
+    int m_pos{};
+
+    uint8_t m_block[STREAM_BLOCK]{};
+    uint8_t m_packed[STREAM_BLOCK]{};
+
+    bool Fill(void)
+    {
+        StreamBlockHeader block;
+        if (m_failed || m_fp->Read(&block, sizeof(block), 1) != 1)
+            return false;
+
+        if (block.rawSize > STREAM_BLOCK || block.packedSize > block.rawSize)
+        {
+            m_failed = true;
+            return false;
+        }
+
+        uint8_t* target = block.packedSize == block.rawSize ? m_block : m_packed;
+        if (block.packedSize && m_fp->Read(target, static_cast<int>(block.packedSize), 1) != 1)
+        {
+            m_failed = true;
+            return false;
+        }
+
+        if (target == m_packed && StreamCodec::DecodeBlock(m_packed, static_cast<int>(block.packedSize), m_block, static_cast<int>(block.rawSize)) != static_cast<int>(block.rawSize))
+        {
+            m_failed = true;
+            return false;
+        }
+
+        m_size = static_cast<int>(block.rawSize);
+        m_pos = 0;
+        return true;
+    }
+
+public:
+    void Begin(File* fp)
+    {
+        m_fp = fp;
+        m_failed = !fp || !fp->IsValid();
+        m_size = 0;
+        m_pos = 0;
+    }
+
+    // returns the number of bytes read, -1 when the stream is damaged
+    int Read(void* data, const int size)
+    {
+        uint8_t* dst = reinterpret_cast<uint8_t*>(data);
+        int done = 0, count;
+        while (done < size)
+        {
+            if (m_pos == m_size && !Fill())
+                break;
+
+            count = cmin(size - done, m_size - m_pos);
+            cmemcpy(dst + done, m_block + m_pos, count);
+            m_pos += count;
+            done += count;
+        }
+
+        return m_failed ? -1 : done;
+    }
+};
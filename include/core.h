@@ -378,7 +378,14 @@ enum class LiftState : int8_t
 
 // bot known file 
 #define FH_WAYPOINT_NEW "EBOTWP!"
-#define FV_WAYPOINT 127
+#define FV_WAYPOINT 128
+#define FV_WAYPOINT_LZSS 127
+#define FH_WAYPOINT_TABLE "EBOTWT!"
+#define FV_WAYPOINT_TABLE 1
+#define FH_WAYPOINT_VISIBILITY "EBOTWV!"
+#define FV_WAYPOINT_VISIBILITY 1
+#define FH_ANALYZE_CHECKPOINT "EBOTAC!"
+#define FV_ANALYZE_CHECKPOINT 1
 
 #define Const_MaxHostages 8
 #define Const_MaxPathIndex 8
@@ -387,6 +394,10 @@ enum class LiftState : int8_t
 #define Const_NumWeapons 26
 #define Const_NumWeaponsHL 15
 #define Const_MaxNavAreas 65535
+#define Const_MatrixUnreachable 65535 // path distance matrix entry for unreachable pairs
+#define Const_MatrixScale 0.25f // matrix stores path distances in 4 unit steps
+#define Const_WaypointGridSize 64 // cells on each axis of the waypoint grid
+#define Const_WaypointGridCell 128.0f // covers the whole -4096...4096 map range
 
 // weapon masks
 #define WeaponBits_Primary ((1 << Weapon::Xm1014) | (1 << Weapon::M3) | (1 << Weapon::Mac10) | (1 << Weapon::Ump45) | (1 << Weapon::Mp5) | (1 << Weapon::Tmp) | (1 << Weapon::P90) | (1 << Weapon::Aug) | (1 << Weapon::M4A1) | (1 << Weapon::Sg552) | (1 << Weapon::Ak47) | (1 << Weapon::Scout) | (1 << Weapon::Sg550) | (1 << Weapon::Awp) | (1 << Weapon::G3SG1) | (1 << Weapon::M249) | (1 << Weapon::Famas) | (1 << Weapon::Galil))
@@ -445,6 +456,11 @@ public:
 			cswap(m_path[i], m_path[max - i]);
 	}
 
+	inline int16_t Capacity(void) const
+	{
+		return m_capacity;
+	}
+
 	inline int16_t Length(void) const
 	{
 		if (m_cursor >= m_length)
@@ -470,7 +486,11 @@ public:
 
 		if (m_length >= m_capacity)
 		{
-			m_capacity = m_length * 2;
+			if (m_capacity >= INT16_MAX)
+				return;
+
+			// an empty node used to "double" to zero
+			m_capacity = static_cast<int16_t>(cclamp(m_capacity * 2, 16, INT16_MAX));
 			safereloc(m_path, m_length, m_capacity);
 		}
 
@@ -482,7 +502,8 @@ public:
 	{
 		m_cursor = 0;
 		m_length = 0;
-		m_path[0] = 0;
+		if (m_path)
+			m_path[0] = 0;
 	}
 
 	inline void Init(const int16_t length)
@@ -492,18 +513,295 @@ public:
 	}
 };
 
+// binary heap open list of the searches
+class PriorityQueue
+{
+public:
+	PriorityQueue(void);
+	~PriorityQueue(void);
+	inline bool IsEmpty(void) const { return !m_size; }
+	inline int Size(void) const { return m_size; }
+	inline void Clear(void) { m_size = 0; }
+	inline void InsertLowest(const int16_t value, const float priority);
+	inline void InsertHighest(const int16_t value, const float priority);
+	inline int16_t RemoveLowest(void);
+	inline int16_t RemoveHighest(void);
+private:
+	struct HeapNode
+	{
+		int16_t id{};
+		float priority{};
+	} *m_heap{};
+	int m_size{};
+	int m_heapSize{};
+
+	inline bool Grow(void);
+};
+
+inline PriorityQueue::PriorityQueue(void)
+{
+	m_heap = nullptr;
+	m_size = 0;
+	m_heapSize = 0;
+}
+
+inline PriorityQueue::~PriorityQueue(void)
+{
+	if (m_heap)
+		free(m_heap);
+
+	m_heap = nullptr;
+	m_size = 0;
+	m_heapSize = 0;
+}
+
+// doubles the heap, keeps the old one if we are out of memory
+inline bool PriorityQueue::Grow(void)
+{
+	const int newSize = cmax(m_heapSize * 2, 64);
+	HeapNode* hp = static_cast<HeapNode*>(realloc(m_heap, sizeof(HeapNode) * newSize));
+	if (!hp)
+		return false;
+
+	m_heap = hp;
+	m_heapSize = newSize;
+	return true;
+}
+
+// inserts a value into the priority queue
+inline void PriorityQueue::InsertLowest(const int16_t value, const float priority)
+{
+	if (m_size >= m_heapSize && !Grow())
+		return;
+
+	m_heap[m_size].priority = priority;
+	m_heap[m_size].id = value;
+
+	int child = ++m_size - 1;
+	int parent;
+	HeapNode temp;
+	while (child)
+	{
+		parent = (child - 1) / 2;
+		if (m_heap[parent].priority < m_heap[child].priority)
+			break;
+
+		temp = m_heap[child];
+		m_heap[child] = m_heap[parent];
+		m_heap[parent] = temp;
+		child = parent;
+	}
+}
+
+// inserts a value into the priority queue
+inline void PriorityQueue::InsertHighest(const int16_t value, const float priority)
+{
+	if (m_size >= m_heapSize && !Grow())
+		return;
+
+	m_heap[m_size].priority = priority;
+	m_heap[m_size].id = value;
+
+	int child = ++m_size - 1;
+	int parent;
+	HeapNode temp;
+	while (child)
+	{
+		parent = (child - 1) / 2;
+		if (m_heap[parent].priority > m_heap[child].priority)
+			break;
+
+		temp = m_heap[child];
+		m_heap[child] = m_heap[parent];
+		m_heap[parent] = temp;
+		child = parent;
+	}
+}
+
+// removes the smallest item from the priority queue
+inline int16_t PriorityQueue::RemoveLowest(void)
+{
+	if (!m_heap || !m_size)
+		return -1;
+
+	const int16_t retID = m_heap[0].id;
+
+	m_size--;
+	m_heap[0] = m_heap[m_size];
+
+	int parent = 0;
+	int child = (2 * parent) + 1;
+	int rightChild;
+	const HeapNode ref = m_heap[parent];
+	while (child < m_size)
+	{
+		rightChild = (2 * parent) + 2;
+		if (rightChild < m_size)
+		{
+			if (m_heap[rightChild].priority < m_heap[child].priority)
+				child = rightChild;
+		}
+
+		if (ref.priority < m_heap[child].priority)
+			break;
+
+		m_heap[parent] = m_heap[child];
+		parent = child;
+		child = (2 * parent) + 1;
+	}
+
+	m_heap[parent] = ref;
+	return retID;
+}
+
+// removes the largest item from the priority queue
+inline int16_t PriorityQueue::RemoveHighest(void)
+{
+	if (!m_heap || !m_size)
+		return -1;
+
+	const int16_t retID = m_heap[0].id;
+
+	m_size--;
+	m_heap[0] = m_heap[m_size];
+
+	int parent = 0;
+	int child = (2 * parent) + 1;
+	int rightChild;
+	const HeapNode ref = m_heap[parent];
+	while (child < m_size)
+	{
+		rightChild = (2 * parent) + 2;
+		if (rightChild < m_size)
+		{
+			if (m_heap[rightChild].priority > m_heap[child].priority)
+				child = rightChild;
+		}
+
+		if (ref.priority > m_heap[child].priority)
+			break;
+
+		m_heap[parent] = m_heap[child];
+		parent = child;
+		child = (2 * parent) + 1;
+	}
+
+	m_heap[parent] = ref;
+	return retID;
+}
+
+// search node, only valid while its generation matches the current search
+struct AStar
+{
+	float g{};
+	float f{};
+	int16_t parent{};
+	bool is_closed{};
+	uint32_t generation{};
+};
+
+// persistent search state, starting a new search is just a generation bump
+class SearchPool
+{
+public:
+	SearchPool(void) : m_nodes(nullptr), m_capacity(0), m_generation(0) {}
+	~SearchPool(void) { safedel(m_nodes); }
+
+	// starts a new search over size nodes and returns the cleared open list
+	inline PriorityQueue& Begin(const int size)
+	{
+		if (m_capacity < size)
+		{
+			safedel(m_nodes);
+			m_capacity = size;
+			safeloc(m_nodes, m_capacity);
+			m_generation = 0;
+		}
+
+		// wrapped around, old stamps could look valid again
+		if (++m_generation == 0)
+		{
+			int i;
+			for (i = 0; i < m_capacity; i++)
+				m_nodes[i].generation = 0;
+
+			m_generation = 1;
+		}
+
+		m_openList.Clear();
+		return m_openList;
+	}
+
+	inline PriorityQueue& OpenList(void) { return m_openList; }
+
+	inline AStar& Get(const int16_t index)
+	{
+		AStar& node = m_nodes[index];
+		if (node.generation != m_generation)
+		{
+			node.g = 0.0f;
+			node.f = 0.0f;
+			node.parent = -1;
+			node.is_closed = false;
+			node.generation = m_generation;
+		}
+
+		return node;
+	}
+private:
+	AStar* m_nodes;
+	int m_capacity;
+	uint32_t m_generation;
+	PriorityQueue m_openList;
+};
+
 // links keywords and replies together
 struct KwChat
 {
-	Array <String> keywords{};
-	Array <String> replies{};
-	Array <String> usedReplies{};
+	Array <char*> keywords{}; // these point into the chat file text InitConfig keeps
+	Array <char*> replies{};
+	Array <bool> usedReplies{}; // one flag per reply
+	int numUsed{};
+};
+
+// every reply keyword compiled into one Aho-Corasick automaton, a single pass over the
+// message finds all reply groups that have a keyword in it, rebuilt by InitConfig whenever chat.cfg is parsed
+class KeywordMatcher
+{
+private:
+	uint8_t m_classOf[256]{}; // bytes that appear in no keyword share class 0
+	int m_numClasses{};
+	int m_numNodes{};
+	int32_t* m_delta{}; // m_numNodes * m_numClasses, complete so the scan never backtracks
+	int32_t* m_dict{}; // nearest suffix node that ends a keyword, -1 for none
+	int32_t* m_firstKeyword{}; // keywords ending at the node, chained by m_nextKeyword
+	int32_t* m_nextKeyword{};
+	int16_t* m_keywordGroup{};
+	int m_numKeywords{};
+	int m_numGroups{};
+
+	// main thread only scratch, stamps avoid clearing per message
+	uint32_t m_stamp{};
+	uint32_t* m_keywordStamp{};
+	uint32_t* m_groupStamp{};
+	int16_t* m_groupHits{};
+	size_t m_bytes{}; // allocated by Build
+public:
+	~KeywordMatcher(void) { Destroy(); }
+	size_t GetMemoryUsage(void) const { return m_bytes; }
+
+	void Build(Array <KwChat>& groups);
+	void Destroy(void);
+
+	// fills groups in ascending order with the number of distinct keywords each one matched,
+	// returns how many groups were written
+	int Match(const char* text, int16_t* groups, int16_t* hits, const int maxGroups);
 };
 
 // botname structure definition
 struct NameItem
 {
-	String name{};
+	char* name{};
 	bool isUsed{};
 };
 
@@ -596,6 +894,72 @@ struct WaypointHeader
 	char author[32]{};
 };
 
+// waypoint file info flags
+#define WFILE_COMPRESSED (1u << 0) // sections are packed with StreamCompressor
+
+// version 128 layout after the waypoint header, sections are 16 byte aligned and the links are pre-sorted
+struct WaypointFileInfo
+{
+	uint32_t checksum{}; // fnv-1a of the uncompressed sections
+	uint32_t flags{};
+	uint32_t nodeOffset{}; // from the start of the file, as if it was uncompressed
+	uint32_t linkOffset{};
+	uint32_t dataSize{}; // uncompressed bytes after this struct
+	uint32_t reserved[3]{};
+};
+
+struct WaypointFileNode
+{
+	Vector origin{};
+	uint32_t flags{};
+	float gravity{};
+	uint8_t radius{};
+	uint8_t mesh{};
+	uint16_t padding{};
+};
+
+struct WaypointFileLinks
+{
+	int16_t index[Const_MaxPathIndex]{};
+	uint16_t connectionFlags[Const_MaxPathIndex]{};
+};
+
+// derived waypoint tables, stored next to the waypoint file
+enum WaypointTable
+{
+	WTABLE_DISTANCE = 1,
+	WTABLE_NEXTHOP = 2,
+	WTABLE_VISIBILITY_ROWS = 3, // rows of the visibility table traced so far
+	WTABLE_VISIBILITY_STAND = 4,
+	WTABLE_VISIBILITY_CROUCH = 5
+};
+
+// header of the waypoint table file, tables are rebuilt when the waypoint hash doesn't match
+struct WaypointTableHeader
+{
+	char header[8]{};
+	int32_t fileVersion{};
+	uint32_t waypointHash{};
+	int32_t pointNumber{};
+	int32_t numTables{};
+};
+
+struct WaypointTableEntry
+{
+	int32_t type{};
+	int32_t size{};
+};
+
+// unfinished analyzer run, followed by the raw paths, waypoints before nextIndex are already expanded
+struct AnalyzeCheckpointHeader
+{
+	char header[8]{};
+	int32_t fileVersion{};
+	int32_t pointNumber{};
+	int32_t nextIndex{};
+	char mapName[32]{};
+};
+
 // define general waypoint structure
 struct Path
 {
@@ -608,19 +972,352 @@ struct Path
 	float gravity{};
 };
 
+// read only struct of arrays copy of the waypoints for the path searches, m_paths stays the editing format
+struct WaypointHotData
+{
+	float* originX{}; // 16 byte aligned
+	float* originY{};
+	float* originZ{};
+	float* gravity{};
+	uint32_t* flags{};
+	uint8_t* radius{};
+	int* edgeStart{}; // first edge of each waypoint, edgeStart[size] is the edge count
+	int16_t* edgeTarget{};
+	uint16_t* edgeFlags{};
+	int* reverseStart{}; // first incoming edge of each waypoint, reverseStart[size] is the edge count
+	int16_t* reverseSource{}; // waypoint the incoming edge comes from
+	int size{};
+	uint32_t version{}; // changes every time the hot data is rebuilt
+	uint8_t* block{};
+	size_t blockSize{};
+};
+
+// cached result of the downward trace of a fall check waypoint
+struct WaypointGroundCheck
+{
+	float expireTime{};
+	bool hasGround{};
+};
+
+// zombie threat and team occupancy around the waypoints, built once a frame and shared by the path costs
+struct WaypointThreatField
+{
+	uint8_t* zombies[Team::Spectator]{}; // zombies not in the team near each waypoint
+	uint32_t* occupied[Team::Spectator]{}; // bit per waypoint, a bot of the team is on it, has just left it or is walking to it
+	uint32_t* shared[Team::Spectator]{}; // bit per waypoint, more than one bot marked it
+	float* humanUntil[Team::Spectator]{}; // humans keep the waypoints they pass for a moment, no bot can tell where they go
+	int zombieCount[Team::Spectator]{}; // zombies not in the team, with the sums below the summed squared distance to any point is O(1)
+	Vector zombieSum[Team::Spectator]{};
+	float zombieSquaredSum[Team::Spectator]{};
+	int size{};
+	float time{-1.0f};
+
+	inline bool IsOccupied(const int team, const int index) const { return (occupied[team][index >> 5] >> (index & 31)) & 1u; }
+	inline bool IsShared(const int team, const int index) const { return (shared[team][index >> 5] >> (index & 31)) & 1u; }
+	inline bool IsHumanReserved(const int team, const int index) const { return humanUntil[team][index] > time; }
+};
+
+// type of a queued path search
+enum class PathType : int8_t
+{
+	Normal,
+	Shortest,
+	Escape
+};
+
+// queued path search, one per bot
+struct PathRequest
+{
+	edict_t* enemy{};
+	Vector dangerOrigin{};
+	float time{}; // when the request was posted, older requests gain priority
+	int16_t srcIndex{};
+	int16_t destIndex{};
+	PathType type{};
+	int8_t priority{};
+	bool active{};
+	bool inProgress{}; // search is running over several frames
+};
+
+// entities the bots look for, classified once per frame so no bot walks the engine entity list
+// entries can be freed by the game later in the same frame, check edict_t::free before use
+class WorldSnapshot
+{
+private:
+	float m_time{-1.0f};
+public:
+	MiniArray <edict_t*> m_smokes{}; // landed smoke grenades
+	MiniArray <edict_t*> m_items{}; // everything FindItem can pick up, use or run from
+	MiniArray <edict_t*> m_hostages{};
+	MiniArray <edict_t*> m_bombs{}; // dropped backpacks
+	MiniArray <edict_t*> m_buttons{}; // func_button and func_rot_button
+	MiniArray <edict_t*> m_targeters{}; // anything with a target, for the buttons that open doors and lifts
+
+	void Update(void);
+
+	// same test as the engine's FIND_ENTITY_IN_SPHERE, distance to the bounding box center
+	static inline bool InSphere(const edict_t* ent, const Vector& origin, const float radius)
+	{
+		return (origin - (ent->v.origin + (ent->v.mins + ent->v.maxs) * 0.5f)).GetLengthSquared() <= squaredf(radius);
+	}
+};
+
+// aim points a bot traces to, eyes are traced eye to eye and shared both ways
+enum class VisPoint : int8_t
+{
+	Body,
+	Head,
+	Feet,
+	LeftEdge,
+	RightEdge,
+	Eyes,
+	Num
+};
+
+// registered cost policies, a new policy only needs its struct, an entry in s_pathCosts and a case in Bot::SearchPath
+enum class PathCost : int8_t
+{
+	Human,
+	Careful,
+	Normal,
+	Rusher,
+	Num
+};
+
+// player slots copied once per think frame and laid out for batch math, slot i is player index i + 1
+class ClientSnapshot
+{
+public:
+	alignas(16) float m_originX[32]{};
+	alignas(16) float m_originY[32]{};
+	alignas(16) float m_originZ[32]{};
+	alignas(16) float m_velocityX[32]{};
+	alignas(16) float m_velocityY[32]{};
+	alignas(16) float m_velocityZ[32]{};
+	alignas(16) float m_eyeZ[32]{}; // view_ofs only moves on z
+	uint32_t m_alive{}; // used and alive slots
+	uint32_t m_team[Team::Count]{};
+	uint32_t m_zombie{};
+	uint32_t m_ducking{};
+
+	void Update(void);
+
+	// squared distances from point to every slot's origin or eyes, out must hold 32 floats aligned to 16
+	void GetDistances(const Vector& point, float* out, const bool eyes = false) const;
+
+	// slots of mask closer than radius (squared) to point, after moving them by velocity * lead
+	uint32_t GetInRadius(const Vector& point, const float radius, const uint32_t mask, const float lead = 0.0f) const;
+
+	inline uint32_t GetTeamMask(const int team) const
+	{
+		if (team < 0 || team >= Team::Count)
+			return 0;
+
+		return m_team[team];
+	}
+
+	inline Vector GetOrigin(const int slot) const { return Vector(m_originX[slot], m_originY[slot], m_originZ[slot]); }
+	inline Vector GetVelocity(const int slot) const { return Vector(m_velocityX[slot], m_velocityY[slot], m_velocityZ[slot]); }
+	inline Vector GetEyePosition(const int slot) const { return Vector(m_originX[slot], m_originY[slot], m_eyeZ[slot]); }
+};
+
+class Bot;
+
+// view and move angles of the bots that asked for them this frame, slot i is bot index i + 1
+// the lanes are solved four at a time once every bot has thought, then written back to the bots
+class AimBatch
+{
+public:
+	alignas(16) float m_lookX[32]{}; // from the eyes to the look target
+	alignas(16) float m_lookY[32]{};
+	alignas(16) float m_lookZ[32]{};
+	alignas(16) float m_punchX[32]{};
+	alignas(16) float m_punchY[32]{};
+	alignas(16) float m_angleX[32]{}; // view angles, solving replaces them with the new ones
+	alignas(16) float m_angleY[32]{};
+	alignas(16) float m_pitchVel[32]{}; // look velocities, replaced as well
+	alignas(16) float m_yawVel[32]{};
+	alignas(16) float m_skill[32]{};
+	alignas(16) float m_delta[32]{}; // aim time step, clamped
+	alignas(16) float m_moveX[32]{}; // move direction, replaced by the move angles
+	alignas(16) float m_moveY[32]{};
+	alignas(16) float m_moveZ[32]{};
+	uint32_t m_face{}; // slots waiting for view angles
+	uint32_t m_move{}; // slots waiting for move angles
+
+	void QueueFace(Bot* bot, const float delta);
+	void QueueMove(Bot* bot, const Vector& direction);
+
+	void Solve(void);
+	void SolveFace(const int slot);
+	void SolveMove(const int slot);
+	void ApplyFace(Bot* bot);
+	void ApplyMove(Bot* bot);
+	void Flush(Bot* bot);
+	void Run(void);
+};
+
+// goals handed out once per team on a slow cadence, the bots read their assignment instead of each scoring the same points
+class TeamPlanner
+{
+private:
+	float m_nextUpdate{};
+	int16_t m_campPoint[32]{}; // zombie mode camp point for each human bot slot, -1 until planned
+	int16_t m_goal[32]{}; // goal each bot slot is heading to, counted when handing out goals
+	MiniArray <uint32_t> m_pointNear{}; // alive humans near each zombie mode camp point
+	MiniArray <uint8_t> m_pointLoad{}; // bots assigned to each camp point in this plan
+public:
+	void Update(void);
+
+	// plan again on the next think frame, e.g. a bot needs a goal we didn't assign
+	inline void Request(void) { m_nextUpdate = 0.0f; }
+
+	inline int GetCampPoint(const int slot) const
+	{
+		if (slot < 0 || slot >= 32)
+			return -1;
+
+		return m_campPoint[slot];
+	}
+
+	// least claimed of a few random points, so a team doesn't stack on one goal
+	int PickGoal(const int slot, const int team, const MiniArray <int16_t>& points);
+};
+
+// one search run backwards from a goal, every waypoint knows its next hop toward it and the cost still to go
+struct FlowField
+{
+	int16_t* next{}; // next hop toward the goal, -1 if the goal can't be reached
+	float* cost{}; // cost to go, 0 on the goal or, for escape fields, on every safe waypoint
+	int size{}; // waypoints the arrays were made for
+	uint32_t version{}; // hot data version it was built on
+	float buildTime{};
+	float useTime{};
+	int16_t goal{-1}; // goal waypoint, the danger waypoint for escape fields
+	int8_t policy{}; // PathCost, Const_FlowEscape for escape fields
+	int8_t team{};
+	bool isZombie{};
+};
+
+constexpr int Const_MaxFlowFields = 8;
+constexpr int Const_MaxFlowDemand = 32;
+constexpr int8_t Const_FlowEscape = -1;
+
+// flow fields for the goals many bots path to at once, a bot on a field walks the next hops instead of searching
+class FlowFieldCache
+{
+private:
+	// searches asked for a goal that has no field yet, enough of them within the interval build one
+	struct Demand
+	{
+		float time{};
+		int16_t goal{-1};
+		int8_t policy{};
+		int8_t team{};
+		bool isZombie{};
+		uint8_t count{};
+	};
+
+	FlowField m_fields[Const_MaxFlowFields]{};
+	Demand m_demand[Const_MaxFlowDemand]{};
+	uint32_t m_builds{};
+	uint32_t m_hits{};
+
+	FlowField* Find(const int16_t goal, const int8_t policy, const int8_t team, const bool isZombie);
+	bool IsWanted(const int16_t goal, const int8_t policy, const int8_t team, const bool isZombie);
+	FlowField& GetFreeField(void);
+	void Build(FlowField& field);
+	const FlowField* Get(const int goal, const int8_t costIndex, const int team, const bool isZombie);
+public:
+	~FlowFieldCache(void) { Reset(); }
+
+	// the field toward goal if it is hot enough to have one, nullptr means search as usual
+	const FlowField* GetField(const int goal, const PathCost policy, const int team, const bool isZombie);
+
+	// the field away from the danger waypoint, its safe waypoints are the ones out of the escape radius
+	const FlowField* GetEscapeField(const int dangerIndex);
+
+	void Reset(void);
+	void Show(void);
+	size_t GetMemoryUsage(void) const;
+};
+
+// measures the wall time we spend in StartFrame and StartFrame_Post and scales our work to keep it under ebot_target_frame_ms
+class FrameGovernor
+{
+private:
+	double m_start{}; // when the current hook was entered
+	double m_frameTime{}; // seconds spent in both hooks this frame
+	double m_peak{}; // slowly decaying worst frame
+	double m_adjustTime{}; // next time the scale is allowed to change
+	float m_scale{1.0f};
+public:
+	void Enter(void);
+	void Leave(void);
+	void Update(void); // call once per server frame, before Enter
+
+	// 1.0 when there is time left, shrinks towards ebot_governor_min_scale
+	inline float GetScale(void) const { return m_scale; }
+
+	// how many levels of detail the bots should drop on top of their own
+	inline int GetLevelBias(void) const { return m_scale > 0.75f ? 0 : (m_scale > 0.4f ? 1 : 2); }
+	inline float GetPeakMs(void) const { return static_cast<float>(m_peak * 1000.0); }
+};
+
+// trace results shared by every bot during one frame, keyed by viewer, target and aim point
+class VisibilityCache
+{
+private:
+	uint32_t m_entry[32][32][static_cast<int>(VisPoint::Num)][2]{}; // frame << 1 | visible, last index is ignore glass
+	uint32_t m_frame{};
+	float m_time{-1.0f};
+public:
+	uint32_t m_hits{};
+	uint32_t m_misses{};
+
+	bool IsVisible(edict_t* viewer, edict_t* target, const VisPoint point, const Vector& start, const Vector& end, const bool ignoreGlass);
+	void ResetStats(void) { m_hits = m_misses = 0; }
+};
+
+// why a target was dropped before or after the visibility traces
+enum class CullReason : int8_t
+{
+	Accept,
+	NotInPVS,
+	TooFar,
+	OutsideFov,
+	NotAttackable,
+	Hidden,
+	Smoke
+};
+
+// chat, message queue and weapon preference state of a bot, touched a few times a second at most,
+// kept out of line so the think sweep over the bot pool stays in fewer cache lines
+struct BotColdData
+{
+	int messageQueue[33]{}; // stack for messages
+	int actMessageIndex{}; // current processed message
+	int pushMessageIndex{}; // offset for next pushed message
+	char tempStrings[512]{}; // space for strings (say text...)
+	SayText sayTextBuffer{}; // holds the index & the actual message of the last unprocessed text message of a player
+	int weaponPrefs[Const_NumWeapons]{};
+	MiniArray <char*> favoritePrimary{};
+	MiniArray <char*> favoriteSecondary{};
+	MiniArray <char*> favoriteStuff{};
+};
+
 // main bot class
 class Bot
 {
 	friend class BotControl;
 public:
+	BotColdData* m_cold{}; // lives in the cold pool, same slot as the bot
 	float m_moveSpeed{}; // current speed forward/backward
 	float m_strafeSpeed{}; // current speed sideways
 	float m_tempstrafeSpeed{}; // temp speed sideways
 
 	bool m_isLeader{}; // bot is leader of his team
 
-	int m_messageQueue[33]{}; // stack for messages
-	char m_tempStrings[512]{}; // space for strings (say text...)
 	int m_tryOpenDoor{}; // attempt's to open the door
 	int m_radioSelect{}; // radio entry
 	float m_chatterTimer{}; // chatter timer
@@ -778,6 +1475,15 @@ public:
 	void FindPath(int& srcIndex, int& destIndex, edict_t* enemy = nullptr);
 	void FindShortestPath(int& srcIndex, int& destIndex);
 	void FindEscapePath(int& srcIndex, const Vector& dangerOrigin);
+	bool SearchPath(int srcIndex, int destIndex, edict_t* enemy);
+	bool BeginPath(const PathCost cost, const int srcIndex, const int destIndex, const int seed, const int16_t stuckIndex, edict_t* enemy, const bool hasHostage);
+	bool ContinuePath(void);
+	template <typename Cost> bool ExpandPath(void);
+	bool FollowNextHops(const int srcIndex, const int destIndex);
+	bool FollowFlowField(const FlowField& field, const int srcIndex);
+	bool RepairPath(const PathCost cost, const int srcIndex, const int destIndex, const int goalIndex, const int16_t blockedIndex, const bool hasHostage);
+	void SearchShortestPath(int srcIndex, int destIndex);
+	void SearchEscapePath(int srcIndex, const Vector& dangerOrigin);
 	void CalculatePing(void);
 public:
 	entvars_t* pev{};
@@ -819,26 +1525,23 @@ public:
 	edict_t* m_radioEntity{}; // pointer to entity issuing a radio command
 	int8_t m_radioOrder{}; // actual command
 
-	int m_actMessageIndex{}; // current processed message
-	int m_pushMessageIndex{}; // offset for next pushed message
-
 	Vector m_waypointOrigin{}; // origin of waypoint
 	Vector m_destOrigin{}; // origin of move destination
 	Vector m_doubleJumpOrigin{}; // origin of double jump
 
-	SayText m_sayTextBuffer{}; // holds the index & the actual message of the last unprocessed text message of a player
 	BurstMode m_weaponBurstMode{}; // bot using burst mode? (famas/glock18, but also silencer mode)
-	int m_pingOffset[2]{}; // offset for faking pings
-	int m_ping[3]{}; // bots pings in scoreboard
+	int m_ping{}; // bots ping in scoreboard
 	bool m_isEnemyReachable{}; // direct line to enemy
 
 	float m_seeEnemyTime{}; // time bot sees enemy
 	float m_radiotimer{}; // a timer for radio call
 	float m_randomattacktimer{}; // a timer for make bots random attack with knife like humans
-	float m_slowthinktimer{}; // slow think timer
 	float m_stayTime{}; // stay time (for simulate server)
+	float m_slowThinkTime{}; // next slow think, in seconds so a lower think rate doesn't stretch it
 
 	bool m_isSlowThink{}; // bool for check is slow think? (every second)
+	bool m_isSenseThink{}; // should look for friends and enemies this frame
+	int8_t m_thinkLevel{}; // level of detail, 0 is near human players, higher levels think less often
 	float m_firePause{}; // time to pause firing
 
 	uint8_t m_currentWeapon{}; // one current weapon for each bot
@@ -847,12 +1550,18 @@ public:
 
 	Path m_waypoint{}; // current waypoint
 	PathNode m_navNode{}; // pointer to current node from path
+	float m_pathTime{}; // time until the bot keeps its current path
 	int8_t m_visibility{}; // visibility flags
+	int8_t m_cullReason[32]{}; // last CullReason per client, debug output only prints changes
 
 	// NEW VARS
 	Process m_currentProcess{};
 	Process m_rememberedProcess{};
 	float m_currentProcessTime{};
+	float m_processUpdateTime{}; // passive processes don't update before this
+	float m_processMoveSpeed{}; // what the last update asked for, repeated until the next one
+	float m_processStrafeSpeed{};
+	int m_processButtons{};
 	float m_rememberedProcessTime{};
 
 	bool m_hasEnemiesNear{};
@@ -888,13 +1597,9 @@ public:
 	bool m_hasProfile{};
 
 	int m_campIndex{};
-	int m_weaponPrefs[Const_NumWeapons]{};
-
-	MiniArray <char*> m_favoritePrimary{};
-	MiniArray <char*> m_favoriteSecondary{};
-	MiniArray <char*> m_favoriteStuff{};
 
 	Bot(edict_t* bot, const int skill, const int personality, const int team, const int member);
+	explicit Bot(entvars_t* vars); // engine-free, only ebot_navbench builds bots this way
 	~Bot(void);
 
 	// NEW AI
@@ -902,6 +1607,8 @@ public:
 	void UpdateLooking(void);
 	void UpdateProcess(void);
 	void CheckSlowThink(void);
+	void UpdateThinkSchedule(void);
+	int GetThinkLevel(void);
 
 	Process GetCurrentState(void);
 	float GetCurrentStateTime(void);
@@ -920,6 +1627,8 @@ public:
 	void MoveOut(const Vector& targetPosition);
 	void FollowPath(void);
 	void FindFriendsAndEnemiens(void);
+	CullReason CullTarget(edict_t* target, const Vector& headOrigin, const float distance, uint8_t* pvs, const bool enemy, const bool needTarget);
+	void DebugCull(const edict_t* target, const CullReason reason);
 	void FindEnemyEntities(void);
 
 	bool IsEnemyViewable(edict_t* player);
@@ -1017,6 +1726,7 @@ public:
 	inline Vector EyePosition(void) { return pev->origin + pev->view_ofs; };
 
 	void FacePosition(void);
+	void SetMoveDirection(const Vector& direction);
 	void LookAt(const Vector& origin);
 	void NewRound(void);
 	void PushMessageQueue(const int message);
@@ -1062,13 +1772,15 @@ private:
 	float m_maintainTime{}; // time to maintain bot creation quota
 	int8_t m_lastWinner{}; // the team who won previous round
 	bool m_economicsGood[2]{}; // is team able to buy anything
+	PathRequest m_pathRequests[32]{}; // queued path searches by bot index
+	uint32_t m_thinkFrame{}; // think ticks so far, bots pick their slow frames from it
 protected:
 	int CreateBot(String name, int skill, int personality, const int team, const int member);
 public:
 	Bot* m_bots[32]{}; // all available bots
 
 	MiniArray <String> m_savedBotNames{}; // storing the bot names
-	MiniArray <String> m_avatars{}; // storing the steam ids
+	MiniArray <char*> m_avatars{}; // storing the steam ids
 
 	BotControl(void);
 	~BotControl(void);
@@ -1076,6 +1788,7 @@ public:
 	bool EconomicsValid(const int team) { return m_economicsGood[team]; }
 
 	int GetLastWinner(void) const { return m_lastWinner; }
+	uint32_t GetThinkFrame(void) const { return m_thinkFrame; }
 	void SetLastWinner(const int8_t winner) { m_lastWinner = winner; }
 
 	int GetIndex(edict_t* ent);
@@ -1091,6 +1804,9 @@ public:
 
 	void Think(void);
 	void DoJoinQuitStuff(void);
+	void PostPathRequest(Bot* bot, PathRequest& request);
+	void CancelPathRequest(const int index);
+	void UpdatePathRequests(void);
 	void Free(void);
 	void Free(const int index);
 
@@ -1114,24 +1830,80 @@ public:
 	static void CallGameEntity(entvars_t* vars);
 };
 
-// netmessage handler class
+// destinations a routed message is parsed for
+enum NetRoute : uint8_t
+{
+	Route_Any = 1, // whoever it goes to
+	Route_All = 2, // MSG_ALL
+	Route_Spec = 4, // MSG_SPEC
+	Route_Bot = 8 // one of our bots
+};
+
+// netmessage handler class, MessageBegin picks the handler from a table indexed by message type,
+// so the writes of a message we don't route (HUD messages of other plugins) return right away
 class NetworkMsg : public Singleton <NetworkMsg>
 {
 private:
+	typedef void (NetworkMsg::*Handler)(void* p);
+
+	struct Route
+	{
+		Handler handler{};
+		int8_t message{NETMSG_UNDEFINED};
+		uint8_t dests{};
+	};
+
 	Bot* m_bot{};
 	int8_t m_state{};
 	int m_message{};
+	Handler m_handler{};
+	bool m_routed{};
 	int m_registerdMessages[NETMSG_NUM]{};
+	Route m_routes[256]{};
+
+	// fields of the message being written, cleared by Begin
+	union
+	{
+		struct { int state, id; } curWeapon;
+		struct { int index; } ammo;
+		struct { uint8_t enabled; } statusIcon;
+		struct { uint8_t r, g, b; } screenFade;
+		struct { int numPlayers; } hltv;
+	} m_record{};
+	WeaponProperty m_weapon{};
+
+	void AddRoute(const int message, const uint8_t dests, const Handler handler);
+
+	void HandleVGUI(void* p);
+	void HandleShowMenu(void* p);
+	void HandleWeaponList(void* p);
+	void HandleCurWeapon(void* p);
+	void HandleAmmo(void* p);
+	void HandleMoney(void* p);
+	void HandleStatusIcon(void* p);
+	void HandleDeath(void* p);
+	void HandleScreenFade(void* p);
+	void HandleHLTV(void* p);
+	void HandleTextMsg(void* p);
+	void HandleBarTime(void* p);
 public:
 	NetworkMsg(void);
 	~NetworkMsg(void) { };
 
-	void Execute(void* p);
-	void Reset(void) { m_message = NETMSG_UNDEFINED; m_state = 0; m_bot = nullptr; };
-	void HandleMessageIfRequired(const int messageType, const int requiredType);
+	// looks the message ids up, runs once before the first message
+	void BuildRoutes(void);
+	void Begin(const int msgDest, const int msgType, edict_t* ed);
 
-	void SetMessage(const int message) { m_message = message; }
-	void SetBot(Bot* bot) { m_bot = bot; }
+	inline void Execute(void* p)
+	{
+		if (!m_handler)
+			return; // no message or not for bot, return
+
+		(this->*m_handler)(p);
+		m_state++; // and finally update network message state
+	}
+
+	void Reset(void) { m_message = NETMSG_UNDEFINED; m_handler = nullptr; m_state = 0; m_bot = nullptr; };
 
 	int GetId(const int messageType) { return m_registerdMessages[messageType]; }
 	void SetId(const int messageType, const int messsageIdentifier) { m_registerdMessages[messageType] = messsageIdentifier; }
@@ -1141,6 +1913,7 @@ public:
 class Waypoint : public Singleton <Waypoint>
 {
 	friend class Bot;
+	friend class TeamPlanner;
 private:
 	bool m_isOnLadder{};
 	bool m_endJumpPoint{};
@@ -1176,6 +1949,49 @@ private:
 	MiniArray <int16_t> m_rescuePoints{};
 	MiniArray <int16_t> m_zmHmPoints{};
 	MiniArray <int16_t> m_hmMeshPoints{};
+
+	uint16_t* m_distMatrix{}; // quantized path distance between each waypoint pair
+	int16_t* m_nextHop{}; // first waypoint to go from source to destination
+	int m_matrixSize{};
+	uint32_t m_waypointHash{}; // hash of the loaded waypoint file
+	void* m_tableMapping{}; // memory mapped waypoint table file, tables point into it
+	size_t m_tableMappingSize{};
+	void* m_tableMappingHandle{};
+
+	uint8_t* m_visibility{}; // standing then crouching bits of each waypoint pair, upper triangle only
+	size_t m_visibilityBytes{}; // size of one of the two bit tables
+	int m_visibilitySize{}; // waypoint count the table is for
+	int m_visibilityRow{}; // rows finished, the table is usable once every row is
+	int m_visibilityColumn{}; // next column of the row being traced
+	float m_visibilitySaveTime{};
+
+	int16_t* m_clusterId{}; // cluster of each waypoint
+	int m_numClusters{};
+	int m_clusterWaypoints{}; // waypoint count the clusters were built for
+	uint32_t m_clusterVersion{}; // hot data version the clusters were built on, any edit since makes them stale
+	int* m_clusterEdgeStart{}; // first cluster graph edge of each waypoint, only entrances have edges
+	int16_t* m_clusterEdgeTarget{};
+	float* m_clusterEdgeCost{};
+
+	int16_t m_gridHead[Const_WaypointGridSize * Const_WaypointGridSize]{}; // first waypoint in each grid cell
+	int16_t m_gridNext[Const_MaxWaypoints]{}; // next waypoint in the same grid cell
+
+	WaypointHotData m_hot{};
+	bool m_hotDirty{true}; // m_paths changed since the hot data was built
+	WaypointThreatField m_threats{};
+	WaypointGroundCheck* m_groundChecks{}; // cached fall check traces
+	int m_groundCheckSize{};
+
+	bool LoadPaths(const char* fileName);
+	bool LoadTables(void);
+	void SaveTables(void);
+	bool LoadVisibility(void);
+	void SaveVisibility(void);
+	void AddToGrid(const int index);
+	void RemoveFromGrid(const int index);
+	void BuildHotData(void);
+	void DestroyHotData(void);
+	void DestroyThreatField(void);
 public:
 	MiniArray <Path> m_paths{};
 	Waypoint(void);
@@ -1183,6 +1999,10 @@ public:
 
 	void Initialize(void);
 	void Analyze(void);
+	void StartAnalyze(const bool createBasic);
+	void SaveAnalyzeCheckpoint(void);
+	bool LoadAnalyzeCheckpoint(void);
+	void RemoveAnalyzeCheckpoint(void);
 	void AnalyzeDeleteUselessWaypoints(void);
 	void InitTypes(void);
 	void AddPath(const int addIndex, const int pathIndex, const int type = 0);
@@ -1197,6 +2017,8 @@ public:
 	void Add(const int flags, const Vector& waypointOrigin = nullvec);
 	void Delete(void);
 	void DeleteByIndex(int index);
+	int DeleteBatch(const bool* remove);
+	void RefreshDerivedData(void);
 	void ToggleFlags(int toggleFlag);
 	void SetRadius(const int radius);
 	bool IsConnected(const int pointA, const int pointB);
@@ -1214,9 +2036,14 @@ public:
 	Vector GetBottomOrigin(const Path* waypoint);
 
 	void Sort(const int16_t self, int16_t index[], const int size = Const_MaxPathIndex);
-	bool Download(void);
+	bool StartDownload(void);
+	bool IsDownloading(void);
+	void UpdateDownload(void);
+	void CancelDownload(void);
+	void StopDownload(void);
 	bool Load(void);
-	void Save(void);
+	bool Save(void);
+	void BenchmarkCompression(void);
 
 	bool Reachable(edict_t* entity, const int index);
 	bool IsNodeReachable(const Vector& src, const Vector& destination);
@@ -1227,6 +2054,36 @@ public:
 	void CreateBasic(void);
 
 	float GetPathDistance(const int srcIndex, const int destIndex);
+	int GetNextHop(const int srcIndex, const int destIndex);
+	bool HasPathMatrix(void);
+	bool IsBuildingPathMatrix(void);
+	void StartPathMatrix(void);
+	void UpdatePathMatrix(void);
+	void DestroyPathMatrix(void);
+
+	bool HasVisibility(void);
+	bool IsVisibleWaypoint(const int srcIndex, const int destIndex, const bool crouch = false);
+	bool IsBuildingVisibility(void);
+	void StartVisibility(void);
+	void UpdateVisibility(void);
+	void DestroyVisibility(void);
+
+	void BuildGrid(void);
+	void BuildClusters(void);
+	void DestroyClusters(void);
+	int GetClusterId(const int index);
+	int GetClusterCount(void) const { return m_numClusters; }
+	int GetClusterWaypoint(const int srcIndex, const int destIndex);
+
+	const WaypointHotData& GetHotData(void) { if (m_hotDirty) BuildHotData(); return m_hot; }
+	void InvalidateHotData(void) { m_hotDirty = true; }
+	void GetMemoryUsage(size_t& waypoints, size_t& tables, size_t& mapped);
+
+	const WaypointThreatField& GetThreatField(void) { return m_threats; }
+	void UpdateThreatField(void);
+
+	bool HasGround(const int index);
+	void ResetGroundChecks(void);
 
 	Path* GetPath(const int id);
 	char* GetWaypointInfo(const int id);
@@ -1238,6 +2095,9 @@ public:
 	Vector GetBombPosition(void) { return m_foundBombOrigin; }
 	void SetBombPosition(const bool shouldReset = false);
 	const char* CheckSubfolderFile(void);
+	const char* GetTableFile(void);
+	const char* GetVisibilityFile(void);
+	const char* GetAnalyzeCheckpointFile(void);
 };
 
 #define g_netMsg NetworkMsg::GetObjectPtr()
@@ -1260,6 +2120,7 @@ extern float GetShootingConeDeviation(edict_t* ent, const Vector& position);
 
 extern bool IsLinux(void);
 extern bool TryFileOpen(char* fileName);
+extern bool IsPlainFileName(const char* fileName);
 extern bool IsWalkableLineClear(const Vector& from, const Vector& to);
 extern bool IsDedicatedServer(void);
 extern bool IsVisible(const Vector& origin, edict_t* ent);
@@ -1269,6 +2130,7 @@ extern bool IsValidBot(edict_t* ent);
 extern bool IsValidBot(const int index);
 extern bool IsValidPlayer(edict_t* ent);
 extern bool OpenConfig(const char* fileName, char* errorIfNotExists, File* outFile);
+extern void InitConfig(const bool reload);
 extern bool FindNearestPlayer(void** holder, edict_t* to, const float searchDistance = 4096.0f, const bool sameTeam = false, const bool needBot = false, const bool needAlive = false, const bool needDrawn = false);
 
 extern char* GetEntityName(edict_t* entity);
@@ -1307,6 +2169,7 @@ extern bool SetEntityAction(const int index, const int team, const int action);
 extern void SetEntityActionData(const int i, const int index = -1, const int team = -1, const int action = -1);
 
 extern void AddLogEntry(const Log logLevel, const char* format, ...);
+extern double GetRealTime(void);
 extern void MOD_AddLogEntry(const int mode, char* format);
 
 extern void DisplayMenuToClient(edict_t* ent, MenuText* menu);
@@ -1327,6 +2190,11 @@ inline bool IsNullString(const char* input)
 extern ConVar ebot_knifemode;
 extern ConVar ebot_gamemod;
 
+#include <jobs.h>
+#include <logger.h>
+#include <profiler.h>
+#include <memstats.h>
+#include <record.h>
 #include <globals.h>
 #include <resource.h>
 #include <compress.h>
@@ -2198,6 +2198,7 @@ extern Vector GetEntityOrigin(entvars_t* pevBModel);
 #define VEC_DUCK_HULL_MAX    Vector(16.0f, 16.0f, 18.0f)
 #define VEC_DUCK_VIEW        Vector(0.0f, 0.0f, 12.0f)
 
+#define SVC_PINGS           17
 #define SVC_TEMPENTITY      23
 #define SVC_INTERMISSION    30
 #define SVC_CDTRACK         32
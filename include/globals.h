@@ -50,7 +50,6 @@ extern float g_lastRadioTime[2];
 extern float g_fakePingUpdate;
 extern float g_randomJoinTime;
 extern float g_DelayTimer;
-extern float g_pathTimer;
 extern float g_audioTime;
 
 extern int g_mapType;
@@ -69,9 +68,10 @@ extern int g_entityId[entityNum];
 extern int g_entityTeam[entityNum];
 extern int g_entityAction[entityNum];
 
-extern Array <Array<String>> g_chatFactory;
+extern Array <Array<char*>> g_chatFactory;
 extern MiniArray <NameItem> g_botNames;
 extern Array <KwChat> g_replyFactory;
+extern KeywordMatcher g_keywordMatcher;
 
 extern FireDelay g_fireDelay[Const_NumWeapons + 1];
 extern WeaponSelect g_weaponSelect[Const_NumWeapons + 1];
@@ -79,6 +79,15 @@ extern WeaponSelect g_weaponSelectHL[Const_NumWeaponsHL + 1];
 extern WeaponProperty g_weaponDefs[Const_MaxWeapons + 1];
 
 extern Clients g_clients[32];
+extern VisibilityCache g_visibilityCache;
+extern WorldSnapshot g_worldSnapshot;
+extern ClientSnapshot g_clientSnapshot;
+extern AimBatch g_aimBatch;
+extern TeamPlanner g_teamPlanner;
+extern FlowFieldCache g_flowFields;
+extern FrameGovernor g_frameGovernor;
+extern JobPool g_jobPool;
+extern LogWriter g_logWriter;
 extern MenuText g_menus[28];
 
 extern edict_t* g_hostEntity;
@@ -0,0 +1,123 @@
+﻿//
+// Job system for E-Bot
+// Runs plugin-only work on worker threads while the engine thread keeps the game going
+//
+// Rule for every job: no engine calls, no cvars, no edicts and nothing the main thread can
+// change while the job runs. A job works on its own copy of the data and hands the result
+// back through finish, which always runs on the main thread inside JobPool::Sync
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct Job
+{
+	void (*run)(void* data){}; // worker thread
+	void (*finish)(void* data){}; // main thread, also called for jobs dropped by Stop
+	void* data{};
+};
+
+// bounded lock-free queue, any thread can push and pop, size must be a power of two
+template <typename T, int Size>
+class JobQueue
+{
+private:
+	struct Cell
+	{
+		std::atomic<uint32_t> sequence{};
+		T data{};
+	};
+
+	Cell m_cells[Size];
+	std::atomic<uint32_t> m_enqueue{};
+	std::atomic<uint32_t> m_dequeue{};
+public:
+	JobQueue(void)
+	{
+		uint32_t i;
+		for (i = 0; i < static_cast<uint32_t>(Size); i++)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool Push(const T& data)
+	{
+		Cell* cell;
+		uint32_t pos = m_enqueue.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[pos & (Size - 1)];
+			const int32_t diff = static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - pos);
+			if (!diff)
+			{
+				if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; // full
+			else
+				pos = m_enqueue.load(std::memory_order_relaxed);
+		}
+
+		cell->data = data;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(T& data)
+	{
+		Cell* cell;
+		uint32_t pos = m_dequeue.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[pos & (Size - 1)];
+			const int32_t diff = static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+			if (!diff)
+			{
+				if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; // empty
+			else
+				pos = m_dequeue.load(std::memory_order_relaxed);
+		}
+
+		data = cell->data;
+		cell->sequence.store(pos + Size, std::memory_order_release);
+		return true;
+	}
+
+	bool IsEmpty(void) const { return m_enqueue.load(std::memory_order_acquire) == m_dequeue.load(std::memory_order_acquire); }
+};
+
+// fixed number of workers, started on the first use and stopped before the plugin unloads
+class JobPool
+{
+private:
+	std::thread* m_workers{};
+	int m_numWorkers{};
+	bool m_started{};
+	std::atomic<bool> m_stop{};
+	std::mutex m_sleepLock{};
+	std::condition_variable m_wake{};
+	JobQueue <Job, 256> m_pending{};
+	JobQueue <Job, 256> m_done{};
+
+	void Start(void);
+	void WorkerThread(void);
+public:
+	~JobPool(void) { Stop(); }
+
+	// queues the job, without workers or when the queue is full it runs right here instead
+	void Submit(const Job& job);
+
+	// runs finish for every job that is done, call once per frame on the main thread
+	void Sync(void);
+
+	void Stop(void);
+	int GetWorkerCount(void);
+};
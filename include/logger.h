@@ -0,0 +1,79 @@
+﻿//
+// Log writer for E-Bot
+// AddLogEntry stamps the line and drops it into a ring, a background thread owns the one log file
+// and writes the ring out, so a burst of warnings on a bad map never waits on the disk
+//
+// The same message repeating faster than ebot_log_repeat times per ebot_log_repeat_window seconds
+// is counted instead of printed, the count is logged when its slot starts over, either for the same message after the window or for another one, or on Stop
+//
+
+#pragma once
+
+constexpr int Const_LogLines = 256; // lines waiting for the writer, more than that are dropped
+constexpr int Const_LogLineLength = 640; // a 512 byte message with its level, stamp and separator
+constexpr int Const_LogRepeatSlots = 16; // distinct messages the rate limit remembers
+
+struct LogLine
+{
+	int day{}; // local date the line was stamped on, the file rotates when it changes
+	char text[Const_LogLineLength]{};
+};
+
+class LogWriter
+{
+private:
+	// filled on the main thread
+	LogLine m_lines[Const_LogLines]{};
+	int m_head{};
+	int m_count{};
+	int m_dropped{};
+	std::mutex m_lock{};
+	std::condition_variable m_wake{};
+
+	// owned by whoever holds m_fileLock, the writer thread or a synchronous flush
+	LogLine m_batch[Const_LogLines]{};
+	std::mutex m_fileLock{};
+	File m_file{};
+	int m_fileBytes{};
+	int m_fileDay{-1};
+	char m_base[256]{}; // path without the .txt, rotated files get _old appended
+	char m_header[512]{};
+
+	std::thread m_thread{};
+	bool m_started{};
+	std::atomic<bool> m_stop{};
+	std::atomic<int> m_maxBytes{1024 * 1024};
+
+	struct Repeat
+	{
+		uint32_t hash{};
+		int count{};
+		int suppressed{};
+		time_t start{};
+		char text[96]{};
+	} m_repeats[Const_LogRepeatSlots]{};
+
+	void Start(void);
+	void WriterThread(void);
+	void Drain(void);
+	void OpenFile(const int day);
+	void Queue(const char* text);
+public:
+	~LogWriter(void) { Stop(); }
+
+	// both are main thread only, the file name is fixed the first time it is set
+	void SetFile(const char* base, const char* header);
+	bool IsFileSet(void) const { return m_base[0] != '\0'; }
+
+	// rate limit, false when the caller should drop the message entirely
+	bool Allow(const char* message);
+
+	// adds one stamped line, never blocks on the disk unless ebot_log_async is 0
+	void Write(const char* text);
+
+	// writes everything queued right here and then
+	void Flush(void);
+
+	// flushes, stops the thread and closes the file, the next write starts over
+	void Stop(void);
+};
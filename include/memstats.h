@@ -0,0 +1,77 @@
+﻿//
+// Memory accounting for E-Bot
+// safeloc and safereloc count every allocation against the innermost MEMORY_TAG scope, "ebot mem"
+// shows them per frame next to the bytes each subsystem holds right now and the most it ever held
+//
+// Frees carry no size, so the held bytes are summed from the owners' own sizes once a second
+// instead of being tracked per allocation
+//
+
+#pragma once
+
+enum MemoryTag : int
+{
+	Mem_Waypoints,
+	Mem_Navmesh,
+	Mem_Tables, // distance, next hop, visibility and cluster tables
+	Mem_Paths, // bot path nodes and flow fields
+	Mem_Chat,
+	Mem_Bots,
+	Mem_Other, // outside any tag, worker threads included
+	Mem_Count
+};
+
+struct MemoryTagStats
+{
+	size_t current{}; // held at the last sample
+	size_t peak{};
+	uint32_t frameAllocs{}; // made in the last finished frame
+	uint32_t frameBytes{};
+	uint32_t maxFrameAllocs{}; // most in one frame since the reset
+	uint32_t maxFrameBytes{};
+	uint64_t totalAllocs{};
+	uint64_t totalBytes{};
+};
+
+class MemoryStats
+{
+private:
+	// frame being recorded, workers allocate too
+	std::atomic<uint32_t> m_allocs[Mem_Count]{};
+	std::atomic<uint32_t> m_bytes[Mem_Count]{};
+
+	MemoryTagStats m_tags[Mem_Count]{};
+	size_t m_mapped{}; // waypoint tables used straight from the mapped file, address space but no heap
+	uint32_t m_frames{};
+	double m_sampleTime{};
+
+	void Sample(void);
+public:
+	inline void Count(const int tag, const size_t bytes)
+	{
+		m_allocs[tag].fetch_add(1, std::memory_order_relaxed);
+		m_bytes[tag].fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+	}
+
+	// closes the frame, samples the held bytes once a second
+	void Update(void);
+	void Reset(void);
+	void Show(void);
+
+	// appended to the profiler dump
+	void Dump(FILE* fp);
+};
+
+extern MemoryStats g_memoryStats;
+extern thread_local int g_memoryTag;
+
+class MemoryTagScope
+{
+private:
+	int m_previous;
+public:
+	explicit MemoryTagScope(const int tag) : m_previous(g_memoryTag) { g_memoryTag = tag; }
+	~MemoryTagScope(void) { g_memoryTag = m_previous; }
+};
+
+#define MEMORY_TAG(tag) const MemoryTagScope memoryTag(tag)
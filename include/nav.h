@@ -1,4 +1,7 @@
 ﻿#define GridSize 24.0f
+#define MaxNavCorners 64
+#define NavHashBuckets 4096 // power of two, area centers are hashed by the GridSize cell they are in
+#define NavMergeHeight 2.0f // areas further apart in height than this are never merged
 
 struct ENavHeader
 {
@@ -53,6 +56,7 @@ public:
 	bool IsAreaOverlapping(const ENavArea area);
 	bool IsPointOverlapping(const Vector& origin);
 
+	void MergeBounds(const ENavArea& area);
 	void MergeWith(const ENavArea area);
 	void ExpandNavArea(const uint8_t radius = static_cast<uint8_t>(50));
 };
@@ -62,6 +66,16 @@ class ENavMesh : public Singleton <ENavMesh>
 	friend class Bot;
 private:
 	MiniArray <ENavArea> m_area{};
+	Vector m_pathCorners[MaxNavCorners]{}; // last path shown with 'ebot nav path'
+	int m_pathCornerCount{};
+
+	// spatial hash of the area centers, so the analyzer finds the areas next to a point without a full scan
+	int16_t m_hashHead[NavHashBuckets]{};
+	MiniArray <int16_t> m_hashNext{}; // next area in the same bucket, -1 ends the chain
+	bool m_hashDirty{true}; // areas were moved or removed, rebuilt on the next lookup
+
+	void HashArea(const int16_t index);
+	void RebuildHash(void);
 public:
 	int16_t m_selectedNavIndex{};
 
@@ -88,11 +102,18 @@ public:
 	void DeleteAreaByIndex(const int index);
 	void ConnectArea(const int start, const int end);
 	void DisconnectArea(const int start, const int end);
+	void MergeArea(const int target, const int index);
 	void OptimizeNavMesh(void);
 
+	bool FindPath(const int srcArea, const int destArea, PathNode& corridor);
+	int SmoothPath(const Vector& start, const Vector& goal, PathNode& corridor, Vector* corners, const int maxCorners);
+	void ShowPath(void);
+
 	ENavArea GetNavArea(const uint16_t id);
 	ENavArea* GetNavAreaP(const uint16_t id);
 	int GetNearestNavAreaID(const Vector origin);
+	int16_t GetNearestAreaCenter(const Vector& origin, const float maxDist, const int ignore);
+	size_t GetMemoryUsage(void);
 	Vector DirectionAsVector(const uint8_t corner, const float size);
 	float DirectionAsFloat(const uint8_t corner);
 	Vector GetAimingPosition(void);
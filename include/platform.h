@@ -80,6 +80,8 @@ typedef void (*EntityPtr_t) (entvars_t*);
 #include <dlfcn.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 
 #define DLL_ENTRYPOINT __attribute__((destructor))  void _fini (void)
 #define DLL_DETACHING true
@@ -0,0 +1,178 @@
+﻿//
+// Hot path profiler for E-Bot
+// Scoped timers feed one second histograms, read them with "ebot prof show|reset|dump <file>",
+// the dump ends with the memory counters of memstats.h
+//
+// Timers are main thread only and cost two clock reads each. Build with EBOT_NO_PROFILER
+// defined to compile them out completely
+//
+// Engine calls made through our wrappers are counted against the innermost running scope
+// (the call site tag) and the bot being updated, see "ebot prof engine" and "ebot prof bots"
+//
+
+#pragma once
+
+#include <chrono>
+
+// everything we time, per process scopes follow the Process enum order
+enum ProfileScope : int
+{
+	Profile_Think,
+	Profile_AimBatch,
+	Profile_BaseUpdate,
+	Profile_Process,
+	Profile_ProcessLast = Profile_Process + 14,
+	Profile_FindPath,
+	Profile_FindShortestPath,
+	Profile_FindEscapePath,
+	Profile_FlowField,
+	Profile_RepairPath,
+	Profile_FindFriendsAndEnemiens,
+	Profile_CheckVisibility,
+	Profile_FindItem,
+	Profile_FindNearest,
+	Profile_Analyze,
+	Profile_NavAnalyze,
+	Profile_Count
+};
+
+// durations are bucketed in half octaves of nanoseconds, good enough for percentiles and tiny to merge
+constexpr int Const_ProfileBuckets = 64;
+constexpr int Const_ProfileSeconds = 10; // seconds kept for show and dump
+
+struct ProfileHistogram
+{
+	uint32_t buckets[Const_ProfileBuckets]{};
+	uint32_t calls{};
+	uint64_t total{}; // nanoseconds
+	uint64_t max{};
+};
+
+// engine functions we count, traces only cover the TraceLine and TraceHull wrappers of support.cpp
+enum EngineCall : int
+{
+	Engine_TraceLine,
+	Engine_TraceHull,
+	Engine_FindEntityByClassname,
+	Engine_FindEntityInSphere,
+	Engine_PointContents,
+	Engine_Count
+};
+
+struct EngineCallStats
+{
+	uint32_t calls{};
+	uint64_t total{}; // nanoseconds
+	uint32_t fractions[4]{}; // traces: started solid, blocked before half, blocked after half, clear
+	uint32_t hulls[4]{}; // TraceHull: point, human, large, head
+};
+
+// engine calls of one second, per call site tag and per bot
+struct EngineSecond
+{
+	EngineCallStats sites[Profile_Count + 1][Engine_Count]{}; // the last tag is "outside any scope"
+	uint32_t bots[32][Engine_Count]{};
+	uint32_t frames{};
+	uint32_t frameMax{}; // most engine calls we made in one frame
+};
+
+class Profiler
+{
+private:
+	ProfileHistogram m_current[Profile_Count]{}; // second being recorded
+	ProfileHistogram m_seconds[Const_ProfileSeconds][Profile_Count]{}; // last finished seconds, ring
+	ProfileHistogram m_total[Profile_Count]{}; // everything since the last reset
+	int m_head{}; // next slot of the ring
+	int m_filled{};
+	double m_secondEnd{};
+
+	EngineSecond m_engine{}; // second being recorded
+	EngineSecond m_engineLast{};
+	uint32_t m_frameCalls{};
+	FILE* m_stream{}; // ebot_prof_stream, rows are appended every second
+	char m_streamName[64]{};
+	int m_streamSecond{};
+
+	int m_scope{Profile_Count}; // innermost running scope, tags the engine calls
+	int m_bot{-1}; // slot of the bot being updated
+
+	void WriteStream(void);
+public:
+	static inline uint64_t Now(void)
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void Record(const int scope, const uint64_t duration);
+	void RecordEngine(const int call, const uint64_t duration, const float fraction = -1.0f, const bool startSolid = false, const int hull = -1);
+
+	inline int EnterScope(const int scope)
+	{
+		const int parent = m_scope;
+		m_scope = scope;
+		return parent;
+	}
+
+	inline void LeaveScope(const int parent) { m_scope = parent; }
+	inline int SetBot(const int slot)
+	{
+		const int previous = m_bot;
+		m_bot = slot;
+		return previous;
+	}
+
+	// closes the second once it's over, called every frame
+	void Update(void);
+	void Reset(void);
+	void Show(void);
+	void ShowEngine(void);
+	void ShowBots(void);
+	bool Dump(const char* fileName);
+	void CloseStream(void);
+};
+
+extern Profiler g_profiler;
+
+class ProfileTimer
+{
+private:
+	uint64_t m_start;
+	int m_scope;
+	int m_parent;
+public:
+	explicit ProfileTimer(const int scope) : m_start(Profiler::Now()), m_scope(scope), m_parent(g_profiler.EnterScope(scope)) { }
+	~ProfileTimer(void)
+	{
+		g_profiler.LeaveScope(m_parent);
+		g_profiler.Record(m_scope, Profiler::Now() - m_start);
+	}
+};
+
+// engine calls inside are charged to this bot
+class ProfileBot
+{
+private:
+	int m_previous;
+public:
+	explicit ProfileBot(const int slot) : m_previous(g_profiler.SetBot(slot)) { }
+	~ProfileBot(void) { g_profiler.SetBot(m_previous); }
+};
+
+#ifdef EBOT_NO_PROFILER
+#define PROFILE_SCOPE(scope)
+#define PROFILE_BOT(slot)
+#else
+#define PROFILE_SCOPE(scope) const ProfileTimer profileTimer(scope)
+#define PROFILE_BOT(slot) const ProfileBot profileBot(slot)
+
+// counted versions of the engine lookups, the call sites stay as they are
+extern edict_t* ProfileFindEntityByClassname(edict_t* start, const char* name);
+extern edict_t* ProfileFindEntityInSphere(edict_t* start, const float* origin, const float radius);
+extern int ProfilePointContents(const float* origin);
+
+#undef FIND_ENTITY_IN_SPHERE
+#undef POINT_CONTENTS
+#define FIND_ENTITY_BY_CLASSNAME ProfileFindEntityByClassname
+#define FIND_ENTITY_IN_SPHERE ProfileFindEntityInSphere
+#define POINT_CONTENTS ProfilePointContents
+#endif
@@ -0,0 +1,156 @@
+﻿//
+// Decision query recorder for E-Bot
+// "ebot record start <file>" writes path searches, nearest waypoint lookups and visibility lines with
+// their results to addons/ebot/<file>, ebot_navbench --replay <file> issues the same queries again
+//
+// Set ebot_random_seed to reseed the generators from the seed, the bot and the update before every
+// bot update, so a recorded round plays the same decisions on the next run
+//
+
+#pragma once
+
+constexpr uint32_t Const_RecordMagic = 0x43524245; // "EBRC"
+constexpr uint32_t Const_RecordVersion = 1;
+constexpr int Const_RecordBuffer = 65536;
+
+enum RecordType : uint8_t
+{
+	Record_Frame,
+	Record_Path,
+	Record_PathResult,
+	Record_Shortest,
+	Record_Escape,
+	Record_Nearest,
+	Record_Visibility,
+	Record_Count
+};
+
+// stream layout, a header then events, each event is a RecordEvent followed by its payload
+struct RecordHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t seed;
+	int32_t numWaypoints;
+	char mapName[32];
+};
+
+struct RecordEvent
+{
+	uint8_t type;
+	uint8_t slot; // bot index - 1, 255 if no bot
+	uint16_t size; // payload bytes
+};
+
+// one bot update cycle, the replay moves the clock with it
+struct RecordFrame
+{
+	float time;
+	uint32_t frame;
+};
+
+// a search as Bot::BeginPath got it, enough to run it again without the bot
+struct RecordPath
+{
+	Vector origin;
+	Vector deathOrigin;
+	int32_t seed;
+	int16_t srcIndex;
+	int16_t destIndex;
+	int16_t stuckIndex;
+	int8_t cost;
+	int8_t team;
+	uint8_t isZombie;
+	uint8_t hasHostage;
+	uint8_t hasEnemy; // enemy checks can't be replayed, counted only
+	uint8_t padding;
+};
+
+struct RecordPathResult
+{
+	int16_t length;
+	int16_t last;
+};
+
+struct RecordShortest
+{
+	int16_t srcIndex;
+	int16_t destIndex;
+};
+
+struct RecordEscape
+{
+	Vector dangerOrigin;
+	int16_t srcIndex;
+	int16_t padding;
+};
+
+struct RecordNearest
+{
+	Vector origin;
+	float minDistance;
+	int32_t flags;
+	int16_t mode;
+	int16_t result;
+	uint8_t hasEntity; // reachability checks need the entity, replayed without it
+	uint8_t padding[3];
+};
+
+struct RecordVisibility
+{
+	Vector start;
+	Vector end;
+	int8_t point;
+	uint8_t ignoreGlass;
+	uint8_t visible;
+	uint8_t padding;
+};
+
+static_assert(sizeof(RecordHeader) == 48, "record header must keep its layout");
+static_assert(sizeof(RecordPath) == 40, "record path must keep its layout");
+static_assert(sizeof(RecordNearest) == 28, "record nearest must keep its layout");
+static_assert(sizeof(RecordVisibility) == 28, "record visibility must keep its layout");
+
+class Recorder
+{
+private:
+	FILE* m_fp{};
+	uint8_t m_buffer[Const_RecordBuffer]{};
+	int m_used{};
+	uint32_t m_frame{};
+	uint32_t m_seed{};
+	uint32_t m_events{};
+	bool m_recording{};
+
+	void Write(const RecordType type, const int slot, const void* data, const int size);
+	void Flush(void);
+	void WriteNearest(const Vector& origin, const float minDistance, const int flags, const int mode, edict_t* entity, const int result);
+public:
+	bool Start(const char* fileName);
+	void Stop(void);
+	void Update(void);
+	void Show(void);
+
+	inline bool IsRecording(void) const { return m_recording; }
+
+	// 0 keeps the time seeded generators
+	uint32_t GetSeed(void) const;
+	void SeedBot(const int slot);
+
+	void Path(const int slot, const RecordPath& path);
+	void PathResult(const int slot, PathNode& path);
+	void Shortest(const int slot, const int srcIndex, const int destIndex);
+	void Escape(const int slot, const int srcIndex, const Vector& dangerOrigin);
+	void Visibility(const int slot, const VisPoint point, const Vector& start, const Vector& end, const bool ignoreGlass, const bool visible);
+
+	// passes the result through, so every return of Waypoint::FindNearest can be wrapped
+	inline int Nearest(const Vector& origin, const float minDistance, const int flags, const int mode, edict_t* entity, const int result)
+	{
+		if (m_recording)
+			WriteNearest(origin, minDistance, flags, mode, entity, result);
+
+		return result;
+	}
+};
+
+extern Recorder g_recorder;
@@ -1,18 +1,33 @@
 #include <ctime>
-static int g_seed = static_cast<int>(time(nullptr));
+
+// state is shared by every translation unit, so a seed set with csrand is seen everywhere
+extern int g_seed;
 inline int frand(void)
 {
-	g_seed = (214013 * g_seed + 2531011);
-	return (g_seed >> 16) & 32767;
+	g_seed = static_cast<int>(214013u * static_cast<uint32_t>(g_seed) + 2531011u);
+	return (static_cast<uint32_t>(g_seed) >> 16) & 32767;
 }
 
 // https://vigna.di.unimi.it/xorshift/xoroshiro128plus.c
 // modified version
-static uint_fast64_t s[2] = {static_cast<uint_fast64_t>(time(nullptr)), static_cast<uint_fast64_t>(time(nullptr) * 2)};
+extern uint_fast64_t g_rngState[2];
 inline uint_fast64_t fnext(void)
 {
-	s[1] ^= s[0];
-	s[0] = (s[0] << 55) | (s[0] >> 9) ^ s[1] ^ (s[1] << 14);
-	s[1] = (s[1] << 36) | (s[1] >> 28);
-	return s[0] + s[1];
+	g_rngState[1] ^= g_rngState[0];
+	g_rngState[0] = (g_rngState[0] << 55) | (g_rngState[0] >> 9) ^ g_rngState[1] ^ (g_rngState[1] << 14);
+	g_rngState[1] = (g_rngState[1] << 36) | (g_rngState[1] >> 28);
+	return g_rngState[0] + g_rngState[1];
+}
+
+// splitmix64 spreads the seed over both generators, xoroshiro must not start from zero
+inline void csrand(const uint32_t seed)
+{
+	uint_fast64_t mix = seed + 0x9E3779B97F4A7C15ull;
+	mix = (mix ^ (mix >> 30)) * 0xBF58476D1CE4E5B9ull;
+	mix = (mix ^ (mix >> 27)) * 0x94D049BB133111EBull;
+	mix ^= mix >> 31;
+
+	g_seed = static_cast<int>(mix);
+	g_rngState[0] = mix | 1;
+	g_rngState[1] = (mix * 0xD1342543DE82EF95ull) | 2;
 }
\ No newline at end of file
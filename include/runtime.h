@@ -739,14 +739,12 @@ public:
             checkSize = m_itemCount + m_resizeStep;
         else
         {
-            checkSize = m_itemCount / 8;
+            // grow by half, a capped step turned big arrays back into linear growth
+            checkSize = m_itemCount / 2;
 
             if (checkSize < 4)
                 checkSize = 4;
 
-            if (checkSize > 1024)
-                checkSize = 1024;
-
             checkSize += m_itemCount;
         }
 
@@ -46,12 +46,13 @@ ConVar ebot_eco_rounds("ebot_eco_rounds", "1");
 ConVar ebot_buy_weapons("ebot_buy_weapons", "1");
 ConVar ebot_prefer_better_pickup("ebot_prefer_better_pickup", "1");
 ConVar ebot_chatter_path("ebot_chatter_path", "radio/bot");
+ConVar ebot_think_lod_distance("ebot_think_lod_distance", "2048");
 
 // this function get the current message from the bots message queue
 int Bot::GetMessageQueue(void)
 {
-	const int message = m_messageQueue[m_actMessageIndex++];
-	m_actMessageIndex &= 0x1f; // wraparound
+	const int message = m_cold->messageQueue[m_cold->actMessageIndex++];
+	m_cold->actMessageIndex &= 0x1f; // wraparound
 	return message;
 }
 
@@ -72,8 +73,8 @@ void Bot::PushMessageQueue(const int message)
 			if (m_isAlive != bot->m_isAlive)
 				continue;
 
-			bot->m_sayTextBuffer.entityIndex = m_index;
-			cstrcpy(bot->m_sayTextBuffer.sayText, m_tempStrings);
+			bot->m_cold->sayTextBuffer.entityIndex = m_index;
+			cstrcpy(bot->m_cold->sayTextBuffer.sayText, m_cold->tempStrings);
 		}
 	}
 	else if (message == CMENU_BUY && g_gameVersion & Game::HalfLife)
@@ -85,8 +86,8 @@ void Bot::PushMessageQueue(const int message)
 		return;
 	}
 
-	m_messageQueue[m_pushMessageIndex++] = message;
-	m_pushMessageIndex &= 0x1f; // wraparound
+	m_cold->messageQueue[m_cold->pushMessageIndex++] = message;
+	m_cold->pushMessageIndex &= 0x1f; // wraparound
 }
 
 float Bot::InFieldOfView(const Vector& destination)
@@ -104,13 +105,57 @@ bool Bot::IsInViewCone(const Vector& origin)
 
 #define vis 0.98f
 #define edgeOffset 13.0f
+
+// bots think one after another inside the frame, so a cached line can be a frame old at most
+bool VisibilityCache::IsVisible(edict_t* viewer, edict_t* target, const VisPoint point, const Vector& start, const Vector& end, const bool ignoreGlass)
+{
+	const float time = engine->GetTime();
+	if (m_time != time)
+	{
+		m_time = time;
+		m_frame++;
+	}
+
+	const int self = ENTINDEX(viewer) - 1;
+	const int other = ENTINDEX(target) - 1;
+	const bool cached = self >= 0 && self < 32 && other >= 0 && other < 32;
+	const int type = static_cast<int>(point);
+	const int glass = ignoreGlass ? 1 : 0;
+
+	if (cached && (m_entry[self][other][type][glass] >> 1) == m_frame)
+	{
+		m_hits++;
+		return m_entry[self][other][type][glass] & 1;
+	}
+
+	m_misses++;
+
+	TraceResult tr{};
+	TraceLine(start, end, true, ignoreGlass, viewer, &tr);
+
+	// eye lines need a clear trace, body parts also count when the target itself was hit
+	const bool visible = point == VisPoint::Eyes ? tr.flFraction == 1.0f : (tr.flFraction > vis || tr.pHit == target);
+	if (g_recorder.IsRecording())
+		g_recorder.Visibility(self, point, start, end, ignoreGlass, visible);
+
+	if (cached)
+	{
+		m_entry[self][other][type][glass] = (m_frame << 1) | (visible ? 1 : 0);
+		if (point == VisPoint::Eyes)
+			m_entry[other][self][type][glass] = m_entry[self][other][type][glass];
+	}
+
+	return visible;
+}
+
 bool Bot::CheckVisibility(edict_t* targetEntity)
 {
+	PROFILE_SCOPE(Profile_CheckVisibility);
+
 	m_visibility = Visibility::None;
 	if (FNullEnt(targetEntity))
 		return false;
 
-	TraceResult tr{};
 	const Vector eyes = EyePosition();
 
 	Vector spot = targetEntity->v.origin;
@@ -121,9 +166,7 @@ bool Bot::CheckVisibility(edict_t* targetEntity)
 	if (m_isZombieBot)
 		ignoreGlass = false;
 
-	TraceLine(eyes, spot, true, ignoreGlass, self, &tr);
-
-	if (tr.flFraction > vis || tr.pHit == targetEntity)
+	if (g_visibilityCache.IsVisible(self, targetEntity, VisPoint::Body, eyes, spot, ignoreGlass))
 	{
 		m_visibility |= Visibility::Body;
 		m_enemyOrigin = spot;
@@ -132,9 +175,7 @@ bool Bot::CheckVisibility(edict_t* targetEntity)
 
 	// check top of head
 	spot.z += 25.0f;
-	TraceLine(eyes, spot, true, ignoreGlass, self, &tr);
-
-	if (tr.flFraction > vis || tr.pHit == targetEntity)
+	if (g_visibilityCache.IsVisible(self, targetEntity, VisPoint::Head, eyes, spot, ignoreGlass))
 	{
 		m_visibility |= Visibility::Head;
 		m_enemyOrigin = spot;
@@ -149,9 +190,7 @@ bool Bot::CheckVisibility(edict_t* targetEntity)
 	else
 		spot.z = targetEntity->v.origin.z - 34.0f;
 
-	TraceLine(eyes, spot, true, ignoreGlass, self, &tr);
-
-	if (tr.flFraction > vis || tr.pHit == targetEntity)
+	if (g_visibilityCache.IsVisible(self, targetEntity, VisPoint::Feet, eyes, spot, ignoreGlass))
 	{
 		m_visibility |= Visibility::Other;
 		m_enemyOrigin = spot;
@@ -162,9 +201,7 @@ bool Bot::CheckVisibility(edict_t* targetEntity)
 	const Vector perp(-dir.y, dir.x, 0.0f);
 	spot = targetEntity->v.origin + Vector(perp.x * edgeOffset, perp.y * edgeOffset, 0);
 
-	TraceLine(eyes, spot, true, ignoreGlass, self, &tr);
-
-	if (tr.flFraction > vis || tr.pHit == targetEntity)
+	if (g_visibilityCache.IsVisible(self, targetEntity, VisPoint::LeftEdge, eyes, spot, ignoreGlass))
 	{
 		m_visibility |= Visibility::Other;
 		m_enemyOrigin = spot;
@@ -172,9 +209,7 @@ bool Bot::CheckVisibility(edict_t* targetEntity)
 	}
 
 	spot = targetEntity->v.origin - Vector(perp.x * edgeOffset, perp.y * edgeOffset, 0);
-	TraceLine(eyes, spot, true, ignoreGlass, self, &tr);
-
-	if (tr.flFraction > vis || tr.pHit == targetEntity)
+	if (g_visibilityCache.IsVisible(self, targetEntity, VisPoint::RightEdge, eyes, spot, ignoreGlass))
 	{
 		m_visibility |= Visibility::Other;
 		m_enemyOrigin = spot;
@@ -232,20 +267,13 @@ bool Bot::IsBehindSmokeClouds(edict_t* ent)
 	if (FNullEnt(ent))
 		return false;
 
-	const char* classname;
+	int16_t i;
 	Vector entOrigin, pentOrigin, betweenUs, betweenNade, betweenResult;
-	edict_t* pentGrenade = nullptr;
-	while (!FNullEnt(pentGrenade = FIND_ENTITY_BY_CLASSNAME(pentGrenade, "grenade")))
+	edict_t* pentGrenade;
+	for (i = 0; i < g_worldSnapshot.m_smokes.Size(); i++)
 	{
-		classname = STRING(pentGrenade->v.model) + 9;
-		if (classname[0] != 's' || classname[1] != 'm')
-			continue;
-
-		if (charToInt(classname) != 1408)
-			continue;
-
-		// if grenade is invisible don't care for it
-		if (pentGrenade->v.effects & EF_NODRAW || !(pentGrenade->v.flags & (FL_ONGROUND | FL_PARTIALGROUND)))
+		pentGrenade = g_worldSnapshot.m_smokes[i];
+		if (pentGrenade->free)
 			continue;
 
 		entOrigin = GetEntityOrigin(ent);
@@ -266,7 +294,7 @@ bool Bot::IsBehindSmokeClouds(edict_t* ent)
 // this function returns the best weapon of this bot (based on personality prefs)
 int Bot::GetBestWeaponCarried(void)
 {
-	int* ptr = m_weaponPrefs;
+	int* ptr = m_cold->weaponPrefs;
 	int weaponIndex = 0;
 	int weapons = pev->weapons;
 
@@ -291,7 +319,7 @@ int Bot::GetBestWeaponCarried(void)
 // this function returns the best secondary weapon of this bot (based on personality prefs)
 int Bot::GetBestSecondaryWeaponCarried(void)
 {
-	int* ptr = m_weaponPrefs;
+	int* ptr = m_cold->weaponPrefs;
 	int weaponIndex = 0;
 	int weapons = pev->weapons;
 
@@ -326,7 +354,7 @@ bool Bot::RateGroundWeapon(edict_t* ent)
 
 	int hasWeapon = 0;
 	int groundIndex = 0;
-	int* ptr = m_weaponPrefs;
+	int* ptr = m_cold->weaponPrefs;
 	const WeaponSelect* weaponTab = &g_weaponSelect[0];
 
 	int i;
@@ -356,12 +384,14 @@ bool Bot::RateGroundWeapon(edict_t* ent)
 edict_t* Bot::FindButton(void)
 {
 	float nearestDistance = FLT_MAX, distance;
-	edict_t* searchEntity = nullptr, * foundEntity = nullptr;
+	edict_t* searchEntity, * foundEntity = nullptr;
 
 	// find the nearest button which can open our target
-	while (!FNullEnt(searchEntity = FIND_ENTITY_IN_SPHERE(searchEntity, pev->origin, 512.0f)))
+	int16_t i;
+	for (i = 0; i < g_worldSnapshot.m_buttons.Size(); i++)
 	{
-		if (cstrncmp("func_button", STRING(searchEntity->v.classname), 12) == 0 || cstrncmp("func_rot_button", STRING(searchEntity->v.classname), 16) == 0)
+		searchEntity = g_worldSnapshot.m_buttons[i];
+		if (!searchEntity->free && WorldSnapshot::InSphere(searchEntity, pev->origin, 512.0f))
 		{
 			distance = (pev->origin - GetEntityOrigin(searchEntity)).GetLengthSquared();
 			if (distance < nearestDistance)
@@ -391,6 +421,8 @@ bool Bot::AllowPickupItem(void)
 
 void Bot::FindItem(void)
 {
+	PROFILE_SCOPE(Profile_FindItem);
+
 	if (!AllowPickupItem())
 	{
 		m_pickupItem = nullptr;
@@ -399,11 +431,17 @@ void Bot::FindItem(void)
 	}
 
 	edict_t* ent = nullptr;
+	int16_t item;
+	MiniArray <edict_t*>& items = g_worldSnapshot.m_items;
 
 	if (!FNullEnt(m_pickupItem))
 	{
-		while (!FNullEnt(ent = FIND_ENTITY_IN_SPHERE(ent, pev->origin, 512.0f)))
+		for (item = 0; item < items.Size(); item++)
 		{
+			ent = items[item];
+			if (ent->free || !WorldSnapshot::InSphere(ent, pev->origin, 512.0f))
+				continue;
+
 			if (ent != m_pickupItem || ent->v.effects & EF_NODRAW || IsValidPlayer(ent->v.owner) || IsValidPlayer(ent))
 				continue; // someone owns this weapon or it hasn't re spawned yet
 
@@ -426,8 +464,12 @@ void Bot::FindItem(void)
 	Vector entityOrigin;
 	int i, i2;
 
-	while (!FNullEnt(ent = FIND_ENTITY_IN_SPHERE(ent, pev->origin, 512.0f)))
+	for (item = 0; item < items.Size(); item++)
 	{
+		ent = items[item];
+		if (ent->free || !WorldSnapshot::InSphere(ent, pev->origin, 512.0f))
+			continue;
+
 		pickupType = PickupType::None;
 		if (ent->v.effects & EF_NODRAW || ent == m_itemIgnore || IsValidPlayer(ent) || ent == GetEntity()) // we can't pickup a player...
 			continue;
@@ -841,7 +883,7 @@ void Bot::PlayChatterMessage(const ChatterMessage& message)
 // this function checks and executes pending messages
 void Bot::CheckMessageQueue(void)
 {
-	if (m_actMessageIndex == m_pushMessageIndex)
+	if (m_cold->actMessageIndex == m_cold->pushMessageIndex)
 		return;
 
 	// get message from stack
@@ -1016,7 +1058,7 @@ void Bot::CheckMessageQueue(void)
 	} // team independent saytext
 	case CMENU_SAY:
 	{
-		ChatSay(false, m_tempStrings);
+		ChatSay(false, m_cold->tempStrings);
 		break;
 	} // team dependent saytext
 	case CMENU_TEAMSAY:
@@ -1024,7 +1066,7 @@ void Bot::CheckMessageQueue(void)
 		if (GetGameMode() == GameMode::Original || g_gameVersion & Game::CStrike)
 			break;
 
-		ChatSay(true, m_tempStrings);
+		ChatSay(true, m_cold->tempStrings);
 		break;
 	}
 	}
@@ -1059,11 +1101,11 @@ void Bot::PerformWeaponPurchase(void)
 	{
 	case 0:
 	{
-		if (!m_favoritePrimary.IsEmpty() && !HasPrimaryWeapon() && !HasShield())
+		if (!m_cold->favoritePrimary.IsEmpty() && !HasPrimaryWeapon() && !HasShield())
 		{
 			int i, id;
 			char* name;
-			for (i = 0; i < m_favoritePrimary.Size(); i++)
+			for (i = 0; i < m_cold->favoritePrimary.Size(); i++)
 			{
 				if (HasPrimaryWeapon())
 				{
@@ -1074,7 +1116,7 @@ void Bot::PerformWeaponPurchase(void)
 				if (HasShield())
 					break;
 
-				name = m_favoritePrimary.Get(i);
+				name = m_cold->favoritePrimary.Get(i);
 				if (IsNullString(name))
 					continue;
 
@@ -1105,11 +1147,11 @@ void Bot::PerformWeaponPurchase(void)
 	}
 	case 2:
 	{
-		if (!m_favoriteSecondary.IsEmpty() && !HasSecondaryWeapon() && (HasPrimaryWeapon() || HasShield()))
+		if (!m_cold->favoriteSecondary.IsEmpty() && !HasSecondaryWeapon() && (HasPrimaryWeapon() || HasShield()))
 		{
 			int i, id;
 			char* name;
-			for (i = 0; i < m_favoriteSecondary.Size(); i++)
+			for (i = 0; i < m_cold->favoriteSecondary.Size(); i++)
 			{
 				if (HasSecondaryWeapon())
 				{
@@ -1117,7 +1159,7 @@ void Bot::PerformWeaponPurchase(void)
 					break;
 				}
 
-				name = m_favoriteSecondary.Get(i);
+				name = m_cold->favoriteSecondary.Get(i);
 				if (IsNullString(name))
 					continue;
 
@@ -1205,12 +1247,12 @@ void Bot::PerformWeaponPurchase(void)
 		else
 			FakeClientCommand(GetEntity(), "buy;menuselect 6");
 
-		if (!m_favoriteStuff.IsEmpty())
+		if (!m_cold->favoriteStuff.IsEmpty())
 		{
 			char* name;
-			for (i = 0; i < m_favoriteStuff.Size(); i++)
+			for (i = 0; i < m_cold->favoriteStuff.Size(); i++)
 			{
-				name = m_favoriteStuff.Get(i);
+				name = m_cold->favoriteStuff.Get(i);
 				if (IsNullString(name))
 					continue;
 
@@ -1433,33 +1475,31 @@ bool Bot::IsEnemyReachable(void)
 
 bool Bot::IsEnemyReachableToPosition(const Vector& origin)
 {
-	TraceResult tr{};
-	for (const auto& client : g_clients)
-	{
-		if (client.ent == pev->pContainingEntity)
-			continue;
-
-		if (client.team == m_team)
-			continue;
+	const uint32_t enemies = g_clientSnapshot.m_alive & ~g_clientSnapshot.GetTeamMask(m_team) & ~(1u << (m_index - 1));
+	uint32_t near = g_clientSnapshot.GetInRadius(origin, squaredf(192.0f), enemies, 0.54f);
+	if (!near)
+		return false;
 
-		if (!IsAlive(client.ent))
-			continue;
+	// ducking against ducking, diff 2
+	if (pev->flags & FL_DUCKING)
+		near = (near & ~g_clientSnapshot.m_ducking) | g_clientSnapshot.GetInRadius(origin, squaredf(128.0f), near & g_clientSnapshot.m_ducking, 0.54f);
 
-		if (pev->flags & FL_DUCKING && client.ent->v.flags & FL_DUCKING) // diff 2
-		{
-			if ((origin - (client.ent->v.origin + client.ent->v.velocity * 0.54f)).GetLengthSquared() > squaredf(128.0f))
-				continue;
-		}
-		else if ((origin - (client.ent->v.origin + client.ent->v.velocity * 0.54f)).GetLengthSquared() > squaredf(192.0f))
+	int i;
+	Vector enemyOrigin;
+	TraceResult tr{};
+	for (i = 0; near; i++, near >>= 1)
+	{
+		if (!(near & 1u))
 			continue;
 
+		enemyOrigin = g_clientSnapshot.GetOrigin(i);
 		if (pev->waterlevel < 2)
 		{
-			if (client.ent->v.origin.z > (origin.z + 62.0f) || client.ent->v.origin.z < (origin.z - 100.0f))
+			if (enemyOrigin.z > (origin.z + 62.0f) || enemyOrigin.z < (origin.z - 100.0f))
 				continue;
 		}
 
-		TraceHull(origin, client.ent->v.origin, true, head_hull, pev->pContainingEntity, &tr);
+		TraceHull(origin, enemyOrigin, true, head_hull, pev->pContainingEntity, &tr);
 
 		// don't take a risk
 		if (tr.fAllSolid)
@@ -1475,7 +1515,7 @@ bool Bot::IsEnemyReachableToPosition(const Vector& origin)
 
 			if (GetTeam(tr.pHit) != m_team)
 			{
-				if (!IsDeadlyDrop(((origin + client.ent->v.origin)) * 0.5f))
+				if (!IsDeadlyDrop(((origin + enemyOrigin)) * 0.5f))
 					return true;
 				else if (tr.flFraction == 1.0f)
 				{
@@ -1487,7 +1527,7 @@ bool Bot::IsEnemyReachableToPosition(const Vector& origin)
 			}
 		}
 
-		if (tr.flFraction == 1.0f && (!tr.fInWater || !IsDeadlyDrop(((origin + client.ent->v.origin)) * 0.5f)))
+		if (tr.flFraction == 1.0f && (!tr.fInWater || !IsDeadlyDrop(((origin + enemyOrigin)) * 0.5f)))
 			return true;
 	}
 
@@ -1969,6 +2009,10 @@ bool Bot::IsNotAttackLab(edict_t* entity)
 
 void Bot::BaseUpdate(void)
 {
+	PROFILE_SCOPE(Profile_BaseUpdate);
+	PROFILE_BOT(m_index - 1);
+	g_recorder.SeedBot(m_index - 1);
+
 	// i'm really tired of getting random pev is nullptr debug logs...
 	// might seems ugly and useless, but... i have made some experiments with it,
 	// still not sure exactly why, but bad third party server plugins can cause this
@@ -1992,14 +2036,10 @@ void Bot::BaseUpdate(void)
 		StartGame();
 	else
 	{
-		if (m_slowthinktimer > time)
-			m_isSlowThink = false;
-		else
+		UpdateThinkSchedule();
+		if (m_isSlowThink)
 		{
-			m_isSlowThink = true;
 			CheckSlowThink();
-			m_slowthinktimer = time + crandomfloat(0.9f, 1.1f);
-
 			if (!m_isAlive)
 			{
 				if (!g_isFakeCommand)
@@ -2023,9 +2063,9 @@ void Bot::BaseUpdate(void)
 							bool sayBufferExists = false;
 
 							// search for last messages, sayed
-							ITERATE_ARRAY(m_sayTextBuffer.lastUsedSentences, i)
+							ITERATE_ARRAY(m_cold->sayTextBuffer.lastUsedSentences, i)
 							{
-								if (cstrncmp(m_sayTextBuffer.lastUsedSentences[i], pickedPhrase, m_sayTextBuffer.lastUsedSentences[i].GetLength()) == 0)
+								if (cstrncmp(m_cold->sayTextBuffer.lastUsedSentences[i], pickedPhrase, m_cold->sayTextBuffer.lastUsedSentences[i].GetLength()) == 0)
 									sayBufferExists = true;
 							}
 
@@ -2035,12 +2075,12 @@ void Bot::BaseUpdate(void)
 								PushMessageQueue(CMENU_SAY);
 
 								// add to ignore list
-								m_sayTextBuffer.lastUsedSentences.Push(pickedPhrase);
+								m_cold->sayTextBuffer.lastUsedSentences.Push(pickedPhrase);
 							}
 
 							// clear the used line buffer every now and then
-							if (m_sayTextBuffer.lastUsedSentences.GetElementNumber() > crandomint(4, 6))
-								m_sayTextBuffer.lastUsedSentences.Destroy();
+							if (m_cold->sayTextBuffer.lastUsedSentences.GetElementNumber() > crandomint(4, 6))
+								m_cold->sayTextBuffer.lastUsedSentences.Destroy();
 						}
 					}
 
@@ -2084,6 +2124,60 @@ void Bot::BaseUpdate(void)
 	m_frameDelay = time;
 }
 
+// bots far from every human think less, but never when they fight
+int Bot::GetThinkLevel(void)
+{
+	const float lodDistance = ebot_think_lod_distance.GetFloat();
+	if (lodDistance <= 0.0f)
+		return 0;
+
+	// spectators count too, their origin follows whoever they watch
+	float distance, nearest = FLT_MAX;
+	for (const auto& client : g_clients)
+	{
+		if (!(client.flags & CFLAG_USED) || FNullEnt(client.ent) || client.ent->v.flags & FL_FAKECLIENT)
+			continue;
+
+		distance = (client.ent->v.origin - pev->origin).GetLengthSquared();
+		if (distance < nearest)
+			nearest = distance;
+	}
+
+	if (nearest < squaredf(lodDistance))
+		return 0;
+
+	if (nearest < squaredf(lodDistance * 2.0f))
+		return 1;
+
+	return 2;
+}
+
+// spreads the expensive updates of all bots over the frames, movement still runs on every tick
+void Bot::UpdateThinkSchedule(void)
+{
+	const uint32_t frame = g_botManager->GetThinkFrame() + static_cast<uint32_t>(m_index);
+	const float time = engine->GetTime();
+
+	// slow think once per second near humans, up to every two seconds far away, each bot at its own offset
+	// timed in seconds, the governor lowers the think rate and that must not stretch it
+	if (m_slowThinkTime <= 0.0f || m_slowThinkTime - time > 2.0f)
+		m_slowThinkTime = time + static_cast<float>(m_index & 31) / 32.0f;
+
+	m_isSlowThink = m_slowThinkTime <= time;
+	if (m_isSlowThink)
+	{
+		m_thinkLevel = static_cast<int8_t>(GetThinkLevel());
+		m_slowThinkTime = time + 1.0f + 0.5f * static_cast<float>(m_thinkLevel);
+	}
+
+	// sensing runs every 1st, 2nd or 4th frame, the governor pushes everyone down when the server is busy
+	const int level = cmin(m_thinkLevel + g_frameGovernor.GetLevelBias(), 2);
+	if (!level || m_hasEnemiesNear || m_currentProcess == Process::Attack || m_currentProcess == Process::Escape)
+		m_isSenseThink = true;
+	else
+		m_isSenseThink = !(frame & ((1u << level) - 1u));
+}
+
 void Bot::CheckSlowThink(void)
 {
 	CalculatePing();
@@ -2237,6 +2331,8 @@ void Bot::UpdateLooking(void)
 
 	if (m_hasEnemiesNear || m_hasEntitiesNear)
 	{
+		// FireWeapon traces along v_angle, so it can't wait for the batch
+		g_aimBatch.Flush(this);
 		LookAtEnemies();
 		FireWeapon();
 		return;
@@ -2611,6 +2707,9 @@ void Bot::LookAtAround(void)
 
 	auto isVisible = [&](void)
 	{
+		if (g_waypoint->HasVisibility() && IsValidWaypoint(m_currentWaypointIndex))
+			return g_waypoint->IsVisibleWaypoint(m_currentWaypointIndex, index, (pev->flags & FL_DUCKING) != 0);
+
 		TraceResult tr{};
 		TraceLine(EyePosition(), selectRandom, true, true, pev->pContainingEntity, &tr);
 		if (tr.flFraction == 1.0f)
@@ -2670,20 +2769,7 @@ void Bot::CalculatePing(void)
 	else if (botPing > 133)
 		botPing = crandomint(99, 119);
 
-	int j;
-	for (j = 0; j < 2; j++)
-	{
-		for (m_pingOffset[j] = 0; m_pingOffset[j] < 4; m_pingOffset[j]++)
-		{
-			if (!((botPing - m_pingOffset[j]) % 4))
-			{
-				m_ping[j] = (botPing - m_pingOffset[j]) * 0.25f;
-				break;
-			}
-		}
-	}
-
-	m_ping[2] = botPing;
+	m_ping = botPing;
 }
 
 void Bot::MoveAction(void)
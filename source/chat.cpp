@@ -112,7 +112,7 @@ void StripTags(char* buffer)
 char* HumanizeName(char* name)
 {
     static char outputName[32]{}; // create return name buffer
-    cstrncpy(outputName, name, sizeof(outputName)); // copy name to new buffer
+    cstrncpy(outputName, name, sizeof(outputName) - 1); // copy name to new buffer
 
     // drop tag marks, 75 percent of time
     if (chanceof(75))
@@ -178,7 +178,7 @@ void Bot::PrepareChatMessage(char* text)
     if (IsNullString(text))
         return;
 
-    cmemset(&m_tempStrings, 0, sizeof(m_tempStrings));
+    cmemset(&m_cold->tempStrings, 0, sizeof(m_cold->tempStrings));
 
     char* textStart = text;
     char* pattern = text;
@@ -193,7 +193,7 @@ void Bot::PrepareChatMessage(char* text)
         {
             const int length = pattern - textStart;
             if (length)
-                cstrncpy(m_tempStrings, textStart, length);
+                cstrncpy(m_cold->tempStrings, textStart, length);
 
             pattern++;
 
@@ -221,25 +221,25 @@ void Bot::PrepareChatMessage(char* text)
 
                 talkEntity = entity;
                 if (!FNullEnt(talkEntity))
-                    cstrcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                    cstrcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
             }
             // mapname?
             else if (*pattern == 'm')
-                cstrcat(m_tempStrings, GetMapName());
+                cstrcat(m_cold->tempStrings, GetMapName());
             // roundtime?
             else if (*pattern == 'r')
             {
                 const int time = static_cast<int>(g_timeRoundEnd - engine->GetTime());
                 char buffer[32];
                 FormatBuffer(buffer, "%02d:%02d", time / 60, time % 60);
-                cstrcat(m_tempStrings, buffer);
+                cstrcat(m_cold->tempStrings, buffer);
             }
             // chat reply?
             else if (*pattern == 's')
             {
-                talkEntity = INDEXENT(m_sayTextBuffer.entityIndex);
+                talkEntity = INDEXENT(m_cold->sayTextBuffer.entityIndex);
                 if (!FNullEnt(talkEntity))
-                    strcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                    strcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
             }
             // teammate alive?
             else if (*pattern == 't')
@@ -266,7 +266,7 @@ void Bot::PrepareChatMessage(char* text)
                         talkEntity = entity;
 
                     if (!FNullEnt(talkEntity))
-                        cstrcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                        cstrcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
                 }
                 else // no teammates alive...
                 {
@@ -287,7 +287,7 @@ void Bot::PrepareChatMessage(char* text)
                         talkEntity = entity;
 
                         if (!FNullEnt(talkEntity))
-                            cstrcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                            cstrcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
                     }
                 }
             }
@@ -312,7 +312,7 @@ void Bot::PrepareChatMessage(char* text)
                     talkEntity = entity;
 
                     if (!FNullEnt(talkEntity))
-                        cstrcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                        cstrcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
                 }
                 else // no teammates alive...
                 {
@@ -333,7 +333,7 @@ void Bot::PrepareChatMessage(char* text)
                         talkEntity = entity;
 
                         if (!FNullEnt(talkEntity))
-                            cstrcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                            cstrcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
                     }
                 }
             }
@@ -342,32 +342,32 @@ void Bot::PrepareChatMessage(char* text)
                 if (g_gameVersion & Game::CZero)
                 {
                     if (crandomint(1, 10) < 4)
-                        cstrcat(m_tempStrings, "cscz");
+                        cstrcat(m_cold->tempStrings, "cscz");
                     else
-                        cstrcat(m_tempStrings, "Condition Zero");
+                        cstrcat(m_cold->tempStrings, "Condition Zero");
                 }
                 else if (g_gameVersion & Game::CStrike)
                 {
                     if (crandomint(1, 10) < 4)
-                        cstrcat(m_tempStrings, "cs 1.6");
+                        cstrcat(m_cold->tempStrings, "cs 1.6");
                     else
-                        cstrcat(m_tempStrings, "Counter-Strike");
+                        cstrcat(m_cold->tempStrings, "Counter-Strike");
                 }
                 else if (g_gameVersion & Game::HalfLife)
                 {
                     if (crandomint(1, 10) < 4)
-                        cstrcat(m_tempStrings, "hl");
+                        cstrcat(m_cold->tempStrings, "hl");
                     else
-                        cstrcat(m_tempStrings, "Half-Life");
+                        cstrcat(m_cold->tempStrings, "Half-Life");
                 }
                 else
-                    cstrcat(m_tempStrings, "this game");
+                    cstrcat(m_cold->tempStrings, "this game");
             }
             else if (*pattern == 'v')
             {
                 talkEntity = m_nearestEnemy;
                 if (!FNullEnt(talkEntity))
-                    cstrcat(m_tempStrings, HumanizeName(GetEntityName(talkEntity)));
+                    cstrcat(m_cold->tempStrings, HumanizeName(GetEntityName(talkEntity)));
             }
 
             pattern++;
@@ -380,7 +380,200 @@ void Bot::PrepareChatMessage(char* text)
     cstrncpy(tempString, textStart, 159);
 
     HumanizeChat(tempString);
-    cstrcat(m_tempStrings, tempString);
+    cstrcat(m_cold->tempStrings, tempString);
+}
+
+void KeywordMatcher::Destroy(void)
+{
+    safedel(m_delta);
+    safedel(m_dict);
+    safedel(m_firstKeyword);
+    safedel(m_nextKeyword);
+    safedel(m_keywordGroup);
+    safedel(m_keywordStamp);
+    safedel(m_groupStamp);
+    safedel(m_groupHits);
+    m_numClasses = 0;
+    m_numNodes = 0;
+    m_numKeywords = 0;
+    m_numGroups = 0;
+    m_stamp = 0;
+    m_bytes = 0;
+}
+
+void KeywordMatcher::Build(Array <KwChat>& groups)
+{
+    Destroy();
+
+    // only bytes that some keyword uses get their own column
+    cmemset(m_classOf, 0, sizeof(m_classOf));
+    m_numClasses = 1;
+
+    int i, j, k, total = 1;
+    const char* keyword;
+    for (i = 0; i < groups.GetElementNumber(); i++)
+    {
+        KwChat& group = groups[i];
+        group.usedReplies.RemoveAll();
+        for (j = 0; j < group.replies.GetElementNumber(); j++)
+            group.usedReplies.Push(false);
+
+        group.numUsed = 0;
+
+        for (j = 0; j < group.keywords.GetElementNumber(); j++)
+        {
+            for (keyword = group.keywords[j]; *keyword; keyword++)
+            {
+                if (!m_classOf[static_cast<uint8_t>(*keyword)])
+                    m_classOf[static_cast<uint8_t>(*keyword)] = static_cast<uint8_t>(m_numClasses++);
+
+                total++;
+            }
+
+            m_numKeywords++;
+        }
+    }
+
+    m_numGroups = groups.GetElementNumber();
+    if (!m_numKeywords)
+        return;
+
+    safeloc(m_delta, total * m_numClasses);
+    safeloc(m_dict, total);
+    safeloc(m_firstKeyword, total);
+    safeloc(m_nextKeyword, m_numKeywords);
+    safeloc(m_keywordGroup, m_numKeywords);
+    safeloc(m_keywordStamp, m_numKeywords);
+    safeloc(m_groupStamp, m_numGroups);
+    safeloc(m_groupHits, m_numGroups);
+    m_bytes = static_cast<size_t>(total) * (m_numClasses + 2) * sizeof(int32_t) + static_cast<size_t>(m_numKeywords) * (sizeof(int32_t) + sizeof(int16_t) + sizeof(uint32_t)) + static_cast<size_t>(m_numGroups) * (sizeof(uint32_t) + sizeof(int16_t));
+
+    for (i = 0; i < total * m_numClasses; i++)
+        m_delta[i] = -1;
+
+    for (i = 0; i < total; i++)
+        m_firstKeyword[i] = -1;
+
+    // plain trie first
+    int node;
+    int32_t* next;
+    m_numNodes = 1;
+    k = 0;
+    for (i = 0; i < groups.GetElementNumber(); i++)
+    {
+        for (j = 0; j < groups[i].keywords.GetElementNumber(); j++)
+        {
+            node = 0;
+            for (keyword = groups[i].keywords[j]; *keyword; keyword++)
+            {
+                next = &m_delta[node * m_numClasses + m_classOf[static_cast<uint8_t>(*keyword)]];
+                if (*next < 0)
+                    *next = m_numNodes++;
+
+                node = *next;
+            }
+
+            m_keywordGroup[k] = static_cast<int16_t>(i);
+            m_nextKeyword[k] = m_firstKeyword[node];
+            m_firstKeyword[node] = k;
+            k++;
+        }
+    }
+
+    // then breadth first, filling the missing moves from the failure links
+    int32_t* fail = safeloc<int32_t>(m_numNodes);
+    int32_t* queue = safeloc<int32_t>(m_numNodes);
+    int head = 0, tail = 0, child, failure;
+    queue[tail++] = 0;
+    m_dict[0] = -1;
+
+    while (head < tail)
+    {
+        node = queue[head++];
+        for (i = 0; i < m_numClasses; i++)
+        {
+            child = m_delta[node * m_numClasses + i];
+            if (node && child < 0)
+            {
+                m_delta[node * m_numClasses + i] = m_delta[fail[node] * m_numClasses + i];
+                continue;
+            }
+
+            if (!node && child < 0)
+            {
+                m_delta[i] = 0;
+                continue;
+            }
+
+            failure = node ? m_delta[fail[node] * m_numClasses + i] : 0;
+            fail[child] = failure;
+            m_dict[child] = m_firstKeyword[failure] >= 0 ? failure : m_dict[failure];
+            queue[tail++] = child;
+        }
+    }
+
+    safedel(fail);
+    safedel(queue);
+}
+
+int KeywordMatcher::Match(const char* text, int16_t* groups, int16_t* hits, const int maxGroups)
+{
+    if (!m_numNodes || IsNullString(text))
+        return 0;
+
+    m_stamp++;
+    if (!m_stamp)
+    {
+        cmemset(m_keywordStamp, 0, m_numKeywords * sizeof(uint32_t));
+        cmemset(m_groupStamp, 0, m_numGroups * sizeof(uint32_t));
+        m_stamp = 1;
+    }
+
+    int found = 0, state = 0, node, k, group;
+    for (; *text; text++)
+    {
+        state = m_delta[state * m_numClasses + m_classOf[static_cast<uint8_t>(*text)]];
+        for (node = m_firstKeyword[state] >= 0 ? state : m_dict[state]; node >= 0; node = m_dict[node])
+        {
+            for (k = m_firstKeyword[node]; k >= 0; k = m_nextKeyword[k])
+            {
+                // a keyword counts once however often it occurs
+                if (m_keywordStamp[k] == m_stamp)
+                    continue;
+
+                m_keywordStamp[k] = m_stamp;
+                group = m_keywordGroup[k];
+                if (m_groupStamp[group] != m_stamp)
+                {
+                    if (found >= maxGroups)
+                        continue;
+
+                    m_groupStamp[group] = m_stamp;
+                    m_groupHits[group] = 0;
+                    groups[found++] = static_cast<int16_t>(group);
+                }
+
+                m_groupHits[group]++;
+            }
+        }
+    }
+
+    // groups keep their order from the chat file, the first one listed wins
+    int i, j;
+    int16_t temp;
+    for (i = 1; i < found; i++)
+    {
+        temp = groups[i];
+        for (j = i - 1; j >= 0 && groups[j] > temp; j--)
+            groups[j + 1] = groups[j];
+
+        groups[j + 1] = temp;
+    }
+
+    for (i = 0; i < found; i++)
+        hits[i] = m_groupHits[groups[i]];
+
+    return found;
 }
 
 // this function checks is string contain keyword, and generates relpy to it
@@ -413,36 +606,37 @@ bool CheckKeywords(char* tempMessage, char* reply)
         getChatTimer = engine->GetTime() + 2.0f;
     }*/
 
-    int16_t i, j, k;
-    bool replyUsed;
-    for (i = 0; i < g_replyFactory.GetElementNumber(); i++)
+    int16_t groups[64], hits[64];
+    const int found = g_keywordMatcher.Match(tempMessage, groups, hits, 64);
+
+    int i, j, index, numReplies;
+    for (i = 0; i < found; i++)
     {
-        for (j = 0; j < g_replyFactory[i].keywords.GetElementNumber(); j++)
+        KwChat& group = g_replyFactory[groups[i]];
+        numReplies = group.replies.GetElementNumber();
+        if (group.usedReplies.GetElementNumber() != numReplies)
+            continue;
+
+        // one draw for every keyword of the group that has occurred in message
+        for (j = 0; j < hits[i]; j++)
         {
-            // check is keyword has occurred in message
-            if (cstrstr(tempMessage, g_replyFactory[i].keywords[j]))
+            if (group.numUsed >= numReplies / 2)
             {
-                if (g_replyFactory[i].usedReplies.GetElementNumber() >= g_replyFactory[i].replies.GetElementNumber() / 2)
-                    g_replyFactory[i].usedReplies.RemoveAll();
+                for (index = 0; index < numReplies; index++)
+                    group.usedReplies[index] = false;
 
-                replyUsed = false;
-                String& generatedReply = g_replyFactory[i].replies.GetRandomElement();
+                group.numUsed = 0;
+            }
 
-                // don't say this twice
-                for (k = 0; k < g_replyFactory[i].usedReplies.GetElementNumber(); k++)
-                {
-                    if (cstrstr(g_replyFactory[i].usedReplies[k], generatedReply))
-                        replyUsed = true;
-                }
+            // don't say this twice
+            index = crandomint(0, numReplies - 1);
+            if (group.usedReplies[index])
+                continue;
 
-                // reply not used, so use it
-                if (!replyUsed)
-                {
-                    cstrcpy(reply, generatedReply); // update final buffer
-                    g_replyFactory[i].usedReplies.Push(generatedReply); // add to ignore list
-                    return true;
-                }
-            }
+            cstrcpy(reply, group.replies[index]); // update final buffer
+            group.usedReplies[index] = true; // add to ignore list
+            group.numUsed++;
+            return true;
         }
     }
 
@@ -460,7 +654,7 @@ bool CheckKeywords(char* tempMessage, char* reply)
 bool Bot::ParseChat(char* reply)
 {
     char tempMessage[512];
-    cstrcpy(tempMessage, m_sayTextBuffer.sayText); // copy to safe place
+    cstrcpy(tempMessage, m_cold->sayTextBuffer.sayText); // copy to safe place
 
     int i;
     const int maxLength = cstrlen(tempMessage);
@@ -475,27 +669,27 @@ bool Bot::ParseChat(char* reply)
 // this function sends reply to a player
 bool Bot::RepliesToPlayer(void)
 {
-    if (m_sayTextBuffer.entityIndex && m_sayTextBuffer.entityIndex != m_index && !IsNullString(m_sayTextBuffer.sayText))
+    if (m_cold->sayTextBuffer.entityIndex && m_cold->sayTextBuffer.entityIndex != m_index && !IsNullString(m_cold->sayTextBuffer.sayText))
     {
         // check is time to chat is good
-        if (m_sayTextBuffer.timeNextChat < engine->GetTime())
+        if (m_cold->sayTextBuffer.timeNextChat < engine->GetTime())
         {
-            if (crandomint(1, 100) < (m_sayTextBuffer.chatProbability + crandomint(2, 10)))
+            if (crandomint(1, 100) < (m_cold->sayTextBuffer.chatProbability + crandomint(2, 10)))
             {
                 char text[256];
                 if (ParseChat(text))
                 {
                     PrepareChatMessage(text);
                     PushMessageQueue(CMENU_SAY);
-                    m_sayTextBuffer.entityIndex = 0;
-                    m_sayTextBuffer.sayText[0] = 0;
-                    m_sayTextBuffer.timeNextChat = engine->GetTime() + m_sayTextBuffer.chatDelay;
+                    m_cold->sayTextBuffer.entityIndex = 0;
+                    m_cold->sayTextBuffer.sayText[0] = 0;
+                    m_cold->sayTextBuffer.timeNextChat = engine->GetTime() + m_cold->sayTextBuffer.chatDelay;
                     return true;
                 }
             }
 
-            m_sayTextBuffer.entityIndex = 0;
-            m_sayTextBuffer.sayText[0] = 0;
+            m_cold->sayTextBuffer.entityIndex = 0;
+            m_cold->sayTextBuffer.sayText[0] = 0;
         }
     }
 
@@ -47,6 +47,11 @@ float catan2f(const float x, const float y)
 	return _mm_cvtss_f32(atan2_ps(_mm_load_ss(&x), _mm_load_ss(&y)));
 }
 
+void catan2f4(const float* y, const float* x, float* result)
+{
+	_mm_store_ps(result, atan2_ps(_mm_load_ps(y), _mm_load_ps(x)));
+}
+
 float ctanf(const float value)
 {
 	return _mm_cvtss_f32(tan_ps(_mm_load_ss(&value)));
@@ -28,39 +28,94 @@ ConVar ebot_escape("ebot_zombie_escape_mode", "0");
 ConVar ebot_zp_use_grenade_percent("ebot_zm_use_grenade_percent", "10");
 ConVar ebot_zp_escape_distance("ebot_zm_escape_distance", "200");
 ConVar ebot_zombie_speed_factor("ebot_zombie_speed_factor", "0.54");
+ConVar ebot_max_view_distance("ebot_max_view_distance", "0");
+ConVar ebot_debug_cull("ebot_debug_cull", "0");
 
 int Bot::GetNearbyFriendsNearPosition(const Vector& origin, const float radius)
 {
-	int count = 0;
-	for (const auto& client : g_clients)
-	{
-		if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || client.team != m_team || client.ent == pev->pContainingEntity)
-			continue;
+	const uint32_t mask = g_clientSnapshot.GetTeamMask(m_team) & ~(1u << (m_index - 1));
+	return cpopcount(g_clientSnapshot.GetInRadius(origin, radius, mask));
+}
 
-		if ((client.origin, origin).GetLengthSquared() < radius)
-			count++;
-	}
+int Bot::GetNearbyEnemiesNearPosition(const Vector& origin, const float radius)
+{
+	const uint32_t mask = g_clientSnapshot.m_alive & ~g_clientSnapshot.GetTeamMask(m_team);
+	return cpopcount(g_clientSnapshot.GetInRadius(origin, radius, mask));
+}
+
+static const char* s_cullNames[] =
+{
+	"accepted",
+	"not in pvs",
+	"too far",
+	"outside view cone",
+	"not attackable",
+	"hidden",
+	"behind smoke"
+};
+
+// prints the spectated bot's decision for a target whenever it changes
+void Bot::DebugCull(const edict_t* target, const CullReason reason)
+{
+	const int index = ENTINDEX(const_cast<edict_t*>(target)) - 1;
+	if (index < 0 || index >= 32 || m_cullReason[index] == static_cast<int8_t>(reason))
+		return;
 
-	return count;
+	m_cullReason[index] = static_cast<int8_t>(reason);
+	if (!ebot_debug_cull.GetBool() || (!FNullEnt(g_hostEntity) && g_hostEntity->v.iuser2 != m_index))
+		return;
+
+	ServerPrintNoTag("%s -> %s: %s", GetEntityName(GetEntity()), GetEntityName(const_cast<edict_t*>(target)), s_cullNames[static_cast<int>(reason)]);
 }
 
-int Bot::GetNearbyEnemiesNearPosition(const Vector& origin, const float radius)
+// cheap rejection before any trace, pvs from the engine, then distance and the view cone
+CullReason Bot::CullTarget(edict_t* target, const Vector& headOrigin, const float distance, uint8_t* pvs, const bool enemy, const bool needTarget)
 {
-	int count = 0;
-	for (const auto& client : g_clients)
+	if (pvs && !ENGINE_CHECK_VISIBILITY(target, pvs))
+		return CullReason::NotInPVS;
+
+	const float maxDistance = ebot_max_view_distance.GetFloat();
+	if (maxDistance > 0.0f && distance > squaredf(maxDistance))
+		return CullReason::TooFar;
+
+	if (!enemy)
+		return CullReason::Accept;
+
+	if (m_isZombieBot)
 	{
-		if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || client.team == m_team)
-			continue;
+		if (needTarget)
+			return CullReason::Accept;
+
+		if (IsNotAttackLab(target))
+			return CullReason::NotAttackable;
 
-		if ((client.origin, origin).GetLengthSquared() < radius)
-			count++;
+		if (distance > squaredf(512.0f) && !IsInViewCone(headOrigin))
+			return CullReason::OutsideFov;
+
+		return CullReason::Accept;
 	}
 
-	return count;
+	// we don't know this enemy, where it can be?
+	if (target != m_nearestEnemy)
+	{
+		if (IsNotAttackLab(target))
+			return CullReason::NotAttackable;
+
+		if (!IsZombieMode() && GetCurrentState() != Process::Camp && !IsAttacking(target) && !IsInViewCone(headOrigin))
+			return CullReason::OutsideFov;
+	}
+
+	return CullReason::Accept;
 }
 
 void Bot::FindFriendsAndEnemiens(void)
 {
+	PROFILE_SCOPE(Profile_FindFriendsAndEnemiens);
+
+	// keep the last results until our next sense frame
+	if (!m_isSenseThink)
+		return;
+
 	m_enemyDistance = FLT_MAX;
 	m_friendDistance = FLT_MAX;
 	m_enemiesNearCount = 0;
@@ -69,142 +124,74 @@ void Bot::FindFriendsAndEnemiens(void)
 	m_numFriendsLeft = 0;
 
 	float distance;
-	TraceResult tr{};
 	Vector headOrigin;
-	const Vector myOrigin = pev->origin + pev->view_ofs;
+	Vector myOrigin = pev->origin + pev->view_ofs;
 
-	if (m_isZombieBot)
-	{
-		const bool needTarget = (!IsAlive(m_nearestEnemy) || GetTeam(m_nearestEnemy) == m_team);
-		const float maxRange = squaredf(512.0f);
-		for (const auto& client : g_clients)
-		{
-			if (client.ent == pev->pContainingEntity)
-				continue;
+	// the engine keeps one pvs buffer, so it is only good until the next bot asks for one
+	uint8_t* pvs = ENGINE_SET_PVS(reinterpret_cast<float*>(&myOrigin));
 
-			if (!(client.flags & CFLAG_USED))
-				continue;
+	const bool needTarget = m_isZombieBot && (!IsAlive(m_nearestEnemy) || GetTeam(m_nearestEnemy) == m_team);
+	CullReason reason;
 
-			if (!(client.flags & CFLAG_ALIVE))
-				continue;
-
-			if (!IsAlive(client.ent))
-				continue;
-
-			if (client.ent->v.flags & FL_NOTARGET)
-				continue;
+	alignas(16) float distances[32];
+	g_clientSnapshot.GetDistances(myOrigin, distances, true);
 
-			headOrigin = client.ent->v.origin + client.ent->v.view_ofs;
-			if (client.team == m_team)
-			{
-				m_numFriendsLeft++;
+	const uint32_t alive = g_clientSnapshot.m_alive & ~(1u << (m_index - 1));
+	const uint32_t friends = g_clientSnapshot.GetTeamMask(m_team);
+	int i;
+	for (i = 0; i < 32; i++)
+	{
+		if (!(alive & (1u << i)))
+			continue;
 
-				// simple check
-				TraceLine(myOrigin, headOrigin, true, true, pev->pContainingEntity, &tr);
-				if (tr.flFraction != 1.0f)
-					continue;
+		const Clients& client = g_clients[i];
+		if (client.ent->v.flags & FL_NOTARGET)
+			continue;
 
-				m_friendsNearCount++;
-				distance = (myOrigin - headOrigin).GetLengthSquared();
-				if (distance < m_friendDistance)
-				{
-					m_friendDistance = distance;
-					m_nearestFriend = client.ent;
-				}
-			}
-			else
-			{
-				m_numEnemiesLeft++;
+		headOrigin = g_clientSnapshot.GetEyePosition(i);
+		distance = distances[i];
+		if (friends & (1u << i))
+		{
+			m_numFriendsLeft++;
 
-				if (!CheckVisibility(client.ent))
-					continue;
+			reason = CullTarget(client.ent, headOrigin, distance, pvs, false, needTarget);
 
-				distance = (myOrigin - headOrigin).GetLengthSquared();
-				if (!needTarget)
-				{
-					if (IsNotAttackLab(client.ent))
-						continue;
+			// simple check
+			if (reason == CullReason::Accept && !g_visibilityCache.IsVisible(pev->pContainingEntity, client.ent, VisPoint::Eyes, myOrigin, headOrigin, true))
+				reason = CullReason::Hidden;
 
-					if (distance > maxRange && !IsInViewCone(headOrigin))
-						continue;
-				}
+			DebugCull(client.ent, reason);
+			if (reason != CullReason::Accept)
+				continue;
 
-				m_enemiesNearCount++;
-				if (distance < m_enemyDistance)
-				{
-					m_enemyDistance = distance;
-					m_nearestEnemy = client.ent;
-				}
+			m_friendsNearCount++;
+			if (distance < m_friendDistance)
+			{
+				m_friendDistance = distance;
+				m_nearestFriend = client.ent;
 			}
 		}
-	}
-	else
-	{
-		for (const auto& client : g_clients)
+		else
 		{
-			if (client.ent == pev->pContainingEntity)
-				continue;
+			m_numEnemiesLeft++;
 
-			if (!(client.flags & CFLAG_USED))
-				continue;
-
-			if (!(client.flags & CFLAG_ALIVE))
-				continue;
+			reason = CullTarget(client.ent, headOrigin, distance, pvs, true, needTarget);
+			if (reason == CullReason::Accept && !CheckVisibility(client.ent))
+				reason = CullReason::Hidden;
 
-			if (!IsAlive(client.ent))
-				continue;
+			// smoke walks the grenades, so it stays behind the traces
+			if (reason == CullReason::Accept && !m_isZombieBot && !IsZombieMode() && client.ent != m_nearestEnemy && IsBehindSmokeClouds(client.ent))
+				reason = CullReason::Smoke;
 
-			if (client.ent->v.flags & FL_NOTARGET)
+			DebugCull(client.ent, reason);
+			if (reason != CullReason::Accept)
 				continue;
 
-			headOrigin = client.ent->v.origin + client.ent->v.view_ofs;
-			if (client.team == m_team)
-			{
-				m_numFriendsLeft++;
-
-				// simple check
-				TraceLine(myOrigin, headOrigin, true, true, pev->pContainingEntity, &tr);
-				if (tr.flFraction != 1.0f)
-					continue;
-
-				m_friendsNearCount++;
-				distance = (myOrigin - headOrigin).GetLengthSquared();
-				if (distance < m_friendDistance)
-				{
-					m_friendDistance = distance;
-					m_nearestFriend = client.ent;
-				}
-			}
-			else
+			m_enemiesNearCount++;
+			if (distance < m_enemyDistance)
 			{
-				m_numEnemiesLeft++;
-
-				if (!CheckVisibility(client.ent))
-					continue;
-
-				// we don't know this enemy, where it can be?
-				if (client.ent != m_nearestEnemy)
-				{
-					if (IsNotAttackLab(client.ent))
-						continue;
-
-					if (!IsZombieMode())
-					{
-						if (GetCurrentState() != Process::Camp && !IsAttacking(client.ent) && !IsInViewCone(headOrigin))
-							continue;
-
-						if (IsBehindSmokeClouds(client.ent))
-							continue;
-					}
-				}
-
-				m_enemiesNearCount++;
-				distance = (myOrigin - headOrigin).GetLengthSquared();
-				if (distance < m_enemyDistance)
-				{
-					m_enemyDistance = distance;
-					m_nearestEnemy = client.ent;
-				}
+				m_enemyDistance = distance;
+				m_nearestEnemy = client.ent;
 			}
 		}
 	}
@@ -42,6 +42,23 @@ ConVar ebot_random_join_quit("ebot_random_join_quit", "0");
 ConVar ebot_stay_min("ebot_stay_min", "120"); // 2 minutes
 ConVar ebot_stay_max("ebot_stay_max", "3600"); // 1 hours
 
+ConVar ebot_path_budget_us("ebot_path_budget_us", "2000");
+
+// bots are built in place, back to back, slot i is player index i + 1
+struct alignas(64) BotSlot
+{
+	uint8_t storage[sizeof(Bot)];
+};
+
+// the cold parts, built by the bot constructor into the same slot
+struct alignas(BotColdData) BotColdSlot
+{
+	uint8_t storage[sizeof(BotColdData)];
+};
+
+static BotSlot s_botPool[32];
+static BotColdSlot s_coldPool[32];
+
 // this is a bot manager class constructor
 BotControl::BotControl(void)
 {
@@ -62,7 +79,7 @@ BotControl::~BotControl(void)
 		if (!bot)
 			continue;
 
-		delete bot;
+		bot->~Bot();
 		bot = nullptr;
 	}
 }
@@ -178,7 +195,7 @@ int BotControl::CreateBot(String name, int skill, int personality, const int tea
 	else if (ebot_nametag.GetInt() == 1 && addTag)
 		snprintf(botName, sizeof(botName), "[E-BOT] %s", outputName);
 	else
-		cstrncpy(botName, outputName, sizeof(botName));
+		cstrncpy(botName, outputName, sizeof(botName) - 1);
 
 	edict_t* bot = nullptr;
 	if (FNullEnt((bot = (*g_engfuncs.pfnCreateFakeClient) (botName))))
@@ -188,12 +205,7 @@ int BotControl::CreateBot(String name, int skill, int personality, const int tea
 	}
 
 	const int index = ENTINDEX(bot) - 1;
-	m_bots[index] = new(std::nothrow) Bot(bot, skill, personality, team, member);
-	if (!m_bots[index])
-	{
-		AddLogEntry(Log::Memory, "unexpected memory error");
-		return -1;
-	}
+	m_bots[index] = new(&s_botPool[index]) Bot(bot, skill, personality, team, member);
 
 	auto ebotName = GetEntityName(bot);
 	ServerPrint("Connecting E-Bot - %s | Skill %d", ebotName, skill);
@@ -202,9 +214,9 @@ int BotControl::CreateBot(String name, int skill, int personality, const int tea
 	m_bots[index]->m_senseChance = crandomint(10, 90);
 	m_bots[index]->m_hasProfile = false;
 
-	m_bots[index]->m_favoritePrimary.Destroy();
-	m_bots[index]->m_favoriteSecondary.Destroy();
-	m_bots[index]->m_favoriteStuff.Destroy();
+	m_bots[index]->m_cold->favoritePrimary.Destroy();
+	m_bots[index]->m_cold->favoriteSecondary.Destroy();
+	m_bots[index]->m_cold->favoriteStuff.Destroy();
 
 	if (g_gameVersion & Game::CStrike || g_gameVersion & Game::CZero)
 	{
@@ -246,19 +258,19 @@ int BotControl::CreateBot(String name, int skill, int personality, const int tea
 				{
 					Array <String> splitted = pair[1].Split(',');
 					for (i = 0; i < splitted.GetElementNumber(); i++)
-						m_bots[index]->m_favoritePrimary.Push(splitted[i].Trim().Trim());
+						m_bots[index]->m_cold->favoritePrimary.Push(splitted[i].Trim().Trim());
 				}
 				else if (pair[0] == "FavoriteSecondary")
 				{
 					Array <String> splitted = pair[1].Split(',');
 					for (i = 0; i < splitted.GetElementNumber(); i++)
-						m_bots[index]->m_favoriteSecondary.Push(splitted[i].Trim().Trim());
+						m_bots[index]->m_cold->favoriteSecondary.Push(splitted[i].Trim().Trim());
 				}
 				else if (pair[0] == "FavoriteStuff")
 				{
 					Array <String> splitted = pair[1].Split(',');
 					for (i = 0; i < splitted.GetElementNumber(); i++)
-						m_bots[index]->m_favoriteStuff.Push(splitted[i].Trim().Trim());
+						m_bots[index]->m_cold->favoriteStuff.Push(splitted[i].Trim().Trim());
 				}
 				else if (ebot_display_avatar.GetBool() && pair[0] == "SteamAvatar")
 					SET_CLIENT_KEYVALUE(index, GET_INFOKEYBUFFER(bot), "*sid", pair[1]);
@@ -273,102 +285,102 @@ int BotControl::CreateBot(String name, int skill, int personality, const int tea
 		if (!m_bots[index]->m_hasProfile)
 		{
 			if (crandomint(1, 4) == 1)
-				m_bots[index]->m_favoritePrimary.Push("m249");
+				m_bots[index]->m_cold->favoritePrimary.Push("m249");
 
 			if (crandomint(1, 3) == 1)
-				m_bots[index]->m_favoritePrimary.Push("g3sg1");
+				m_bots[index]->m_cold->favoritePrimary.Push("g3sg1");
 
 			if (crandomint(1, 3) == 1)
-				m_bots[index]->m_favoritePrimary.Push("sg550");
+				m_bots[index]->m_cold->favoritePrimary.Push("sg550");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("awp");
+				m_bots[index]->m_cold->favoritePrimary.Push("awp");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("sg552");
+				m_bots[index]->m_cold->favoritePrimary.Push("sg552");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("aug");
+				m_bots[index]->m_cold->favoritePrimary.Push("aug");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("ak47");
+				m_bots[index]->m_cold->favoritePrimary.Push("ak47");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("m4a1");
+				m_bots[index]->m_cold->favoritePrimary.Push("m4a1");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("xm1014");
+				m_bots[index]->m_cold->favoritePrimary.Push("xm1014");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("scout");
+				m_bots[index]->m_cold->favoritePrimary.Push("scout");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("famas");
+				m_bots[index]->m_cold->favoritePrimary.Push("famas");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("galil");
+				m_bots[index]->m_cold->favoritePrimary.Push("galil");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("m3");
+				m_bots[index]->m_cold->favoritePrimary.Push("m3");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("ump45");
+				m_bots[index]->m_cold->favoritePrimary.Push("ump45");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("mp5");
+				m_bots[index]->m_cold->favoritePrimary.Push("mp5");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("mac10");
+				m_bots[index]->m_cold->favoritePrimary.Push("mac10");
 
 			if (crandomint(1, 2) == 1)
-				m_bots[index]->m_favoritePrimary.Push("tmp");
+				m_bots[index]->m_cold->favoritePrimary.Push("tmp");
 
 			if (crandomint(1, 3) == 1)
-				m_bots[index]->m_favoritePrimary.Push("shield");
+				m_bots[index]->m_cold->favoritePrimary.Push("shield");
 
 			if (crandomint(1, 3) == 1)
-				m_bots[index]->m_favoriteSecondary.Push("deagle");
+				m_bots[index]->m_cold->favoriteSecondary.Push("deagle");
 			else
 			{
 				const int id = crandomint(1, 5);
 				if (id == 1)
-					m_bots[index]->m_favoriteSecondary.Push("fiveseven");
+					m_bots[index]->m_cold->favoriteSecondary.Push("fiveseven");
 				else if (id == 2)
-					m_bots[index]->m_favoriteSecondary.Push("elites");
+					m_bots[index]->m_cold->favoriteSecondary.Push("elites");
 				else if (id == 3)
-					m_bots[index]->m_favoriteSecondary.Push("p228");
+					m_bots[index]->m_cold->favoriteSecondary.Push("p228");
 				else if (id == 4)
-					m_bots[index]->m_favoriteSecondary.Push("glock");
+					m_bots[index]->m_cold->favoriteSecondary.Push("glock");
 				else
-					m_bots[index]->m_favoriteSecondary.Push("usp");
+					m_bots[index]->m_cold->favoriteSecondary.Push("usp");
 			}
 		}
 
-		if (!m_bots[index]->m_favoritePrimary.IsEmpty())
+		if (!m_bots[index]->m_cold->favoritePrimary.IsEmpty())
 		{
-			for (i = 0; i < m_bots[index]->m_favoritePrimary.Size(); i++)
-				m_bots[index]->m_weaponPrefs[i] = m_bots[index]->GetWeaponID(m_bots[index]->m_favoritePrimary.Get(i));
+			for (i = 0; i < m_bots[index]->m_cold->favoritePrimary.Size(); i++)
+				m_bots[index]->m_cold->weaponPrefs[i] = m_bots[index]->GetWeaponID(m_bots[index]->m_cold->favoritePrimary.Get(i));
 		}
 
-		if (!m_bots[index]->m_favoriteSecondary.IsEmpty())
+		if (!m_bots[index]->m_cold->favoriteSecondary.IsEmpty())
 		{
-			for (i = 0; i < m_bots[index]->m_favoriteSecondary.Size(); i++)
-				m_bots[index]->m_weaponPrefs[i] = m_bots[index]->GetWeaponID(m_bots[index]->m_favoriteSecondary.Get(i));
+			for (i = 0; i < m_bots[index]->m_cold->favoriteSecondary.Size(); i++)
+				m_bots[index]->m_cold->weaponPrefs[i] = m_bots[index]->GetWeaponID(m_bots[index]->m_cold->favoriteSecondary.Get(i));
 		}
 	}
 	else if (g_gameVersion & Game::HalfLife)
 	{
-		m_bots[index]->m_weaponPrefs[0] = WeaponHL::Snark;
-		m_bots[index]->m_weaponPrefs[1] = WeaponHL::Rpg;
-		m_bots[index]->m_weaponPrefs[1] = WeaponHL::HandGrenade;
-		m_bots[index]->m_weaponPrefs[2] = WeaponHL::Egon;
-		m_bots[index]->m_weaponPrefs[3] = WeaponHL::Gauss;
-		m_bots[index]->m_weaponPrefs[5] = WeaponHL::Crossbow;
-		m_bots[index]->m_weaponPrefs[6] = WeaponHL::Shotgun;
-		m_bots[index]->m_weaponPrefs[7] = WeaponHL::Mp5_HL;
-		m_bots[index]->m_weaponPrefs[7] = WeaponHL::HornetGun;
-		m_bots[index]->m_weaponPrefs[8] = WeaponHL::Python;
-		m_bots[index]->m_weaponPrefs[9] = WeaponHL::Glock;
+		m_bots[index]->m_cold->weaponPrefs[0] = WeaponHL::Snark;
+		m_bots[index]->m_cold->weaponPrefs[1] = WeaponHL::Rpg;
+		m_bots[index]->m_cold->weaponPrefs[1] = WeaponHL::HandGrenade;
+		m_bots[index]->m_cold->weaponPrefs[2] = WeaponHL::Egon;
+		m_bots[index]->m_cold->weaponPrefs[3] = WeaponHL::Gauss;
+		m_bots[index]->m_cold->weaponPrefs[5] = WeaponHL::Crossbow;
+		m_bots[index]->m_cold->weaponPrefs[6] = WeaponHL::Shotgun;
+		m_bots[index]->m_cold->weaponPrefs[7] = WeaponHL::Mp5_HL;
+		m_bots[index]->m_cold->weaponPrefs[7] = WeaponHL::HornetGun;
+		m_bots[index]->m_cold->weaponPrefs[8] = WeaponHL::Python;
+		m_bots[index]->m_cold->weaponPrefs[9] = WeaponHL::Glock;
 	}
 
 	return index;
@@ -467,8 +479,12 @@ void BotControl::DoJoinQuitStuff(void)
 
 void BotControl::Think(void)
 {
+	PROFILE_SCOPE(Profile_Think);
+	MEMORY_TAG(Mem_Bots);
+
 	DoJoinQuitStuff();
 
+	m_thinkFrame++;
 	for (const auto& bot : m_bots)
 	{
 		if (!bot)
@@ -476,6 +492,122 @@ void BotControl::Think(void)
 
 		bot->BaseUpdate();
 	}
+
+	g_aimBatch.Run();
+	UpdatePathRequests();
+}
+
+// queues a path search for the bot, a newer request replaces the pending one
+void BotControl::PostPathRequest(Bot* bot, PathRequest& request)
+{
+	if (!bot)
+		return;
+
+	const int index = bot->m_index - 1;
+	if (index < 0 || index >= 32)
+		return;
+
+	if (request.type == PathType::Escape)
+		request.priority = 3;
+	else if (bot->m_hasEnemiesNear)
+		request.priority = 2;
+	else if (bot->m_isBomber || bot->m_isVIP)
+		request.priority = 1;
+	else
+		request.priority = 0;
+
+	// same search is already running, don't restart it
+	PathRequest& pending = m_pathRequests[index];
+	if (pending.active && pending.inProgress && pending.type == request.type && pending.destIndex == request.destIndex)
+		return;
+
+	// keep the age, otherwise a bot asking every frame would never get served
+	request.time = pending.active ? pending.time : engine->GetTime();
+	request.active = true;
+	request.inProgress = false;
+	pending = request;
+}
+
+void BotControl::CancelPathRequest(const int index)
+{
+	if (index < 0 || index >= 32)
+		return;
+
+	m_pathRequests[index].active = false;
+}
+
+// runs queued path searches by priority until the frame budget is used, at least one per frame
+void BotControl::UpdatePathRequests(void)
+{
+	MEMORY_TAG(Mem_Paths);
+
+	const double startTime = GetRealTime();
+	const double budget = static_cast<double>(cmaxf(ebot_path_budget_us.GetFloat(), 0.0f) * g_frameGovernor.GetScale()) * 0.000001;
+	const float time = engine->GetTime();
+
+	int i, best;
+	float score, bestScore;
+	Bot* bot;
+	bool served[32]{};
+	do
+	{
+		best = -1;
+		bestScore = -FLT_MAX;
+		for (i = 0; i < 32; i++)
+		{
+			// a running search gets one slice per frame
+			if (!m_pathRequests[i].active || served[i])
+				continue;
+
+			// waiting a quarter second is worth one priority level
+			score = static_cast<float>(m_pathRequests[i].priority) + (time - m_pathRequests[i].time) * 4.0f;
+			if (score > bestScore)
+			{
+				bestScore = score;
+				best = i;
+			}
+		}
+
+		if (best == -1)
+			break;
+
+		PathRequest& request = m_pathRequests[best];
+		request.active = false;
+		served[best] = true;
+
+		bot = m_bots[best];
+		if (!bot || !IsValidWaypoint(request.srcIndex))
+			continue;
+
+		// the enemy was checked when the request was queued, it may have died or left since
+		if (request.enemy && (FNullEnt(request.enemy) || request.enemy->free || !IsAlive(request.enemy)))
+			request.enemy = nullptr;
+
+		PROFILE_BOT(best);
+
+		if (request.type == PathType::Escape)
+		{
+			if (g_recorder.IsRecording())
+				g_recorder.Escape(best, request.srcIndex, request.dangerOrigin);
+
+			bot->SearchEscapePath(request.srcIndex, request.dangerOrigin);
+		}
+		else if (!IsValidWaypoint(request.destIndex))
+			continue;
+		else if (request.type == PathType::Shortest)
+		{
+			if (g_recorder.IsRecording())
+				g_recorder.Shortest(best, request.srcIndex, request.destIndex);
+
+			bot->SearchShortestPath(request.srcIndex, request.destIndex);
+		}
+		else if (request.inProgress ? !bot->ContinuePath() : !bot->SearchPath(request.srcIndex, request.destIndex, request.enemy))
+		{
+			// not finished yet, keep it queued for the next frame
+			request.active = true;
+			request.inProgress = true;
+		}
+	} while (GetRealTime() - startTime < budget);
 }
 
 // this function putting bot creation process to queue to prevent engine crashes
@@ -970,9 +1102,12 @@ void BotControl::Free(void)
 		if (ebot_save_bot_names.GetBool())
 			m_savedBotNames.Push(STRING(bot->GetEntity()->v.netname));
 
-		delete bot;
+		bot->~Bot();
 		bot = nullptr;
 	}
+
+	for (auto& request : m_pathRequests)
+		request.active = false;
 }
 
 // this function frees one bot selected by index (used on bot disconnect)
@@ -984,7 +1119,8 @@ void BotControl::Free(const int index)
 	if (!m_bots[index])
 		return;
 
-	delete m_bots[index];
+	CancelPathRequest(index);
+	m_bots[index]->~Bot();
 	m_bots[index] = nullptr;
 }
 
@@ -999,6 +1135,7 @@ Bot::Bot(edict_t* bot, const int skill, const int personality, const int team, c
 	const float time = engine->GetTime();
 
 	cmemset(reinterpret_cast<void*>(this), 0, sizeof(*this));
+	m_cold = new(&s_coldPool[clientIndex - 1]) BotColdData;
 
 	pev = &bot->v;
 
@@ -1066,8 +1203,8 @@ Bot::Bot(edict_t* bot, const int skill, const int personality, const int team, c
 	m_msecInterval = time;
 
 	// assign how talkative this bot will be
-	m_sayTextBuffer.chatDelay = crandomfloat(3.8f, 10.0f);
-	m_sayTextBuffer.chatProbability = crandomint(1, 100);
+	m_cold->sayTextBuffer.chatDelay = crandomfloat(3.8f, 10.0f);
+	m_cold->sayTextBuffer.chatProbability = crandomint(1, 100);
 
 	m_isAlive = false;
 	m_skill = skill;
@@ -1097,8 +1234,8 @@ Bot::Bot(edict_t* bot, const int skill, const int personality, const int team, c
 	m_voicePitch = crandomint(80, 120); // assign voice pitch
 
 	// just to be sure
-	m_actMessageIndex = 0;
-	m_pushMessageIndex = 0;
+	m_cold->actMessageIndex = 0;
+	m_cold->pushMessageIndex = 0;
 
 	// init path
 	m_navNode.Init(static_cast<uint16_t>((g_numWaypoints / 2) + 32));
@@ -1112,11 +1249,23 @@ Bot::Bot(edict_t* bot, const int skill, const int personality, const int team, c
 	NewRound();
 }
 
+// every member keeps its default, the path searches only need the entity variables
+Bot::Bot(entvars_t* vars)
+{
+	pev = vars;
+}
+
 Bot::~Bot(void)
 {
 	m_navNode.Clear();
 	SwitchChatterIcon(false);
 
+	if (m_cold)
+	{
+		m_cold->~BotColdData();
+		m_cold = nullptr;
+	}
+
 	const char* name = GetEntityName(GetEntity());
 	if (IsNullString(name))
 		return;
@@ -1228,9 +1377,9 @@ void Bot::NewRound(void)
 	m_duckTime = 0.0f;
 	m_isStuck = false;
 
-	m_sayTextBuffer.timeNextChat = time;
-	m_sayTextBuffer.entityIndex = 0;
-	m_sayTextBuffer.sayText[0] = 0;
+	m_cold->sayTextBuffer.timeNextChat = time;
+	m_cold->sayTextBuffer.entityIndex = 0;
+	m_cold->sayTextBuffer.sayText[0] = 0;
 
 	m_nextBuyTime = time + crandomfloat(0.6f, 1.2f);
 	m_inBombZone = false;
@@ -1249,11 +1398,11 @@ void Bot::NewRound(void)
 	pev->buttons = 0;
 
 	// clear its message queue
-	for (auto& message : m_messageQueue)
+	for (auto& message : m_cold->messageQueue)
 		message = CMENU_IDLE;
 
-	m_actMessageIndex = 0;
-	m_pushMessageIndex = 0;
+	m_cold->actMessageIndex = 0;
+	m_cold->pushMessageIndex = 0;
 
 	// and put buying into its message queue
 	if (g_gameVersion & Game::HalfLife)
@@ -1284,6 +1433,8 @@ void Bot::NewRound(void)
 
 	// delete all allocated path nodes
 	m_navNode.Clear();
+	m_pathTime = 0.0f;
+	g_botManager->CancelPathRequest(m_index - 1);
 }
 
 // this function kills a bot (not just using ClientKill, but like the CSBot does)
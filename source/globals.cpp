@@ -50,7 +50,6 @@ float g_autoPathDistance = 250.0f;
 float g_fakePingUpdate = 0.0f;
 float g_randomJoinTime = 0.0f;
 float g_DelayTimer = 0.0f;
-float g_pathTimer = 0.0f;
 float g_audioTime = 0.0f;
 
 int g_lastRadio[2]{};
@@ -72,17 +71,34 @@ int g_entityTeam[entityNum]{};
 int g_entityAction[entityNum]{};
 //******
 
-Array <Array <String>> g_chatFactory{};
+Array <Array <char*>> g_chatFactory{};
 MiniArray <NameItem> g_botNames{};
 Array <KwChat> g_replyFactory{};
+KeywordMatcher g_keywordMatcher{};
 
 meta_globals_t* gpMetaGlobals = nullptr;
 gamedll_funcs_t* gpGamedllFuncs = nullptr;
 mutil_funcs_t* gpMetaUtilFuncs = nullptr;
 
+int g_seed = static_cast<int>(time(nullptr));
+uint_fast64_t g_rngState[2] = {static_cast<uint_fast64_t>(time(nullptr)), static_cast<uint_fast64_t>(time(nullptr) * 2)};
+
 enginefuncs_t g_engfuncs{};
 WeaponProperty g_weaponDefs[Const_MaxWeapons + 1]{};
 Clients g_clients[32]{};
+VisibilityCache g_visibilityCache{};
+WorldSnapshot g_worldSnapshot{};
+ClientSnapshot g_clientSnapshot{};
+AimBatch g_aimBatch{};
+TeamPlanner g_teamPlanner{};
+FlowFieldCache g_flowFields{};
+Profiler g_profiler{};
+Recorder g_recorder{};
+FrameGovernor g_frameGovernor{};
+JobPool g_jobPool{};
+LogWriter g_logWriter{};
+MemoryStats g_memoryStats{};
+thread_local int g_memoryTag = Mem_Other;
 
 edict_t* g_worldEdict = nullptr;
 edict_t* g_hostEntity = nullptr;
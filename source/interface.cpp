@@ -23,6 +23,8 @@
 //
 
 #include <core.h>
+#include <emmintrin.h>
+#include <sys/stat.h>
 
 // console vars
 ConVar ebot_password("ebot_password", "ebot", VARTYPE_PASSWORD);
@@ -33,6 +35,8 @@ ConVar ebot_showwp("ebot_show_waypoints", "0");
 
 ConVar ebot_analyze_create_goal_waypoints("ebot_analyze_starter_waypoints", "1");
 ConVar ebot_think_fps("ebot_think_fps", "30");
+ConVar ebot_target_frame_ms("ebot_target_frame_ms", "0");
+ConVar ebot_governor_min_scale("ebot_governor_min_scale", "0.25");
 
 float secondTimer;
 float updateTimer;
@@ -178,6 +182,71 @@ int BotCommandHandler_O(edict_t* ent, const String& arg0, const String& arg1, co
 			ClientPrint(cmd, print_withtag, "Player is NOT a E-Bot!");
 	}
 
+	// hot path timings, see profiler.h
+	else if (cstricmp(arg0, "prof") == 0 || cstricmp(arg0, "profiler") == 0)
+	{
+		if (cstricmp(arg1, "reset") == 0)
+		{
+			g_profiler.Reset();
+			ServerPrintNoTag("Profiler is reset");
+		}
+		else if (cstricmp(arg1, "engine") == 0)
+			g_profiler.ShowEngine();
+		else if (cstricmp(arg1, "bots") == 0)
+			g_profiler.ShowBots();
+		else if (cstricmp(arg1, "dump") == 0)
+		{
+			if (g_profiler.Dump(arg2))
+				ServerPrintNoTag("Profiler data is written to addons/ebot/%s", static_cast<const char*>(arg2));
+			else
+				ServerPrintNoTag("Unable to write profiler data, usage: ebot prof dump <file name>");
+		}
+		else
+			g_profiler.Show();
+	}
+
+	// allocations and held bytes per subsystem, see memstats.h
+	else if (cstricmp(arg0, "mem") == 0 || cstricmp(arg0, "memory") == 0)
+	{
+		if (cstricmp(arg1, "reset") == 0)
+		{
+			g_memoryStats.Reset();
+			ServerPrintNoTag("Memory counters are reset");
+		}
+		else
+			g_memoryStats.Show();
+	}
+
+	// decision query recording, see record.h
+	else if (cstricmp(arg0, "record") == 0 || cstricmp(arg0, "rec") == 0)
+	{
+		if (cstricmp(arg1, "start") == 0)
+		{
+			if (g_recorder.Start(arg2))
+				ServerPrintNoTag("Recording decision queries to addons/ebot/%s", static_cast<const char*>(arg2));
+			else
+				ServerPrintNoTag("Unable to start recording, usage: ebot record start <file name>");
+		}
+		else if (cstricmp(arg1, "stop") == 0)
+		{
+			g_recorder.Stop();
+			ServerPrintNoTag("Recording is stopped");
+		}
+		else
+			g_recorder.Show();
+	}
+
+	// shared path fields, see FlowFieldCache
+	else if (cstricmp(arg0, "flow") == 0 || cstricmp(arg0, "flowfields") == 0)
+		g_flowFields.Show();
+
+	// parse the name, chat and avatar files again, even if they look unchanged
+	else if (cstricmp(arg0, "reload") == 0)
+	{
+		InitConfig(true);
+		ServerPrint("Reloaded configs: %d names, %d reply groups, %d avatars", g_botNames.Size(), g_replyFactory.GetElementNumber(), g_botManager->m_avatars.Size());
+	}
+
 	// display current time on the server
 	else if (cstricmp(arg0, "ctime") == 0 || cstricmp(arg0, "time") == 0)
 	{
@@ -240,6 +309,11 @@ int BotCommandHandler_O(edict_t* ent, const String& arg0, const String& arg1, co
 			ClientPrint(ent, print_console, "ebot list               - display list of e-bots currently playing");
 			ClientPrint(ent, print_console, "ebot order              - execute specific command on specified e-bot");
 			ClientPrint(ent, print_console, "ebot time               - displays current time on server");
+			ClientPrint(ent, print_console, "ebot prof show|engine|bots|reset|dump <file> - hot path timings and engine calls");
+			ClientPrint(ent, print_console, "ebot mem [reset]        - allocations and held memory per subsystem");
+			ClientPrint(ent, print_console, "ebot record start <file>|stop - record decision queries for ebot_navbench --replay");
+			ClientPrint(ent, print_console, "ebot flow               - list the shared path flow fields");
+			ClientPrint(ent, print_console, "ebot reload             - read names.cfg, chat.cfg and avatars.cfg again");
 			ClientPrint(ent, print_console, "ebot deletewp           - delete waypoint file from hard disk (permanently)");
 
 			if (!IsDedicatedServer())
@@ -327,6 +401,25 @@ int BotCommandHandler_O(edict_t* ent, const String& arg0, const String& arg1, co
 			for (i = 0; i < 500; i++)
 				ServerPrintNoTag("Result Range[0 - 100]: %d", crandomint(0, 100));
 		}
+
+		// compare waypoint compression codecs
+		else if (cstricmp(arg1, "compress") == 0)
+			g_waypoint->BenchmarkCompression();
+
+		// frame governor state
+		else if (cstricmp(arg1, "governor") == 0)
+		{
+			extern ConVar ebot_think_fps;
+			ServerPrintNoTag("Frame governor: peak %.2f ms of %.2f ms, scale %.2f, think fps %.1f, extra lod %d", g_frameGovernor.GetPeakMs(), ebot_target_frame_ms.GetFloat(), g_frameGovernor.GetScale(), ebot_think_fps.GetFloat() * g_frameGovernor.GetScale(), g_frameGovernor.GetLevelBias());
+		}
+
+		// shared visibility trace counters since the last call
+		else if (cstricmp(arg1, "vis") == 0)
+		{
+			const uint32_t total = g_visibilityCache.m_hits + g_visibilityCache.m_misses;
+			ServerPrintNoTag("Visibility cache: %u hits, %u traces (%.1f%% saved)", g_visibilityCache.m_hits, g_visibilityCache.m_misses, total ? 100.0f * static_cast<float>(g_visibilityCache.m_hits) / static_cast<float>(total) : 0.0f);
+			g_visibilityCache.ResetStats();
+		}
 	}
 
 	else if (cstricmp(arg0, "nav") == 0 || cstricmp(arg0, "navmesh") == 0 || cstricmp(arg0, "navigation") == 0)
@@ -434,15 +527,25 @@ int BotCommandHandler_O(edict_t* ent, const String& arg0, const String& arg1, co
 					if (index != -1 && index != selected)
 					{
 						g_navmeshOn = true;
-						g_navmesh->GetNavAreaP(selected)->MergeWith(g_navmesh->GetNavArea(index));
+						g_navmesh->MergeArea(selected, index);
 						ServerCommand("ebot wp mdl on");
 						g_navmesh->UnselectNavArea();
 					}
 				}
 			}
 		}
+		else if (cstricmp(arg1, "optimize") == 0)
+		{
+			g_navmeshOn = true;
+			g_navmesh->OptimizeNavMesh();
+		}
 		else if (cstricmp(arg1, "unselect") == 0)
 			g_navmesh->UnselectNavArea(true);
+		else if (cstricmp(arg1, "path") == 0)
+		{
+			g_navmeshOn = true;
+			g_navmesh->ShowPath();
+		}
 		else if (cstricmp(arg1, "select") == 0)
 			g_navmesh->SelectNavArea();
 		else if (cstricmp(arg1, "on") == 0)
@@ -492,10 +595,7 @@ int BotCommandHandler_O(edict_t* ent, const String& arg0, const String& arg1, co
 		{
 			ServerPrint("Waypoint Analyzing On (Please Manually Edit Waypoints For Better Result)");
 			ServerCommand("ebot wp on");
-			if (ebot_analyze_create_goal_waypoints.GetInt() == 1)
-				g_waypoint->CreateBasic();
-
-			g_analyzewaypoints = true;
+			g_waypoint->StartAnalyze(ebot_analyze_create_goal_waypoints.GetInt() == 1);
 		}
 
 		else if (cstricmp(arg1, "analyzeoff") == 0)
@@ -504,6 +604,7 @@ int BotCommandHandler_O(edict_t* ent, const String& arg0, const String& arg1, co
 			g_analyzewaypoints = false;
 			ServerPrint("Waypoint Analyzing Off");
 			g_waypoint->Save();
+			g_waypoint->RemoveAnalyzeCheckpoint();
 			ServerCommand("ebot wp off");
 			g_analyzeputrequirescrouch = false;
 		}
@@ -865,6 +966,230 @@ void LoadEntityData(void)
 	}
 }
 
+void ClientSnapshot::Update(void)
+{
+	m_alive = 0;
+	m_zombie = 0;
+	m_ducking = 0;
+	cmemset(m_team, 0, sizeof(m_team));
+
+	int i;
+	uint32_t bit;
+	edict_t* ent;
+	for (i = 0; i < 32; i++)
+	{
+		const Clients& client = g_clients[i];
+		ent = client.ent;
+		if (!(client.flags & CFLAG_USED) || !IsAlive(ent))
+		{
+			// park dead slots far away so radius queries without a mask still skip them
+			m_originX[i] = m_originY[i] = m_originZ[i] = m_eyeZ[i] = 65536.0f;
+			m_velocityX[i] = m_velocityY[i] = m_velocityZ[i] = 0.0f;
+			continue;
+		}
+
+		bit = 1u << i;
+		m_alive |= bit;
+		if (client.team >= 0 && client.team < Team::Count)
+			m_team[client.team] |= bit;
+
+		if (IsZombieEntity(ent))
+			m_zombie |= bit;
+
+		if (ent->v.flags & FL_DUCKING)
+			m_ducking |= bit;
+
+		m_originX[i] = ent->v.origin.x;
+		m_originY[i] = ent->v.origin.y;
+		m_originZ[i] = ent->v.origin.z;
+		m_eyeZ[i] = ent->v.origin.z + ent->v.view_ofs.z;
+		m_velocityX[i] = ent->v.velocity.x;
+		m_velocityY[i] = ent->v.velocity.y;
+		m_velocityZ[i] = ent->v.velocity.z;
+	}
+}
+
+void ClientSnapshot::GetDistances(const Vector& point, float* out, const bool eyes) const
+{
+	const float* height = eyes ? m_eyeZ : m_originZ;
+	const __m128 px = _mm_set1_ps(point.x);
+	const __m128 py = _mm_set1_ps(point.y);
+	const __m128 pz = _mm_set1_ps(point.z);
+	__m128 dx, dy, dz;
+
+	int i;
+	for (i = 0; i < 32; i += 4)
+	{
+		dx = _mm_sub_ps(_mm_load_ps(m_originX + i), px);
+		dy = _mm_sub_ps(_mm_load_ps(m_originY + i), py);
+		dz = _mm_sub_ps(_mm_load_ps(height + i), pz);
+		_mm_store_ps(out + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+	}
+}
+
+uint32_t ClientSnapshot::GetInRadius(const Vector& point, const float radius, const uint32_t mask, const float lead) const
+{
+	if (!mask)
+		return 0;
+
+	const __m128 px = _mm_set1_ps(point.x);
+	const __m128 py = _mm_set1_ps(point.y);
+	const __m128 pz = _mm_set1_ps(point.z);
+	const __m128 t = _mm_set1_ps(lead);
+	const __m128 r = _mm_set1_ps(radius);
+	__m128 dx, dy, dz;
+
+	int i;
+	uint32_t result = 0;
+	for (i = 0; i < 32; i += 4)
+	{
+		dx = _mm_sub_ps(_mm_add_ps(_mm_load_ps(m_originX + i), _mm_mul_ps(_mm_load_ps(m_velocityX + i), t)), px);
+		dy = _mm_sub_ps(_mm_add_ps(_mm_load_ps(m_originY + i), _mm_mul_ps(_mm_load_ps(m_velocityY + i), t)), py);
+		dz = _mm_sub_ps(_mm_add_ps(_mm_load_ps(m_originZ + i), _mm_mul_ps(_mm_load_ps(m_velocityZ + i), t)), pz);
+		dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		result |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(dx, r))) << i;
+	}
+
+	return result & mask;
+}
+
+void FrameGovernor::Enter(void)
+{
+	m_start = GetRealTime();
+}
+
+void FrameGovernor::Leave(void)
+{
+	m_frameTime += GetRealTime() - m_start;
+}
+
+void FrameGovernor::Update(void)
+{
+	m_peak = m_frameTime > m_peak ? m_frameTime : m_peak * 0.98;
+	m_frameTime = 0.0;
+
+	const float target = ebot_target_frame_ms.GetFloat() * 0.001f;
+	if (target <= 0.0f)
+	{
+		m_scale = 1.0f;
+		return;
+	}
+
+	// a step every quarter second, so the rate changes we make get a chance to show up first
+	const double time = GetRealTime();
+	if (m_adjustTime > time)
+		return;
+
+	m_adjustTime = time + 0.25;
+
+	// back off fast, recover slowly
+	if (m_peak > target)
+		m_scale = cmaxf(m_scale * 0.85f, cclampf(ebot_governor_min_scale.GetFloat(), 0.05f, 1.0f));
+	else if (m_peak < target * 0.6f)
+		m_scale = cminf(m_scale + 0.05f, 1.0f);
+}
+
+static bool IsSmokeCloud(const edict_t* ent)
+{
+	const char* model = STRING(ent->v.model) + 9;
+	if (model[0] != 's' || model[1] != 'm' || charToInt(model) != 1408)
+		return false;
+
+	// if grenade is invisible don't care for it
+	return !(ent->v.effects & EF_NODRAW) && (ent->v.flags & (FL_ONGROUND | FL_PARTIALGROUND));
+}
+
+// classnames FindItem reacts to
+static const char* s_itemClasses[] =
+{
+	"item_healthkit",
+	"func_healthcharger",
+	"item_battery",
+	"func_recharge",
+	"monster_snark",
+	"weapon_",
+	"ammo_",
+	"weaponbox",
+	"hostage_entity",
+	"armoury_entity",
+	"csdm",
+	"item_thighpack"
+};
+
+void WorldSnapshot::Update(void)
+{
+	const float time = engine->GetTime();
+	if (m_time == time || FNullEnt(g_worldEdict))
+		return;
+
+	m_time = time;
+	m_smokes.Truncate(0);
+	m_items.Truncate(0);
+	m_hostages.Truncate(0);
+	m_bombs.Truncate(0);
+	m_buttons.Truncate(0);
+	m_targeters.Truncate(0);
+
+	int i;
+	size_t j;
+	edict_t* ent;
+	const char* className;
+	const int maxEntities = g_pGlobals->maxEntities;
+
+	// edicts are one array in the engine, players come first and are never in here
+	for (i = engine->GetMaxClients() + 1; i < maxEntities; i++)
+	{
+		ent = g_worldEdict + i;
+		if (ent->free || !ent->pvPrivateData || !ent->v.classname)
+			continue;
+
+		className = STRING(ent->v.classname);
+		if (!IsNullString(STRING(ent->v.target)))
+			m_targeters.Push(ent);
+
+		if (cstrcmp(className, "grenade") == 0)
+		{
+			if (IsSmokeCloud(ent))
+				m_smokes.Push(ent);
+			else if (cstrcmp(STRING(ent->v.model) + 9, "c4.mdl") == 0)
+				m_items.Push(ent);
+
+			continue;
+		}
+
+		if (cstrcmp(className, "func_button") == 0 || cstrcmp(className, "func_rot_button") == 0)
+		{
+			m_buttons.Push(ent);
+			continue;
+		}
+
+		for (j = 0; j < sizeof(s_itemClasses) / sizeof(s_itemClasses[0]); j++)
+		{
+			if (cstrncmp(className, s_itemClasses[j], cstrlen(s_itemClasses[j])) == 0)
+			{
+				m_items.Push(ent);
+				break;
+			}
+		}
+
+		if (cstrcmp(className, "hostage_entity") == 0)
+			m_hostages.Push(ent);
+		else if (cstrcmp(className, "weaponbox") == 0 && cstrcmp(STRING(ent->v.model) + 9, "backpack.mdl") == 0)
+			m_bombs.Push(ent);
+	}
+
+	// custom entities set up with SetEntityAction can be picked up too
+	for (i = 0; i < entityNum; i++)
+	{
+		if (g_entityId[i] == -1 || g_entityAction[i] != 3)
+			continue;
+
+		ent = INDEXENT(g_entityId[i]);
+		if (!FNullEnt(ent) && !m_items.Has(ent))
+			m_items.Push(ent);
+	}
+}
+
 void AddBot(void)
 {
 	g_botManager->AddRandom();
@@ -880,58 +1205,205 @@ void AddBot_CT(void)
 	g_botManager->AddBotAPI("", -1, 2);
 }
 
-void InitConfig(void)
+// a config file read in one go, everything parsed from it points into text, so a file costs
+// one allocation and is only parsed again when it changed on disk
+struct ConfigText
 {
-	File fp;
-	char command[256], line[256];
+	char* text{};
+	time_t mtime{};
+	long size{-1};
+	uint32_t hash{};
+	bool missing{};
+};
+
+static ConfigText s_namesConfig{};
+static ConfigText s_chatConfig{};
+static ConfigText s_avatarsConfig{};
+
+// true when the file has to be parsed again, config.text is then the new contents or nullptr when it's gone
+static bool ReadConfig(ConfigText& config, const char* fileName, char* errorIfNotExists, const bool reload)
+{
+	char path[1024];
+	FormatBuffer(path, "%s/addons/ebot/%s", GetModName(), fileName);
 
-	KwChat replyKey;
-	int chatType = -1;
+	struct stat info;
+	if (stat(path, &info))
+	{
+		// only say it once, not on every map change
+		if (config.missing)
+			return false;
 
-#define SKIP_COMMENTS() if ((line[0] == '/') || (line[0] == '\r') || (line[0] == '\n') || (line[0] == 0) || (line[0] == ' ') || (line[0] == '\t')) continue;
+		AddLogEntry(Log::Error, errorIfNotExists);
+		safedel(config.text);
+		config.size = -1;
+		config.missing = true;
+		return true;
+	}
+
+	config.missing = false;
+	if (!reload && config.text && config.mtime == info.st_mtime && config.size == static_cast<long>(info.st_size))
+		return false;
+
+	File fp(path, "rb");
+	if (!fp.IsValid())
+		return false;
+
+	const int size = fp.GetSize();
+	char* text = safeloc<char>(size + 1);
+	fp.Read(text, size);
+	text[size] = '\0';
+	fp.Close();
+
+	// touched but not edited, keep what we have
+	uint32_t hash = 2166136261u;
+	int i;
+	for (i = 0; i < size; i++)
+	{
+		hash ^= static_cast<uint8_t>(text[i]);
+		hash *= 16777619u;
+	}
+
+	config.mtime = info.st_mtime;
+	config.size = static_cast<long>(info.st_size);
+	if (!reload && config.text && config.hash == hash)
+	{
+		safedel(text);
+		return false;
+	}
+
+	safedel(config.text);
+	config.text = text;
+	config.hash = hash;
+	return true;
+}
+
+// cuts the next line out of the text in place, nullptr at the end
+static char* NextConfigLine(char*& cursor, const int maxLength)
+{
+	if (!cursor || !*cursor)
+		return nullptr;
+
+	char* line = cursor;
+	char* end = line;
+	while (*end && *end != '\n')
+		end++;
+
+	cursor = *end ? end + 1 : end;
+	*end = '\0';
+
+	if (end - line > maxLength)
+		line[maxLength] = '\0';
+
+	return line;
+}
+
+// same as String::TrimQuotes, but in place
+static char* TrimConfigQuotes(char* text)
+{
+	int length = cstrlen(text);
+	while (length && text[length - 1] == '\"')
+		text[--length] = '\0';
+
+	while (length && text[length - 1] == '\'')
+		text[--length] = '\0';
+
+	while (*text == '\"')
+		text++;
+
+	while (*text == '\'')
+		text++;
+
+	return text;
+}
 
-	if (!g_botNames.IsEmpty())
+// the config text blocks and the pointer lists into them
+size_t GetConfigMemoryUsage(void)
+{
+	size_t bytes = 0;
+	if (s_namesConfig.text)
+		bytes += static_cast<size_t>(s_namesConfig.size) + 1;
+
+	if (s_chatConfig.text)
+		bytes += static_cast<size_t>(s_chatConfig.size) + 1;
+
+	if (s_avatarsConfig.text)
+		bytes += static_cast<size_t>(s_avatarsConfig.size) + 1;
+
+	bytes += static_cast<size_t>(g_botNames.Capacity()) * sizeof(NameItem);
+	bytes += static_cast<size_t>(g_botManager->m_avatars.Capacity()) * sizeof(char*);
+
+	int i;
+	bytes += static_cast<size_t>(g_chatFactory.GetSize()) * sizeof(Array <char*>);
+	for (i = 0; i < g_chatFactory.GetElementNumber(); i++)
+		bytes += static_cast<size_t>(g_chatFactory[i].GetSize()) * sizeof(char*);
+
+	bytes += static_cast<size_t>(g_replyFactory.GetSize()) * sizeof(KwChat);
+	for (i = 0; i < g_replyFactory.GetElementNumber(); i++)
 	{
-		int16_t i;
-		for (i = 0; i < g_botNames.Size(); i++)
-			g_botNames[i].isUsed = false;
+		const KwChat& group = g_replyFactory[i];
+		bytes += static_cast<size_t>(group.keywords.GetSize() + group.replies.GetSize()) * sizeof(char*) + static_cast<size_t>(group.usedReplies.GetSize()) * sizeof(bool);
 	}
 
+	return bytes;
+}
+
+void InitConfig(const bool reload)
+{
+	MEMORY_TAG(Mem_Chat);
+
+	char* line;
+	char* cursor;
+
+#define SKIP_COMMENTS() if ((line[0] == '/') || (line[0] == '\r') || (line[0] == '\n') || (line[0] == 0) || (line[0] == ' ') || (line[0] == '\t')) continue;
+
 	// NAME SYSTEM INITIALIZATION
-	if (g_botNames.IsEmpty() && OpenConfig("names.cfg", "Name configuration file not found.", &fp))
+	if (ReadConfig(s_namesConfig, "names.cfg", "Name configuration file not found.", reload))
 	{
-		while (fp.GetBuffer(line, 255))
+		g_botNames.Destroy();
+		for (cursor = s_namesConfig.text; (line = NextConfigLine(cursor, 254)) != nullptr;)
 		{
 			SKIP_COMMENTS();
 
 			cstrtrim(line);
-			NameItem item;
-
-			char Name[33];
-			sprintf(Name, "%s", line);
+			if (cstrlen(line) > 32)
+				line[32] = '\0';
 
-			item.name = Name;
+			NameItem item;
+			item.name = line;
 			item.isUsed = false;
 			g_botNames.Push(item);
 		}
-
-		fp.Close();
 	}
 
+	int16_t i;
+	for (i = 0; i < g_botNames.Size(); i++)
+		g_botNames[i].isUsed = false;
+
 	// CHAT SYSTEM CONFIG INITIALIZATION
-	char* field;
-	if (g_chatFactory.IsEmpty())
+	if (ReadConfig(s_chatConfig, "chat.cfg", "Chat file not found.", reload))
 	{
-		if (OpenConfig("chat.cfg", "Chat file not found.", &fp))
+		int j;
+		for (j = 0; j < g_chatFactory.GetElementNumber(); j++)
+			g_chatFactory[j].Destroy();
+
+		g_replyFactory.Destroy();
+		g_keywordMatcher.Destroy();
+
+		if (s_chatConfig.text)
 		{
+			KwChat replyKey;
 			int chatType = -1;
+			char command[256];
+			char* field;
+			char* keyword;
 			g_chatFactory.SetSize(CHAT_NUM);
 
-			while (fp.GetBuffer(line, 255))
+			for (cursor = s_chatConfig.text; (line = NextConfigLine(cursor, 254)) != nullptr;)
 			{
 				SKIP_COMMENTS();
 
-				field = GetField(line, 0, 1);
+				// the line has no new line character left to cut
+				field = GetField(line, 0, 0);
 				if (!field)
 					continue;
 
@@ -977,7 +1449,7 @@ void InitConfig(void)
 					continue;
 				}
 
-				if (chatType != 3)
+				if (chatType != 3 && cstrlen(line) > 79)
 					line[79] = 0;
 
 				cstrtrim(line);
@@ -1010,10 +1482,23 @@ void InitConfig(void)
 						}
 
 						replyKey.keywords.Destroy();
-						replyKey.keywords = String(&line[4]).Split(',');
 
-						ITERATE_ARRAY(replyKey.keywords, i)
-							replyKey.keywords[i].Trim().TrimQuotes();
+						// split on commas in place, empty fields are skipped like String::Split does
+						for (keyword = &line[4]; *keyword;)
+						{
+							field = keyword;
+							while (*keyword && *keyword != ',')
+								keyword++;
+
+							if (*keyword)
+								*keyword++ = '\0';
+
+							if (!*field)
+								continue;
+
+							cstrtrim(field);
+							replyKey.keywords.Push(TrimConfigQuotes(field));
+						}
 					}
 					else if (!replyKey.keywords.IsEmpty())
 						replyKey.replies.Push(line);
@@ -1042,7 +1527,11 @@ void InitConfig(void)
 				}
 			}
 
-			fp.Close();
+			// the last reply group has no @KEY after it
+			if (!replyKey.keywords.IsEmpty() && !replyKey.replies.IsEmpty())
+				g_replyFactory.Push(replyKey);
+
+			g_keywordMatcher.Build(g_replyFactory);
 		}
 		else
 		{
@@ -1052,16 +1541,15 @@ void InitConfig(void)
 	}
 
 	// AVATARS INITITALIZATION
-	if (OpenConfig("avatars.cfg", "Avatars config file not found. Avatars will not be displayed.", &fp))
+	if (ReadConfig(s_avatarsConfig, "avatars.cfg", "Avatars config file not found. Avatars will not be displayed.", reload))
 	{
-		while (fp.GetBuffer(line, 255))
+		g_botManager->m_avatars.Destroy();
+		for (cursor = s_avatarsConfig.text; (line = NextConfigLine(cursor, 254)) != nullptr;)
 		{
 			SKIP_COMMENTS();
 			cstrtrim(line);
 			g_botManager->m_avatars.Push(line);
 		}
-
-		fp.Close();
 	}
 }
 
@@ -2577,12 +3065,12 @@ void ClientCommand(edict_t* ent)
 			if (team != -1 && team != bot->m_team)
 				continue;
 
-			bot->m_sayTextBuffer.entityIndex = ENTINDEX(ent);
+			bot->m_cold->sayTextBuffer.entityIndex = ENTINDEX(ent);
 			if (IsNullString(CMD_ARGS()))
 				continue;
 
-			cstrncpy(bot->m_sayTextBuffer.sayText, CMD_ARGS(), sizeof(bot->m_sayTextBuffer.sayText));
-			bot->m_sayTextBuffer.timeNextChat = engine->GetTime() + bot->m_sayTextBuffer.chatDelay;
+			cstrncpy(bot->m_cold->sayTextBuffer.sayText, CMD_ARGS(), sizeof(bot->m_cold->sayTextBuffer.sayText) - 1);
+			bot->m_cold->sayTextBuffer.timeNextChat = engine->GetTime() + bot->m_cold->sayTextBuffer.chatDelay;
 		}
 	}
 
@@ -2630,11 +3118,15 @@ void ServerActivate(edict_t* pentEdictList, int edictCount, int clientMax)
 	// Once this function has been called, the server can be considered as "running".
 
 	// initialize all config files
-	InitConfig();
+	InitConfig(false);
+
+	// a recording covers one map
+	g_recorder.Stop();
 
 	// do level initialization stuff here...
 	g_waypoint->Initialize();
 	g_waypoint->Load();
+	g_flowFields.Reset();
 
 	// execute main config
 	ServerCommand("exec addons/ebot/ebot.cfg");
@@ -2651,71 +3143,88 @@ void ServerActivate(edict_t* pentEdictList, int edictCount, int clientMax)
 
 	secondTimer = 0.0f;
 	updateTimer = 0.0f;
-	g_pathTimer = 0.0f;
 
 	RETURN_META(MRES_IGNORED);
 }
 
-void SetPing(edict_t* to)
-{
-	if (FNullEnt(to))
-		return;
+// svc_pings payload for every bot, encoded once per frame and sent as is to everyone holding the scoreboard
+static uint8_t s_pingPacket[128];
+static int s_pingPacketSize = 0;
+static float s_pingPacketTime = -1.0f;
 
-	if (!(to->v.flags & FL_CLIENT))
-		return;
+static void BuildPingPacket(void)
+{
+	// the message is a bit stream, lowest bit first: per player a set flag, 5 bits slot,
+	// 12 bits ping and 7 bits loss, a clear flag ends it
+	uint32_t bits = 0;
+	int numBits = 0;
+	s_pingPacketSize = 0;
 
-	if (g_fakePingUpdate < engine->GetTime())
+	auto put = [&bits, &numBits](const uint32_t value, const int count)
 	{
-		// update timer if someone lookin' at scoreboard
-		if (to->v.buttons & IN_SCORE || to->v.oldbuttons & IN_SCORE)
-			g_fakePingUpdate = engine->GetTime() + 2.0f;
-		else
-			return;
-	}
+		bits |= value << numBits;
+		numBits += count;
+		while (numBits >= 8)
+		{
+			s_pingPacket[s_pingPacketSize++] = static_cast<uint8_t>(bits & 255);
+			bits >>= 8;
+			numBits -= 8;
+		}
+	};
 
-	int index;
-	static int sending{};
 	for (const auto& bot : g_botManager->m_bots)
 	{
 		if (!bot)
 			continue;
 
-		index = bot->m_index - 1;
-		switch (sending)
-		{
-		case 0:
-		{
-			// start a new message
-			MESSAGE_BEGIN(MSG_ONE_UNRELIABLE, 17, nullptr, to);
-			WRITE_BYTE((bot->m_pingOffset[sending] * 64) + (1 + 2 * index));
-			WRITE_SHORT(bot->m_ping[sending]);
-			sending++;
-		}
-		case 1:
-		{
-			// append additional data
-			WRITE_BYTE((bot->m_pingOffset[sending] * 128) + (2 + 4 * index));
-			WRITE_SHORT(bot->m_ping[sending]);
-			sending++;
-		}
-		case 2:
-		{
-			// append additional data and end message
-			WRITE_BYTE(4 + 8 * index);
-			WRITE_SHORT(bot->m_ping[sending]);
-			WRITE_BYTE(0);
-			MESSAGE_END();
-			sending = 0;
-		}
-		}
+		put(1, 1);
+		put(static_cast<uint32_t>(bot->m_index - 1) & 31, 5);
+		put(static_cast<uint32_t>(cclamp(bot->m_ping, 0, 4095)), 12);
+		put(0, 7);
 	}
 
-	// end message if not yet sent
-	if (sending)
+	put(0, 1);
+	if (numBits)
+		s_pingPacket[s_pingPacketSize++] = static_cast<uint8_t>(bits & 255);
+}
+
+void SetPing(edict_t* to)
+{
+	if (FNullEnt(to))
+		return;
+
+	if (!(to->v.flags & FL_CLIENT))
+		return;
+
+	// the engine only sends pings while the scoreboard is up, so only those clients need ours
+	if (!(to->v.buttons & IN_SCORE) && !(to->v.oldbuttons & IN_SCORE))
+		return;
+
+	// keep the bots calculating their pings while someone is looking
+	const float time = engine->GetTime();
+	g_fakePingUpdate = time + 2.0f;
+
+	if (s_pingPacketTime != time)
 	{
-		WRITE_BYTE(0);
-		MESSAGE_END();
+		BuildPingPacket();
+		s_pingPacketTime = time;
 	}
+
+	// nothing but the end flag, no bots
+	if (s_pingPacketSize < 2)
+		return;
+
+	MESSAGE_BEGIN(MSG_ONE_UNRELIABLE, SVC_PINGS, nullptr, to);
+
+	// longs are written little endian, same bytes in a quarter of the calls
+	int i;
+	for (i = 0; i + 4 <= s_pingPacketSize; i += 4)
+		WRITE_LONG(s_pingPacket[i] | (s_pingPacket[i + 1] << 8) | (s_pingPacket[i + 2] << 16) | (s_pingPacket[i + 3] << 24));
+
+	for (; i < s_pingPacketSize; i++)
+		WRITE_BYTE(s_pingPacket[i]);
+
+	MESSAGE_END();
 }
 
 void UpdateClientData(const struct edict_s* ent, int sendweapons, struct clientdata_s* cd)
@@ -2836,12 +3345,23 @@ void StartFrame(void)
 	// for example if a new player joins the server, we should disconnect a bot, and if the
 	// player population decreases, we should fill the server with other bots.
 
+	g_frameGovernor.Update();
+	g_frameGovernor.Enter();
+	g_profiler.Update();
+	g_memoryStats.Update();
+
 	if (updateTimer < engine->GetTime())
 	{
+		g_worldSnapshot.Update();
+		g_clientSnapshot.Update();
+		g_waypoint->UpdateThreatField();
+		g_teamPlanner.Update();
+		g_recorder.Update();
 		g_botManager->Think();
-		updateTimer = engine->GetTime() + (1.0f / ebot_think_fps.GetFloat());
+		updateTimer = engine->GetTime() + (1.0f / (ebot_think_fps.GetFloat() * g_frameGovernor.GetScale()));
 	}
 
+	g_frameGovernor.Leave();
 	RETURN_META(MRES_IGNORED);
 }
 
@@ -2853,6 +3373,11 @@ void StartFrame_Post(void)
 	// during the game, for example making the bots think (yes, because no Think() function exists
 	// for the bots by the MOD side, remember).  Post version called only by metamod.
 
+	g_frameGovernor.Enter();
+
+	// results of the worker jobs are applied here
+	g_jobPool.Sync();
+
 	if (secondTimer < engine->GetTime())
 		FrameThread();
 	else if (g_analyzenavmesh)
@@ -2862,6 +3387,17 @@ void StartFrame_Post(void)
 	else
 		g_botManager->MaintainBotQuota();
 
+	// build the derived waypoint tables in small steps instead of freezing the server
+	if (g_waypoint->IsBuildingPathMatrix())
+		g_waypoint->UpdatePathMatrix();
+	else if (g_waypoint->IsBuildingVisibility())
+		g_waypoint->UpdateVisibility(); // bots need the path matrix more, it goes first
+
+	// waypoints are downloaded on their own thread, swap them in once they arrive
+	if (g_waypoint->IsDownloading())
+		g_waypoint->UpdateDownload();
+
+	g_frameGovernor.Leave();
 	RETURN_META(MRES_IGNORED);
 }
 
@@ -2977,73 +3513,17 @@ exportc int GetEngineFunctions(enginefuncs_t* functionTable, int* /*interfaceVer
 
 	functionTable->pfnMessageBegin = [](int msgDest, int msgType, const float* origin, edict_t* ed)
 	{
-			// store the message type in our own variables, since the GET_USER_MSG_ID will just do a lot of strcmp's...
-			if (g_netMsg->GetId(NETMSG_MONEY) == -1)
-			{
-				g_netMsg->SetId(NETMSG_VGUI, GET_USER_MSG_ID(PLID, "VGUIMenu", nullptr));
-				g_netMsg->SetId(NETMSG_SHOWMENU, GET_USER_MSG_ID(PLID, "ShowMenu", nullptr));
-				g_netMsg->SetId(NETMSG_WLIST, GET_USER_MSG_ID(PLID, "WeaponList", nullptr));
-				g_netMsg->SetId(NETMSG_CURWEAPON, GET_USER_MSG_ID(PLID, "CurWeapon", nullptr));
-				g_netMsg->SetId(NETMSG_AMMOX, GET_USER_MSG_ID(PLID, "AmmoX", nullptr));
-				g_netMsg->SetId(NETMSG_AMMOPICK, GET_USER_MSG_ID(PLID, "AmmoPickup", nullptr));
-				//g_netMsg->SetId(NETMSG_DAMAGE, GET_USER_MSG_ID(PLID, "Damage", nullptr));
-				g_netMsg->SetId(NETMSG_MONEY, GET_USER_MSG_ID(PLID, "Money", nullptr));
-				g_netMsg->SetId(NETMSG_STATUSICON, GET_USER_MSG_ID(PLID, "StatusIcon", nullptr));
-				g_netMsg->SetId(NETMSG_DEATH, GET_USER_MSG_ID(PLID, "DeathMsg", nullptr));
-				g_netMsg->SetId(NETMSG_SCREENFADE, GET_USER_MSG_ID(PLID, "ScreenFade", nullptr));
-				g_netMsg->SetId(NETMSG_HLTV, GET_USER_MSG_ID(PLID, "HLTV", nullptr));
-				g_netMsg->SetId(NETMSG_TEXTMSG, GET_USER_MSG_ID(PLID, "TextMsg", nullptr));
-				g_netMsg->SetId(NETMSG_SCOREINFO, GET_USER_MSG_ID(PLID, "ScoreInfo", nullptr));
-				g_netMsg->SetId(NETMSG_BARTIME, GET_USER_MSG_ID(PLID, "BarTime", nullptr));
-				g_netMsg->SetId(NETMSG_SENDAUDIO, GET_USER_MSG_ID(PLID, "SendAudio", nullptr));
-				g_netMsg->SetId(NETMSG_SAYTEXT, GET_USER_MSG_ID(PLID, "SayText", nullptr));
-				g_netMsg->SetId(NETMSG_BOTVOICE, GET_USER_MSG_ID(PLID, "BotVoice", nullptr));
-			}
-
-			if (msgDest == MSG_SPEC && msgType == g_netMsg->GetId(NETMSG_HLTV))
-				g_netMsg->SetMessage(NETMSG_HLTV);
-
-			g_netMsg->HandleMessageIfRequired(msgType, NETMSG_WLIST);
-
-			if (msgDest == MSG_ALL)
-			{
-				//g_netMsg->HandleMessageIfRequired (msgType, NETMSG_SCOREINFO);
-				g_netMsg->HandleMessageIfRequired(msgType, NETMSG_DEATH);
-				g_netMsg->HandleMessageIfRequired(msgType, NETMSG_TEXTMSG);
-
-				if (msgType == SVC_INTERMISSION)
-				{
-					for (const auto& bot : g_botManager->m_bots)
-					{
-						if (bot)
-							bot->m_isAlive = false;
-					}
-				}
-			}
-			else
+		if (msgDest == MSG_ALL && msgType == SVC_INTERMISSION)
+		{
+			for (const auto& bot : g_botManager->m_bots)
 			{
-				bot = g_botManager->GetBot(ed);
-
-				// is this message for a bot?
-				if (bot && bot->GetEntity() == ed)
-				{
-					g_netMsg->SetBot(bot);
-
-					// message handling is done in usermsg.cpp
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_VGUI);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_CURWEAPON);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_AMMOX);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_AMMOPICK);
-					//g_netMsg->HandleMessageIfRequired(msgType, NETMSG_DAMAGE);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_MONEY);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_STATUSICON);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_SCREENFADE);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_BARTIME);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_TEXTMSG);
-					g_netMsg->HandleMessageIfRequired(msgType, NETMSG_SHOWMENU);
-				}
+				if (bot)
+					bot->m_isAlive = false;
 			}
+		}
 
+		// message handling is done in netmsg.cpp
+		g_netMsg->Begin(msgDest, msgType, ed);
 		RETURN_META(MRES_IGNORED);
 	};
 
@@ -3249,6 +3729,12 @@ exportc int Meta_Detach(PLUG_LOADTIME now, PL_UNLOAD_REASON reason)
 	}
 
 	g_botManager->RemoveAll(); // kick all bots off this server
+	g_waypoint->StopDownload();
+	g_waypoint->DestroyPathMatrix(); // cancels a matrix build, otherwise Stop would wait for the workers to finish it
+	g_jobPool.Stop();
+	g_logWriter.Stop();
+	g_profiler.CloseStream();
+	g_recorder.Stop();
 
 	return true;
 }
@@ -0,0 +1,115 @@
+﻿//
+// Job system for E-Bot
+//
+
+#include <core.h>
+
+ConVar ebot_worker_threads("ebot_worker_threads", "-1");
+
+void JobPool::Start(void)
+{
+	m_started = true;
+
+	// -1 leaves one core to the engine and never takes more than four
+	int count = ebot_worker_threads.GetInt();
+	if (count < 0)
+		count = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+
+	count = cclamp(count, 0, 4);
+	if (!count)
+		return;
+
+	m_stop.store(false);
+	m_workers = new(std::nothrow) std::thread[count];
+	if (!m_workers)
+	{
+		AddLogEntry(Log::Memory, "unable to allocate %d worker threads", count);
+		return;
+	}
+
+	m_numWorkers = count;
+
+	int i;
+	for (i = 0; i < count; i++)
+		m_workers[i] = std::thread(&JobPool::WorkerThread, this);
+}
+
+void JobPool::WorkerThread(void)
+{
+	Job job;
+	while (!m_stop.load(std::memory_order_acquire))
+	{
+		if (m_pending.Pop(job))
+		{
+			job.run(job.data);
+			while (!m_done.Push(job))
+				std::this_thread::yield();
+
+			continue;
+		}
+
+		// the timeout covers a submit that slipped in between the pop and the wait
+		std::unique_lock<std::mutex> lock(m_sleepLock);
+		m_wake.wait_for(lock, std::chrono::milliseconds(10), [this] { return m_stop.load() || !m_pending.IsEmpty(); });
+	}
+}
+
+void JobPool::Submit(const Job& job)
+{
+	if (!m_started)
+		Start();
+
+	if (m_numWorkers && m_pending.Push(job))
+	{
+		m_wake.notify_one();
+		return;
+	}
+
+	job.run(job.data);
+	if (!m_done.Push(job))
+		job.finish(job.data);
+}
+
+void JobPool::Sync(void)
+{
+	Job job;
+	while (m_done.Pop(job))
+		job.finish(job.data);
+}
+
+void JobPool::Stop(void)
+{
+	if (m_workers)
+	{
+		m_stop.store(true, std::memory_order_release);
+		m_wake.notify_all();
+
+		int i;
+		for (i = 0; i < m_numWorkers; i++)
+		{
+			if (m_workers[i].joinable())
+				m_workers[i].join();
+		}
+
+		delete[] m_workers;
+		m_workers = nullptr;
+	}
+
+	m_numWorkers = 0;
+	m_started = false;
+
+	// jobs nobody picked up only get their finish, so they can free what they own
+	Job job;
+	while (m_pending.Pop(job))
+		job.finish(job.data);
+
+	Sync();
+}
+
+int JobPool::GetWorkerCount(void)
+{
+	if (!m_started)
+		Start();
+
+	return m_numWorkers;
+}
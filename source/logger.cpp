@@ -0,0 +1,283 @@
+﻿//
+// Log writer for E-Bot
+//
+
+#include <core.h>
+#include <sys/stat.h>
+
+ConVar ebot_log_async("ebot_log_async", "1");
+ConVar ebot_log_max_kb("ebot_log_max_kb", "1024");
+ConVar ebot_log_repeat("ebot_log_repeat", "5");
+ConVar ebot_log_repeat_window("ebot_log_repeat_window", "10");
+
+// localtime shares one buffer between threads, the writer needs its own
+static void GetLocalTime(const time_t when, tm& out)
+{
+#ifdef PLATFORM_WIN32
+	localtime_s(&out, &when);
+#else
+	localtime_r(&when, &out);
+#endif
+}
+
+static int GetDay(const tm& local)
+{
+	return local.tm_year * 1000 + local.tm_yday;
+}
+
+static uint32_t HashMessage(const char* message)
+{
+	uint32_t hash = 2166136261u;
+	while (*message)
+	{
+		hash ^= static_cast<uint8_t>(*message++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+void LogWriter::SetFile(const char* base, const char* header)
+{
+	if (IsFileSet())
+		return;
+
+	cstrncpy(m_header, header, sizeof(m_header) - 1);
+	cstrncpy(m_base, base, sizeof(m_base) - 1);
+}
+
+void LogWriter::Start(void)
+{
+	m_started = true;
+	m_stop.store(false);
+	m_thread = std::thread(&LogWriter::WriterThread, this);
+}
+
+void LogWriter::WriterThread(void)
+{
+	for (;;)
+	{
+		{
+			// the timeout also picks up repeat counts queued without a wake
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_wake.wait_for(lock, std::chrono::milliseconds(250), [this] { return m_stop.load() || m_count || m_dropped; });
+			if (m_stop.load() && !m_count && !m_dropped)
+				break;
+		}
+
+		Drain();
+	}
+}
+
+void LogWriter::Queue(const char* text)
+{
+	tm local{};
+	GetLocalTime(time(nullptr), local);
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_count >= Const_LogLines)
+	{
+		m_dropped++;
+		return;
+	}
+
+	LogLine& line = m_lines[(m_head + m_count) % Const_LogLines];
+	line.day = GetDay(local);
+	snprintf(line.text, sizeof(line.text), "[%02d:%02d:%02d] %s\n", local.tm_hour, local.tm_min, local.tm_sec, text);
+	m_count++;
+}
+
+void LogWriter::Write(const char* text)
+{
+	m_maxBytes.store(cmax(ebot_log_max_kb.GetInt(), 16) * 1024, std::memory_order_relaxed);
+	Queue(text);
+
+	if (!ebot_log_async.GetBool())
+	{
+		Flush();
+		return;
+	}
+
+	if (!m_started)
+		Start();
+
+	m_wake.notify_one();
+}
+
+bool LogWriter::Allow(const char* message)
+{
+	const int limit = ebot_log_repeat.GetInt();
+	if (limit <= 0)
+		return true;
+
+	const uint32_t hash = HashMessage(message);
+	const time_t now = time(nullptr);
+	const time_t window = static_cast<time_t>(cmax(ebot_log_repeat_window.GetInt(), 1));
+	char summary[192];
+
+	Repeat* oldest = &m_repeats[0];
+	for (Repeat& repeat : m_repeats)
+	{
+		if (repeat.count && repeat.hash == hash)
+		{
+			if (now - repeat.start < window)
+			{
+				repeat.count++;
+				if (repeat.count <= limit)
+					return true;
+
+				repeat.suppressed++;
+				return false;
+			}
+
+			oldest = &repeat;
+			break;
+		}
+
+		if (repeat.start < oldest->start)
+			oldest = &repeat;
+	}
+
+	// the slot is reused, report what it held back first
+	if (oldest->suppressed)
+	{
+		snprintf(summary, sizeof(summary), "Log: previous message repeated %d more times: %s", oldest->suppressed, oldest->text);
+		Queue(summary);
+	}
+
+	oldest->hash = hash;
+	oldest->count = 1;
+	oldest->suppressed = 0;
+	oldest->start = now;
+	cstrncpy(oldest->text, message, sizeof(oldest->text) - 1);
+	return true;
+}
+
+void LogWriter::OpenFile(const int day)
+{
+	m_file.Close();
+	m_fileBytes = 0;
+	m_fileDay = day;
+
+	if (!IsFileSet())
+		return;
+
+	// if logs folder deleted, it will result a crash... so create it again before writing logs...
+	char path[300];
+	cstrncpy(path, m_base, sizeof(path) - 1);
+	char* slash = strrchr(path, '/');
+	if (slash)
+	{
+		*slash = '\0';
+		CreatePath(path);
+	}
+
+	// a file that is too big or from an earlier day moves aside, one old file is kept
+	snprintf(path, sizeof(path), "%s.txt", m_base);
+	struct stat info;
+	if (!stat(path, &info))
+	{
+		tm modified{};
+		GetLocalTime(info.st_mtime, modified);
+		if (info.st_size >= m_maxBytes.load(std::memory_order_relaxed) || GetDay(modified) != day)
+		{
+			char old[300];
+			snprintf(old, sizeof(old), "%s_old.txt", m_base);
+			remove(old);
+			rename(path, old);
+		}
+	}
+
+	if (!m_file.Open(path, "at"))
+		return;
+
+	m_fileBytes = m_file.GetSize();
+	if (!m_fileBytes)
+	{
+		const int length = cstrlen(m_header);
+		m_file.Write(m_header, length);
+		m_fileBytes += length;
+	}
+}
+
+void LogWriter::Drain(void)
+{
+	std::lock_guard<std::mutex> file(m_fileLock);
+
+	int count, dropped, i;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		count = m_count;
+		dropped = m_dropped;
+		for (i = 0; i < count; i++)
+		{
+			const LogLine& line = m_lines[(m_head + i) % Const_LogLines];
+			m_batch[i].day = line.day;
+			cstrncpy(m_batch[i].text, line.text, sizeof(m_batch[i].text) - 1);
+		}
+
+		m_head = (m_head + count) % Const_LogLines;
+		m_count = 0;
+		m_dropped = 0;
+	}
+
+	if (!count && !dropped)
+		return;
+
+	const int maxBytes = m_maxBytes.load(std::memory_order_relaxed);
+	int length;
+	for (i = 0; i < count; i++)
+	{
+		if (!m_file.IsValid() || m_batch[i].day != m_fileDay || m_fileBytes >= maxBytes)
+			OpenFile(m_batch[i].day);
+
+		if (!m_file.IsValid())
+			continue;
+
+		length = cstrlen(m_batch[i].text);
+		m_file.Write(m_batch[i].text, length);
+		m_fileBytes += length;
+	}
+
+	if (dropped && m_file.IsValid())
+		m_fileBytes += m_file.Printf("Log: %d lines dropped, the log writer fell behind\n", dropped);
+
+	if (m_file.IsValid())
+		m_file.Flush();
+}
+
+void LogWriter::Flush(void)
+{
+	Drain();
+}
+
+void LogWriter::Stop(void)
+{
+	char summary[192];
+	for (Repeat& repeat : m_repeats)
+	{
+		if (repeat.suppressed)
+		{
+			snprintf(summary, sizeof(summary), "Log: previous message repeated %d more times: %s", repeat.suppressed, repeat.text);
+			Queue(summary);
+		}
+
+		repeat = Repeat{};
+	}
+
+	if (m_started)
+	{
+		m_stop.store(true);
+		m_wake.notify_one();
+		if (m_thread.joinable())
+			m_thread.join();
+
+		m_started = false;
+	}
+
+	Drain();
+
+	std::lock_guard<std::mutex> file(m_fileLock);
+	m_file.Close();
+	m_fileDay = -1;
+}
@@ -0,0 +1,138 @@
+﻿//
+// Memory accounting for E-Bot
+//
+
+#include <core.h>
+
+extern size_t GetConfigMemoryUsage(void);
+
+static const char* s_tagNames[Mem_Count] =
+{
+	"waypoints",
+	"navmesh",
+	"tables",
+	"paths",
+	"chat",
+	"bots",
+	"other"
+};
+
+void MemoryCountAllocation(const size_t bytes)
+{
+	g_memoryStats.Count(g_memoryTag, bytes);
+}
+
+void MemoryStats::Sample(void)
+{
+	size_t held[Mem_Count]{};
+	g_waypoint->GetMemoryUsage(held[Mem_Waypoints], held[Mem_Tables], m_mapped);
+	held[Mem_Navmesh] = g_navmesh->GetMemoryUsage();
+	held[Mem_Paths] = g_flowFields.GetMemoryUsage();
+	held[Mem_Chat] = GetConfigMemoryUsage() + g_keywordMatcher.GetMemoryUsage();
+
+	// the bots live in fixed pools, only the slots in use are counted
+	for (const auto& bot : g_botManager->m_bots)
+	{
+		if (!bot)
+			continue;
+
+		held[Mem_Bots] += sizeof(Bot) + sizeof(BotColdData);
+		held[Mem_Paths] += static_cast<size_t>(bot->m_navNode.Capacity()) * sizeof(int16_t);
+		if (bot->m_cold)
+			held[Mem_Bots] += static_cast<size_t>(bot->m_cold->favoritePrimary.Capacity() + bot->m_cold->favoriteSecondary.Capacity() + bot->m_cold->favoriteStuff.Capacity()) * sizeof(char*);
+	}
+
+	int i;
+	for (i = 0; i < Mem_Count; i++)
+	{
+		m_tags[i].current = held[i];
+		if (held[i] > m_tags[i].peak)
+			m_tags[i].peak = held[i];
+	}
+}
+
+void MemoryStats::Update(void)
+{
+	uint32_t allocs, bytes;
+	int i;
+	for (i = 0; i < Mem_Count; i++)
+	{
+		MemoryTagStats& tag = m_tags[i];
+		allocs = m_allocs[i].exchange(0, std::memory_order_relaxed);
+		bytes = m_bytes[i].exchange(0, std::memory_order_relaxed);
+
+		tag.frameAllocs = allocs;
+		tag.frameBytes = bytes;
+		tag.maxFrameAllocs = cmax(tag.maxFrameAllocs, allocs);
+		tag.maxFrameBytes = cmax(tag.maxFrameBytes, bytes);
+		tag.totalAllocs += allocs;
+		tag.totalBytes += bytes;
+	}
+
+	m_frames++;
+
+	const double time = GetRealTime();
+	if (m_sampleTime > time)
+		return;
+
+	m_sampleTime = time + 1.0;
+	Sample();
+}
+
+void MemoryStats::Reset(void)
+{
+	int i;
+	for (i = 0; i < Mem_Count; i++)
+	{
+		const size_t current = m_tags[i].current;
+		m_tags[i] = MemoryTagStats{};
+		m_tags[i].current = current;
+		m_tags[i].peak = current;
+	}
+
+	m_frames = 0;
+}
+
+void MemoryStats::Show(void)
+{
+	Sample();
+
+	ServerPrintNoTag("Memory since the reset, %u frames, sizes in KB:", m_frames);
+	ServerPrintNoTag("%-10s %10s %10s %10s %10s %10s %10s %12s %12s", "tag", "current", "peak", "allocs/f", "KB/f", "max al/f", "max KB/f", "allocs", "KB");
+
+	size_t current = 0, peak = 0;
+	int i;
+	for (i = 0; i < Mem_Count; i++)
+	{
+		const MemoryTagStats& tag = m_tags[i];
+		current += tag.current;
+		peak += tag.peak;
+
+		ServerPrintNoTag("%-10s %10.1f %10.1f %10u %10.1f %10u %10.1f %12llu %12.1f", s_tagNames[i], tag.current / 1024.0, tag.peak / 1024.0,
+			tag.frameAllocs, tag.frameBytes / 1024.0, tag.maxFrameAllocs, tag.maxFrameBytes / 1024.0,
+			static_cast<unsigned long long>(tag.totalAllocs), static_cast<double>(tag.totalBytes) / 1024.0);
+	}
+
+	// peaks of different tags can come from different moments, their sum is an upper bound
+	ServerPrintNoTag("%-10s %10.1f %10.1f", "total", current / 1024.0, peak / 1024.0);
+
+	if (m_mapped)
+		ServerPrintNoTag("Waypoint tables mapped from their file: %.1f KB of address space, not in the heap", m_mapped / 1024.0);
+}
+
+void MemoryStats::Dump(FILE* fp)
+{
+	Sample();
+
+	fprintf(fp, "\nmemory_tag,current_bytes,peak_bytes,frame_allocs,frame_bytes,max_frame_allocs,max_frame_bytes,total_allocs,total_bytes\n");
+
+	int i;
+	for (i = 0; i < Mem_Count; i++)
+	{
+		const MemoryTagStats& tag = m_tags[i];
+		fprintf(fp, "%s,%llu,%llu,%u,%u,%u,%u,%llu,%llu\n", s_tagNames[i], static_cast<unsigned long long>(tag.current), static_cast<unsigned long long>(tag.peak),
+			tag.frameAllocs, tag.frameBytes, tag.maxFrameAllocs, tag.maxFrameBytes, static_cast<unsigned long long>(tag.totalAllocs), static_cast<unsigned long long>(tag.totalBytes));
+	}
+
+	fprintf(fp, "mapped_tables,%llu,%llu,0,0,0,0,0,0\n", static_cast<unsigned long long>(m_mapped), static_cast<unsigned long long>(m_mapped));
+}
@@ -155,7 +155,7 @@ ENavDir GetDirection(const Vector& start, const Vector& end)
     return static_cast<ENavDir>(static_cast<int>((degree + 45.0f) * 0.0111111111111f) % ENavDir::NumDir);
 }
 
-void ENavArea::MergeWith(const ENavArea area)
+void ENavArea::MergeBounds(const ENavArea& area)
 {
     if (direction[ENavDir::Left] > area.direction[ENavDir::Left])
     {
@@ -180,29 +180,33 @@ void ENavArea::MergeWith(const ENavArea area)
         direction[ENavDir::Forward] = area.direction[ENavDir::Forward];
         dirHeight[ENavDir::Forward] = area.dirHeight[ENavDir::Forward];
     }
+}
 
-    ENavArea temp;
+void ENavArea::MergeWith(const ENavArea area)
+{
+    MergeBounds(area);
+
+    // we lead wherever it led, and whoever led to it now leads to us
     uint16_t i, j;
+    for (j = 0; j < area.connectionCount; j++)
+    {
+        if (area.connection[j] != index)
+            g_navmesh->ConnectArea(index, area.connection[j]);
+    }
+
+    const ENavArea* other;
     for (i = 0; i < g_numNavAreas; i++)
     {
-        temp = g_navmesh->GetNavArea(i);
-        if (area.index == temp.index)
-        {
-            for (j = 0; j < area.connectionCount; j++)
-            {
-                g_navmesh->ConnectArea(index, area.connection[j]);
-                if (area.connection[j] == area.index)
-                    g_navmesh->ConnectArea(area.connection[j], index);
-            }
-        }
-        else
+        if (i == area.index || i == index)
+            continue;
+
+        other = g_navmesh->GetNavAreaP(i);
+        for (j = 0; j < other->connectionCount; j++)
         {
-            for (j = 0; j < temp.connectionCount; j++)
+            if (other->connection[j] == area.index)
             {
-                if (temp.connection[j] != area.index)
-                    continue;
-                
-                g_navmesh->ConnectArea(temp.connection[j], index);
+                g_navmesh->ConnectArea(i, index);
+                break;
             }
         }
     }
@@ -23,6 +23,7 @@
 //
 
 #include <core.h>
+#include <emmintrin.h>
 
 ConVar ebot_zombies_as_path_cost("ebot_zombie_count_as_path_cost", "1");
 ConVar ebot_has_semiclip("ebot_has_semiclip", "0");
@@ -31,6 +32,129 @@ ConVar ebot_stuck_detect_height("ebot_stuck_detect_height", "72.0");
 ConVar ebot_force_shortest_path("ebot_force_shortest_path", "0");
 ConVar ebot_pathfinder_seed_min("ebot_pathfinder_seed_min", "0.5");
 ConVar ebot_pathfinder_seed_max("ebot_pathfinder_seed_max", "5.0");
+ConVar ebot_path_slice_nodes("ebot_path_slice_nodes", "256");
+ConVar ebot_planner_interval("ebot_planner_interval", "1.0");
+ConVar ebot_planner_spread("ebot_planner_spread", "256.0");
+ConVar ebot_flowfield("ebot_flowfield", "1");
+ConVar ebot_flowfield_bots("ebot_flowfield_bots", "2");
+ConVar ebot_flowfield_interval("ebot_flowfield_interval", "0.5");
+ConVar ebot_flowfield_escape_radius("ebot_flowfield_escape_radius", "768.0");
+ConVar ebot_path_repair("ebot_path_repair", "1");
+ConVar ebot_path_repair_nodes("ebot_path_repair_nodes", "128");
+ConVar ebot_aim_batch("ebot_aim_batch", "1");
+
+void TeamPlanner::Update(void)
+{
+	const float time = engine->GetTime();
+	if (m_nextUpdate > time)
+		return;
+
+	m_nextUpdate = time + cmaxf(ebot_planner_interval.GetFloat(), 0.1f);
+
+	int i;
+	Bot* bot;
+	for (i = 0; i < 32; i++)
+	{
+		m_campPoint[i] = -1;
+		bot = g_botManager->GetBot(i);
+		m_goal[i] = (bot && bot->m_isAlive) ? static_cast<int16_t>(bot->m_currentGoalIndex) : -1;
+	}
+
+	if (!IsZombieMode() || g_waypoint->m_zmHmPoints.IsEmpty() || g_DelayTimer > time)
+		return;
+
+	// humans near each point once for everyone, instead of every bot tracing to every client for every point
+	MiniArray <int16_t>& points = g_waypoint->m_zmHmPoints;
+	const uint32_t humans = g_clientSnapshot.m_alive & ~g_clientSnapshot.m_zombie;
+	m_pointNear.Truncate(0);
+	m_pointLoad.Truncate(0);
+	for (i = 0; i < points.Size(); i++)
+	{
+		m_pointNear.Push(g_clientSnapshot.GetInRadius(g_waypoint->m_paths[points.Get(i)].origin, squaredf(192.0f), humans, 0.54f));
+		m_pointLoad.Push(static_cast<uint8_t>(0));
+	}
+
+	const WaypointThreatField& field = g_waypoint->GetThreatField();
+	const float spread = cmaxf(ebot_planner_spread.GetFloat(), 0.0f);
+	int k, tier, team, index, best;
+	float distance, cost, bestCost;
+	uint32_t friends;
+	for (i = 0; i < 32; i++)
+	{
+		bot = g_botManager->GetBot(i);
+		if (!bot || !bot->m_isAlive || bot->m_isZombieBot || IsValidWaypoint(bot->m_myMeshWaypoint))
+			continue;
+
+		team = cclamp(bot->m_team, Team::Terrorist, Team::Counter);
+		friends = humans & g_clientSnapshot.GetTeamMask(bot->m_team) & ~(1u << i);
+		best = -1;
+		bestCost = FLT_MAX;
+		for (k = 0; k < points.Size(); k++)
+		{
+			index = points.Get(k);
+			if (IsValidWaypoint(bot->m_currentWaypointIndex))
+				distance = g_waypoint->GetPathDistance(bot->m_currentWaypointIndex, index);
+			else
+				distance = (bot->pev->origin - g_waypoint->m_paths[index].origin).GetLengthSquared();
+
+			if (distance == FLT_MAX)
+				continue;
+
+			// with friends left stay with them, else keep away from the zombies, alone just take the nearest
+			tier = 0;
+			if (bot->m_numFriendsLeft && !(m_pointNear[k] & friends))
+				tier = field.zombies[team][index] ? 2 : 1;
+
+			cost = static_cast<float>(tier) * 65536.0f + csqrtf(distance) + static_cast<float>(m_pointLoad[k]) * spread;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				best = k;
+			}
+		}
+
+		if (best == -1)
+			continue;
+
+		if (m_pointLoad[best] < 255)
+			m_pointLoad[best]++;
+
+		m_campPoint[i] = points.Get(best);
+	}
+}
+
+int TeamPlanner::PickGoal(const int slot, const int team, const MiniArray <int16_t>& points)
+{
+	if (points.IsEmpty())
+		return -1;
+
+	const uint32_t mates = g_clientSnapshot.GetTeamMask(team);
+	int i, j, claims, index, best = -1, bestClaims = 33;
+	for (i = 0; i < 3; i++)
+	{
+		index = points.Random();
+		claims = 0;
+		for (j = 0; j < 32; j++)
+		{
+			if (j != slot && m_goal[j] == index && (mates & (1u << j)))
+				claims++;
+		}
+
+		if (claims < bestClaims)
+		{
+			bestClaims = claims;
+			best = index;
+		}
+
+		if (!claims)
+			break;
+	}
+
+	if (slot >= 0 && slot < 32)
+		m_goal[slot] = static_cast<int16_t>(best);
+
+	return best;
+}
 
 int Bot::FindGoal(void)
 {
@@ -51,75 +175,15 @@ int Bot::FindGoal(void)
 		{
 			if (!g_waypoint->m_zmHmPoints.IsEmpty())
 			{
-				if (g_DelayTimer < engine->GetTime())
-				{
-					float dist, maxDist = 999999999999.0f;
-					int16_t i, index = -1, temp;
-
-					if (m_numFriendsLeft)
-					{
-						for (i = 0; i < g_waypoint->m_zmHmPoints.Size(); i++)
-						{
-							temp = g_waypoint->m_zmHmPoints.Get(i);
-							dist = (pev->origin - g_waypoint->m_paths[temp].origin).GetLengthSquared();
-							if (dist > maxDist)
-								continue;
-
-							// bots won't left you alone like other persons in your life...
-							if (!IsFriendReachableToPosition(g_waypoint->m_paths[temp].origin))
-								continue;
-
-							index = temp;
-							maxDist = dist;
-						}
-
-						if (!IsValidWaypoint(index))
-						{
-							maxDist = 999999999999.0f;
-							int16_t i, index = -1, temp;
-							for (i = 0; i < g_waypoint->m_zmHmPoints.Size(); i++)
-							{
-								temp = g_waypoint->m_zmHmPoints.Get(i);
-								dist = (pev->origin - g_waypoint->m_paths[temp].origin).GetLengthSquared();
-								if (dist > maxDist)
-									continue;
-
-								// no friends nearby? go to safe camp spot
-								if (IsEnemyReachableToPosition(g_waypoint->m_paths[temp].origin))
-									continue;
-
-								index = temp;
-								maxDist = dist;
-							}
-						}
-					}
-
-					// if we are alone just stay to nearest
-					// theres nothing we can do...
-					if (!IsValidWaypoint(index))
-					{
-						maxDist = 999999999999.0f;
-						for (i = 0; i < g_waypoint->m_zmHmPoints.Size(); i++)
-						{
-							temp = g_waypoint->m_zmHmPoints.Get(i);
-							dist = (pev->origin - g_waypoint->m_paths[temp].origin).GetLengthSquared();
+				// the team planner scores the camp points for all humans at once
+				const int index = g_teamPlanner.GetCampPoint(m_index - 1);
+				if (IsValidWaypoint(index))
+					return index;
 
-							// at least get nearest camp spot
-							if (dist > maxDist)
-								continue;
-
-							index = temp;
-							maxDist = dist;
-						}
-					}
+				if (g_DelayTimer < engine->GetTime())
+					g_teamPlanner.Request();
 
-					if (IsValidWaypoint(index))
-						return index;
-					else
-						return g_waypoint->m_zmHmPoints.Random();
-				}
-				else
-					return g_waypoint->m_zmHmPoints.Random();
+				return g_waypoint->m_zmHmPoints.Random();
 			}
 		}
 
@@ -228,7 +292,7 @@ int Bot::FindGoal(void)
 					{
 						if (!g_waypoint->m_ctPoints.IsEmpty())
 						{
-							const int index = g_waypoint->m_ctPoints.Random();
+							const int index = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_ctPoints);
 							if (IsValidWaypoint(index))
 								return m_currentGoalIndex = index;
 						}
@@ -241,11 +305,11 @@ int Bot::FindGoal(void)
 							if (IsValidWaypoint(m_navNode.Last()) && g_waypoint->GetPath(m_navNode.Last())->flags & WAYPOINT_GOAL)
 								return m_currentGoalIndex = m_navNode.Last();
 							else if (!g_waypoint->m_goalPoints.IsEmpty())
-								return m_currentGoalIndex = g_waypoint->m_goalPoints.Random();
+								return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_goalPoints);
 						}
 						else if (!g_waypoint->m_terrorPoints.IsEmpty())
 						{
-							const int index = g_waypoint->m_terrorPoints.Random();
+							const int index = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_terrorPoints);
 							if (IsValidWaypoint(index))
 								return m_currentGoalIndex = index;
 						}
@@ -262,24 +326,24 @@ int Bot::FindGoal(void)
 					if (IsValidWaypoint(m_navNode.Last()) && g_waypoint->GetPath(m_navNode.Last())->flags & WAYPOINT_RESCUE)
 						return m_currentGoalIndex = m_navNode.Last();
 					else
-						return m_currentGoalIndex = g_waypoint->m_rescuePoints.Random();
+						return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_rescuePoints);
 				}
 				else
 				{
 					if (!g_waypoint->m_goalPoints.IsEmpty() && (g_timeRoundMid < engine->GetTime() || crandomint(1, 3) <= 2))
-						return m_currentGoalIndex = g_waypoint->m_goalPoints.Random();
+						return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_goalPoints);
 					else if (!g_waypoint->m_ctPoints.IsEmpty())
-						return m_currentGoalIndex = g_waypoint->m_ctPoints.Random();
+						return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_ctPoints);
 				}
 			}
 			else
 			{
 				if (!g_waypoint->m_rescuePoints.IsEmpty() && crandomint(1, 11) == 1)
-					return m_currentGoalIndex = g_waypoint->m_rescuePoints.Random();
+					return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_rescuePoints);
 				else if (!g_waypoint->m_goalPoints.IsEmpty() && crandomint(1, 3) == 1)
-					return m_currentGoalIndex = g_waypoint->m_goalPoints.Random();
+					return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_goalPoints);
 				else if (!g_waypoint->m_terrorPoints.IsEmpty())
-					return m_currentGoalIndex = g_waypoint->m_terrorPoints.Random();
+					return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_terrorPoints);
 			}
 		}
 		else if (g_mapType == MAP_AS)
@@ -287,21 +351,21 @@ int Bot::FindGoal(void)
 			if (m_team == Team::Counter)
 			{
 				if (m_isVIP && !g_waypoint->m_goalPoints.IsEmpty())
-					return m_currentGoalIndex = g_waypoint->m_goalPoints.Random();
+					return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_goalPoints);
 				else
 				{
 					if (!g_waypoint->m_goalPoints.IsEmpty() && crandomint(1, 2) == 1)
-						return m_currentGoalIndex = g_waypoint->m_goalPoints.Random();
+						return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_goalPoints);
 					else if (!g_waypoint->m_ctPoints.IsEmpty())
-						return m_currentGoalIndex = g_waypoint->m_ctPoints.Random();
+						return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_ctPoints);
 				}
 			}
 			else
 			{
 				if (!g_waypoint->m_goalPoints.IsEmpty() && crandomint(1, 11) == 1)
-					return m_currentGoalIndex = g_waypoint->m_goalPoints.Random();
+					return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_goalPoints);
 				else if (!g_waypoint->m_terrorPoints.IsEmpty())
-					return m_currentGoalIndex = g_waypoint->m_terrorPoints.Random();
+					return m_currentGoalIndex = g_teamPlanner.PickGoal(m_index - 1, m_team, g_waypoint->m_terrorPoints);
 			}
 		}
 	}
@@ -325,9 +389,7 @@ void Bot::MoveTo(const Vector& targetPosition)
 	const Vector directionOld = (targetPosition + m_moveAngles * -m_frameInterval) - (pev->origin + m_moveAngles * m_frameInterval);
 	const Vector directionNormal = directionOld.Normalize2D();
 	SetStrafeSpeed(directionNormal, pev->maxspeed);
-	m_moveAngles = directionOld.ToAngles();
-	m_moveAngles.ClampAngles();
-	m_moveAngles.x = -m_moveAngles.x; // invert for engine
+	SetMoveDirection(directionOld);
 	m_moveSpeed = pev->maxspeed;
 }
 
@@ -336,9 +398,7 @@ void Bot::MoveOut(const Vector& targetPosition)
 	const Vector directionOld = (targetPosition + m_moveAngles * -m_frameInterval) - (pev->origin + m_moveAngles * m_frameInterval);
 	const Vector directionNormal = directionOld.Normalize2D();
 	SetStrafeSpeed(directionNormal, pev->maxspeed);
-	m_moveAngles = directionOld.ToAngles();
-	m_moveAngles.ClampAngles();
-	m_moveAngles.x = -m_moveAngles.x; // invert for engine
+	SetMoveDirection(directionOld);
 	m_moveSpeed = -pev->maxspeed;
 }
 
@@ -348,9 +408,7 @@ void Bot::FollowPath(void)
 	m_moveSpeed = GetMaxSpeed();
 	DoWaypointNav();
 	CheckStuck(m_moveSpeed + cabsf(m_strafeSpeed));
-	m_moveAngles = ((m_destOrigin - m_moveAngles * -m_frameInterval) - (pev->origin + m_moveAngles * m_frameInterval)).ToAngles();
-	m_moveAngles.ClampAngles();
-	m_moveAngles.x = -m_moveAngles.x; // invert for engine
+	SetMoveDirection((m_destOrigin - m_moveAngles * -m_frameInterval) - (pev->origin + m_moveAngles * m_frameInterval));
 }
 
 // this function used after jump action to track real path
@@ -465,10 +523,7 @@ void Bot::DoWaypointNav(void)
 
 	if (m_waypoint.flags & WAYPOINT_FALLCHECK)
 	{
-		TraceResult tr{};
-		const Vector origin = g_waypoint->m_paths[m_currentWaypointIndex].origin;
-		TraceLine(origin, origin - Vector(0.0f, 0.0f, 60.0f), false, false, GetEntity(), &tr);
-		if (tr.flFraction == 1.0f)
+		if (!g_waypoint->HasGround(m_currentWaypointIndex))
 		{
 			m_navNode.Clear();
 			ResetStuck();
@@ -479,10 +534,7 @@ void Bot::DoWaypointNav(void)
 	}
 	else if (m_waypoint.flags & WAYPOINT_WAITUNTIL)
 	{
-		TraceResult tr{};
-		const Vector origin = g_waypoint->m_paths[m_currentWaypointIndex].origin;
-		TraceLine(origin, origin - Vector(0.0f, 0.0f, 60.0f), false, false, GetEntity(), &tr);
-		if (tr.flFraction == 1.0f)
+		if (!g_waypoint->HasGround(m_currentWaypointIndex))
 		{
 			ResetStuck();
 			m_moveSpeed = 0.0f;
@@ -1070,465 +1122,550 @@ bool Bot::UpdateLiftStates(void)
 	return true;
 }
 
-class PriorityQueue
-{
-public:
-	PriorityQueue(void);
-	~PriorityQueue(void);
-	inline bool IsEmpty(void) const { return !m_size; }
-	inline int16_t Size(void) const { return m_size; }
-	inline void InsertLowest(const int16_t value, const float priority);
-	inline void InsertHighest(const int16_t value, const float priority);
-	inline int16_t RemoveLowest(void);
-	inline int16_t RemoveHighest(void);
-private:
-	struct HeapNode
-	{
-		int16_t id{};
-		float priority{};
-	} *m_heap{};
-	int16_t m_size{};
-	int16_t m_heapSize{};
+static SearchPool s_searchPool;
+
+// search that can continue over frames, one for each bot
+struct PathSearch
+{
+	SearchPool pool;
+	PathCost cost{};
+	edict_t* enemy{};
+	int seed{};
+	float min{};
+	float max{};
+	int16_t srcIndex{};
+	int16_t destIndex{};
+	int16_t stuckIndex{};
+	int16_t enemyIndex{}; // waypoint of the enemy when the visibility table can stand in for traces
+	bool hasHostage{};
+	MiniArray <int16_t> lastPath{}; // last path handed to the bot, a block on it gets repaired instead of searched again
+	uint32_t lastVersion{}; // waypoint version the last path was made with
 };
 
-PriorityQueue::PriorityQueue(void)
+static PathSearch s_pathSearch[32];
+static SearchPool s_repairPool;
+static SearchPool s_repairJoin; // marks the old path after the block, parent is the position on it
+
+// remembers the path a search gave the bot, from where the bot is now
+static void KeepPath(PathSearch& search, PathNode& path)
 {
-	m_size = 0;
-	m_heapSize = static_cast<int16_t>((g_numWaypoints / 2) + 32);
-	m_heap = static_cast<HeapNode*>(malloc(sizeof(HeapNode) * m_heapSize));
+	const int16_t length = path.Length();
+	search.lastPath.Truncate(0);
+	search.lastVersion = g_waypoint->GetHotData().version;
+	if (search.lastPath.Capacity() < length)
+		search.lastPath.Resize(length, true);
+
+	int16_t i;
+	for (i = 0; i < length; i++)
+		search.lastPath.Push(path.Get(i), false);
 }
 
-PriorityQueue::~PriorityQueue(void)
+inline const Vector HF_Origin(const int16_t index)
 {
-	if (m_heap)
-		free(m_heap);
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	return Vector(hot.originX[index], hot.originY[index], hot.originZ[index]);
+}
 
-	m_size = 0;
-	m_heapSize = 0;
+inline const float HF_Distance(const int16_t start, const int16_t goal)
+{
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	const float x = hot.originX[start] - hot.originX[goal];
+	const float y = hot.originY[start] - hot.originY[goal];
+	const float z = hot.originZ[start] - hot.originZ[goal];
+	return csqrtf(x * x + y * y + z * z);
 }
 
-// inserts a value into the priority queue
-void PriorityQueue::InsertLowest(const int16_t value, const float priority)
+inline const float HF_Distance2D(const int16_t start, const int16_t goal)
 {
-	if (m_size >= m_heapSize)
-	{
-		m_heapSize += static_cast<int16_t>(50);
-		if (!m_heap)
-			m_heap = static_cast<HeapNode*>(malloc(sizeof(HeapNode) * m_heapSize));
-		else
-		{
-			HeapNode* hp = static_cast<HeapNode*>(realloc(m_heap, sizeof(HeapNode) * m_size));
-			m_heap = hp;
-			hp = nullptr;
-		}
-	}
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	const float x = hot.originX[start] - hot.originX[goal];
+	const float y = hot.originY[start] - hot.originY[goal];
+	return csqrtf(x * x + y * y);
+}
 
-	if (!m_heap)
-		return;
+inline const float HF_DistanceSquared(const int16_t start, const int16_t goal)
+{
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	const float x = hot.originX[start] - hot.originX[goal];
+	const float y = hot.originY[start] - hot.originY[goal];
+	const float z = hot.originZ[start] - hot.originZ[goal];
+	return x * x + y * y + z * z;
+}
 
-	m_heap[m_size].priority = priority;
-	m_heap[m_size].id = value;
+// bot state the cost policies read, taken once per search slice
+struct PathCostContext
+{
+	int8_t team; // terrorist or counter, indexes the threat field
+	bool isZombie;
+	const WaypointThreatField* threats;
+};
 
-	static int16_t child{};
-	static int16_t parent{};
-	static HeapNode temp{};
+// rules shared by every cost policy, true if the parent waypoint can't be used
+inline bool IsPathCostBlocked(const int16_t parent, const uint32_t parentFlags, const PathCostContext& context)
+{
+	if (parentFlags & WAYPOINT_AVOID)
+		return true;
 
-	child = ++m_size - 1;
-	while (child)
+	if (context.isZombie)
 	{
-		parent = (child - 1) / 2;
-		if (m_heap[parent].priority < m_heap[child].priority)
-			break;
-
-		temp = m_heap[child];
-		m_heap[child] = m_heap[parent];
-		m_heap[parent] = temp;
-		child = parent;
+		if (parentFlags & WAYPOINT_HUMANONLY)
+			return true;
 	}
-}
+	else if (parentFlags & (WAYPOINT_ZOMBIEONLY | WAYPOINT_DJUMP))
+		return true;
 
-// inserts a value into the priority queue
-void PriorityQueue::InsertHighest(const int16_t value, const float priority)
-{
-	if (m_size >= m_heapSize)
-	{
-		m_heapSize += static_cast<int16_t>(50);
-		if (!m_heap)
-			m_heap = static_cast<HeapNode*>(malloc(sizeof(HeapNode) * m_heapSize));
-		else
-		{
-			HeapNode* hp = static_cast<HeapNode*>(realloc(m_heap, sizeof(HeapNode) * m_size));
-			m_heap = hp;
-			hp = nullptr;
-		}
-	}
+	if ((parentFlags & WAYPOINT_ONLYONE) && (context.threats->IsOccupied(context.team, parent) || context.threats->IsHumanReserved(context.team, parent)))
+		return true;
 
-	if (!m_heap)
-		return;
+	return false;
+}
 
-	m_heap[m_size].priority = priority;
-	m_heap[m_size].id = value;
+// teammates that can boost a zombie on a double jump waypoint
+inline int CountPathBoosters(const int16_t parent, const PathCostContext& context)
+{
+	const Vector origin = HF_Origin(parent);
+	const int radius = squaredi(static_cast<int>(g_waypoint->GetHotData().radius[parent]) + 512);
 
-	static int16_t child{};
-	static int16_t parent{};
-	static HeapNode temp{};
+	const uint32_t team = g_clientSnapshot.GetTeamMask(context.team);
+	const uint32_t near = g_clientSnapshot.GetInRadius(origin, static_cast<float>(radius), team);
 
-	child = ++m_size - 1;
-	while (child)
+	// the rest still count if they can see the jump
+	int i;
+	int count = cpopcount(near);
+	uint32_t far = team & ~near;
+	for (i = 0; far; i++, far >>= 1)
 	{
-		parent = (child - 1) / 2;
-		if (m_heap[parent].priority > m_heap[child].priority)
-			break;
-
-		temp = m_heap[child];
-		m_heap[child] = m_heap[parent];
-		m_heap[parent] = temp;
-		child = parent;
+		if ((far & 1u) && IsVisible(origin, g_clients[i].ent))
+			count++;
 	}
+
+	return count;
 }
 
-// removes the smallest item from the priority queue
-int16_t PriorityQueue::RemoveLowest(void)
+// cost policies, each one gets its own specialized search loop through Bot::ExpandPath
+struct CostHuman
 {
-	if (!m_heap)
-		return -1;
+	static inline float Get(const int16_t index, const int16_t parent, const uint32_t parentFlags, const PathCostContext& context)
+	{
+		if (!parentFlags)
+			return HF_Distance2D(index, parent);
 
-	static int16_t retID{};
-	retID = m_heap[0].id;
+		if (IsPathCostBlocked(parent, parentFlags, context))
+			return 65355.0f;
+
+		const WaypointThreatField& threats = *context.threats;
+		const int count = threats.zombies[context.team][parent];
+		if (!count)
+			return HF_Distance(index, parent);
 
-	m_size--;
-	m_heap[0] = m_heap[m_size];
+		// summed squared distance of every zombie to the parent
+		const Vector origin = HF_Origin(parent);
+		const float totalDistance = threats.zombieSquaredSum[context.team] - 2.0f * (threats.zombieSum[context.team] | origin) + static_cast<float>(threats.zombieCount[context.team]) * origin.GetLengthSquared();
+		if (totalDistance > 0.0f)
+			return (HF_Distance(index, parent) * static_cast<float>(count)) + totalDistance;
 
-	static int16_t parent{};
-	static int16_t child{};
-	static int16_t rightChild{};
-	static HeapNode ref{};
+		return HF_Distance(index, parent);
+	}
+};
 
-	parent = 0;
-	child = (2 * parent) + 1;
-	ref = m_heap[parent];
-	while (child < m_size)
+struct CostCareful
+{
+	static inline float Get(const int16_t index, const int16_t parent, const uint32_t parentFlags, const PathCostContext& context)
 	{
-		rightChild = (2 * parent) + 2;
-		if (rightChild < m_size)
+		if (!parentFlags)
+			return HF_Distance2D(index, parent);
+
+		if (IsPathCostBlocked(parent, parentFlags, context))
+			return 65355.0f;
+
+		if (context.isZombie && (parentFlags & WAYPOINT_DJUMP))
 		{
-			if (m_heap[rightChild].priority < m_heap[child].priority)
-				child = rightChild;
-		}
+			// don't count me
+			const int count = CountPathBoosters(parent, context);
+			if (count < 2)
+				return 65355.0f;
 
-		if (ref.priority < m_heap[child].priority)
-			break;
+			return HF_Distance2D(index, parent) / static_cast<float>(count);
+		}
 
-		m_heap[parent] = m_heap[child];
-		parent = child;
-		child = (2 * parent) + 1;
+		return HF_Distance2D(index, parent);
 	}
+};
 
-	m_heap[parent] = ref;
-	return retID;
-}
-
-// removes the largest item from the priority queue
-int16_t PriorityQueue::RemoveHighest(void)
+struct CostNormal
 {
-	if (!m_heap)
-		return -1;
-
-	static int16_t retID{};
-	retID = m_heap[0].id;
-
-	m_size--;
-	m_heap[0] = m_heap[m_size];
+	static inline float Get(const int16_t index, const int16_t parent, const uint32_t parentFlags, const PathCostContext& context)
+	{
+		if (!parentFlags)
+			return HF_Distance(index, parent);
 
-	static int16_t parent{};
-	static int16_t child{};
-	static int16_t rightChild{};
-	static HeapNode ref{};
+		if (IsPathCostBlocked(parent, parentFlags, context))
+			return 65355.0f;
 
-	parent = 0;
-	child = (2 * parent) + 1;
-	ref = m_heap[parent];
-	while (child < m_size)
-	{
-		rightChild = (2 * parent) + 2;
-		if (rightChild < m_size)
+		if (context.isZombie && (parentFlags & WAYPOINT_DJUMP))
 		{
-			if (m_heap[rightChild].priority < m_heap[child].priority)
-				child = rightChild;
+			// don't count me
+			const int count = CountPathBoosters(parent, context);
+			if (count < 2)
+				return 65355.0f;
+
+			return HF_Distance(index, parent) / static_cast<float>(count);
 		}
 
-		if (ref.priority > m_heap[child].priority)
-			break;
+		if (parentFlags & WAYPOINT_LADDER)
+			return HF_Distance(index, parent) * 2.0f;
 
-		m_heap[parent] = m_heap[child];
-		parent = child;
-		child = (2 * parent) + 1;
+		return HF_Distance(index, parent);
 	}
+};
 
-	m_heap[parent] = ref;
-	return retID;
-}
-
-static int16_t temp;
-static int16_t temp2;
-inline const float HF_Distance(const int16_t& start, const int16_t& goal)
+struct CostRusher
 {
-	temp = start;
-	temp2 = goal;
-	return (g_waypoint->m_paths[temp].origin - g_waypoint->m_paths[temp2].origin).GetLength();
-}
+	static inline float Get(const int16_t index, const int16_t parent, const uint32_t parentFlags, const PathCostContext& context)
+	{
+		if (!parentFlags)
+			return HF_Distance(index, parent);
 
-inline const float HF_Distance2D(const int16_t& start, const int16_t& goal)
-{
-	temp = start;
-	temp2 = goal;
-	return (g_waypoint->m_paths[temp].origin - g_waypoint->m_paths[temp2].origin).GetLength2D();
-}
+		// rusher bots never wait for boosting
+		if ((parentFlags & WAYPOINT_DJUMP) || IsPathCostBlocked(parent, parentFlags, context))
+			return 65355.0f;
+
+		if (parentFlags & WAYPOINT_CROUCH)
+			return HF_Distance(index, parent) * 2.0f;
 
-inline const float HF_DistanceSquared(const int16_t& start, const int16_t& goal)
+		return HF_Distance(index, parent);
+	}
+};
+
+// cost and search loop of each policy, in PathCost order
+struct PathCostPolicy
 {
-	temp = start;
-	temp2 = goal;
-	return (g_waypoint->m_paths[temp].origin - g_waypoint->m_paths[temp2].origin).GetLengthSquared();
-}
+	float (*cost) (const int16_t, const int16_t, const uint32_t, const PathCostContext&);
+	bool (Bot::*expand) (void);
+};
 
-static Path pathCache{};
-static int8_t countCache{};
-inline const float GF_CostHuman(const int16_t& index, const int16_t& parent, const uint32_t& parentFlags, const int8_t& team, const float& gravity, const bool& isZombie)
+static const PathCostPolicy s_pathCosts[static_cast<int>(PathCost::Num)] =
 {
-	if (!parentFlags)
-		return HF_Distance2D(index, parent);
+	{ CostHuman::Get, &Bot::ExpandPath <CostHuman> },
+	{ CostCareful::Get, &Bot::ExpandPath <CostCareful> },
+	{ CostNormal::Get, &Bot::ExpandPath <CostNormal> },
+	{ CostRusher::Get, &Bot::ExpandPath <CostRusher> }
+};
 
-	if (parentFlags & WAYPOINT_AVOID)
-		return 65355.0f;
+static SearchPool s_flowPool;
 
-	if (isZombie)
+FlowField* FlowFieldCache::Find(const int16_t goal, const int8_t policy, const int8_t team, const bool isZombie)
+{
+	int i;
+	for (i = 0; i < Const_MaxFlowFields; i++)
 	{
-		if (parentFlags & WAYPOINT_HUMANONLY)
-			return 65355.0f;
+		FlowField& field = m_fields[i];
+		if (field.goal == goal && field.policy == policy && field.team == team && field.isZombie == isZombie && field.next)
+			return &field;
 	}
-	else
-	{
-		if (parentFlags & WAYPOINT_ZOMBIEONLY)
-			return 65355.0f;
 
-		if (parentFlags & WAYPOINT_DJUMP)
-			return 65355.0f;
-	}
+	return nullptr;
+}
 
-	pathCache = g_waypoint->m_paths[parent];
-	if (parentFlags & WAYPOINT_ONLYONE)
+// counts the searches toward a goal, true once enough bots asked for it within the interval
+bool FlowFieldCache::IsWanted(const int16_t goal, const int8_t policy, const int8_t team, const bool isZombie)
+{
+	const float time = engine->GetTime();
+	const float interval = ebot_flowfield_interval.GetFloat();
+	const int needed = cmax(ebot_flowfield_bots.GetInt(), 1);
+
+	int i;
+	Demand* oldest = &m_demand[0];
+	for (i = 0; i < Const_MaxFlowDemand; i++)
 	{
-		for (const auto& client : g_clients)
+		Demand& demand = m_demand[i];
+		if (demand.goal == goal && demand.policy == policy && demand.team == team && demand.isZombie == isZombie)
 		{
-			if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || team != client.team)
-				continue;
+			if (demand.time + interval < time)
+				demand.count = 0;
 
-			if ((client.origin - pathCache.origin).GetLengthSquared() < squaredi(static_cast<int>(pathCache.radius) + 64))
-				return 65355.0f;
+			demand.time = time;
+			if (++demand.count < needed)
+				return false;
+
+			demand.goal = -1;
+			return true;
 		}
+
+		if (demand.time < oldest->time)
+			oldest = &demand;
 	}
 
-	static float distance{};
-	static float totalDistance{};
-	totalDistance = 0.0f;
-	countCache = 0;
-	for (const auto& client : g_clients)
-	{
-		if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || team == client.team || !IsZombieEntity(client.ent))
-			continue;
+	oldest->time = time;
+	oldest->goal = goal;
+	oldest->policy = policy;
+	oldest->team = team;
+	oldest->isZombie = isZombie;
+	oldest->count = 1;
+	return needed <= 1;
+}
 
-		distance = ((client.ent->v.origin + client.ent->v.velocity * g_pGlobals->frametime) - pathCache.origin).GetLengthSquared();
-		if (distance < squaredi(static_cast<int>(pathCache.radius) + 128))
-			countCache++;
+// least recently used field, an empty one first
+FlowField& FlowFieldCache::GetFreeField(void)
+{
+	int i;
+	FlowField* best = &m_fields[0];
+	for (i = 0; i < Const_MaxFlowFields; i++)
+	{
+		if (!m_fields[i].next)
+			return m_fields[i];
 
-		totalDistance += distance;
+		if (m_fields[i].useTime < best->useTime)
+			best = &m_fields[i];
 	}
 
-	if (countCache && totalDistance > 0.0f)
-		return (HF_Distance(index, parent) * static_cast<float>(countCache)) + totalDistance;
-
-	return HF_Distance(index, parent);
+	return *best;
 }
 
-inline const float GF_CostCareful(const int16_t& index, const int16_t& parent, const uint32_t& parentFlags, const int8_t& team, const float& gravity, const bool& isZombie)
+// dijkstra over the incoming edges, step costs are the ones a forward search of the same policy would add
+void FlowFieldCache::Build(FlowField& field)
 {
-	if (!parentFlags)
-		return HF_Distance2D(index, parent);
-
-	if (parentFlags & WAYPOINT_AVOID)
-		return 65355.0f;
+	PROFILE_SCOPE(Profile_FlowField);
+	MEMORY_TAG(Mem_Paths);
 
-	if (isZombie)
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	const int count = hot.size;
+	if (field.size != count)
 	{
-		if (parentFlags & WAYPOINT_HUMANONLY)
-			return 65355.0f;
+		safedel(field.next);
+		safedel(field.cost);
+		safeloc(field.next, count);
+		safeloc(field.cost, count);
+		field.size = count;
 	}
-	else
-	{
-		if (parentFlags & WAYPOINT_ZOMBIEONLY)
-			return 65355.0f;
 
-		if (parentFlags & WAYPOINT_DJUMP)
-			return 65355.0f;
-	}
+	field.version = hot.version;
+	field.buildTime = engine->GetTime();
+	m_builds++;
+
+	int i;
+	for (i = 0; i < count; i++)
+		field.next[i] = -1;
 
-	if (parentFlags & WAYPOINT_ONLYONE)
+	PriorityQueue& openList = s_flowPool.Begin(count);
+	if (field.policy == Const_FlowEscape)
 	{
-		pathCache = g_waypoint->m_paths[parent];
-		for (const auto& client : g_clients)
+		// every waypoint out of the radius is a way out
+		const Vector danger = HF_Origin(field.goal);
+		const float radius = squaredf(ebot_flowfield_escape_radius.GetFloat());
+		for (i = 0; i < count; i++)
 		{
-			if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || team != client.team)
+			if ((HF_Origin(static_cast<int16_t>(i)) - danger).GetLengthSquared() < radius)
 				continue;
 
-			if ((client.origin - pathCache.origin).GetLengthSquared() < squaredi(static_cast<int>(pathCache.radius) + 64))
-				return 65355.0f;
+			s_flowPool.Get(static_cast<int16_t>(i)).parent = static_cast<int16_t>(i);
+			openList.InsertLowest(static_cast<int16_t>(i), 0.0f);
 		}
 	}
+	else
+	{
+		s_flowPool.Get(field.goal).parent = field.goal;
+		openList.InsertLowest(field.goal, 0.0f);
+	}
+
+	g_waypoint->UpdateThreatField();
+	const PathCostContext context{ static_cast<int8_t>(cclamp(static_cast<int>(field.team), Team::Terrorist, Team::Counter)), field.isZombie, &g_waypoint->GetThreatField() };
+	const bool escape = field.policy == Const_FlowEscape;
+	float (*cost) (const int16_t, const int16_t, const uint32_t, const PathCostContext&) = escape ? nullptr : s_pathCosts[static_cast<int>(field.policy)].cost;
 
-	if (isZombie)
+	// one seed per build, every bot on the field walks the same routes until the next refresh
+	int seed = crandomint(0, 32767);
+	float min = ebot_pathfinder_seed_min.GetFloat();
+	float max = ebot_pathfinder_seed_max.GetFloat();
+
+	AStar* current;
+	AStar* source;
+	int16_t currentIndex, sourceIndex;
+	float g;
+	while (!openList.IsEmpty())
 	{
-		if (parentFlags & WAYPOINT_DJUMP)
+		currentIndex = openList.RemoveLowest();
+		current = &s_flowPool.Get(currentIndex);
+		if (current->is_closed)
+			continue;
+
+		current->is_closed = true;
+		field.next[currentIndex] = current->parent;
+		field.cost[currentIndex] = current->g;
+
+		// nobody walks through a fall check waypoint that lost its ground, the goal itself is still fine
+		if (current->parent != currentIndex && (hot.flags[currentIndex] & WAYPOINT_FALLCHECK) && !g_waypoint->HasGround(currentIndex))
+			continue;
+
+		for (i = hot.reverseStart[currentIndex]; i < hot.reverseStart[currentIndex + 1]; i++)
 		{
-			pathCache = g_waypoint->m_paths[parent];
-			countCache = 0;
-			for (const auto& client : g_clients)
-			{
-				if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || client.team != team)
-					continue;
+			sourceIndex = hot.reverseSource[i];
+			source = &s_flowPool.Get(sourceIndex);
+			if (source->is_closed)
+				continue;
 
-				if ((client.origin - pathCache.origin).GetLengthSquared() < squaredi(static_cast<int>(pathCache.radius) + 512))
-					countCache++;
-				else if (IsVisible(pathCache.origin, client.ent))
-					countCache++;
-			}
+			if (escape)
+				g = current->g + HF_Distance(sourceIndex, currentIndex);
+			else
+				g = current->g + cost(sourceIndex, currentIndex, hot.flags[currentIndex], context) * crandomfloatfast(seed, min, max);
 
-			// don't count me
-			if (countCache < static_cast<int8_t>(2))
-				return 65355.0f;
+			if (source->parent != -1 && source->g <= g)
+				continue;
 
-			return HF_Distance2D(index, parent) / static_cast<float>(countCache);
+			source->parent = currentIndex;
+			source->g = g;
+			openList.InsertLowest(sourceIndex, g);
 		}
 	}
 
-	return HF_Distance2D(index, parent);
+	// sources point at themselves while building, the walk stops on -1
+	if (escape)
+	{
+		for (i = 0; i < count; i++)
+		{
+			if (field.next[i] == i)
+				field.next[i] = -1;
+		}
+	}
+	else
+		field.next[field.goal] = -1;
 }
 
-inline const float GF_CostNormal(const int16_t& index, const int16_t& parent, const uint32_t& parentFlags, const int8_t& team, const float& gravity, const bool& isZombie)
+const FlowField* FlowFieldCache::Get(const int goal, const int8_t costIndex, const int team, const bool isZombie)
 {
-	if (!parentFlags)
-		return HF_Distance(index, parent);
+	if (!ebot_flowfield.GetBool() || !IsValidWaypoint(goal))
+		return nullptr;
 
-	if (parentFlags & WAYPOINT_AVOID)
-		return 65355.0f;
+	const int16_t goalIndex = static_cast<int16_t>(goal);
+	const int8_t teamIndex = static_cast<int8_t>(team);
 
-	if (isZombie)
+	FlowField* field = Find(goalIndex, costIndex, teamIndex, isZombie);
+	if (!field)
 	{
-		if (parentFlags & WAYPOINT_HUMANONLY)
-			return 65355.0f;
+		if (!IsWanted(goalIndex, costIndex, teamIndex, isZombie))
+			return nullptr;
+
+		field = &GetFreeField();
+		field->goal = goalIndex;
+		field->policy = costIndex;
+		field->team = teamIndex;
+		field->isZombie = isZombie;
+		field->version = 0;
 	}
+
+	// the threat field and occupancy move under it, a used field is refreshed on the interval
+	const float time = engine->GetTime();
+	if (field->version != g_waypoint->GetHotData().version || field->buildTime + ebot_flowfield_interval.GetFloat() < time || field->buildTime > time)
+		Build(*field);
 	else
-	{
-		if (parentFlags & WAYPOINT_ZOMBIEONLY)
-			return 65355.0f;
+		m_hits++;
 
-		if (parentFlags & WAYPOINT_DJUMP)
-			return 65355.0f;
-	}
+	field->useTime = time;
+	return field;
+}
 
-	if (parentFlags & WAYPOINT_ONLYONE)
-	{
-		pathCache = g_waypoint->m_paths[parent];
-		for (const auto& client : g_clients)
-		{
-			if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || team != client.team)
-				continue;
+const FlowField* FlowFieldCache::GetField(const int goal, const PathCost policy, const int team, const bool isZombie)
+{
+	return Get(goal, static_cast<int8_t>(policy), team, isZombie);
+}
 
-			if ((client.origin - pathCache.origin).GetLengthSquared() < squaredi(static_cast<int>(pathCache.radius) + 64))
-				return 65355.0f;
-		}
-	}
+const FlowField* FlowFieldCache::GetEscapeField(const int dangerIndex)
+{
+	return Get(dangerIndex, Const_FlowEscape, 0, false);
+}
 
-	if (isZombie)
+void FlowFieldCache::Reset(void)
+{
+	int i;
+	for (i = 0; i < Const_MaxFlowFields; i++)
 	{
-		if (parentFlags & WAYPOINT_DJUMP)
-		{
-			pathCache = g_waypoint->m_paths[parent];
-			countCache = 0;
-			for (const auto& client : g_clients)
-			{
-				if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || client.team != team)
-					continue;
+		safedel(m_fields[i].next);
+		safedel(m_fields[i].cost);
+		m_fields[i] = FlowField{};
+	}
 
-				if ((client.origin - pathCache.origin).GetLengthSquared() < squaredi(static_cast<int>(pathCache.radius) + 512))
-					countCache++;
-				else if (IsVisible(pathCache.origin, client.ent))
-					countCache++;
-			}
+	for (i = 0; i < Const_MaxFlowDemand; i++)
+		m_demand[i] = Demand{};
 
-			// don't count me
-			if (countCache < static_cast<int8_t>(2))
-				return 65355.0f;
+	m_builds = 0;
+	m_hits = 0;
+}
 
-			return HF_Distance(index, parent) / static_cast<float>(countCache);
-		}
+size_t FlowFieldCache::GetMemoryUsage(void) const
+{
+	size_t bytes = 0;
+	for (const FlowField& field : m_fields)
+	{
+		if (field.next)
+			bytes += static_cast<size_t>(field.size) * (sizeof(int16_t) + sizeof(float));
 	}
 
-	if (parentFlags & WAYPOINT_LADDER)
-		return HF_Distance(index, parent) * 2.0f;
-
-	return HF_Distance(index, parent);
+	return bytes;
 }
 
-inline const float GF_CostRusher(const int16_t& index, const int16_t& parent, const uint32_t& parentFlags, const int8_t& team, const float& gravity, const bool& isZombie)
+void FlowFieldCache::Show(void)
 {
-	if (!parentFlags)
-		return HF_Distance(index, parent);
-
-	if (parentFlags & WAYPOINT_AVOID)
-		return 65355.0f;
+	ServerPrintNoTag("Flow fields: %u built, %u reused", m_builds, m_hits);
 
-	if (isZombie)
-	{
-		if (parentFlags & WAYPOINT_HUMANONLY)
-			return 65355.0f;
-	}
-	else
+	int i;
+	const float time = engine->GetTime();
+	for (i = 0; i < Const_MaxFlowFields; i++)
 	{
-		if (parentFlags & WAYPOINT_ZOMBIEONLY)
-			return 65355.0f;
+		const FlowField& field = m_fields[i];
+		if (!field.next)
+			continue;
 
-		if (parentFlags & WAYPOINT_DJUMP)
-			return 65355.0f;
+		if (field.policy == Const_FlowEscape)
+			ServerPrintNoTag("  escape from %d, built %.1fs ago", field.goal, time - field.buildTime);
+		else
+			ServerPrintNoTag("  goal %d, policy %d, team %d%s, built %.1fs ago", field.goal, field.policy, field.team, field.isZombie ? ", zombie" : "", time - field.buildTime);
 	}
+}
+
+// walks the next hops of a field from srcIndex, false if the field doesn't get there or a waypoint is closed for us
+bool Bot::FollowFlowField(const FlowField& field, const int srcIndex)
+{
+	if (!IsValidWaypoint(srcIndex) || srcIndex >= field.size)
+		return false;
+
+	int16_t currentIndex = static_cast<int16_t>(srcIndex);
+	if (field.next[currentIndex] == -1)
+		return false;
 
-	if (parentFlags & WAYPOINT_ONLYONE)
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	m_navNode.Clear();
+	m_navNode.Add(currentIndex);
+
+	int steps = field.size;
+	while (field.next[currentIndex] != -1)
 	{
-		pathCache = g_waypoint->m_paths[parent];
-		for (const auto& client : g_clients)
-		{
-			if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || team != client.team)
-				continue;
+		currentIndex = field.next[currentIndex];
 
-			if ((client.origin - pathCache.origin).GetLengthSquared() < squaredi(static_cast<int>(pathCache.radius) + 64))
-				return 65355.0f;
+		// a loop can only come from a broken field, never trust it
+		if (!IsValidWaypoint(currentIndex) || --steps < 0)
+		{
+			m_navNode.Clear();
+			return false;
 		}
-	}
 
-	// rusher bots never wait for boosting
-	if (parentFlags & WAYPOINT_DJUMP)
-		return 65355.0f;
+		if ((hot.flags[currentIndex] & WAYPOINT_SPECIFICGRAVITY) && (pev->gravity * engine->GetGravity()) > hot.gravity[currentIndex])
+		{
+			m_navNode.Clear();
+			return false;
+		}
 
-	if (parentFlags & WAYPOINT_CROUCH)
-		return HF_Distance(index, parent) * 2.0f;
+		m_navNode.Add(currentIndex);
+	}
 
-	return HF_Distance(index, parent);
+	ChangeWptIndex(m_navNode.First());
+	m_pathTime = engine->GetTime() + 0.2f;
+	return true;
 }
 
-// this function finds a path from srcIndex to destIndex
+// this function posts a path request from srcIndex to destIndex, the search runs later inside the path budget
 void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 {
-	if (g_pathTimer > engine->GetTime() && !m_navNode.IsEmpty())
+	if (m_pathTime > engine->GetTime() && !m_navNode.IsEmpty())
 		return;
 
 	if (g_gameVersion & Game::HalfLife || ebot_force_shortest_path.GetBool())
@@ -1545,10 +1682,9 @@ void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 			enemy = m_nearestEnemy;
 	}
 
-	int16_t index;
 	if (!IsValidWaypoint(srcIndex))
 	{
-		index = FindWaypoint();
+		const int16_t index = FindWaypoint();
 		srcIndex = index;
 		ChangeWptIndex(index);
 	}
@@ -1559,29 +1695,43 @@ void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 	if (srcIndex == destIndex)
 		return;
 
-	const float (*gcalc) (const int16_t&, const int16_t&, const uint32_t&, const int8_t&, const float&, const bool&) = nullptr;
+	PathRequest request;
+	request.type = PathType::Normal;
+	request.srcIndex = static_cast<int16_t>(srcIndex);
+	request.destIndex = static_cast<int16_t>(destIndex);
+	request.enemy = enemy;
+	g_botManager->PostPathRequest(this, request);
+}
+
+// this function finds a path from srcIndex to destIndex
+bool Bot::SearchPath(int srcIndex, int destIndex, edict_t* enemy)
+{
+	const int goalIndex = destIndex;
+
+	// on big maps only search in detail up to the next clusters
+	destIndex = g_waypoint->GetClusterWaypoint(srcIndex, destIndex);
+
+	int16_t index;
+	PathCost cost;
 
 	if (IsZombieMode() && ebot_zombies_as_path_cost.GetBool() && !m_isZombieBot)
-		gcalc = GF_CostHuman;
+		cost = PathCost::Human;
 	else if (g_bombPlanted && m_team == Team::Counter)
-		gcalc = GF_CostRusher;
+		cost = PathCost::Rusher;
 	else if (m_isBomber || m_isVIP || (g_bombPlanted && m_inBombZone))
 	{
 		// move faster...
 		if (g_timeRoundMid < engine->GetTime())
-			gcalc = GF_CostRusher;
+			cost = PathCost::Rusher;
 		else
-			gcalc = GF_CostCareful;
+			cost = PathCost::Careful;
 	}
 	else if (m_personality == Personality::Careful)
-		gcalc = GF_CostCareful;
+		cost = PathCost::Careful;
 	else if (m_personality == Personality::Rusher)
-		gcalc = GF_CostRusher;
+		cost = PathCost::Rusher;
 	else
-		gcalc = GF_CostNormal;
-
-	if (!gcalc)
-		return;
+		cost = PathCost::Normal;
 
 	bool hasHostage;
 	if (HasHostage())
@@ -1590,80 +1740,287 @@ void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 		hasHostage = false;
 
 	int seed = m_index + m_numSpawns + m_currentWeapon;
-	float min = ebot_pathfinder_seed_min.GetFloat();
-	float max = ebot_pathfinder_seed_max.GetFloat();
+	int i;
+	int16_t stuckIndex;
+
+	if (m_isStuck)
+	{
+		stuckIndex = g_waypoint->FindNearestInCircle(m_stuckArea, 256.0f);
+		if (srcIndex == stuckIndex)
+		{
+			const WaypointHotData& hot = g_waypoint->GetHotData();
+			for (i = hot.edgeStart[srcIndex]; i < hot.edgeStart[srcIndex + 1]; i++)
+			{
+				index = hot.edgeTarget[i];
+				if (!IsWaypointOccupied(index))
+				{
+					srcIndex = index;
+					break;
+				}
+			}
+		}
+
+		// usually only the way around one waypoint is gone, the rest of the old path still holds
+		if (FNullEnt(enemy) && RepairPath(cost, srcIndex, destIndex, goalIndex, stuckIndex, hasHostage))
+			return true;
+
+		// if we stuck always randomize paths to better unstuck
+		seed += static_cast<int>(engine->GetTime() * 0.1f);
+		seed += m_stuckWarn;
+	}
+	else
+		stuckIndex = -1;
+
+	// bots heading to the same goal share one backward search, unless this one needs its own checks
+	if (stuckIndex == -1 && !hasHostage && FNullEnt(enemy) && m_index >= 1 && m_index <= 32)
+	{
+		const FlowField* field = g_flowFields.GetField(goalIndex, cost, m_team, m_isZombieBot);
+		if (field && FollowFlowField(*field, srcIndex))
+		{
+			KeepPath(s_pathSearch[m_index - 1], m_navNode);
+			return true;
+		}
+	}
+
+	return BeginPath(cost, srcIndex, destIndex, seed, stuckIndex, enemy, hasHostage);
+}
+
+// starts a search with everything SearchPath took from the bot, replays call it with recorded values
+bool Bot::BeginPath(const PathCost cost, const int srcIndex, const int destIndex, const int seed, const int16_t stuckIndex, edict_t* enemy, const bool hasHostage)
+{
+	if (m_index < 1 || m_index > 32)
+		return true;
+
+	if (g_recorder.IsRecording())
+	{
+		RecordPath record{};
+		record.origin = pev->origin;
+		record.deathOrigin = m_avgDeathOrigin;
+		record.seed = seed;
+		record.srcIndex = static_cast<int16_t>(srcIndex);
+		record.destIndex = static_cast<int16_t>(destIndex);
+		record.stuckIndex = stuckIndex;
+		record.cost = static_cast<int8_t>(cost);
+		record.team = static_cast<int8_t>(m_team);
+		record.isZombie = m_isZombieBot ? 1 : 0;
+		record.hasHostage = hasHostage ? 1 : 0;
+		record.hasEnemy = FNullEnt(enemy) ? 0 : 1;
+		g_recorder.Path(m_index - 1, record);
+	}
+
+	PathSearch& search = s_pathSearch[m_index - 1];
+	PriorityQueue& openList = search.pool.Begin(g_numWaypoints);
+
+	search.cost = cost;
+	search.seed = seed;
+	search.min = ebot_pathfinder_seed_min.GetFloat();
+	search.max = ebot_pathfinder_seed_max.GetFloat();
+	search.srcIndex = static_cast<int16_t>(srcIndex);
+	search.destIndex = static_cast<int16_t>(destIndex);
+	search.stuckIndex = stuckIndex;
+	search.enemy = enemy;
+	search.enemyIndex = (!FNullEnt(enemy) && g_waypoint->HasVisibility()) ? static_cast<int16_t>(g_waypoint->FindNearestInCircle(GetEntityOrigin(enemy), 256.0f)) : -1;
+	search.hasHostage = hasHostage;
+
+	// put start waypoint into open list
+	AStar& srcWaypoint = search.pool.Get(srcIndex);
+	g_waypoint->UpdateThreatField();
+	const PathCostContext context{ static_cast<int8_t>(cclamp(m_team, Team::Terrorist, Team::Counter)), m_isZombieBot, &g_waypoint->GetThreatField() };
+	srcWaypoint.g = ((s_pathCosts[static_cast<int>(cost)].cost(srcIndex, destIndex, 0, context) * crandomfloatfast(search.seed, search.min, search.max)) / (pev->origin - m_avgDeathOrigin).GetLength());
+	srcWaypoint.f = srcWaypoint.g + HF_Distance(srcIndex, destIndex);
+	openList.InsertLowest(srcIndex, srcWaypoint.f);
+
+	return ContinuePath();
+}
+
+// expands a slice of the bot's running search, returns false if the search needs more frames
+bool Bot::ContinuePath(void)
+{
+	PROFILE_SCOPE(Profile_FindPath);
+	MEMORY_TAG(Mem_Paths);
+
+	if (m_index < 1 || m_index > 32)
+		return true;
+
+	PathSearch& search = s_pathSearch[m_index - 1];
+	const bool done = (this->*s_pathCosts[static_cast<int>(search.cost)].expand)();
+	if (!done)
+		return false;
+
+	KeepPath(search, m_navNode);
+	if (g_recorder.IsRecording())
+		g_recorder.PathResult(m_index - 1, m_navNode);
+
+	return true;
+}
+
+// searches only around the blocked waypoint until the last path is reached again, then keeps the rest of it
+bool Bot::RepairPath(const PathCost cost, const int srcIndex, const int destIndex, const int goalIndex, const int16_t blockedIndex, const bool hasHostage)
+{
+	if (!ebot_path_repair.GetBool() || m_index < 1 || m_index > 32 || !IsValidWaypoint(srcIndex) || !IsValidWaypoint(blockedIndex))
+		return false;
+
+	PROFILE_SCOPE(Profile_RepairPath);
+	MEMORY_TAG(Mem_Paths);
+
+	PathSearch& search = s_pathSearch[m_index - 1];
+	MiniArray <int16_t>& path = search.lastPath;
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	if (path.Size() < 2 || search.lastVersion != hot.version || (path.Last() != destIndex && path.Last() != goalIndex))
+		return false;
+
+	int16_t i, blocked = -1;
+	for (i = 0; i < path.Size(); i++)
+	{
+		if (path[i] == blockedIndex)
+		{
+			blocked = i;
+			break;
+		}
+	}
+
+	// the block isn't on our way, or it's the goal itself
+	if (blocked == -1 || blocked >= path.Size() - 1)
+		return false;
+
+	s_repairJoin.Begin(g_numWaypoints);
+	for (i = blocked + 1; i < path.Size(); i++)
+	{
+		AStar& join = s_repairJoin.Get(path[i]);
+		join.is_closed = true;
+		join.parent = i;
+	}
+
+	PriorityQueue& openList = s_repairPool.Begin(g_numWaypoints);
+	const int16_t resumeIndex = path[blocked + 1];
+	s_repairPool.Get(srcIndex);
+	openList.InsertLowest(static_cast<int16_t>(srcIndex), HF_Distance(srcIndex, resumeIndex));
+
+	g_waypoint->UpdateThreatField();
+	const PathCostContext context{ static_cast<int8_t>(cclamp(m_team, Team::Terrorist, Team::Counter)), m_isZombieBot, &g_waypoint->GetThreatField() };
+	float (*getCost) (const int16_t, const int16_t, const uint32_t, const PathCostContext&) = s_pathCosts[static_cast<int>(cost)].cost;
+
+	// loop cache
+	AStar* currWaypoint;
+	AStar* childWaypoint;
+	int16_t currentIndex, self;
+	int edge;
+	uint32_t flags;
+	float g;
+
+	int expansions = cmax(ebot_path_repair_nodes.GetInt(), 1);
+	while (!openList.IsEmpty() && --expansions >= 0)
+	{
+		currentIndex = openList.RemoveLowest();
+		currWaypoint = &s_repairPool.Get(currentIndex);
+		if (currWaypoint->is_closed)
+			continue;
+
+		currWaypoint->is_closed = true;
+
+		// back on the old path, the detour plus what's left of it is the new path
+		const AStar& join = s_repairJoin.Get(currentIndex);
+		if (join.is_closed)
+		{
+			const int16_t joinAt = join.parent;
+			m_navNode.Clear();
+
+			do
+			{
+				m_navNode.Add(currentIndex);
+				currentIndex = s_repairPool.Get(currentIndex).parent;
+			} while (IsValidWaypoint(currentIndex));
+
+			m_navNode.Reverse();
+			for (i = joinAt + 1; i < path.Size(); i++)
+				m_navNode.Add(path[i]);
 
-	int16_t i;
-	int16_t stuckIndex;
-	Path currWay;
+			ChangeWptIndex(m_navNode.First());
+			m_pathTime = engine->GetTime() + 0.2f;
+			KeepPath(search, m_navNode);
+			return true;
+		}
 
-	if (m_isStuck)
-	{
-		stuckIndex = g_waypoint->FindNearestInCircle(m_stuckArea, 256.0f);
-		if (srcIndex == stuckIndex)
+		for (edge = hot.edgeStart[currentIndex]; edge < hot.edgeStart[currentIndex + 1]; edge++)
 		{
-			currWay = g_waypoint->m_paths[srcIndex];
-			for (i = 0; i < Const_MaxPathIndex; i++)
-			{
-				index = currWay.index[i];
-				if (!IsValidWaypoint(index))
-					continue;
+			self = hot.edgeTarget[edge];
+			if (self == blockedIndex)
+				continue;
 
-				if (!IsWaypointOccupied(index))
+			flags = hot.flags[self];
+			if (flags)
+			{
+				if (flags & WAYPOINT_FALLCHECK)
 				{
-					srcIndex = index;
-					break;
+					if (!g_waypoint->HasGround(self))
+						continue;
+				}
+				else if (flags & WAYPOINT_SPECIFICGRAVITY)
+				{
+					if ((pev->gravity * engine->GetGravity()) > hot.gravity[self])
+						continue;
 				}
+				else if (hasHostage && (flags & (WAYPOINT_CROUCH | WAYPOINT_LADDER) || hot.edgeFlags[edge] & (PATHFLAG_JUMP | PATHFLAG_DOUBLE)))
+					continue;
 			}
-		}
 
-		// if we stuck always randomize paths to better unstuck
-		seed += static_cast<int>(engine->GetTime() * 0.1f);
-		seed += m_stuckWarn;
+			childWaypoint = &s_repairPool.Get(self);
+			if (childWaypoint->is_closed)
+				continue;
+
+			g = currWaypoint->g + getCost(currentIndex, self, flags, context);
+			if (childWaypoint->parent != -1 && childWaypoint->g <= g)
+				continue;
+
+			childWaypoint->parent = currentIndex;
+			childWaypoint->g = g;
+			openList.InsertLowest(self, g + HF_Distance(self, resumeIndex));
+		}
 	}
-	else
-		stuckIndex = -1;
 
-	struct AStar
-	{
-		float g = 0.0f;
-		float f = 0.0f;
-		int16_t parent = -1;
-		bool is_closed = false;
-	} waypoints[g_numWaypoints];
+	// the block cuts off more than a short detour, a full search has to do it
+	return false;
+}
 
-	// put start waypoint into open list
-	AStar& srcWaypoint = waypoints[srcIndex];
-	srcWaypoint.g = ((gcalc(srcIndex, destIndex, 0, m_team, pev->gravity, m_isZombieBot) * crandomfloatfast(seed, min, max)) / (pev->origin - m_avgDeathOrigin).GetLength());
-	srcWaypoint.f = srcWaypoint.g + HF_Distance(srcIndex, destIndex);
+// search loop specialized on the cost policy, the cost is inlined into the edge loop
+template <typename Cost> bool Bot::ExpandPath(void)
+{
+	PathSearch& search = s_pathSearch[m_index - 1];
+	PriorityQueue& openList = search.pool.OpenList();
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	g_waypoint->UpdateThreatField();
+	const PathCostContext context{ static_cast<int8_t>(cclamp(m_team, Team::Terrorist, Team::Counter)), m_isZombieBot, &g_waypoint->GetThreatField() };
+	const float deathDistance = (pev->origin - m_avgDeathOrigin).GetLength();
+	const bool enemyIsNull = FNullEnt(search.enemy) || search.enemy->free || !IsAlive(search.enemy); // a sliced search outlives the frame it was queued in
+	edict_t* enemy = search.enemy;
 
 	// loop cache
 	AStar* currWaypoint;
 	AStar* childWaypoint;
 	int16_t currentIndex, self;
+	int i;
 	uint32_t flags;
 	float g, f;
-	bool enemyIsNull;
-
-	if (!FNullEnt(enemy))
-		enemyIsNull = false;
-	else
-		enemyIsNull = true;
-
-	// do not allow to search whole map
-	const int16_t limit = static_cast<int16_t>((g_numWaypoints / 2) + 24);
 
-	PriorityQueue openList;
-	openList.InsertLowest(srcIndex, srcWaypoint.f);
+	int expansions = cmax(ebot_path_slice_nodes.GetInt(), 1);
 	while (!openList.IsEmpty())
 	{
+		// continue next frame, the bot can use its old path until then
+		if (--expansions < 0)
+		{
+			if (m_navNode.IsEmpty())
+				FollowNextHops(search.srcIndex, search.destIndex);
+
+			return false;
+		}
+
 		// remove the first waypoint from the open list
 		currentIndex = openList.RemoveLowest();
-		if (stuckIndex == currentIndex)
+		if (search.stuckIndex == currentIndex)
 			continue;
 
 		// is the current waypoint the goal waypoint?
-		if (currentIndex == destIndex || openList.Size() > limit)
+		if (currentIndex == search.destIndex)
 		{
 			// delete path for new one
 			m_navNode.Clear();
@@ -1671,16 +2028,29 @@ void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 			do
 			{
 				m_navNode.Add(currentIndex);
-				currentIndex = waypoints[currentIndex].parent;
+				currentIndex = search.pool.Get(currentIndex).parent;
 			} while (IsValidWaypoint(currentIndex));
 
 			m_navNode.Reverse();
+
+			// we may have walked a bit while the search was running
+			for (i = 0; i < m_navNode.Length(); i++)
+			{
+				if (m_navNode.Get(i) != m_currentWaypointIndex)
+					continue;
+
+				while (i-- > 0)
+					m_navNode.Shift();
+
+				break;
+			}
+
 			ChangeWptIndex(m_navNode.First());
-			g_pathTimer = engine->GetTime() + 0.2f;
-			return;
+			m_pathTime = engine->GetTime() + 0.2f;
+			return true;
 		}
 
-		currWaypoint = &waypoints[currentIndex];
+		currWaypoint = &search.pool.Get(currentIndex);
 		if (currWaypoint->is_closed)
 			continue;
 
@@ -1688,43 +2058,37 @@ void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 		currWaypoint->is_closed = true;
 
 		// now expand the current waypoint
-		currWay = g_waypoint->m_paths[currentIndex];
-		for (i = 0; i < Const_MaxPathIndex; i++)
+		for (i = hot.edgeStart[currentIndex]; i < hot.edgeStart[currentIndex + 1]; i++)
 		{
-			self = currWay.index[i];
-			if (!IsValidWaypoint(self))
-				continue;
-
-			if (stuckIndex == self)
+			self = hot.edgeTarget[i];
+			if (search.stuckIndex == self)
 				continue;
 
-			if (self != destIndex)
+			flags = hot.flags[self];
+			if (self != search.destIndex)
 			{
-				if (flags = g_waypoint->m_paths[self].flags)
+				if (flags)
 				{
 					if (flags & WAYPOINT_FALLCHECK)
 					{
-						TraceResult tr{};
-						const Vector origin = g_waypoint->m_paths[self].origin;
-						TraceLine(origin, origin - Vector(0.0f, 0.0f, 60.0f), false, false, GetEntity(), &tr);
-						if (tr.flFraction == 1.0f)
+						if (!g_waypoint->HasGround(self))
 							continue;
 					}
 					else if (flags & WAYPOINT_SPECIFICGRAVITY)
 					{
-						if ((pev->gravity * engine->GetGravity()) > g_waypoint->m_paths[self].gravity)
+						if ((pev->gravity * engine->GetGravity()) > hot.gravity[self])
 							continue;
 					}
 					else if (!enemyIsNull)
 					{
-						const Vector origin = g_waypoint->GetPath(self)->origin;
-						if (::IsInViewCone(origin, enemy) && IsVisible(origin, enemy))
+						const Vector origin = HF_Origin(self);
+						if (::IsInViewCone(origin, enemy) && (search.enemyIndex != -1 ? g_waypoint->IsVisibleWaypoint(search.enemyIndex, self) : IsVisible(origin, enemy)))
 						{
 							if ((GetEntityOrigin(enemy) - origin).GetLengthSquared() - (pev->origin - origin).GetLengthSquared() < 0.0f)
 								continue;
 						}
 					}
-					else if (hasHostage)
+					else if (search.hasHostage)
 					{
 						if (flags & WAYPOINT_CROUCH)
 							continue;
@@ -1732,65 +2096,47 @@ void Bot::FindPath(int& srcIndex, int& destIndex, edict_t* enemy)
 						if (flags & WAYPOINT_LADDER)
 							continue;
 
-						int8_t i;
-						int16_t neighbour;
-						Path path;
-						for (i = 0; i < Const_MaxPathIndex; i++)
-						{
-							neighbour = g_waypoint->m_paths[index].index[i];
-							if (neighbour == self)
-							{
-								path = g_waypoint->m_paths[index];
-								if (path.connectionFlags[i] & PATHFLAG_JUMP || path.connectionFlags[i] & PATHFLAG_DOUBLE)
-									continue;
-							}
-						}
+						if (hot.edgeFlags[i] & PATHFLAG_JUMP || hot.edgeFlags[i] & PATHFLAG_DOUBLE)
+							continue;
 					}
 				}
 			}
 
-			g = currWaypoint->g + ((gcalc(currentIndex, self, flags, m_team, pev->gravity, m_isZombieBot) * crandomfloatfast(seed, min, max)) / (pev->origin - m_avgDeathOrigin).GetLength());
-			f = g + HF_Distance(self, destIndex);
+			g = currWaypoint->g + ((Cost::Get(currentIndex, self, flags, context) * crandomfloatfast(search.seed, search.min, search.max)) / deathDistance);
+			f = g + HF_Distance(self, search.destIndex);
 
-			childWaypoint = &waypoints[self];
-			if (!childWaypoint->is_closed || childWaypoint->f > f)
-			{
-				// put the current child into open list
-				childWaypoint->parent = currentIndex;
-				childWaypoint->is_closed = true;
-				childWaypoint->g = g;
-				childWaypoint->f = f;
-				openList.InsertLowest(self, f);
-			}
-		}
-	}
+			childWaypoint = &search.pool.Get(self);
+			if (childWaypoint->is_closed)
+				continue;
 
-	// roam around poorly :(
-	MiniArray <int16_t> PossiblePath;
-	for (i = 0; i < g_numWaypoints; i++)
-	{
-		if (waypoints[i].is_closed)
-			PossiblePath.Push(i);
-	}
+			// already in the open list with a better cost
+			if (childWaypoint->parent != -1 && childWaypoint->g <= g)
+				continue;
 
-	if (!PossiblePath.IsEmpty())
-	{
-		index = PossiblePath.Random();
-		FindShortestPath(srcIndex, destIndex);
-		return;
+			// put the current child into open list
+			childWaypoint->parent = currentIndex;
+			childWaypoint->g = g;
+			childWaypoint->f = f;
+			openList.InsertLowest(self, f);
+		}
 	}
 
-	FindShortestPath(srcIndex, destIndex);
+	// roam around poorly :(, queued so the shortest search is paid from the next frame's budget
+	PathRequest request;
+	request.type = PathType::Shortest;
+	request.srcIndex = search.srcIndex;
+	request.destIndex = search.destIndex;
+	g_botManager->PostPathRequest(this, request);
+	return true;
 }
 
 void Bot::FindShortestPath(int& srcIndex, int& destIndex)
 {
-	int16_t i;
 	if (!IsValidWaypoint(srcIndex))
 	{
-		i = FindWaypoint();
-		srcIndex = i;
-		ChangeWptIndex(i);
+		const int16_t index = FindWaypoint();
+		srcIndex = index;
+		ChangeWptIndex(index);
 	}
 
 	if (!IsValidWaypoint(destIndex))
@@ -1799,15 +2145,84 @@ void Bot::FindShortestPath(int& srcIndex, int& destIndex)
 	if (srcIndex == destIndex)
 		return;
 
-	struct AStar
+	PathRequest request;
+	request.type = PathType::Shortest;
+	request.srcIndex = static_cast<int16_t>(srcIndex);
+	request.destIndex = static_cast<int16_t>(destIndex);
+	g_botManager->PostPathRequest(this, request);
+}
+
+// builds the path from the waypoint next hop table, fails if there is no table or the way is blocked
+bool Bot::FollowNextHops(const int srcIndex, const int destIndex)
+{
+	if (!g_waypoint->HasPathMatrix() || !IsValidWaypoint(g_waypoint->GetNextHop(srcIndex, destIndex)))
+		return false;
+
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+	uint32_t flags;
+	int16_t currentIndex = static_cast<int16_t>(srcIndex);
+
+	m_navNode.Clear();
+	m_navNode.Add(currentIndex);
+
+	// tied costs over coincident waypoints or a damaged sidecar can make the hops cycle, the caller searches instead
+	int steps = g_numWaypoints;
+	while (currentIndex != destIndex)
+	{
+		currentIndex = static_cast<int16_t>(g_waypoint->GetNextHop(currentIndex, destIndex));
+		if (!IsValidWaypoint(currentIndex) || --steps < 0)
+		{
+			m_navNode.Clear();
+			return false;
+		}
+
+		if (flags = hot.flags[currentIndex])
+		{
+			if (flags & WAYPOINT_FALLCHECK)
+			{
+				if (!g_waypoint->HasGround(currentIndex))
+				{
+					m_navNode.Clear();
+					return false;
+				}
+			}
+			else if (flags & WAYPOINT_SPECIFICGRAVITY)
+			{
+				if ((pev->gravity * engine->GetGravity()) > hot.gravity[currentIndex])
+				{
+					m_navNode.Clear();
+					return false;
+				}
+			}
+		}
+
+		m_navNode.Add(currentIndex);
+	}
+
+	ChangeWptIndex(m_navNode.First());
+	return true;
+}
+
+void Bot::SearchShortestPath(int srcIndex, int destIndex)
+{
+	PROFILE_SCOPE(Profile_FindShortestPath);
+	MEMORY_TAG(Mem_Paths);
+
+	int i;
+
+	// shortest path is already known, just follow the next hops
+	if (FollowNextHops(srcIndex, destIndex))
 	{
-		float g = 0.0f;
-		float f = 0.0f;
-		int16_t parent = -1;
-		bool is_closed = false;
-	} waypoints[g_numWaypoints];
+		m_pathTime = engine->GetTime() + 0.2f;
+		return;
+	}
 
-	AStar& srcWaypoint = waypoints[srcIndex];
+	destIndex = g_waypoint->GetClusterWaypoint(srcIndex, destIndex);
+
+	PriorityQueue& openList = s_searchPool.Begin(g_numWaypoints);
+	const WaypointHotData& hot = g_waypoint->GetHotData();
+
+	AStar& srcWaypoint = s_searchPool.Get(srcIndex);
 	srcWaypoint.f = HF_DistanceSquared(srcIndex, destIndex);
 
 	// loop cache
@@ -1815,13 +2230,11 @@ void Bot::FindShortestPath(int& srcIndex, int& destIndex)
 	AStar* childWaypoint;
 	int16_t currentIndex, self;
 	uint32_t flags;
-	Path currPath;
 	float f;
 
 	// do not allow to search whole map
 	const int16_t limit = static_cast<int16_t>((g_numWaypoints / 2) + 24);
 
-	PriorityQueue openList;
 	openList.InsertLowest(srcIndex, srcWaypoint.f);
 	while (!openList.IsEmpty())
 	{
@@ -1839,16 +2252,16 @@ void Bot::FindShortestPath(int& srcIndex, int& destIndex)
 			do
 			{
 				m_navNode.Add(currentIndex);
-				currentIndex = waypoints[currentIndex].parent;
+				currentIndex = s_searchPool.Get(currentIndex).parent;
 			} while (IsValidWaypoint(currentIndex));
 
 			m_navNode.Reverse();
 			ChangeWptIndex(m_navNode.First());
-			g_pathTimer = engine->GetTime() + 0.2f;
+			m_pathTime = engine->GetTime() + 0.2f;
 			return;
 		}
 
-		currWaypoint = &waypoints[currentIndex];
+		currWaypoint = &s_searchPool.Get(currentIndex);
 		if (currWaypoint->is_closed)
 			continue;
 
@@ -1856,32 +2269,25 @@ void Bot::FindShortestPath(int& srcIndex, int& destIndex)
 		currWaypoint->is_closed = true;
 
 		// now expand the current waypoint
-		currPath = g_waypoint->m_paths[currentIndex];
-		for (i = 0; i < Const_MaxPathIndex; i++)
+		for (i = hot.edgeStart[currentIndex]; i < hot.edgeStart[currentIndex + 1]; i++)
 		{
-			self = currPath.index[i];
-			if (!IsValidWaypoint(self))
-				break;
-
-			if (flags = g_waypoint->m_paths[self].flags)
+			self = hot.edgeTarget[i];
+			if (flags = hot.flags[self])
 			{
 				if (flags & WAYPOINT_FALLCHECK)
 				{
-					TraceResult tr{};
-					const Vector origin = g_waypoint->m_paths[self].origin;
-					TraceLine(origin, origin - Vector(0.0f, 0.0f, 60.0f), false, false, GetEntity(), &tr);
-					if (tr.flFraction == 1.0f)
+					if (!g_waypoint->HasGround(self))
 						continue;
 				}
 				else if (flags & WAYPOINT_SPECIFICGRAVITY)
 				{
-					if ((pev->gravity * engine->GetGravity()) > g_waypoint->m_paths[self].gravity)
+					if ((pev->gravity * engine->GetGravity()) > hot.gravity[self])
 						continue;
 				}
 			}
 
 			f = HF_DistanceSquared(self, destIndex);
-			childWaypoint = &waypoints[self];
+			childWaypoint = &s_searchPool.Get(self);
 			if (!childWaypoint->is_closed || childWaypoint->f > f)
 			{
 				// put the current child into open list
@@ -1895,37 +2301,47 @@ void Bot::FindShortestPath(int& srcIndex, int& destIndex)
 
 void Bot::FindEscapePath(int& srcIndex, const Vector& dangerOrigin)
 {
-	int16_t i;
 	if (!IsValidWaypoint(srcIndex))
 	{
-		i = FindWaypoint();
-		srcIndex = i;
-		ChangeWptIndex(i);
+		const int16_t index = FindWaypoint();
+		srcIndex = index;
+		ChangeWptIndex(index);
 	}
 
-	struct AStar
-	{
-		float g = 0.0f;
-		float f = 0.0f;
-		int16_t parent = -1;
-		bool is_closed = false;
-	} waypoints[g_numWaypoints];
+	PathRequest request;
+	request.type = PathType::Escape;
+	request.srcIndex = static_cast<int16_t>(srcIndex);
+	request.dangerOrigin = dangerOrigin;
+	g_botManager->PostPathRequest(this, request);
+}
+
+void Bot::SearchEscapePath(int srcIndex, const Vector& dangerOrigin)
+{
+	PROFILE_SCOPE(Profile_FindEscapePath);
+	MEMORY_TAG(Mem_Paths);
+
+	// everyone running from the same spot shares one field
+	const FlowField* field = g_flowFields.GetEscapeField(g_waypoint->FindNearestInCircle(dangerOrigin, 512.0f));
+	if (field && FollowFlowField(*field, srcIndex))
+		return;
+
+	int i;
+	PriorityQueue& openList = s_searchPool.Begin(g_numWaypoints);
+	const WaypointHotData& hot = g_waypoint->GetHotData();
 
-	AStar& srcWaypoint = waypoints[srcIndex];
-	srcWaypoint.f = (g_waypoint->m_paths[srcIndex].origin - dangerOrigin).GetLengthSquared();
+	AStar& srcWaypoint = s_searchPool.Get(srcIndex);
+	srcWaypoint.f = (HF_Origin(static_cast<int16_t>(srcIndex)) - dangerOrigin).GetLengthSquared();
 
 	// loop cache
 	AStar* currWaypoint;
 	AStar* childWaypoint;
 	int16_t currentIndex, self;
 	uint32_t flags;
-	Path currPath;
 	float f;
 
 	// do not allow to search whole map
 	const int16_t limit = static_cast<int16_t>((g_numWaypoints / 2) + 24);
 
-	PriorityQueue openList;
 	openList.InsertLowest(srcIndex, srcWaypoint.f);
 	while (!openList.IsEmpty())
 	{
@@ -1934,11 +2350,8 @@ void Bot::FindEscapePath(int& srcIndex, const Vector& dangerOrigin)
 		if (!IsValidWaypoint(currentIndex))
 			break;
 
-		// now expand the current waypoint
-		currPath = g_waypoint->m_paths[currentIndex];
-
 		// is the current waypoint the goal waypoint?
-		if (!IsEnemyReachableToPosition(currPath.origin) || openList.Size() > limit)
+		if (!IsEnemyReachableToPosition(HF_Origin(currentIndex)) || openList.Size() > limit)
 		{
 			// delete path for new one
 			m_navNode.Clear();
@@ -1946,7 +2359,7 @@ void Bot::FindEscapePath(int& srcIndex, const Vector& dangerOrigin)
 			do
 			{
 				m_navNode.Add(currentIndex);
-				currentIndex = waypoints[currentIndex].parent;
+				currentIndex = s_searchPool.Get(currentIndex).parent;
 			} while (IsValidWaypoint(currentIndex));
 
 			m_navNode.Reverse();
@@ -1954,37 +2367,33 @@ void Bot::FindEscapePath(int& srcIndex, const Vector& dangerOrigin)
 			return;
 		}
 
-		currWaypoint = &waypoints[currentIndex];
+		currWaypoint = &s_searchPool.Get(currentIndex);
 		if (currWaypoint->is_closed)
 			continue;
 
 		// set current waypoint as closed
 		currWaypoint->is_closed = true;
-		for (i = 0; i < Const_MaxPathIndex; i++)
-		{
-			self = currPath.index[i];
-			if (!IsValidWaypoint(self))
-				break;
 
-			if (flags = g_waypoint->m_paths[self].flags)
+		// now expand the current waypoint
+		for (i = hot.edgeStart[currentIndex]; i < hot.edgeStart[currentIndex + 1]; i++)
+		{
+			self = hot.edgeTarget[i];
+			if (flags = hot.flags[self])
 			{
 				if (flags & WAYPOINT_FALLCHECK)
 				{
-					TraceResult tr{};
-					const Vector origin = g_waypoint->m_paths[self].origin;
-					TraceLine(origin, origin - Vector(0.0f, 0.0f, 60.0f), false, false, GetEntity(), &tr);
-					if (tr.flFraction == 1.0f)
+					if (!g_waypoint->HasGround(self))
 						continue;
 				}
 				else if (flags & WAYPOINT_SPECIFICGRAVITY)
 				{
-					if ((pev->gravity * engine->GetGravity()) > g_waypoint->m_paths[self].gravity)
+					if ((pev->gravity * engine->GetGravity()) > hot.gravity[self])
 						continue;
 				}
 			}
 
-			f = (g_waypoint->m_paths[self].origin - dangerOrigin).GetLengthSquared();
-			childWaypoint = &waypoints[self];
+			f = (HF_Origin(self) - dangerOrigin).GetLengthSquared();
+			childWaypoint = &s_searchPool.Get(self);
 			if (!childWaypoint->is_closed || childWaypoint->f > f)
 			{
 				// put the current child into open list
@@ -2442,10 +2851,10 @@ void Bot::ChangeWptIndex(const int waypointIndex)
 
 	if (m_prevWptIndex[0] != m_currentWaypointIndex)
 	{
-		m_prevWptIndex[0] = m_currentWaypointIndex;
-		m_prevWptIndex[1] = m_prevWptIndex[0];
+		// oldest first, the history has three entries
 		m_prevWptIndex[2] = m_prevWptIndex[1];
-		m_prevWptIndex[3] = m_prevWptIndex[2];
+		m_prevWptIndex[1] = m_prevWptIndex[0];
+		m_prevWptIndex[0] = m_currentWaypointIndex;
 	}
 
 	m_waypoint = g_waypoint->m_paths[waypointIndex];
@@ -2465,6 +2874,9 @@ int Bot::FindDefendWaypoint(const Vector& origin)
 	int i, index;
 	TraceResult tr{};
 	Path* pointer;
+
+	// the visibility table answers for the waypoint we defend, if there is one close enough
+	const int originIndex = g_waypoint->HasVisibility() ? g_waypoint->FindNearestInCircle(origin, 128.0f) : -1;
 	for (i = 0; i < g_waypoint->m_campPoints.Size(); i++)
 	{
 		index = g_waypoint->m_campPoints.Get(i);
@@ -2488,7 +2900,10 @@ int Bot::FindDefendWaypoint(const Vector& origin)
 
 		if (!IsWaypointOccupied(index))
 		{
-			TraceLine(pointer->origin, origin, true, true, pev->pContainingEntity, &tr);
+			if (IsValidWaypoint(originIndex))
+				tr.flFraction = g_waypoint->IsVisibleWaypoint(index, originIndex) ? 1.0f : 0.0f;
+			else
+				TraceLine(pointer->origin, origin, true, true, pev->pContainingEntity, &tr);
 
 			if (tr.flFraction == 1.0f) // distance isn't matter
 				BestSpots.Push(index);
@@ -2917,48 +3332,277 @@ void Bot::FacePosition(void)
 	if (delta > 0.05f)
 		delta = 0.05f;
 
-	// adjust all body and view angles to face an absolute vector
-	Vector direction = (m_lookAt - EyePosition()).ToAngles() + pev->punchangle;
+	g_aimBatch.QueueFace(this, delta);
+}
+
+// m_moveAngles is picked up by the next player move, so it can wait for the batch as well
+void Bot::SetMoveDirection(const Vector& direction)
+{
+	g_aimBatch.QueueMove(this, direction);
+}
+
+// copies what FacePosition needs into the bot's lane, solved right away if the batch is off
+void AimBatch::QueueFace(Bot* bot, const float delta)
+{
+	const int slot = bot->m_index - 1;
+	if (slot < 0 || slot >= 32)
+		return;
+
+	const Vector look = bot->m_lookAt - bot->EyePosition();
+	m_lookX[slot] = look.x;
+	m_lookY[slot] = look.y;
+	m_lookZ[slot] = look.z;
+	m_punchX[slot] = bot->pev->punchangle.x;
+	m_punchY[slot] = bot->pev->punchangle.y;
+	m_angleX[slot] = bot->pev->v_angle.x;
+	m_angleY[slot] = bot->pev->v_angle.y;
+	m_pitchVel[slot] = bot->m_lookPitchVel;
+	m_yawVel[slot] = bot->m_lookYawVel;
+	m_skill[slot] = static_cast<float>(bot->m_skill);
+	m_delta[slot] = delta;
+
+	if (ebot_aim_batch.GetBool())
+		m_face |= 1u << slot;
+	else
+	{
+		SolveFace(slot);
+		ApplyFace(bot);
+	}
+}
+
+void AimBatch::QueueMove(Bot* bot, const Vector& direction)
+{
+	const int slot = bot->m_index - 1;
+	if (slot < 0 || slot >= 32)
+		return;
+
+	m_moveX[slot] = direction.x;
+	m_moveY[slot] = direction.y;
+	m_moveZ[slot] = direction.z;
+
+	if (ebot_aim_batch.GetBool())
+		m_move |= 1u << slot;
+	else
+	{
+		SolveMove(slot);
+		ApplyMove(bot);
+	}
+}
+
+// adjust all body and view angles to face an absolute vector
+void AimBatch::SolveFace(const int slot)
+{
+	const float delta = m_delta[slot];
+	Vector direction = Vector(m_lookX[slot], m_lookY[slot], m_lookZ[slot]).ToAngles() + Vector(m_punchX[slot], m_punchY[slot], 0.0f);
 	direction.x = -direction.x; // invert for engine
 
-	const float angleDiffPitch = AngleNormalize(direction.x - pev->v_angle.x);
-	const float angleDiffYaw = AngleNormalize(direction.y - pev->v_angle.y);
+	const float angleDiffPitch = AngleNormalize(direction.x - m_angleX[slot]);
+	const float angleDiffYaw = AngleNormalize(direction.y - m_angleY[slot]);
 	const float lockn = 0.128f / delta;
+	const float fskill = m_skill[slot];
+	const float accelerate = fskill * 40.0f;
 
 	if (cabsf(angleDiffYaw) < lockn)
 	{
-		m_lookYawVel = 0.0f;
-		pev->v_angle.y = AngleNormalize(direction.y);
+		m_yawVel[slot] = 0.0f;
+		m_angleY[slot] = AngleNormalize(direction.y);
 	}
 	else
 	{
-		const float fskill = static_cast<float>(m_skill);
-		const float accelerate = fskill * 40.0f;
-		m_lookYawVel += delta * cclampf((fskill * 4.0f * angleDiffYaw) - (fskill * 0.4f * m_lookYawVel), -accelerate, accelerate);
-		pev->v_angle.y += delta * m_lookYawVel;
+		m_yawVel[slot] += delta * cclampf((fskill * 4.0f * angleDiffYaw) - (fskill * 0.4f * m_yawVel[slot]), -accelerate, accelerate);
+		m_angleY[slot] += delta * m_yawVel[slot];
 	}
 
 	if (cabsf(angleDiffPitch) < lockn)
 	{
-		m_lookPitchVel = 0.0f;
-		pev->v_angle.x = AngleNormalize(direction.x);
+		m_pitchVel[slot] = 0.0f;
+		m_angleX[slot] = AngleNormalize(direction.x);
 	}
 	else
 	{
-		const float fskill = static_cast<float>(m_skill);
-		const float accelerate = fskill * 40.0f;
-		m_lookPitchVel += delta * cclampf(fskill * 8.0f * angleDiffPitch - (fskill * 0.4f * m_lookPitchVel), -accelerate, accelerate);
-		pev->v_angle.x += delta * m_lookPitchVel;
+		m_pitchVel[slot] += delta * cclampf(fskill * 8.0f * angleDiffPitch - (fskill * 0.4f * m_pitchVel[slot]), -accelerate, accelerate);
+		m_angleX[slot] += delta * m_pitchVel[slot];
+	}
+
+	if (m_angleX[slot] < -89.0f)
+		m_angleX[slot] = -89.0f;
+	else if (m_angleX[slot] > 89.0f)
+		m_angleX[slot] = 89.0f;
+}
+
+void AimBatch::SolveMove(const int slot)
+{
+	Vector angles = Vector(m_moveX[slot], m_moveY[slot], m_moveZ[slot]).ToAngles();
+	angles.ClampAngles();
+	m_moveX[slot] = -angles.x; // invert for engine
+	m_moveY[slot] = angles.y;
+	m_moveZ[slot] = 0.0f;
+}
+
+// Math::AngleNormalize on four lanes, rounds the turns like croundf does
+inline __m128 AngleNormalize4(const __m128 angle)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 turns = _mm_mul_ps(angle, _mm_set1_ps(0.00277777777778f));
+	__m128 rounded = _mm_cvtepi32_ps(_mm_cvttps_epi32(turns));
+	const __m128 fraction = _mm_sub_ps(turns, rounded);
+	rounded = _mm_add_ps(rounded, _mm_and_ps(_mm_cmpgt_ps(fraction, half), one));
+	rounded = _mm_sub_ps(rounded, _mm_and_ps(_mm_cmplt_ps(fraction, _mm_sub_ps(_mm_setzero_ps(), half)), one));
+
+	const __m128 outside = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), angle), _mm_set1_ps(180.0f));
+	return _mm_sub_ps(angle, _mm_and_ps(outside, _mm_mul_ps(rounded, _mm_set1_ps(360.0f))));
+}
+
+inline __m128 Select4(const __m128 mask, const __m128 a, const __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Vector::ToAngles on four lanes, pitch and yaw in degrees
+inline void ToAngles4(const float* x, const float* y, const float* z, __m128& pitch, __m128& yaw)
+{
+	alignas(16) float length[4];
+	alignas(16) float radians[4];
+	const __m128 vx = _mm_load_ps(x);
+	const __m128 vy = _mm_load_ps(y);
+	const __m128 vz = _mm_load_ps(z);
+	_mm_store_ps(length, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy))));
+
+	const __m128 toDegree = _mm_set1_ps(MATH_R2D);
+	catan2f4(z, length, radians);
+	pitch = _mm_mul_ps(_mm_load_ps(radians), toDegree);
+	catan2f4(y, x, radians);
+	yaw = _mm_mul_ps(_mm_load_ps(radians), toDegree);
+
+	// straight up or down
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 epsilon = _mm_set1_ps(MATH_ONEPSILON);
+	const __m128 vertical = _mm_and_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, vx), epsilon), _mm_cmplt_ps(_mm_andnot_ps(sign, vy), epsilon));
+	pitch = Select4(vertical, Select4(_mm_cmpgt_ps(vz, _mm_setzero_ps()), _mm_set1_ps(90.0f), _mm_set1_ps(270.0f)), pitch);
+	yaw = _mm_andnot_ps(vertical, yaw);
+}
+
+// same as SolveFace and SolveMove, four slots at a time, groups without a waiting slot are skipped
+void AimBatch::Solve(void)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	__m128 pitch, yaw;
+
+	int base;
+	for (base = 0; base < 32; base += 4)
+	{
+		if ((m_face >> base) & 15u)
+		{
+			ToAngles4(m_lookX + base, m_lookY + base, m_lookZ + base, pitch, yaw);
+			const __m128 directionX = _mm_sub_ps(zero, _mm_add_ps(pitch, _mm_load_ps(m_punchX + base)));
+			const __m128 directionY = _mm_add_ps(yaw, _mm_load_ps(m_punchY + base));
+
+			const __m128 angleX = _mm_load_ps(m_angleX + base);
+			const __m128 angleY = _mm_load_ps(m_angleY + base);
+			const __m128 diffPitch = AngleNormalize4(_mm_sub_ps(directionX, angleX));
+			const __m128 diffYaw = AngleNormalize4(_mm_sub_ps(directionY, angleY));
+
+			const __m128 delta = _mm_load_ps(m_delta + base);
+			const __m128 lockn = _mm_div_ps(_mm_set1_ps(0.128f), delta);
+			const __m128 skill = _mm_load_ps(m_skill + base);
+			const __m128 accelerate = _mm_mul_ps(skill, _mm_set1_ps(40.0f));
+			const __m128 decelerate = _mm_sub_ps(zero, accelerate);
+			const __m128 damping = _mm_mul_ps(skill, _mm_set1_ps(0.4f));
+
+			__m128 velocity = _mm_load_ps(m_yawVel + base);
+			__m128 force = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(skill, _mm_set1_ps(4.0f)), diffYaw), _mm_mul_ps(damping, velocity));
+			velocity = _mm_add_ps(velocity, _mm_mul_ps(delta, _mm_min_ps(_mm_max_ps(force, decelerate), accelerate)));
+			__m128 lock = _mm_cmplt_ps(_mm_andnot_ps(sign, diffYaw), lockn);
+			_mm_store_ps(m_yawVel + base, _mm_andnot_ps(lock, velocity));
+			_mm_store_ps(m_angleY + base, Select4(lock, AngleNormalize4(directionY), _mm_add_ps(angleY, _mm_mul_ps(delta, velocity))));
+
+			velocity = _mm_load_ps(m_pitchVel + base);
+			force = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(skill, _mm_set1_ps(8.0f)), diffPitch), _mm_mul_ps(damping, velocity));
+			velocity = _mm_add_ps(velocity, _mm_mul_ps(delta, _mm_min_ps(_mm_max_ps(force, decelerate), accelerate)));
+			lock = _mm_cmplt_ps(_mm_andnot_ps(sign, diffPitch), lockn);
+			_mm_store_ps(m_pitchVel + base, _mm_andnot_ps(lock, velocity));
+
+			const __m128 angle = Select4(lock, AngleNormalize4(directionX), _mm_add_ps(angleX, _mm_mul_ps(delta, velocity)));
+			_mm_store_ps(m_angleX + base, _mm_min_ps(_mm_max_ps(angle, _mm_set1_ps(-89.0f)), _mm_set1_ps(89.0f)));
+		}
+
+		if ((m_move >> base) & 15u)
+		{
+			ToAngles4(m_moveX + base, m_moveY + base, m_moveZ + base, pitch, yaw);
+			_mm_store_ps(m_moveX + base, _mm_sub_ps(zero, AngleNormalize4(pitch)));
+			_mm_store_ps(m_moveY + base, AngleNormalize4(yaw));
+			_mm_store_ps(m_moveZ + base, zero);
+		}
 	}
+}
 
-	if (pev->v_angle.x < -89.0f)
-		pev->v_angle.x = -89.0f;
-	else if (pev->v_angle.x > 89.0f)
-		pev->v_angle.x = 89.0f;
+void AimBatch::ApplyFace(Bot* bot)
+{
+	const int slot = bot->m_index - 1;
+	bot->pev->v_angle.x = m_angleX[slot];
+	bot->pev->v_angle.y = m_angleY[slot];
+	bot->m_lookPitchVel = m_pitchVel[slot];
+	bot->m_lookYawVel = m_yawVel[slot];
 
 	// set the body angles to point the gun correctly
-	pev->angles.x = -pev->v_angle.x * 0.33333333333f;
-	pev->angles.y = pev->v_angle.y;
+	bot->pev->angles.x = -bot->pev->v_angle.x * 0.33333333333f;
+	bot->pev->angles.y = bot->pev->v_angle.y;
+}
+
+void AimBatch::ApplyMove(Bot* bot)
+{
+	const int slot = bot->m_index - 1;
+	bot->m_moveAngles = Vector(m_moveX[slot], m_moveY[slot], m_moveZ[slot]);
+}
+
+// solves a queued face lane right away, for bots that trace or shoot along their view angles in this think
+void AimBatch::Flush(Bot* bot)
+{
+	const int slot = bot->m_index - 1;
+	if (slot < 0 || slot >= 32)
+		return;
+
+	const uint32_t bit = 1u << slot;
+	if (!(m_face & bit))
+		return;
+
+	SolveFace(slot);
+	ApplyFace(bot);
+	m_face &= ~bit;
+}
+
+// runs after every bot has thought, the angles are only read by the player moves of the next frame
+void AimBatch::Run(void)
+{
+	if (!m_face && !m_move)
+		return;
+
+	PROFILE_SCOPE(Profile_AimBatch);
+	Solve();
+
+	Bot* bot;
+	int slot;
+	for (slot = 0; slot < 32; slot++)
+	{
+		const uint32_t bit = 1u << slot;
+		if (!((m_face | m_move) & bit))
+			continue;
+
+		bot = g_botManager->GetBot(slot);
+		if (!bot || !bot->pev || bot->m_index != slot + 1)
+			continue;
+
+		if (m_face & bit)
+			ApplyFace(bot);
+
+		if (m_move & bit)
+			ApplyMove(bot);
+	}
+
+	m_face = 0;
+	m_move = 0;
 }
 
 void Bot::LookAt(const Vector& origin)
@@ -3002,10 +3646,14 @@ int Bot::FindHostage(void)
 	if (m_team != Team::Counter || g_mapType != MAP_CS)
 		return -1;
 
-	edict_t* ent = nullptr;
-
-	while (!FNullEnt(ent = FIND_ENTITY_BY_CLASSNAME(ent, "hostage_entity")))
+	edict_t* ent;
+	int16_t i;
+	for (i = 0; i < g_worldSnapshot.m_hostages.Size(); i++)
 	{
+		ent = g_worldSnapshot.m_hostages[i];
+		if (ent->free)
+			continue;
+
 		int16_t j;
 		bool canF = true;
 		for (const auto& bot : g_botManager->m_bots)
@@ -3040,12 +3688,14 @@ int Bot::FindLoosedBomb(void)
 	if (GetGameMode() != GameMode::Original || g_mapType != MAP_DE)
 		return -1;
 
-	edict_t* bombEntity = nullptr; // temporaly pointer to bomb
+	edict_t* bombEntity; // temporaly pointer to bomb
 
 	// search the bomb on the map
-	while (!FNullEnt(bombEntity = FIND_ENTITY_BY_CLASSNAME(bombEntity, "weaponbox")))
+	int16_t i;
+	for (i = 0; i < g_worldSnapshot.m_bombs.Size(); i++)
 	{
-		if (cstrcmp(STRING(bombEntity->v.model) + 9, "backpack.mdl") == 0)
+		bombEntity = g_worldSnapshot.m_bombs[i];
+		if (!bombEntity->free)
 		{
 			int nearestIndex = g_waypoint->FindNearest(bombEntity->v.origin, 512.0f, -1, bombEntity);
 			if (IsValidWaypoint(nearestIndex))
@@ -3073,34 +3723,22 @@ bool Bot::IsWaypointOccupied(const int index)
 	if (pev->solid == SOLID_NOT)
 		return false;
 
-	Path* pointer;
-	Bot* bot;
-	for (const auto& client : g_clients)
-	{
-		if (!(client.flags & CFLAG_USED) || !(client.flags & CFLAG_ALIVE) || client.team != m_team || client.ent == GetEntity())
-			continue;
+	if (!IsValidWaypoint(index) || m_team < Team::Terrorist || m_team >= Team::Spectator)
+		return false;
 
-		bot = g_botManager->GetBot(client.index);
-		if (bot && bot->m_isAlive)
-		{
-			if (bot->m_currentWaypointIndex == index)
-				return true;
+	g_waypoint->UpdateThreatField();
+	const WaypointThreatField& field = g_waypoint->GetThreatField();
+	if (field.IsHumanReserved(m_team, index))
+		return true;
 
-			if (bot->m_prevWptIndex[0] == index)
-				return true;
+	if (!field.IsOccupied(m_team, index))
+		return false;
 
-			if (!bot->m_navNode.IsEmpty() && bot->m_navNode.Last() == index)
-				return true;
-		}
-		else
-		{
-			pointer = g_waypoint->GetPath(index);
-			if (pointer && ((client.ent->v.origin + client.ent->v.velocity * m_frameInterval) - pointer->origin).GetLengthSquared() < squaredi(pointer->radius + 54))
-				return true;
-		}
-	}
+	// our own marks don't count, unless another bot has the waypoint too
+	if (index != m_currentWaypointIndex && index != m_prevWptIndex[0] && (m_navNode.IsEmpty() || m_navNode.Last() != index))
+		return true;
 
-	return false;
+	return field.IsShared(m_team, index);
 }
 
 // this function tries to find nearest to current bot button, and returns pointer to
@@ -3111,13 +3749,18 @@ edict_t* Bot::FindNearestButton(const char* className)
 		return nullptr;
 
 	float nearestDistance = 65355.0f;
-	edict_t* searchEntity = nullptr;
+	edict_t* searchEntity;
 	edict_t* foundEntity = nullptr;
 	float distance;
 
 	// find the nearest button which can open our target
-	while (!FNullEnt(searchEntity = FIND_ENTITY_BY_TARGET(searchEntity, className)))
+	int16_t i;
+	for (i = 0; i < g_worldSnapshot.m_targeters.Size(); i++)
 	{
+		searchEntity = g_worldSnapshot.m_targeters[i];
+		if (searchEntity->free || cstrcmp(STRING(searchEntity->v.target), className) != 0)
+			continue;
+
 		distance = (pev->origin - GetEntityOrigin(searchEntity)).GetLengthSquared();
 		if (distance < nearestDistance)
 		{
@@ -1,5 +1,7 @@
 ﻿#include <core.h>
 
+extern ConVar ebot_analyze_frame_ms;
+
 bool IsValidNavArea(const uint16_t index)
 {
     if (index >= g_numNavAreas)
@@ -32,8 +34,14 @@ uint8_t GetNextCorner(const uint8_t corner)
 
 void ENavMesh::Initialize(void)
 {
+    int16_t i;
+    for (i = 0; i < m_area.Size(); i++)
+        safedel(m_area[i].connection);
+
     m_area.Destroy();
+    m_hashDirty = true;
     g_numNavAreas = 0;
+    m_pathCornerCount = 0;
 }
 
 void ENavMesh::CreateBasic(void)
@@ -138,28 +146,72 @@ void ENavMesh::CreateBasic(void)
         CreateArea(GetPositionOnGrid(GetWalkablePosition(GetEntityOrigin(ent))));
 }
 
-int16_t GetNearestNavAreaCenterID(const Vector& origin, const float maxDist, const int ignore)
+static inline int GetNavHashCell(const float value)
 {
-    int16_t index = -1;
-    uint16_t i;
-    float dist, minDist = squaredf(maxDist);
+    return static_cast<int>(cfloorf(value / GridSize));
+}
 
-    // for each NavArea
-    for (i = 0; i < g_numNavAreas; i++)
+static inline int GetNavHashBucket(const int x, const int y)
+{
+    return static_cast<int>((static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u)) & (NavHashBuckets - 1);
+}
+
+void ENavMesh::HashArea(const int16_t index)
+{
+    const Vector center = m_area[index].GetCenter();
+    int16_t& head = m_hashHead[GetNavHashBucket(GetNavHashCell(center.x), GetNavHashCell(center.y))];
+    m_hashNext[index] = head;
+    head = index;
+}
+
+void ENavMesh::RebuildHash(void)
+{
+    int16_t i;
+    for (i = 0; i < NavHashBuckets; i++)
+        m_hashHead[i] = -1;
+
+    m_hashNext.Destroy();
+    m_hashNext.Reserve(static_cast<int16_t>(g_numNavAreas));
+    for (i = 0; i < static_cast<int16_t>(g_numNavAreas); i++)
     {
-        // ignore this for expanding
-        if (i == ignore)
-            continue;
+        m_hashNext.Push(-1);
+        HashArea(i);
+    }
 
-        // compute the squared distance from the given origin to the NavArea's center
-        dist = (g_navmesh->GetNavArea(i).GetCenter() - origin).GetLengthSquared();
+    m_hashDirty = false;
+}
 
-        // if this NavArea is closer than the previous closest NavArea
-        if (dist < minDist)
+// closest area center within maxDist, only the cells around the origin are searched
+int16_t ENavMesh::GetNearestAreaCenter(const Vector& origin, const float maxDist, const int ignore)
+{
+    if (m_hashDirty)
+        RebuildHash();
+
+    const int rings = static_cast<int>(cceilf(maxDist / GridSize));
+    const int cellX = GetNavHashCell(origin.x);
+    const int cellY = GetNavHashCell(origin.y);
+
+    int16_t index = -1, area;
+    float dist, minDist = squaredf(maxDist);
+    int x, y;
+    for (x = cellX - rings; x <= cellX + rings; x++)
+    {
+        for (y = cellY - rings; y <= cellY + rings; y++)
         {
-            // update the closest NavArea and its minimum distance
-            index = g_navmesh->GetNavArea(i).index;
-            minDist = dist;
+            for (area = m_hashHead[GetNavHashBucket(x, y)]; area != -1; area = m_hashNext[area])
+            {
+                // ignore this for expanding
+                if (area == ignore)
+                    continue;
+
+                // buckets are shared, the same area can show up twice, equal distances keep the lower index like a full scan would
+                dist = (m_area[area].GetCenter() - origin).GetLengthSquared();
+                if (dist < minDist || (dist == minDist && area < index))
+                {
+                    index = area;
+                    minDist = dist;
+                }
+            }
         }
     }
 
@@ -254,11 +306,13 @@ bool IsReachable(const Vector& start, const Vector& end)
 
 void ENavMesh::Analyze(void)
 {
+    PROFILE_SCOPE(Profile_NavAnalyze);
+    MEMORY_TAG(Mem_Navmesh);
+
     if (!g_numNavAreas)
         return;
 
     static bool* expanded{};
-    static float magicTimer{};
     if (!FNullEnt(g_hostEntity))
     {
         char message[] =
@@ -269,19 +323,21 @@ void ENavMesh::Analyze(void)
         HudMessage(g_hostEntity, true, Color(255, 255, 255, 255), message);
     }
 
-    int16_t i, j;
+    int i;
 
     // guarantee to have it
     if (!expanded)
     {
-        safeloc(expanded, Const_MaxWaypoints);
-        for (i = 0; i < Const_MaxWaypoints; i++)
+        safeloc(expanded, Const_MaxNavAreas);
+        for (i = 0; i < Const_MaxNavAreas; i++)
             expanded[i] = false;
     }
 
+    // expand as many areas as fit in the frame budget, new ones are appended and picked up by the same loop
+    const double deadline = GetRealTime() + static_cast<double>(cmaxf(ebot_analyze_frame_ms.GetFloat() * g_frameGovernor.GetScale(), 0.1f)) * 0.001;
+
     ENavArea* area;
     int what, nav;
-    TraceResult tr{};
     Vector temp, temp2;
     int8_t dir;
     for (i = 0; i < g_numNavAreas; i++)
@@ -289,7 +345,7 @@ void ENavMesh::Analyze(void)
         if (expanded[i])
             continue;
 
-        if (magicTimer > engine->GetTime())
+        if (GetRealTime() > deadline)
             return;
 
         for (dir = 0; dir < ENavDir::NumDir; dir++)
@@ -322,7 +378,7 @@ void ENavMesh::Analyze(void)
                 continue;
             }
 
-            nav = GetNearestNavAreaCenterID(temp2, GridSize * 1.1f, i);
+            nav = GetNearestAreaCenter(temp2, GridSize * 1.1f, i);
             if (nav != -1)
             {
                 ConnectArea(i, nav);
@@ -331,27 +387,6 @@ void ENavMesh::Analyze(void)
                 continue;
             }
 
-            for (j = 0; j < g_numNavAreas; j++)
-            {
-                if (m_area[i].index == m_area[j].index)
-                {
-                    engine->DrawLine(g_hostEntity, temp, temp2, Color(255, 0, 0, 255), 4, 0, 5, 1, LINE_SIMPLE);
-                    continue;
-                }
-
-                if (m_area[j].IsPointOverlapping(temp2))
-                {
-                    engine->DrawLine(g_hostEntity, temp, temp2, Color(255, 0, 0, 255), 4, 0, 5, 1, LINE_SIMPLE);
-                    continue;
-                }
-
-                if (m_area[j].IsAreaOverlapping(m_area[i]))
-                {
-                    engine->DrawLine(g_hostEntity, temp, temp2, Color(255, 0, 0, 255), 4, 0, 5, 1, LINE_SIMPLE);
-                    continue;
-                }
-            }
-
             if (!IsWalkableLineClear(temp, temp2))
             {
                 engine->DrawLine(g_hostEntity, temp, temp2, Color(255, 0, 0, 255), 4, 0, 5, 1, LINE_SIMPLE);
@@ -364,41 +399,229 @@ void ENavMesh::Analyze(void)
             area = CreateArea(temp2);
             if (area)
             {
-                if (IsReachable(area->GetCenter(), GetNavArea(i).GetCenter()))
-                    ConnectArea(area->index, i);
+                const Vector center = area->GetCenter();
+                const int16_t index = area->index;
+                if (IsReachable(center, m_area[i].GetCenter()))
+                    ConnectArea(index, i);
 
-                if (IsReachable(GetNavArea(i).GetCenter(), area->GetCenter()))
-                    ConnectArea(i, area->index);
+                if (IsReachable(m_area[i].GetCenter(), center))
+                    ConnectArea(i, index);
             }
-
-            magicTimer = engine->GetTime() + 0.005f;
         }
 
         expanded[i] = true;
     }
 
-    if (magicTimer + 2.0f < engine->GetTime()) // set to 2.0f
+    // every area is expanded, nothing can add more
+    g_analyzewaypoints = false;
+    g_analyzenavmesh = false;
+    g_waypointOn = false;
+    //g_navmeshOn = false;
+    g_editNoclip = false;
+    FinishAnalyze();
+    safedel(expanded);
+}
+
+void ENavMesh::FinishAnalyze(void)
+{
+    // the analyzer leaves one small area per grid cell, merge them into as few as possible
+    OptimizeNavMesh();
+}
+
+// two areas can become one rectangle when they share a whole side, are flat at the same height and have the same flags
+static bool CanMergeAreas(const ENavArea& area, const ENavArea& other)
+{
+    if (area.flags != other.flags || (area.flags & NAV_LADDER))
+        return false;
+
+    float low = area.dirHeight[0], high = low;
+    uint8_t i;
+    for (i = 0; i < ENavDir::NumDir; i++)
     {
-        g_analyzewaypoints = false;
-        g_analyzenavmesh = false;
-        g_waypointOn = false;
-        //g_navmeshOn = false;
-        g_editNoclip = false;
-        FinishAnalyze();
-        safedel(expanded);
+        low = cminf(low, cminf(area.dirHeight[i], other.dirHeight[i]));
+        high = cmaxf(high, cmaxf(area.dirHeight[i], other.dirHeight[i]));
     }
+
+    if (high - low > NavMergeHeight)
+        return false;
+
+    // analyzed areas are smaller than a grid cell, neighbours have up to half a cell between them
+    const float gap = GridSize * 0.5f + 1.0f;
+    if (cabsf(area.direction[ENavDir::Forward] - other.direction[ENavDir::Forward]) < 1.0f && cabsf(area.direction[ENavDir::Backward] - other.direction[ENavDir::Backward]) < 1.0f)
+        return cabsf(area.direction[ENavDir::Right] - other.direction[ENavDir::Left]) <= gap || cabsf(other.direction[ENavDir::Right] - area.direction[ENavDir::Left]) <= gap;
+
+    if (cabsf(area.direction[ENavDir::Right] - other.direction[ENavDir::Right]) < 1.0f && cabsf(area.direction[ENavDir::Left] - other.direction[ENavDir::Left]) < 1.0f)
+        return cabsf(area.direction[ENavDir::Forward] - other.direction[ENavDir::Backward]) <= gap || cabsf(other.direction[ENavDir::Forward] - area.direction[ENavDir::Backward]) <= gap;
+
+    return false;
 }
 
-void ENavMesh::FinishAnalyze(void)
+// merges connected areas until nothing can be merged, then removes the merged ones in one pass,
+// deleting them one by one renumbers every connection each time
+void ENavMesh::OptimizeNavMesh(void)
 {
-    uint16_t i;
+    MEMORY_TAG(Mem_Navmesh);
 
-    // try to merge nav areas, first try to merge if their z axis is equal
-    MiniArray <int> mergeList;
-    for (i = 0; i < g_numNavAreas; i++)
+    const int count = g_numNavAreas;
+    if (count < 2)
+        return;
+
+    // merged areas point to the one that took them, connections are followed through it
+    int16_t* parent = safeloc<int16_t>(count);
+    int i, j, k, l;
+    for (i = 0; i < count; i++)
+        parent[i] = static_cast<int16_t>(i);
+
+    auto find = [parent](int index)
     {
+        while (parent[index] != index)
+        {
+            parent[index] = parent[parent[index]];
+            index = parent[index];
+        }
+
+        return index;
+    };
+
+    uint16_t connections[255];
+    int numConnections, other, merged = 0;
+    bool changed, back;
+    do
+    {
+        changed = false;
+        for (i = 0; i < count; i++)
+        {
+            if (parent[i] != i)
+                continue;
+
+            ENavArea& area = m_area[i];
+            for (j = 0; j < area.connectionCount; j++)
+            {
+                other = find(area.connection[j]);
+                if (other == i)
+                    continue;
 
+                ENavArea& target = m_area[other];
+                if (!CanMergeAreas(area, target))
+                    continue;
+
+                // only areas that can be walked both ways
+                back = false;
+                for (k = 0; k < target.connectionCount; k++)
+                {
+                    if (find(target.connection[k]) == i)
+                    {
+                        back = true;
+                        break;
+                    }
+                }
+
+                if (!back)
+                    continue;
+
+                area.MergeBounds(target);
+                parent[other] = static_cast<int16_t>(i);
+
+                // take over its connections, kept as the areas they resolve to right now so the list stays short
+                numConnections = 0;
+                for (k = 0; k < area.connectionCount + target.connectionCount && numConnections < 255; k++)
+                {
+                    const uint16_t connection = static_cast<uint16_t>(find(k < area.connectionCount ? area.connection[k] : target.connection[k - area.connectionCount]));
+                    if (connection == i)
+                        continue;
+
+                    for (l = 0; l < numConnections; l++)
+                    {
+                        if (connections[l] == connection)
+                            break;
+                    }
+
+                    if (l == numConnections)
+                        connections[numConnections++] = connection;
+                }
+
+                uint16_t* newCons = new(std::nothrow) uint16_t[numConnections > 0 ? numConnections : 1]{};
+                if (newCons)
+                {
+                    cmemcpy(newCons, connections, sizeof(uint16_t) * numConnections);
+                    safedel(area.connection);
+                    area.connection = newCons;
+                    area.connectionCount = static_cast<uint8_t>(numConnections);
+                }
+
+                merged++;
+                changed = true;
+                j = -1; // the list changed, start over
+            }
+        }
+    } while (changed);
+
+    if (!merged)
+    {
+        safedel(parent);
+        ServerPrint("NavMesh optimized: nothing to merge, %d areas", count);
+        return;
     }
+
+    int16_t* remap = safeloc<int16_t>(count);
+    int16_t alive = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (parent[i] == i)
+            remap[i] = alive++;
+    }
+
+    int16_t mapped;
+    for (i = 0; i < count; i++)
+    {
+        ENavArea& area = m_area[i];
+        if (parent[i] != i)
+        {
+            safedel(area.connection);
+            area.connectionCount = 0;
+            continue;
+        }
+
+        // renumber in place, the list can only get shorter
+        numConnections = 0;
+        for (j = 0; j < area.connectionCount; j++)
+        {
+            mapped = remap[find(area.connection[j])];
+            if (mapped == remap[i])
+                continue;
+
+            for (k = 0; k < numConnections; k++)
+            {
+                if (area.connection[k] == mapped)
+                    break;
+            }
+
+            if (k == numConnections)
+                area.connection[numConnections++] = static_cast<uint16_t>(mapped);
+        }
+
+        area.connectionCount = static_cast<uint8_t>(numConnections);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (parent[i] != i)
+            continue;
+
+        if (remap[i] != i)
+            m_area[remap[i]] = m_area[i];
+
+        m_area[remap[i]].index = static_cast<uint16_t>(remap[i]);
+    }
+
+    m_area.Truncate(alive);
+    g_numNavAreas = static_cast<uint16_t>(alive);
+    m_hashDirty = true;
+    m_selectedNavIndex = -1;
+
+    safedel(parent);
+    safedel(remap);
+    ServerPrint("NavMesh optimized: %d areas merged, %d left", merged, alive);
 }
 
 void ENavMesh::ConnectArea(const int start, const int goal)
@@ -485,6 +708,8 @@ void ENavMesh::DisconnectArea(const int start, const int goal)
 
 ENavArea* ENavMesh::CreateArea(const Vector origin, const bool expand)
 {
+    MEMORY_TAG(Mem_Navmesh);
+
     if (g_numNavAreas >= Const_MaxNavAreas)
         return nullptr;
 
@@ -519,10 +744,27 @@ ENavArea* ENavMesh::CreateArea(const Vector origin, const bool expand)
     //else
     //    area->ExpandNavArea(static_cast<uint8_t>(croundf(GridSize * 0.25f)));
 
+    // appended areas go straight into the hash, no need to rebuild it
+    if (!m_hashDirty)
+    {
+        m_hashNext.Push(-1);
+        HashArea(static_cast<int16_t>(index));
+    }
+
     PlaySound(g_hostEntity, "weapons/xbow_hit1.wav");
     return area;
 }
 
+// the target grows over the other area, so its center moves even when the delete bails out
+void ENavMesh::MergeArea(const int target, const int index)
+{
+    if (target == index || !IsValidNavArea(target) || !IsValidNavArea(index))
+        return;
+
+    m_area[target].MergeWith(m_area[index]);
+    m_hashDirty = true;
+}
+
 void ENavMesh::DeleteArea(const ENavArea area)
 {
     DeleteAreaByIndex(area.index);
@@ -571,10 +813,13 @@ void ENavMesh::DeleteAreaByIndex(const int index)
             m_area[i].index--;
     }
 
+    safedel(m_area[index].connection);
     m_area.RemoveAt(index);
     if (g_numNavAreas)
         g_numNavAreas--;
 
+    m_hashDirty = true;
+
     PlaySound(g_hostEntity, "weapons/mine_activate.wav");
 }
 
@@ -683,6 +928,10 @@ void ENavMesh::DrawNavArea(void)
     engine->DrawLine(g_hostEntity, aimPosition + Vector(0.0f, size, 0.0f), aimPosition + Vector(0.0f, -size, 0.0f), Color(255, 255, 255, 255), 4, 0, 5, 1, LINE_SIMPLE);
     engine->DrawLine(g_hostEntity, aimPosition + Vector(0.0f, 0.0f, size), aimPosition + Vector(0.0f, 0.0f, -size), Color(255, 255, 255, 255), 4, 0, 5, 1, LINE_SIMPLE);
 
+    int corner;
+    for (corner = 1; corner < m_pathCornerCount; corner++)
+        engine->DrawLine(g_hostEntity, m_pathCorners[corner - 1], m_pathCorners[corner], Color(255, 255, 0, 255), 10, 0, 5, 1, LINE_SIMPLE);
+
     const int areaIndex = GetNearestNavAreaID(aimPosition);
     if (areaIndex == -1)
         return;
@@ -739,6 +988,270 @@ void ENavMesh::DrawNavArea(void)
     }
 }
 
+// twice the signed area of the triangle, sign tells on which side of a to b the point c is
+inline float TriArea2(const Vector& a, const Vector& b, const Vector& c)
+{
+    return (c.x - a.x) * (b.y - a.y) - (b.x - a.x) * (c.y - a.y);
+}
+
+inline bool IsSamePoint2D(const Vector& a, const Vector& b)
+{
+    return (a - b).GetLengthSquared2D() < 0.01f;
+}
+
+// simple stupid funnel over the portals, the first and the last portal are the start and goal points
+// writes the corner points after the start and the portal each corner belongs to
+static int RunFunnel(const Vector* lefts, const Vector* rights, const int numPortals, Vector* corners, int* cornerPortals, const int maxCorners)
+{
+    if (numPortals < 2 || maxCorners < 1)
+        return 0;
+
+    int count = 0;
+    Vector apex = lefts[0], left = lefts[0], right = rights[0];
+    int apexIndex = 0, leftIndex = 0, rightIndex = 0;
+
+    int i;
+    for (i = 1; i < numPortals && count < maxCorners; i++)
+    {
+        const Vector& newLeft = lefts[i];
+        const Vector& newRight = rights[i];
+
+        // tighten the right side
+        if (TriArea2(apex, right, newRight) <= 0.0f)
+        {
+            if (IsSamePoint2D(apex, right) || TriArea2(apex, left, newRight) > 0.0f)
+            {
+                right = newRight;
+                rightIndex = i;
+            }
+            else
+            {
+                // right crossed over left, left is the next corner
+                corners[count] = left;
+                cornerPortals[count++] = leftIndex;
+                apex = left;
+                apexIndex = leftIndex;
+                right = left;
+                rightIndex = leftIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+
+        // tighten the left side
+        if (TriArea2(apex, left, newLeft) >= 0.0f)
+        {
+            if (IsSamePoint2D(apex, left) || TriArea2(apex, right, newLeft) < 0.0f)
+            {
+                left = newLeft;
+                leftIndex = i;
+            }
+            else
+            {
+                // left crossed over right, right is the next corner
+                corners[count] = right;
+                cornerPortals[count++] = rightIndex;
+                apex = right;
+                apexIndex = rightIndex;
+                left = right;
+                leftIndex = rightIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+
+    // the goal is always the last corner
+    if (count < maxCorners && (!count || !IsSamePoint2D(corners[count - 1], lefts[numPortals - 1])))
+    {
+        corners[count] = lefts[numPortals - 1];
+        cornerPortals[count++] = numPortals - 1;
+    }
+
+    return count;
+}
+
+// shared edge of two connected areas, left and right are seen when moving from the first to the second area
+static void GetPortal(ENavArea& from, ENavArea& to, Vector& left, Vector& right)
+{
+    const float minX = cmaxf(from.direction[ENavDir::Left], to.direction[ENavDir::Left]);
+    const float maxX = cminf(from.direction[ENavDir::Right], to.direction[ENavDir::Right]);
+    const float minY = cmaxf(from.direction[ENavDir::Backward], to.direction[ENavDir::Backward]);
+    const float maxY = cminf(from.direction[ENavDir::Forward], to.direction[ENavDir::Forward]);
+    const Vector fromCenter = from.GetCenter();
+    const Vector toCenter = to.GetCenter();
+
+    // the thinner side of the overlap is the edge we cross
+    Vector a, b;
+    if (maxX - minX < maxY - minY)
+    {
+        const float x = (minX + maxX) * 0.5f;
+        a = Vector(x, cminf(minY, maxY), toCenter.z);
+        b = Vector(x, cmaxf(minY, maxY), toCenter.z);
+    }
+    else
+    {
+        const float y = (minY + maxY) * 0.5f;
+        a = Vector(cminf(minX, maxX), y, toCenter.z);
+        b = Vector(cmaxf(minX, maxX), y, toCenter.z);
+    }
+
+    const Vector dir = toCenter - fromCenter;
+    if (dir.x * (a.y - fromCenter.y) - dir.y * (a.x - fromCenter.x) > 0.0f)
+    {
+        left = a;
+        right = b;
+    }
+    else
+    {
+        left = b;
+        right = a;
+    }
+}
+
+static SearchPool s_navSearch;
+static Vector* s_portals{};
+static int s_portalCapacity{};
+static int s_cornerPortals[MaxNavCorners]{};
+
+// A* over the area connections, corridor must be initialized and gets the areas from start to goal
+bool ENavMesh::FindPath(const int srcArea, const int destArea, PathNode& corridor)
+{
+    corridor.Clear();
+    if (!IsValidNavArea(srcArea) || !IsValidNavArea(destArea))
+        return false;
+
+    PriorityQueue& openList = s_navSearch.Begin(g_numNavAreas);
+    const Vector goal = m_area[destArea].GetCenter();
+
+    AStar& srcNode = s_navSearch.Get(srcArea);
+    srcNode.f = (m_area[srcArea].GetCenter() - goal).GetLength();
+    openList.InsertLowest(static_cast<int16_t>(srcArea), srcNode.f);
+
+    int16_t currentIndex;
+    uint8_t i;
+    float g;
+    while (!openList.IsEmpty())
+    {
+        currentIndex = openList.RemoveLowest();
+        if (currentIndex == destArea)
+        {
+            do
+            {
+                corridor.Add(currentIndex);
+                currentIndex = s_navSearch.Get(currentIndex).parent;
+            } while (currentIndex != -1);
+
+            corridor.Reverse();
+            return true;
+        }
+
+        AStar& current = s_navSearch.Get(currentIndex);
+        if (current.is_closed)
+            continue;
+
+        current.is_closed = true;
+
+        ENavArea& area = m_area[currentIndex];
+        const Vector origin = area.GetCenter();
+        for (i = 0; i < area.connectionCount; i++)
+        {
+            const uint16_t link = area.connection[i];
+            if (!IsValidNavArea(link))
+                continue;
+
+            ENavArea& next = m_area[link];
+            if (link != destArea && (next.flags & (NAV_AVOID | NAV_DONT_WALK)))
+                continue;
+
+            AStar& child = s_navSearch.Get(link);
+            if (child.is_closed)
+                continue;
+
+            const Vector center = next.GetCenter();
+            g = current.g + (center - origin).GetLength();
+            if (child.parent != -1 && child.g <= g)
+                continue;
+
+            child.parent = currentIndex;
+            child.g = g;
+            child.f = g + (goal - center).GetLength();
+            openList.InsertLowest(static_cast<int16_t>(link), child.f);
+        }
+    }
+
+    return false;
+}
+
+// pulls the path tight through the corridor, corridor is left with the area of each corner
+int ENavMesh::SmoothPath(const Vector& start, const Vector& goal, PathNode& corridor, Vector* corners, const int maxCorners)
+{
+    const int numAreas = corridor.Length();
+    if (numAreas < 1)
+        return 0;
+
+    const int numPortals = numAreas + 1;
+    if (s_portalCapacity < numPortals * 2)
+    {
+        safedel(s_portals);
+        s_portalCapacity = cmax(numPortals * 2, s_portalCapacity * 2);
+        safeloc(s_portals, s_portalCapacity);
+    }
+
+    Vector* lefts = s_portals;
+    Vector* rights = s_portals + numPortals;
+    lefts[0] = rights[0] = start;
+    lefts[numPortals - 1] = rights[numPortals - 1] = goal;
+
+    int i;
+    for (i = 1; i < numAreas; i++)
+        GetPortal(m_area[corridor.Get(i - 1)], m_area[corridor.Get(i)], lefts[i], rights[i]);
+
+    const int count = RunFunnel(lefts, rights, numPortals, corners, s_cornerPortals, cmin(maxCorners, MaxNavCorners));
+
+    // keep the areas of the corners only, portal i leads into area i
+    int cornerAreas[MaxNavCorners];
+    for (i = 0; i < count; i++)
+        cornerAreas[i] = corridor.Get(cmin(s_cornerPortals[i], numAreas - 1));
+
+    corridor.Clear();
+    for (i = 0; i < count; i++)
+        corridor.Add(cornerAreas[i]);
+
+    return count;
+}
+
+// finds the smoothed path from the host to the selected area and shows it with the nav areas
+void ENavMesh::ShowPath(void)
+{
+    m_pathCornerCount = 0;
+    if (FNullEnt(g_hostEntity))
+        return;
+
+    if (!IsValidNavArea(m_selectedNavIndex))
+    {
+        CenterPrint("Select target nav area first!");
+        return;
+    }
+
+    const Vector start = GetEntityOrigin(g_hostEntity);
+    const int srcArea = GetNearestNavAreaID(start);
+
+    PathNode corridor;
+    corridor.Init(static_cast<int16_t>(cmin(g_numNavAreas + 1, 32767)));
+    if (!FindPath(srcArea, m_selectedNavIndex, corridor))
+    {
+        CenterPrint("No path to nav area #%d", m_selectedNavIndex);
+        return;
+    }
+
+    // first point is the start, so the path can be drawn
+    const int numAreas = corridor.Length();
+    m_pathCorners[0] = start;
+    m_pathCornerCount = SmoothPath(start, m_area[m_selectedNavIndex].GetCenter(), corridor, m_pathCorners + 1, MaxNavCorners - 1) + 1;
+    CenterPrint("Path to nav area #%d: %d areas, %d corners", m_selectedNavIndex, numAreas, m_pathCornerCount - 1);
+}
+
 bool ENavMesh::IsConnected(const int start, const int goal)
 {
     const ENavArea area = m_area[start];
@@ -770,31 +1283,91 @@ const char* CheckSubfolderFile(void)
     return &navFilePath[0];
 }
 
+// bytes of one area record in the nav file, the connections follow the count
+#define NavRecordSize (sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint8_t) + 2 * ENavDir::NumDir * sizeof(float))
+
 bool ENavMesh::LoadNav(void)
 {
-    ENavHeader header;
+    MEMORY_TAG(Mem_Navmesh);
+
     File fp(CheckSubfolderFile(), "rb");
+    if (!fp.IsValid())
+        return false;
 
-    if (fp.IsValid())
+    // the whole file in one read, the records are parsed from memory
+    const int size = fp.GetSize();
+    if (size < static_cast<int>(sizeof(ENavHeader)))
     {
-        Initialize();
-        fp.Read(&header, sizeof(header));
-        g_numNavAreas = header.navNumber;
+        fp.Close();
+        return false;
+    }
 
-        uint16_t i;
-        for (i = 0; i < g_numNavAreas; i++)
+    uint8_t* buffer = safeloc<uint8_t>(size);
+    const bool valid = fp.Read(buffer, size) == 1;
+    fp.Close();
+
+    if (!valid)
+    {
+        safedel(buffer);
+        return false;
+    }
+
+    Initialize();
+
+    ENavHeader header;
+    cmemcpy(&header, buffer, sizeof(header));
+
+    const int count = cclamp(static_cast<int>(header.navNumber), 0, static_cast<int>(INT16_MAX));
+    m_area.Reserve(static_cast<int16_t>(count));
+
+    const uint8_t* read = buffer + sizeof(header);
+    const uint8_t* end = buffer + size;
+
+    int i, j;
+    for (i = 0; i < count; i++)
+    {
+        if (read + NavRecordSize > end)
+            break;
+
+        ENavArea area;
+        cmemcpy(&area.index, read, sizeof(uint16_t));
+        read += sizeof(uint16_t);
+        cmemcpy(&area.flags, read, sizeof(uint32_t));
+        read += sizeof(uint32_t);
+        cmemcpy(&area.connectionCount, read, sizeof(uint8_t));
+        read += sizeof(uint8_t);
+
+        if (read + area.connectionCount * sizeof(uint16_t) + 2 * ENavDir::NumDir * sizeof(float) > end)
+            break;
+
+        safeloc(area.connection, area.connectionCount);
+        cmemcpy(area.connection, read, area.connectionCount * sizeof(uint16_t));
+        read += area.connectionCount * sizeof(uint16_t);
+        cmemcpy(area.direction, read, ENavDir::NumDir * sizeof(float));
+        read += ENavDir::NumDir * sizeof(float);
+        cmemcpy(area.dirHeight, read, ENavDir::NumDir * sizeof(float));
+        read += ENavDir::NumDir * sizeof(float);
+
+        area.index = static_cast<uint16_t>(i);
+        m_area.Push(area);
+    }
+
+    g_numNavAreas = static_cast<uint16_t>(m_area.Size());
+    safedel(buffer);
+
+    // files written before the connections were saved properly hold pointer bytes there, drop what can't be an area
+    int numConnections;
+    for (i = 0; i < g_numNavAreas; i++)
+    {
+        ENavArea& area = m_area[i];
+        numConnections = 0;
+        for (j = 0; j < area.connectionCount; j++)
         {
-            m_area.Push(ENavArea{});
-            fp.Read(&m_area[i].index, sizeof(uint16_t));
-            fp.Read(&m_area[i].flags, sizeof(uint32_t));
-            fp.Read(&m_area[i].connectionCount, sizeof(uint8_t));
-            safeloc(m_area[i].connection, m_area[i].connectionCount);
-            fp.Read(m_area[i].connection, m_area[i].connectionCount * sizeof(uint16_t));
-            fp.Read(&m_area[i].direction, 4 * sizeof(float));
-            fp.Read(&m_area[i].dirHeight, 4 * sizeof(float));
+            if (area.connection[j] < g_numNavAreas && area.connection[j] != i)
+                area.connection[numConnections++] = area.connection[j];
         }
 
-        fp.Close();
+        area.connectionCount = static_cast<uint8_t>(numConnections);
     }
 
     return true;
@@ -810,26 +1383,50 @@ void ENavMesh::SaveNav(void)
     // file was opened
     if (fp.IsValid())
     {
-        // write the nav header to the file...
-        fp.Write(&header, sizeof(header));
-
+        size_t size = sizeof(header);
         uint16_t i;
+        for (i = 0; i < g_numNavAreas; i++)
+            size += NavRecordSize + m_area[i].connectionCount * sizeof(uint16_t);
+
+        // same layout as before, built in memory and written at once
+        uint8_t* buffer = safeloc<uint8_t>(size);
+        uint8_t* write = buffer;
+        auto put = [&write](const void* data, const size_t bytes)
+        {
+            cmemcpy(write, data, bytes);
+            write += bytes;
+        };
+
+        put(&header, sizeof(header));
         for (i = 0; i < g_numNavAreas; i++)
         {
-            fp.Write(&m_area[i].index, sizeof(uint16_t));
-            fp.Write(&m_area[i].flags, sizeof(uint32_t));
-            fp.Write(&m_area[i].connectionCount, sizeof(uint8_t));
-            fp.Write(&m_area[i].connection, m_area[i].connectionCount * sizeof(uint16_t));
-            fp.Write(&m_area[i].direction, 4 * sizeof(float));
-            fp.Write(&m_area[i].dirHeight, 4 * sizeof(float));
+            const ENavArea& area = m_area[i];
+            put(&area.index, sizeof(uint16_t));
+            put(&area.flags, sizeof(uint32_t));
+            put(&area.connectionCount, sizeof(uint8_t));
+            put(area.connection, area.connectionCount * sizeof(uint16_t));
+            put(area.direction, ENavDir::NumDir * sizeof(float));
+            put(area.dirHeight, ENavDir::NumDir * sizeof(float));
         }
 
+        fp.Write(buffer, static_cast<int>(size));
         fp.Close();
+        safedel(buffer);
     }
     else
         AddLogEntry(Log::Error, "writing '%s' navmesh file, missing navigations file, create one", GetMapName());
 }
 
+size_t ENavMesh::GetMemoryUsage(void)
+{
+    size_t bytes = static_cast<size_t>(m_area.Capacity()) * sizeof(ENavArea) + static_cast<size_t>(m_hashNext.Capacity()) * sizeof(int16_t);
+    uint16_t i;
+    for (i = 0; i < g_numNavAreas; i++)
+        bytes += m_area[i].connectionCount * sizeof(uint16_t);
+
+    return bytes;
+}
+
 ENavArea ENavMesh::GetNavArea(const uint16_t id)
 {
     return m_area[id];
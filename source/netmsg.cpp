@@ -39,610 +39,668 @@ NetworkMsg::NetworkMsg(void)
         message = NETMSG_UNDEFINED;
 }
 
-void NetworkMsg::HandleMessageIfRequired(const int messageType, const int requiredType)
+void NetworkMsg::AddRoute(const int message, const uint8_t dests, const Handler handler)
 {
-    if (messageType == m_registerdMessages[requiredType])
-        SetMessage(requiredType);
+    // metamod hands out 0 for a message the game never registered
+    const int id = m_registerdMessages[message];
+    if (id <= 0 || id > 255)
+        return;
+
+    m_routes[id].handler = handler;
+    m_routes[id].message = static_cast<int8_t>(message);
+    m_routes[id].dests = dests;
 }
 
-void NetworkMsg::Execute(void* p)
+void NetworkMsg::BuildRoutes(void)
 {
-    if (m_message == NETMSG_UNDEFINED)
-        return; // no message or not for bot, return
+    // store the message type in our own variables, since the GET_USER_MSG_ID will just do a lot of strcmp's...
+    SetId(NETMSG_VGUI, GET_USER_MSG_ID(PLID, "VGUIMenu", nullptr));
+    SetId(NETMSG_SHOWMENU, GET_USER_MSG_ID(PLID, "ShowMenu", nullptr));
+    SetId(NETMSG_WLIST, GET_USER_MSG_ID(PLID, "WeaponList", nullptr));
+    SetId(NETMSG_CURWEAPON, GET_USER_MSG_ID(PLID, "CurWeapon", nullptr));
+    SetId(NETMSG_AMMOX, GET_USER_MSG_ID(PLID, "AmmoX", nullptr));
+    SetId(NETMSG_AMMOPICK, GET_USER_MSG_ID(PLID, "AmmoPickup", nullptr));
+    //SetId(NETMSG_DAMAGE, GET_USER_MSG_ID(PLID, "Damage", nullptr));
+    SetId(NETMSG_MONEY, GET_USER_MSG_ID(PLID, "Money", nullptr));
+    SetId(NETMSG_STATUSICON, GET_USER_MSG_ID(PLID, "StatusIcon", nullptr));
+    SetId(NETMSG_DEATH, GET_USER_MSG_ID(PLID, "DeathMsg", nullptr));
+    SetId(NETMSG_SCREENFADE, GET_USER_MSG_ID(PLID, "ScreenFade", nullptr));
+    SetId(NETMSG_HLTV, GET_USER_MSG_ID(PLID, "HLTV", nullptr));
+    SetId(NETMSG_TEXTMSG, GET_USER_MSG_ID(PLID, "TextMsg", nullptr));
+    SetId(NETMSG_SCOREINFO, GET_USER_MSG_ID(PLID, "ScoreInfo", nullptr));
+    SetId(NETMSG_BARTIME, GET_USER_MSG_ID(PLID, "BarTime", nullptr));
+    SetId(NETMSG_SENDAUDIO, GET_USER_MSG_ID(PLID, "SendAudio", nullptr));
+    SetId(NETMSG_SAYTEXT, GET_USER_MSG_ID(PLID, "SayText", nullptr));
+    SetId(NETMSG_BOTVOICE, GET_USER_MSG_ID(PLID, "BotVoice", nullptr));
+
+    for (auto& route : m_routes)
+        route = Route{};
+
+    // everything else, the HUD messages of other plugins included, stays unrouted
+    AddRoute(NETMSG_WLIST, Route_Any, &NetworkMsg::HandleWeaponList);
+    AddRoute(NETMSG_HLTV, Route_Spec, &NetworkMsg::HandleHLTV);
+    AddRoute(NETMSG_DEATH, Route_All, &NetworkMsg::HandleDeath);
+    AddRoute(NETMSG_TEXTMSG, Route_All | Route_Bot, &NetworkMsg::HandleTextMsg);
+    AddRoute(NETMSG_VGUI, Route_Bot, &NetworkMsg::HandleVGUI);
+    AddRoute(NETMSG_CURWEAPON, Route_Bot, &NetworkMsg::HandleCurWeapon);
+    AddRoute(NETMSG_AMMOX, Route_Bot, &NetworkMsg::HandleAmmo);
+    AddRoute(NETMSG_AMMOPICK, Route_Bot, &NetworkMsg::HandleAmmo);
+    //AddRoute(NETMSG_DAMAGE, Route_Bot, &NetworkMsg::HandleDamage);
+    AddRoute(NETMSG_MONEY, Route_Bot, &NetworkMsg::HandleMoney);
+    AddRoute(NETMSG_STATUSICON, Route_Bot, &NetworkMsg::HandleStatusIcon);
+    AddRoute(NETMSG_SCREENFADE, Route_Bot, &NetworkMsg::HandleScreenFade);
+    AddRoute(NETMSG_BARTIME, Route_Bot, &NetworkMsg::HandleBarTime);
+    AddRoute(NETMSG_SHOWMENU, Route_Bot, &NetworkMsg::HandleShowMenu);
+
+    // the game registers its messages all at once, try again if it hasn't done that yet
+    for (const auto& message : m_registerdMessages)
+    {
+        if (message > 0)
+        {
+            m_routed = true;
+            break;
+        }
+    }
+}
 
-    // some needed variables
-    static uint8_t r{}, g{}, b{};
-    static uint8_t enabled{};
+void NetworkMsg::Begin(const int msgDest, const int msgType, edict_t* ed)
+{
+    Reset();
+
+    if (!m_routed)
+        BuildRoutes();
 
-    static int index{}, numPlayers{};
-    static int state{}, id{};
-    //static int killerIndex{}, victimIndex{};
+    if (msgType < 0 || msgType > 255)
+        return;
 
-    static WeaponProperty weaponProp{};
+    const Route& route = m_routes[msgType];
+    if (!route.handler)
+        return;
 
-    // now starts of netmessage execution
-    switch (m_message)
+    if (route.dests & Route_Any)
+        m_handler = route.handler;
+    else if (msgDest == MSG_ALL)
     {
-    case NETMSG_VGUI:
+        if (route.dests & Route_All)
+            m_handler = route.handler;
+    }
+    else if (msgDest == MSG_SPEC && (route.dests & Route_Spec))
+        m_handler = route.handler;
+    else if (route.dests & Route_Bot)
     {
-        // this message is sent when a VGUI menu is displayed
-        if (!m_state && m_bot)
+        // is this message for a bot?
+        Bot* bot = g_botManager->GetBot(ed);
+        if (bot && bot->GetEntity() == ed)
         {
-            switch (PTR_TO_INT(p))
+            m_bot = bot;
+            m_handler = route.handler;
+        }
+    }
+
+    if (!m_handler)
+        return;
+
+    m_message = route.message;
+    cmemset(&m_record, 0, sizeof(m_record));
+}
+
+void NetworkMsg::HandleVGUI(void* p)
+{
+    // this message is sent when a VGUI menu is displayed
+    if (!m_state && m_bot)
+    {
+        switch (PTR_TO_INT(p))
+        {
+        case GMENU_TEAM:
+        {
+            m_bot->m_startAction = CMENU_TEAM;
+            break;
+        }
+        case GMENU_TERRORIST:
+        case GMENU_COUNTER:
+        {
+            m_bot->m_startAction = CMENU_CLASS;
+            break;
+        }
+        }
+    }
+}
+
+void NetworkMsg::HandleShowMenu(void* p)
+{
+    // this message is sent when a text menu is displayed
+    if (m_state < 3) // ignore first 3 fields of message
+        return;
+
+    if (m_bot)
+    {
+        const char* x = PTR_TO_STR(p);
+        switch (x[1])
+        {
+        case 'T':
+        {
+            switch (charToInt(x))
+            {
+            case 1010:
             {
-            case GMENU_TEAM:
+                m_bot->m_startAction = CMENU_TEAM;
+                break;
+            }
+            case 1616:
             {
                 m_bot->m_startAction = CMENU_TEAM;
                 break;
             }
-            case GMENU_TERRORIST:
-            case GMENU_COUNTER:
+            case 1593:
             {
                 m_bot->m_startAction = CMENU_CLASS;
                 break;
             }
             }
-        }
-        break;
-    }
-    case NETMSG_SHOWMENU:
-    {
-        // this message is sent when a text menu is displayed
-        if (m_state < 3) // ignore first 3 fields of message
             break;
-
-        if (m_bot)
+        }
+        case 'I':
         {
-            const char* x = PTR_TO_STR(p);
-            switch (x[1])
+            switch (charToInt(x))
             {
-            case 'T':
+            case 1866:
             {
-                switch (charToInt(x))
-                {
-                case 1010:
-                {
-                    m_bot->m_startAction = CMENU_TEAM;
-                    break;
-                }
-                case 1616:
-                {
-                    m_bot->m_startAction = CMENU_TEAM;
-                    break;
-                }
-                case 1593:
-                {
-                    m_bot->m_startAction = CMENU_CLASS;
-                    break;
-                }
-                }
+                m_bot->m_startAction = CMENU_TEAM;
                 break;
             }
-            case 'I':
+            case 1260:
             {
-                switch (charToInt(x))
-                {
-                case 1866:
-                {
-                    m_bot->m_startAction = CMENU_TEAM;
-                    break;
-                }
-                case 1260:
-                {
-                    m_bot->m_startAction = CMENU_TEAM;
-                    break;
-                }
-                case 1594:
-                {
-                    m_bot->m_startAction = CMENU_TEAM;
-                    break;
-                }
-                case 2200:
-                {
-                    m_bot->m_startAction = CMENU_TEAM;
-                    break;
-                }
-                }
+                m_bot->m_startAction = CMENU_TEAM;
                 break;
             }
-            case 'C':
+            case 1594:
             {
-                if (charToInt(x) == 787)
-                {
-                    m_bot->m_startAction = CMENU_CLASS;
-                    break;
-                }
+                m_bot->m_startAction = CMENU_TEAM;
                 break;
             }
-            }
-
-            /*if (cstrncmp(x, "#Team_Select", 13) == 0) // team select menu?
-                m_bot->m_startAction = CMENU_TEAM;
-            else if (cstrncmp(x, "#Team_Select_Spect", 19) == 0) // team select menu?
-                m_bot->m_startAction = CMENU_TEAM;
-            else if (cstrncmp(x, "#IG_Team_Select_Spect", 22) == 0) // team select menu?
-                m_bot->m_startAction = CMENU_TEAM;
-            else if (cstrncmp(x, "#IG_Team_Select", 16) == 0) // team select menu?
-                m_bot->m_startAction = CMENU_TEAM;
-            else if (cstrncmp(x, "#IG_VIP_Team_Select", 20) == 0) // team select menu?
-                m_bot->m_startAction = CMENU_TEAM;
-            else if (cstrncmp(x, "#IG_VIP_Team_Select_Spect", 26) == 0) // team select menu?
+            case 2200:
+            {
                 m_bot->m_startAction = CMENU_TEAM;
-            else if (cstrncmp(x, "#Terrorist_Select", 18) == 0) // T model select?
-                m_bot->m_startAction = CMENU_CLASS;
-            else if (cstrncmp(x, "#CT_Select", 11) == 0) // CT model select menu?
-                m_bot->m_startAction = CMENU_CLASS;*/
-        }
-
-        break;
-    }
-    case NETMSG_WLIST:
-    {
-        // this message is sent when a client joins the game. All of the weapons are sent with the weapon ID and information about what ammo is used
-        switch (m_state)
-        {
-        case 0:
-        {
-            cstrncpy(weaponProp.className, PTR_TO_STR(p), sizeof(weaponProp.className));
-            break;
-        }
-        case 1:
-        {
-            weaponProp.ammo1 = PTR_TO_INT(p); // ammo index 1
-            break;
-        }
-        case 2:
-        {
-            weaponProp.ammo1Max = PTR_TO_INT(p); // max ammo 1
-            break;
-        }
-        case 5:
-        {
-            weaponProp.slotID = PTR_TO_INT(p); // slot for this weapon
-            break;
-        }
-        case 6:
-        {
-            weaponProp.position = PTR_TO_INT(p); // position in slot
-            break;
-        }
-        case 7:
-        {
-            weaponProp.id = PTR_TO_INT(p); // weapon ID
+                break;
+            }
+            }
             break;
         }
-        case 8:
+        case 'C':
         {
-
-            if (weaponProp.id > -1 && weaponProp.id < Const_MaxWeapons)
+            if (charToInt(x) == 787)
             {
-                weaponProp.flags = PTR_TO_INT(p); // flags for weapon (WTF???)
-                g_weaponDefs[weaponProp.id] = weaponProp; // store away this weapon with it's ammo information...
+                m_bot->m_startAction = CMENU_CLASS;
+                break;
             }
-
             break;
         }
         }
+
+        /*if (cstrncmp(x, "#Team_Select", 13) == 0) // team select menu?
+            m_bot->m_startAction = CMENU_TEAM;
+        else if (cstrncmp(x, "#Team_Select_Spect", 19) == 0) // team select menu?
+            m_bot->m_startAction = CMENU_TEAM;
+        else if (cstrncmp(x, "#IG_Team_Select_Spect", 22) == 0) // team select menu?
+            m_bot->m_startAction = CMENU_TEAM;
+        else if (cstrncmp(x, "#IG_Team_Select", 16) == 0) // team select menu?
+            m_bot->m_startAction = CMENU_TEAM;
+        else if (cstrncmp(x, "#IG_VIP_Team_Select", 20) == 0) // team select menu?
+            m_bot->m_startAction = CMENU_TEAM;
+        else if (cstrncmp(x, "#IG_VIP_Team_Select_Spect", 26) == 0) // team select menu?
+            m_bot->m_startAction = CMENU_TEAM;
+        else if (cstrncmp(x, "#Terrorist_Select", 18) == 0) // T model select?
+            m_bot->m_startAction = CMENU_CLASS;
+        else if (cstrncmp(x, "#CT_Select", 11) == 0) // CT model select menu?
+            m_bot->m_startAction = CMENU_CLASS;*/
+    }
+}
+
+void NetworkMsg::HandleWeaponList(void* p)
+{
+    // this message is sent when a client joins the game. All of the weapons are sent with the weapon ID and information about what ammo is used
+    switch (m_state)
+    {
+    case 0:
+    {
+        cstrncpy(m_weapon.className, PTR_TO_STR(p), sizeof(m_weapon.className) - 1);
         break;
     }
-    case NETMSG_CURWEAPON:
+    case 1:
     {
-        // this message is sent when a weapon is selected (either by the bot chosing a weapon or by the server auto assigning the bot a weapon). In CS it's also called when Ammo is increased/decreased
-        switch (m_state)
-        {
-        case 0:
-        {
-            state = PTR_TO_INT(p); // state of the current weapon (WTF???)
-            break;
-        }
-        case 1:
-        {
-            id = PTR_TO_INT(p); // weapon ID of current weapon
-            break;
-        }
-        case 2:
-        {
-            if (m_bot && id > -1 && id < Const_MaxWeapons)
-            {
-                if (state != 0)
-                    m_bot->m_currentWeapon = id;
-                m_bot->m_ammoInClip[id] = PTR_TO_INT(p);
-            }
-            break;
-        }
-        }
+        m_weapon.ammo1 = PTR_TO_INT(p); // ammo index 1
         break;
     }
-    case NETMSG_AMMOX:
+    case 2:
     {
-        switch (m_state)
-        {
-        case 0:
-        {
-            index = PTR_TO_INT(p); // ammo index (for type of ammo)
-            break;
-        }
-        case 1:
-        {
-            if (m_bot && index > -1 && index < Const_MaxWeapons)
-                m_bot->m_ammo[index] = PTR_TO_INT(p);
-            break;
-        }
-        }
+        m_weapon.ammo1Max = PTR_TO_INT(p); // max ammo 1
         break;
     }
-    case NETMSG_AMMOPICK:
+    case 5:
     {
-        // this message is sent when the bot picks up some ammo (AmmoX messages are also sent so this message is probably
-        // not really necessary except it allows the HUD to draw pictures of ammo that have been picked up
-        // The bots don't really need pictures since they don't have any eyes anyway
-        switch (m_state)
-        {
-        case 0:
-        {
-            index = PTR_TO_INT(p);
-            break;
-        }
-        case 1:
+        m_weapon.slotID = PTR_TO_INT(p); // slot for this weapon
+        break;
+    }
+    case 6:
+    {
+        m_weapon.position = PTR_TO_INT(p); // position in slot
+        break;
+    }
+    case 7:
+    {
+        m_weapon.id = PTR_TO_INT(p); // weapon ID
+        break;
+    }
+    case 8:
+    {
+
+        if (m_weapon.id > -1 && m_weapon.id < Const_MaxWeapons)
         {
-            if (m_bot && index > -1 && index < Const_MaxWeapons)
-                m_bot->m_ammo[index] = PTR_TO_INT(p);
-            break;
-        }
+            m_weapon.flags = PTR_TO_INT(p); // flags for weapon (WTF???)
+            g_weaponDefs[m_weapon.id] = m_weapon; // store away this weapon with it's ammo information...
         }
+
         break;
     }
-    case NETMSG_MONEY:
+    }
+}
+
+void NetworkMsg::HandleCurWeapon(void* p)
+{
+    // this message is sent when a weapon is selected (either by the bot chosing a weapon or by the server auto assigning the bot a weapon). In CS it's also called when Ammo is increased/decreased
+    switch (m_state)
+    {
+    case 0:
     {
-        // this message gets sent when the bots money amount changes
-        if (!m_state && m_bot)
-            m_bot->m_moneyAmount = PTR_TO_INT(p); // amount of money
+        m_record.curWeapon.state = PTR_TO_INT(p); // state of the current weapon (WTF???)
         break;
     }
-    case NETMSG_STATUSICON:
+    case 1:
     {
-        switch (m_state)
-        {
-        case 0:
+        m_record.curWeapon.id = PTR_TO_INT(p); // weapon ID of current weapon
+        break;
+    }
+    case 2:
+    {
+        if (m_bot && m_record.curWeapon.id > -1 && m_record.curWeapon.id < Const_MaxWeapons)
         {
-            enabled = PTR_TO_BYTE(p);
-            break;
+            if (m_record.curWeapon.state != 0)
+                m_bot->m_currentWeapon = m_record.curWeapon.id;
+            m_bot->m_ammoInClip[m_record.curWeapon.id] = PTR_TO_INT(p);
         }
-        case 1:
-        {
-            if (!(g_gameVersion & Game::HalfLife) && m_bot)
-            {
-                const char* x = PTR_TO_STR(p);
+        break;
+    }
+    }
+}
 
-                // this is around up to 3-5 times faster than cstrncmp one
-                switch (x[0])
-                {
-                case 'b':
-                {
-                    if (x[1] == 'u' && charToInt(x) == 565)
-                        m_bot->m_inBuyZone = (enabled != 0);
-                    break;
-                }
-                case 'd':
-                {
-                    if (x[1] == 'e' && charToInt(x) == 549)
-                        m_bot->m_hasDefuser = (enabled != 0);
-                    break;
-                }
-                case 'v':
-                {
-                    if (x[1] == 'i' && charToInt(x) == 764)
-                        m_bot->m_inVIPZone = (enabled != 0);
-                    break;
-                }
-                case 'c':
-                {
-                    if (x[1] == '4')
-                        m_bot->m_inBombZone = (enabled == 2);
-                    break;
-                }
-                }
+void NetworkMsg::HandleAmmo(void* p)
+{
+    // this message is sent when the bot picks up some ammo (AmmoX messages are also sent so this message is probably
+    // not really necessary except it allows the HUD to draw pictures of ammo that have been picked up
+    // The bots don't really need pictures since they don't have any eyes anyway
+    switch (m_state)
+    {
+    case 0:
+    {
+        m_record.ammo.index = PTR_TO_INT(p);
+        break;
+    }
+    case 1:
+    {
+        if (m_bot && m_record.ammo.index > -1 && m_record.ammo.index < Const_MaxWeapons)
+            m_bot->m_ammo[m_record.ammo.index] = PTR_TO_INT(p);
+        break;
+    }
+    }
+}
 
-                /*if (cstrncmp(x, "defuser", 8) == 0)
-                    m_bot->m_hasDefuser = (enabled != 0);
-                else if (cstrncmp(x, "buyzone", 8) == 0)
-                    m_bot->m_inBuyZone = (enabled != 0);
-                else if (cstrncmp(x, "vipsafety", 10) == 0)
-                    m_bot->m_inVIPZone = (enabled != 0);
-                else if (cstrncmp(x, "c4", 3) == 0)
-                    m_bot->m_inBombZone = (enabled == 2);*/
-            }
-            break;
-        }
-        }
+void NetworkMsg::HandleMoney(void* p)
+{
+    // this message gets sent when the bots money amount changes
+    if (!m_state && m_bot)
+        m_bot->m_moneyAmount = PTR_TO_INT(p); // amount of money
+}
+
+void NetworkMsg::HandleStatusIcon(void* p)
+{
+    switch (m_state)
+    {
+    case 0:
+    {
+        m_record.statusIcon.enabled = PTR_TO_BYTE(p);
         break;
     }
-    case NETMSG_DEATH: // this message sends on death
+    case 1:
     {
-        if (m_state == 1)
+        if (!(g_gameVersion & Game::HalfLife) && m_bot)
         {
-            Bot* victimer = g_botManager->GetBot(PTR_TO_INT(p));
-            if (victimer)
+            const char* x = PTR_TO_STR(p);
+
+            // this is around up to 3-5 times faster than cstrncmp one
+            switch (x[0])
+            {
+            case 'b':
             {
-                victimer->m_isAlive = false;
-                victimer->m_navNode.Clear();
-                victimer->m_avgDeathOrigin += victimer->pev->origin;
-                victimer->m_avgDeathOrigin *= 0.5f;
+                if (x[1] == 'u' && charToInt(x) == 565)
+                    m_bot->m_inBuyZone = (m_record.statusIcon.enabled != 0);
+                break;
             }
+            case 'd':
+            {
+                if (x[1] == 'e' && charToInt(x) == 549)
+                    m_bot->m_hasDefuser = (m_record.statusIcon.enabled != 0);
+                break;
+            }
+            case 'v':
+            {
+                if (x[1] == 'i' && charToInt(x) == 764)
+                    m_bot->m_inVIPZone = (m_record.statusIcon.enabled != 0);
+                break;
+            }
+            case 'c':
+            {
+                if (x[1] == '4')
+                    m_bot->m_inBombZone = (m_record.statusIcon.enabled == 2);
+                break;
+            }
+            }
+
+            /*if (cstrncmp(x, "defuser", 8) == 0)
+                m_bot->m_hasDefuser = (m_record.statusIcon.enabled != 0);
+            else if (cstrncmp(x, "buyzone", 8) == 0)
+                m_bot->m_inBuyZone = (m_record.statusIcon.enabled != 0);
+            else if (cstrncmp(x, "vipsafety", 10) == 0)
+                m_bot->m_inVIPZone = (m_record.statusIcon.enabled != 0);
+            else if (cstrncmp(x, "c4", 3) == 0)
+                m_bot->m_inBombZone = (m_record.statusIcon.enabled == 2);*/
         }
         break;
+    }
+    }
+}
 
-        // causing to message not has been sent bug...
-        /*switch (m_state)
-        {
-        case 0:
+void NetworkMsg::HandleDeath(void* p)
+{
+    if (m_state == 1)
+    {
+        Bot* victimer = g_botManager->GetBot(PTR_TO_INT(p));
+        if (victimer)
         {
-            killerIndex = PTR_TO_INT(p);
-            break;
+            victimer->m_isAlive = false;
+            victimer->m_navNode.Clear();
+            victimer->m_avgDeathOrigin += victimer->pev->origin;
+            victimer->m_avgDeathOrigin *= 0.5f;
         }
-        case 1:
-        {
-            victimIndex = PTR_TO_INT(p);
+    }
+
+    // causing to message not has been sent bug...
+    /*switch (m_state)
+    {
+    case 0:
+    {
+        killerIndex = PTR_TO_INT(p);
+        break;
+    }
+    case 1:
+    {
+        victimIndex = PTR_TO_INT(p);
+        break;
+    }
+    case 2: // this one is heavy...
+    {
+        edict_t* victim = INDEXENT(victimIndex);
+        if (!IsValidPlayer(victim))
             break;
-        }
-        case 2: // this one is heavy...
-        {
-            edict_t* victim = INDEXENT(victimIndex);
-            if (!IsValidPlayer(victim))
-                break;
 
-            Bot* bot = g_botManager->GetBot(victimIndex);
-            if (bot)
-            {
-                bot->m_isAlive = false;
-                bot->m_navNode.Clear();
-                bot->m_avgDeathOrigin += bot->pev->origin;
-                bot->m_avgDeathOrigin *= 0.5f;
-            }
+        Bot* bot = g_botManager->GetBot(victimIndex);
+        if (bot)
+        {
+            bot->m_isAlive = false;
+            bot->m_navNode.Clear();
+            bot->m_avgDeathOrigin += bot->pev->origin;
+            bot->m_avgDeathOrigin *= 0.5f;
+        }
 
-            edict_t* killer = INDEXENT(killerIndex);
-            if (!IsValidPlayer(killer))
-                break;
+        edict_t* killer = INDEXENT(killerIndex);
+        if (!IsValidPlayer(killer))
+            break;
 
-            bot = g_botManager->GetBot(killerIndex);
-            int index, teamValue = GetTeam(killer);
-            float timeCache = engine->GetTime();
-            extern ConVar ebot_camp_max;
-            if ((bot && bot->GetCurrentState() == Process::Camp) || (!bot && killer->v.flags & FL_DUCKING))
+        bot = g_botManager->GetBot(killerIndex);
+        int index, teamValue = GetTeam(killer);
+        float timeCache = engine->GetTime();
+        extern ConVar ebot_camp_max;
+        if ((bot && bot->GetCurrentState() == Process::Camp) || (!bot && killer->v.flags & FL_DUCKING))
+        {
+            for (const auto& teammate : g_botManager->m_bots)
             {
-                for (const auto& teammate : g_botManager->m_bots)
-                {
-                    if (!teammate)
-                        continue;
+                if (!teammate)
+                    continue;
 
-                    if (teammate->m_team == teamValue)
-                        continue;
+                if (teammate->m_team == teamValue)
+                    continue;
 
-                    if (!teammate->m_isAlive)
-                        continue;
+                if (!teammate->m_isAlive)
+                    continue;
 
-                    if ((teammate->pev->origin - killer->v.origin).GetLengthSquared() > squaredf(1280.0f))
-                        continue;
+                if ((teammate->pev->origin - killer->v.origin).GetLengthSquared() > squaredf(1280.0f))
+                    continue;
 
-                    if (teammate->m_isBomber || teammate->m_isVIP)
-                    {
-                        if (teammate->CheckGrenadeThrow(killer))
-                            teammate->RadioMessage(Radio::Fallback);
-                        else
-                        {
-                            index = teammate->m_navNode.Last();
-                            teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
-                        }
-                    }
+                if (teammate->m_isBomber || teammate->m_isVIP)
+                {
+                    if (teammate->CheckGrenadeThrow(killer))
+                        teammate->RadioMessage(Radio::Fallback);
                     else
                     {
-                        teammate->m_pauseTime = timeCache + crandomfloat(2.0f, 5.0f);
-                        teammate->m_lookAt = killer->v.origin + killer->v.view_ofs;
+                        index = teammate->m_navNode.Last();
+                        teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
+                    }
+                }
+                else
+                {
+                    teammate->m_pauseTime = timeCache + crandomfloat(2.0f, 5.0f);
+                    teammate->m_lookAt = killer->v.origin + killer->v.view_ofs;
 
-                        if (teammate->CheckGrenadeThrow(killer))
-                            teammate->RadioMessage(Radio::Fallback);
-                        else if ((bot && bot->m_friendsNearCount > teammate->m_friendsNearCount) && (!bot && teammate->pev->health < killer->v.health))
+                    if (teammate->CheckGrenadeThrow(killer))
+                        teammate->RadioMessage(Radio::Fallback);
+                    else if ((bot && bot->m_friendsNearCount > teammate->m_friendsNearCount) && (!bot && teammate->pev->health < killer->v.health))
+                    {
+                        index = teammate->FindDefendWaypoint(teammate->EyePosition());
+                        if (IsValidWaypoint(index))
                         {
-                            index = teammate->FindDefendWaypoint(teammate->EyePosition());
-                            if (IsValidWaypoint(index))
-                            {
-                                teammate->m_campIndex = index;
-                                teammate->SetProcess(Process::Camp, "there's too many... i must camp", true, timeCache + ebot_camp_max.GetFloat());
-                            }
-                            else // hell no...
-                            {
-                                index = teammate->m_navNode.Last();
-                                teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
-                                teammate->RadioMessage(Radio::RegroupTeam);
-                            }
+                            teammate->m_campIndex = index;
+                            teammate->SetProcess(Process::Camp, "there's too many... i must camp", true, timeCache + ebot_camp_max.GetFloat());
                         }
-                        else
+                        else // hell no...
                         {
                             index = teammate->m_navNode.Last();
                             teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
+                            teammate->RadioMessage(Radio::RegroupTeam);
                         }
                     }
+                    else
+                    {
+                        index = teammate->m_navNode.Last();
+                        teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
+                    }
                 }
             }
-            else // not camping (act different, but idk what can i do else ???)
+        }
+        else // not camping (act different, but idk what can i do else ???)
+        {
+            for (const auto& teammate : g_botManager->m_bots)
             {
-                for (const auto& teammate : g_botManager->m_bots)
-                {
-                    if (!teammate)
-                        continue;
+                if (!teammate)
+                    continue;
 
-                    if (teammate->m_team == teamValue)
-                        continue;
+                if (teammate->m_team == teamValue)
+                    continue;
 
-                    if (!teammate->m_isAlive)
-                        continue;
+                if (!teammate->m_isAlive)
+                    continue;
 
-                    if ((teammate->pev->origin - killer->v.origin).GetLengthSquared() > squaredf(1280.0f))
-                        continue;
+                if ((teammate->pev->origin - killer->v.origin).GetLengthSquared() > squaredf(1280.0f))
+                    continue;
 
-                    if (teammate->m_isBomber || teammate->m_isVIP)
-                    {
-                        index = teammate->m_navNode.Last();
-                        teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
-                    }
-                    else
-                    {
-                        teammate->m_pauseTime = timeCache + crandomfloat(2.0f, 5.0f);
-                        teammate->m_lookAt = killer->v.origin + killer->v.view_ofs;
+                if (teammate->m_isBomber || teammate->m_isVIP)
+                {
+                    index = teammate->m_navNode.Last();
+                    teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
+                }
+                else
+                {
+                    teammate->m_pauseTime = timeCache + crandomfloat(2.0f, 5.0f);
+                    teammate->m_lookAt = killer->v.origin + killer->v.view_ofs;
 
-                        if ((bot && bot->m_friendsNearCount > teammate->m_friendsNearCount) && (!bot && teammate->pev->health < killer->v.health))
+                    if ((bot && bot->m_friendsNearCount > teammate->m_friendsNearCount) && (!bot && teammate->pev->health < killer->v.health))
+                    {
+                        index = teammate->FindDefendWaypoint(teammate->EyePosition());
+                        if (IsValidWaypoint(index))
                         {
-                            index = teammate->FindDefendWaypoint(teammate->EyePosition());
-                            if (IsValidWaypoint(index))
-                            {
-                                teammate->m_campIndex = index;
-                                teammate->SetProcess(Process::Camp, "there's too many... i must camp", true, timeCache + ebot_camp_max.GetFloat());
-                            }
-                            else // hell no...
-                            {
-                                index = teammate->m_navNode.Last();
-                                teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
-                                teammate->RadioMessage(Radio::RegroupTeam);
-                            }
+                            teammate->m_campIndex = index;
+                            teammate->SetProcess(Process::Camp, "there's too many... i must camp", true, timeCache + ebot_camp_max.GetFloat());
                         }
-                        else
+                        else // hell no...
                         {
                             index = teammate->m_navNode.Last();
                             teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
+                            teammate->RadioMessage(Radio::RegroupTeam);
                         }
                     }
+                    else
+                    {
+                        index = teammate->m_navNode.Last();
+                        teammate->FindPath(teammate->m_currentWaypointIndex, index, killer);
+                    }
                 }
             }
-            break;
-        }
         }
-        break;*/
+        break;
+    }
     }
-    case NETMSG_SCREENFADE: // this message gets sent when the screen fades (flashbang)
+    break;*/
+}
+
+void NetworkMsg::HandleScreenFade(void* p)
+{
+    switch (m_state)
     {
-        switch (m_state)
-        {
-        case 3:
-        {
-            r = PTR_TO_BYTE(p);
-            break;
-        }
-        case 4:
-        {
-            g = PTR_TO_BYTE(p);
-            break;
-        }
-        case 5:
-        {
-            b = PTR_TO_BYTE(p);
-            break;
-        }
-        case 6:
-        {
-            if (m_bot)
-                m_bot->TakeBlinded(Vector(r, g, b), PTR_TO_BYTE(p));
-            break;
-        }
-        }
+    case 3:
+    {
+        m_record.screenFade.r = PTR_TO_BYTE(p);
         break;
     }
-    case NETMSG_HLTV: // round restart in steam cs
+    case 4:
     {
-        switch (m_state)
-        {
-        case 0:
-        {
-            numPlayers = PTR_TO_INT(p);
-            break;
-        }
-        case 1:
-        {
-            if (!numPlayers && !PTR_TO_INT(p))
-                RoundInit();
-            break;
-        }
-        }
+        m_record.screenFade.g = PTR_TO_BYTE(p);
         break;
     }
-    case NETMSG_TEXTMSG:
+    case 5:
     {
-        if (m_state)
-        {
-            const char* x = PTR_TO_STR(p);
-            if (cstrncmp(x, "#CTs_Win", 9) == 0 ||
-                cstrncmp(x, "#Bomb_Defused", 14) == 0 ||
-                cstrncmp(x, "#Terrorists_Win", 16) == 0 ||
-                cstrncmp(x, "#Round_Draw", 12) == 0 ||
-                cstrncmp(x, "#All_Hostages_Rescued", 22) == 0 ||
-                cstrncmp(x, "#Target_Saved", 14) == 0 ||
-                cstrncmp(x, "#Hostages_Not_Rescued", 22) == 0 ||
-                cstrncmp(x, "#Terrorists_Not_Escaped", 24) == 0 ||
-                cstrncmp(x, "#VIP_Not_Escaped", 17) == 0 ||
-                cstrncmp(x, "#Escaping_Terrorists_Neutralized", 33) == 0 ||
-                cstrncmp(x, "#VIP_Assassinated", 18) == 0 ||
-                cstrncmp(x, "#VIP_Escaped", 13) == 0 ||
-                cstrncmp(x, "#Terrorists_Escaped", 20) == 0 ||
-                cstrncmp(x, "#CTs_PreventEscape", 19) == 0 ||
-                cstrncmp(x, "#Target_Bombed", 15) == 0 ||
-                cstrncmp(x, "#Game_Commencing", 17) == 0 ||
-                cstrncmp(x, "#Game_will_restart_in", 22) == 0)
-            {
-                g_roundEnded = true;
+        m_record.screenFade.b = PTR_TO_BYTE(p);
+        break;
+    }
+    case 6:
+    {
+        if (m_bot)
+            m_bot->TakeBlinded(Vector(m_record.screenFade.r, m_record.screenFade.g, m_record.screenFade.b), PTR_TO_BYTE(p));
+        break;
+    }
+    }
+}
 
-                if (GetGameMode() == GameMode::Original)
-                {
-                    if (cstrncmp(x, "#CTs_Win", 9) == 0)
-                        g_botManager->SetLastWinner(Team::Counter); // update last winner for economics
-                    else if (cstrncmp(x, "#Terrorists_Win", 16) == 0)
-                        g_botManager->SetLastWinner(Team::Terrorist); // update last winner for economics
-                }
+void NetworkMsg::HandleHLTV(void* p)
+{
+    switch (m_state)
+    {
+    case 0:
+    {
+        m_record.hltv.numPlayers = PTR_TO_INT(p);
+        break;
+    }
+    case 1:
+    {
+        if (!m_record.hltv.numPlayers && !PTR_TO_INT(p))
+            RoundInit();
+        break;
+    }
+    }
+}
 
-                g_waypoint->SetBombPosition(true);
-            }
-            else if (!g_bombPlanted && cstrncmp(x, "#Bomb_Planted", 14) == 0)
-            {
-                g_bombPlanted = true;
-                g_bombSayString = true;
-                g_timeBombPlanted = engine->GetTime();
-                g_waypoint->SetBombPosition();
+void NetworkMsg::HandleTextMsg(void* p)
+{
+    if (m_state)
+    {
+        const char* x = PTR_TO_STR(p);
+        if (cstrncmp(x, "#CTs_Win", 9) == 0 ||
+            cstrncmp(x, "#Bomb_Defused", 14) == 0 ||
+            cstrncmp(x, "#Terrorists_Win", 16) == 0 ||
+            cstrncmp(x, "#Round_Draw", 12) == 0 ||
+            cstrncmp(x, "#All_Hostages_Rescued", 22) == 0 ||
+            cstrncmp(x, "#Target_Saved", 14) == 0 ||
+            cstrncmp(x, "#Hostages_Not_Rescued", 22) == 0 ||
+            cstrncmp(x, "#Terrorists_Not_Escaped", 24) == 0 ||
+            cstrncmp(x, "#VIP_Not_Escaped", 17) == 0 ||
+            cstrncmp(x, "#Escaping_Terrorists_Neutralized", 33) == 0 ||
+            cstrncmp(x, "#VIP_Assassinated", 18) == 0 ||
+            cstrncmp(x, "#VIP_Escaped", 13) == 0 ||
+            cstrncmp(x, "#Terrorists_Escaped", 20) == 0 ||
+            cstrncmp(x, "#CTs_PreventEscape", 19) == 0 ||
+            cstrncmp(x, "#Target_Bombed", 15) == 0 ||
+            cstrncmp(x, "#Game_Commencing", 17) == 0 ||
+            cstrncmp(x, "#Game_will_restart_in", 22) == 0)
+        {
+            g_roundEnded = true;
 
-                for (const auto& bot : g_botManager->m_bots)
-                {
-                    if (!bot)
-                        continue;
+            if (GetGameMode() == GameMode::Original)
+            {
+                if (cstrncmp(x, "#CTs_Win", 9) == 0)
+                    g_botManager->SetLastWinner(Team::Counter); // update last winner for economics
+                else if (cstrncmp(x, "#Terrorists_Win", 16) == 0)
+                    g_botManager->SetLastWinner(Team::Terrorist); // update last winner for economics
+            }
 
-                    if (!bot->m_isAlive)
-                        continue;
+            g_waypoint->SetBombPosition(true);
+        }
+        else if (!g_bombPlanted && cstrncmp(x, "#Bomb_Planted", 14) == 0)
+        {
+            g_bombPlanted = true;
+            g_bombSayString = true;
+            g_timeBombPlanted = engine->GetTime();
+            g_waypoint->SetBombPosition();
 
-                    bot->m_navNode.Clear();
-                }
-            }
-            else if (m_bot)
+            for (const auto& bot : g_botManager->m_bots)
             {
-                if (cstrncmp(x, "#Switch_To_BurstFire", 21) == 0)
-                    m_bot->m_weaponBurstMode = BurstMode::Enabled;
-                else if (cstrncmp(x, "#Switch_To_SemiAuto", 20) == 0)
-                    m_bot->m_weaponBurstMode = BurstMode::Disabled;
+                if (!bot)
+                    continue;
+
+                if (!bot->m_isAlive)
+                    continue;
+
+                bot->m_navNode.Clear();
             }
         }
-        break;
+        else if (m_bot)
+        {
+            if (cstrncmp(x, "#Switch_To_BurstFire", 21) == 0)
+                m_bot->m_weaponBurstMode = BurstMode::Enabled;
+            else if (cstrncmp(x, "#Switch_To_SemiAuto", 20) == 0)
+                m_bot->m_weaponBurstMode = BurstMode::Disabled;
+        }
     }
-    case NETMSG_BARTIME:
+}
+
+void NetworkMsg::HandleBarTime(void* p)
+{
+    if (!m_state && m_bot)
     {
-        if (!m_state && m_bot)
+        if (GetGameMode() == GameMode::Original)
         {
-            if (GetGameMode() == GameMode::Original)
-            {
-                if (PTR_TO_INT(p))
-                    m_bot->m_hasProgressBar = true; // the progress bar on a hud
-                else
-                    m_bot->m_hasProgressBar = false; // no progress bar or disappeared
-            }
+            if (PTR_TO_INT(p))
+                m_bot->m_hasProgressBar = true; // the progress bar on a hud
             else
-                m_bot->m_hasProgressBar = false;
+                m_bot->m_hasProgressBar = false; // no progress bar or disappeared
         }
-        break;
-    }
+        else
+            m_bot->m_hasProgressBar = false;
     }
-    m_state++; // and finally update network message state
 }
@@ -0,0 +1,411 @@
+﻿//
+// Hot path profiler for E-Bot
+//
+
+#include <core.h>
+
+ConVar ebot_prof_stream("ebot_prof_stream", "");
+
+static const char* s_scopeNames[Profile_Count] =
+{
+	"BotControl::Think",
+	"AimBatch::Run",
+	"Bot::BaseUpdate",
+	"Process DEFAULT",
+	"Process ATTACK",
+	"Process HIDE",
+	"Process CAMP",
+	"Process ESCAPE",
+	"Process PLANT",
+	"Process DEFUSE",
+	"Process PAUSE",
+	"Process DESTROY BREAKABLE",
+	"Process PICKUP",
+	"Process THROW HE",
+	"Process THROW FB",
+	"Process THROW SM",
+	"Process BLINDED",
+	"Process JUMPING",
+	"Bot::ContinuePath",
+	"Bot::SearchShortestPath",
+	"Bot::SearchEscapePath",
+	"FlowFieldCache::Build",
+	"Bot::RepairPath",
+	"Bot::FindFriendsAndEnemiens",
+	"Bot::CheckVisibility",
+	"Bot::FindItem",
+	"Waypoint::FindNearest",
+	"Waypoint::Analyze",
+	"ENavMesh::Analyze"
+};
+
+static const char* s_engineNames[Engine_Count] =
+{
+	"TraceLine",
+	"TraceHull",
+	"FindEntityByClassname",
+	"FindEntityInSphere",
+	"PointContents"
+};
+
+static_assert(Profile_ProcessLast - Profile_Process == static_cast<int>(Process::Jump), "profile scopes don't match the Process enum");
+
+// two buckets per power of two, the second half starts at 1.5 times the power
+static inline int GetBucket(uint64_t duration)
+{
+	if (duration < 2)
+		return 0;
+
+	int log = 0;
+	while (duration >> (log + 1))
+		log++;
+
+	const int bucket = log * 2 + static_cast<int>((duration >> (log - 1)) & 1);
+	return cmin(bucket, Const_ProfileBuckets - 1);
+}
+
+// upper edge of a bucket in microseconds, percentiles never look better than they are
+static inline double GetBucketLimit(const int bucket)
+{
+	const int log = bucket / 2;
+	const double base = static_cast<double>(1ull << log);
+	return ((bucket & 1) ? base * 2.0 : base * 1.5) * 0.001;
+}
+
+static double GetPercentile(const ProfileHistogram& histogram, const double percent)
+{
+	if (!histogram.calls)
+		return 0.0;
+
+	const uint64_t rank = static_cast<uint64_t>(static_cast<double>(histogram.calls) * percent);
+	uint64_t count = 0;
+	int i;
+	for (i = 0; i < Const_ProfileBuckets; i++)
+	{
+		count += histogram.buckets[i];
+		if (count > rank)
+			return cmin(GetBucketLimit(i), static_cast<double>(histogram.max) * 0.001);
+	}
+
+	return static_cast<double>(histogram.max) * 0.001;
+}
+
+static void MergeHistogram(ProfileHistogram& to, const ProfileHistogram& from)
+{
+	int i;
+	for (i = 0; i < Const_ProfileBuckets; i++)
+		to.buckets[i] += from.buckets[i];
+
+	to.calls += from.calls;
+	to.total += from.total;
+	if (from.max > to.max)
+		to.max = from.max;
+}
+
+static const char* GetSiteName(const int site)
+{
+	return site < Profile_Count ? s_scopeNames[site] : "other";
+}
+
+void Profiler::Record(const int scope, const uint64_t duration)
+{
+	if (scope < 0 || scope >= Profile_Count)
+		return;
+
+	ProfileHistogram& histogram = m_current[scope];
+	histogram.buckets[GetBucket(duration)]++;
+	histogram.calls++;
+	histogram.total += duration;
+	if (duration > histogram.max)
+		histogram.max = duration;
+}
+
+void Profiler::RecordEngine(const int call, const uint64_t duration, const float fraction, const bool startSolid, const int hull)
+{
+	EngineCallStats& stats = m_engine.sites[m_scope][call];
+	stats.calls++;
+	stats.total += duration;
+	if (fraction >= 0.0f)
+		stats.fractions[startSolid ? 0 : (fraction < 0.5f ? 1 : (fraction < 1.0f ? 2 : 3))]++;
+
+	if (hull >= 0 && hull < 4)
+		stats.hulls[hull]++;
+
+	if (m_bot >= 0 && m_bot < 32)
+		m_engine.bots[m_bot][call]++;
+
+	m_frameCalls++;
+}
+
+edict_t* ProfileFindEntityByClassname(edict_t* start, const char* name)
+{
+	const uint64_t begin = Profiler::Now();
+	edict_t* ent = FIND_ENTITY_BY_STRING(start, "classname", name);
+	g_profiler.RecordEngine(Engine_FindEntityByClassname, Profiler::Now() - begin);
+	return ent;
+}
+
+edict_t* ProfileFindEntityInSphere(edict_t* start, const float* origin, const float radius)
+{
+	const uint64_t begin = Profiler::Now();
+	edict_t* ent = (*g_engfuncs.pfnFindEntityInSphere) (start, origin, radius);
+	g_profiler.RecordEngine(Engine_FindEntityInSphere, Profiler::Now() - begin);
+	return ent;
+}
+
+int ProfilePointContents(const float* origin)
+{
+	const uint64_t begin = Profiler::Now();
+	const int contents = (*g_engfuncs.pfnPointContents) (origin);
+	g_profiler.RecordEngine(Engine_PointContents, Profiler::Now() - begin);
+	return contents;
+}
+
+void Profiler::Update(void)
+{
+	m_engine.frames++;
+	if (m_frameCalls > m_engine.frameMax)
+		m_engine.frameMax = m_frameCalls;
+
+	m_frameCalls = 0;
+
+	const double time = GetRealTime();
+	if (m_secondEnd > time)
+		return;
+
+	// a long stall still counts as one second, the histograms are per recorded second not per wall second
+	if (m_secondEnd > 0.0)
+	{
+		int i;
+		for (i = 0; i < Profile_Count; i++)
+		{
+			MergeHistogram(m_total[i], m_current[i]);
+			m_seconds[m_head][i] = m_current[i];
+			m_current[i] = ProfileHistogram{};
+		}
+
+		m_head = (m_head + 1) % Const_ProfileSeconds;
+		if (m_filled < Const_ProfileSeconds)
+			m_filled++;
+
+		m_engineLast = m_engine;
+		m_engine = EngineSecond{};
+		WriteStream();
+	}
+
+	m_secondEnd = time + 1.0;
+}
+
+void Profiler::Reset(void)
+{
+	int i, j;
+	for (i = 0; i < Profile_Count; i++)
+	{
+		m_current[i] = ProfileHistogram{};
+		m_total[i] = ProfileHistogram{};
+		for (j = 0; j < Const_ProfileSeconds; j++)
+			m_seconds[j][i] = ProfileHistogram{};
+	}
+
+	m_head = 0;
+	m_filled = 0;
+	m_secondEnd = 0.0;
+	m_engine = EngineSecond{};
+	m_engineLast = EngineSecond{};
+	m_frameCalls = 0;
+}
+
+void Profiler::Show(void)
+{
+#ifdef EBOT_NO_PROFILER
+	ServerPrintNoTag("Profiler is not built in, rebuild without EBOT_NO_PROFILER");
+#else
+	if (!m_filled)
+	{
+		ServerPrintNoTag("Profiler has no finished second yet");
+		return;
+	}
+
+	// the recent seconds merged, so one slow frame isn't lost in the average
+	ProfileHistogram recent[Profile_Count]{};
+	int i, j;
+	for (j = 0; j < m_filled; j++)
+	{
+		for (i = 0; i < Profile_Count; i++)
+			MergeHistogram(recent[i], m_seconds[j][i]);
+	}
+
+	ServerPrintNoTag("Last %d seconds, times in microseconds:", m_filled);
+	ServerPrintNoTag("%-28s %10s %10s %10s %10s %10s", "scope", "calls/s", "p50", "p99", "max", "ms/s");
+	for (i = 0; i < Profile_Count; i++)
+	{
+		const ProfileHistogram& histogram = recent[i];
+		if (!histogram.calls)
+			continue;
+
+		ServerPrintNoTag("%-28s %10.1f %10.2f %10.2f %10.2f %10.3f", s_scopeNames[i], static_cast<double>(histogram.calls) / m_filled,
+			GetPercentile(histogram, 0.5), GetPercentile(histogram, 0.99), static_cast<double>(histogram.max) * 0.001,
+			static_cast<double>(histogram.total) * 0.000001 / m_filled);
+	}
+#endif
+}
+
+bool Profiler::Dump(const char* fileName)
+{
+	if (!IsPlainFileName(fileName))
+		return false;
+
+	char path[512];
+	FormatBuffer(path, "%s/addons/ebot/%s", GetModName(), fileName);
+
+	FILE* fp = fopen(path, "wt");
+	if (!fp)
+		return false;
+
+	// one row per scope and second, oldest first, then the totals since the reset
+	fprintf(fp, "second,scope,calls,p50_us,p99_us,max_us,total_ms\n");
+
+	auto write = [&](const int second, const int scope, const ProfileHistogram& histogram)
+	{
+		if (!histogram.calls)
+			return;
+
+		fprintf(fp, "%d,%s,%u,%.2f,%.2f,%.2f,%.3f\n", second, s_scopeNames[scope], histogram.calls, GetPercentile(histogram, 0.5),
+			GetPercentile(histogram, 0.99), static_cast<double>(histogram.max) * 0.001, static_cast<double>(histogram.total) * 0.000001);
+	};
+
+	int i, j, slot;
+	for (j = 0; j < m_filled; j++)
+	{
+		slot = (m_head - m_filled + j + Const_ProfileSeconds) % Const_ProfileSeconds;
+		for (i = 0; i < Profile_Count; i++)
+			write(j - m_filled, i, m_seconds[slot][i]);
+	}
+
+	for (i = 0; i < Profile_Count; i++)
+		write(0, i, m_total[i]);
+
+	g_memoryStats.Dump(fp);
+	fclose(fp);
+	return true;
+}
+
+void Profiler::ShowEngine(void)
+{
+#ifdef EBOT_NO_PROFILER
+	ServerPrintNoTag("Profiler is not built in, rebuild without EBOT_NO_PROFILER");
+#else
+	const EngineSecond& second = m_engineLast;
+	if (!second.frames)
+	{
+		ServerPrintNoTag("Profiler has no finished second yet");
+		return;
+	}
+
+	uint32_t total = 0;
+	int i, j;
+	for (i = 0; i <= Profile_Count; i++)
+	{
+		for (j = 0; j < Engine_Count; j++)
+			total += second.sites[i][j].calls;
+	}
+
+	ServerPrintNoTag("Last second: %u engine calls over %u frames, %.1f per frame, at most %u", total, second.frames, static_cast<double>(total) / second.frames, second.frameMax);
+	ServerPrintNoTag("%-28s %-22s %8s %9s %7s %7s %7s %7s", "site", "call", "calls", "avg us", "solid", "<0.5", "<1", "clear");
+	for (i = 0; i <= Profile_Count; i++)
+	{
+		for (j = 0; j < Engine_Count; j++)
+		{
+			const EngineCallStats& stats = second.sites[i][j];
+			if (!stats.calls)
+				continue;
+
+			ServerPrintNoTag("%-28s %-22s %8u %9.2f %7u %7u %7u %7u", GetSiteName(i), s_engineNames[j], stats.calls, static_cast<double>(stats.total) * 0.001 / stats.calls,
+				stats.fractions[0], stats.fractions[1], stats.fractions[2], stats.fractions[3]);
+
+			if (j == Engine_TraceHull)
+				ServerPrintNoTag("%-28s %-22s point %u, human %u, large %u, head %u", "", "  hulls", stats.hulls[0], stats.hulls[1], stats.hulls[2], stats.hulls[3]);
+		}
+	}
+#endif
+}
+
+void Profiler::ShowBots(void)
+{
+#ifdef EBOT_NO_PROFILER
+	ServerPrintNoTag("Profiler is not built in, rebuild without EBOT_NO_PROFILER");
+#else
+	const EngineSecond& second = m_engineLast;
+	ServerPrintNoTag("Engine calls of each bot in the last second:");
+	ServerPrintNoTag("%-24s %10s %10s %10s %10s %10s", "bot", "line", "hull", "classname", "sphere", "contents");
+
+	int i;
+	Bot* bot;
+	for (i = 0; i < 32; i++)
+	{
+		const uint32_t* calls = second.bots[i];
+		if (!(calls[Engine_TraceLine] | calls[Engine_TraceHull] | calls[Engine_FindEntityByClassname] | calls[Engine_FindEntityInSphere] | calls[Engine_PointContents]))
+			continue;
+
+		bot = g_botManager->GetBot(i);
+		ServerPrintNoTag("%-24s %10u %10u %10u %10u %10u", bot ? GetEntityName(bot->GetEntity()) : "(left)", calls[Engine_TraceLine], calls[Engine_TraceHull],
+			calls[Engine_FindEntityByClassname], calls[Engine_FindEntityInSphere], calls[Engine_PointContents]);
+	}
+#endif
+}
+
+// appends the second that just closed to the ebot_prof_stream file
+void Profiler::WriteStream(void)
+{
+	const char* name = ebot_prof_stream.GetString();
+	if (cstrcmp(name, m_streamName))
+	{
+		CloseStream();
+		if (!IsPlainFileName(name))
+			return;
+
+		char path[512];
+		FormatBuffer(path, "%s/addons/ebot/%s", GetModName(), name);
+		m_stream = fopen(path, "at");
+		if (!m_stream)
+		{
+			AddLogEntry(Log::Warning, "unable to open profiler stream %s", path);
+			return;
+		}
+
+		cstrncpy(m_streamName, name, sizeof(m_streamName) - 1);
+		m_streamSecond = 0;
+		fprintf(m_stream, "second,site,call,calls,total_us,solid,half,blocked,clear,frames,frame_max\n");
+	}
+
+	if (!m_stream)
+		return;
+
+	int i, j;
+	for (i = 0; i <= Profile_Count; i++)
+	{
+		for (j = 0; j < Engine_Count; j++)
+		{
+			const EngineCallStats& stats = m_engineLast.sites[i][j];
+			if (!stats.calls)
+				continue;
+
+			fprintf(m_stream, "%d,%s,%s,%u,%.1f,%u,%u,%u,%u,%u,%u\n", m_streamSecond, GetSiteName(i), s_engineNames[j], stats.calls, static_cast<double>(stats.total) * 0.001,
+				stats.fractions[0], stats.fractions[1], stats.fractions[2], stats.fractions[3], m_engineLast.frames, m_engineLast.frameMax);
+		}
+	}
+
+	fflush(m_stream);
+	m_streamSecond++;
+}
+
+void Profiler::CloseStream(void)
+{
+	if (m_stream)
+	{
+		fclose(m_stream);
+		m_stream = nullptr;
+	}
+
+	m_streamName[0] = '\0';
+}
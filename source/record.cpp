@@ -0,0 +1,176 @@
+﻿//
+// Decision query recorder for E-Bot
+//
+
+#include <core.h>
+
+ConVar ebot_random_seed("ebot_random_seed", "0");
+
+bool Recorder::Start(const char* fileName)
+{
+	if (!IsPlainFileName(fileName))
+		return false;
+
+	Stop();
+
+	char path[512];
+	FormatBuffer(path, "%s/addons/ebot/%s", GetModName(), fileName);
+
+	m_fp = fopen(path, "wb");
+	if (!m_fp)
+		return false;
+
+	RecordHeader header{};
+	header.magic = Const_RecordMagic;
+	header.version = Const_RecordVersion;
+	header.seed = GetSeed();
+	header.numWaypoints = g_numWaypoints;
+	cstrncpy(header.mapName, GetMapName(), sizeof(header.mapName) - 1);
+
+	if (fwrite(&header, sizeof(header), 1, m_fp) != 1)
+	{
+		fclose(m_fp);
+		m_fp = nullptr;
+		return false;
+	}
+
+	m_seed = header.seed;
+	m_used = 0;
+	m_events = 0;
+	m_recording = true;
+	return true;
+}
+
+void Recorder::Stop(void)
+{
+	if (!m_fp)
+		return;
+
+	Flush();
+	fclose(m_fp);
+	m_fp = nullptr;
+	m_recording = false;
+}
+
+void Recorder::Flush(void)
+{
+	if (!m_used || !m_fp)
+		return;
+
+	// a full disk ends the recording, the file stays readable up to the last whole buffer
+	if (fwrite(m_buffer, static_cast<size_t>(m_used), 1, m_fp) != 1)
+		m_recording = false;
+
+	m_used = 0;
+}
+
+void Recorder::Write(const RecordType type, const int slot, const void* data, const int size)
+{
+	if (!m_recording)
+		return;
+
+	const int total = static_cast<int>(sizeof(RecordEvent)) + size;
+	if (m_used + total > Const_RecordBuffer)
+		Flush();
+
+	RecordEvent event;
+	event.type = type;
+	event.slot = (slot >= 0 && slot < 32) ? static_cast<uint8_t>(slot) : 255;
+	event.size = static_cast<uint16_t>(size);
+
+	cmemcpy(m_buffer + m_used, &event, sizeof(event));
+	cmemcpy(m_buffer + m_used + sizeof(event), data, size);
+	m_used += total;
+	m_events++;
+}
+
+// called once per bot update cycle, before the bots think
+void Recorder::Update(void)
+{
+	m_frame++;
+	if (!m_recording)
+		return;
+
+	RecordFrame record;
+	record.time = engine->GetTime();
+	record.frame = m_frame;
+	Write(Record_Frame, -1, &record, sizeof(record));
+}
+
+void Recorder::Show(void)
+{
+	if (m_recording)
+		ServerPrintNoTag("Recording, %u events, seed %u", m_events, m_seed);
+	else
+		ServerPrintNoTag("Not recording, seed %u", GetSeed());
+}
+
+uint32_t Recorder::GetSeed(void) const
+{
+	if (m_recording)
+		return m_seed;
+
+	return static_cast<uint32_t>(ebot_random_seed.GetInt());
+}
+
+// every bot gets its own sequence, it doesn't shift when another bot draws more numbers
+void Recorder::SeedBot(const int slot)
+{
+	const uint32_t seed = GetSeed();
+	if (!seed)
+		return;
+
+	csrand(seed ^ (static_cast<uint32_t>(slot + 1) * 0x9E3779B9u) ^ (m_frame * 0x85EBCA6Bu));
+}
+
+void Recorder::Path(const int slot, const RecordPath& path)
+{
+	Write(Record_Path, slot, &path, sizeof(path));
+}
+
+void Recorder::PathResult(const int slot, PathNode& path)
+{
+	RecordPathResult record;
+	record.length = path.Length();
+	record.last = record.length ? path.Last() : -1;
+	Write(Record_PathResult, slot, &record, sizeof(record));
+}
+
+void Recorder::Shortest(const int slot, const int srcIndex, const int destIndex)
+{
+	RecordShortest record;
+	record.srcIndex = static_cast<int16_t>(srcIndex);
+	record.destIndex = static_cast<int16_t>(destIndex);
+	Write(Record_Shortest, slot, &record, sizeof(record));
+}
+
+void Recorder::Escape(const int slot, const int srcIndex, const Vector& dangerOrigin)
+{
+	RecordEscape record{};
+	record.dangerOrigin = dangerOrigin;
+	record.srcIndex = static_cast<int16_t>(srcIndex);
+	Write(Record_Escape, slot, &record, sizeof(record));
+}
+
+void Recorder::WriteNearest(const Vector& origin, const float minDistance, const int flags, const int mode, edict_t* entity, const int result)
+{
+	RecordNearest record{};
+	record.origin = origin;
+	record.minDistance = minDistance;
+	record.flags = flags;
+	record.mode = static_cast<int16_t>(mode);
+	record.result = static_cast<int16_t>(result);
+	record.hasEntity = FNullEnt(entity) ? 0 : 1;
+	Write(Record_Nearest, FNullEnt(entity) ? -1 : ENTINDEX(entity) - 1, &record, sizeof(record));
+}
+
+void Recorder::Visibility(const int slot, const VisPoint point, const Vector& start, const Vector& end, const bool ignoreGlass, const bool visible)
+{
+	RecordVisibility record{};
+	record.start = start;
+	record.end = end;
+	record.point = static_cast<int8_t>(point);
+	record.ignoreGlass = ignoreGlass ? 1 : 0;
+	record.visible = visible ? 1 : 0;
+	Write(Record_Visibility, slot, &record, sizeof(record));
+}
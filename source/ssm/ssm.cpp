@@ -1,5 +1,50 @@
 #include <core.h>
 
+// how a process is run, one entry for each Process in the same order as the enum
+struct ProcessDescriptor
+{
+	const char* name;
+	void (Bot::*start)(void);
+	void (Bot::*update)(void);
+	void (Bot::*end)(void);
+	bool (Bot::*req)(void);
+	float interval; // minimum time between updates while the bot stands still, 0 is every think tick
+	bool interruptible; // keep sensing between the updates and update right away once an enemy shows up
+};
+
+static const ProcessDescriptor s_processes[] =
+{
+	{ "DEFAULT", &Bot::DefaultStart, &Bot::DefaultUpdate, &Bot::DefaultEnd, &Bot::DefaultReq, 0.0f, false },
+	{ "ATTACK", &Bot::AttackStart, &Bot::AttackUpdate, &Bot::AttackEnd, &Bot::AttackReq, 0.0f, false },
+	{ "HIDE FROM DANGER", nullptr, nullptr, nullptr, nullptr, 0.0f, false },
+	{ "CAMP", &Bot::CampStart, &Bot::CampUpdate, &Bot::CampEnd, &Bot::CampReq, 0.1f, true },
+	{ "ESCAPE FROM THE BOMB", &Bot::EscapeStart, &Bot::EscapeUpdate, &Bot::EscapeEnd, &Bot::EscapeReq, 0.0f, false },
+	{ "PLANT THE BOMB", &Bot::PlantStart, &Bot::PlantUpdate, &Bot::PlantEnd, &Bot::PlantReq, 0.0f, false },
+	{ "DEFUSE THE BOMB", &Bot::DefuseStart, &Bot::DefuseUpdate, &Bot::DefuseEnd, &Bot::DefuseReq, 0.0f, false },
+	{ "PAUSE", &Bot::PauseStart, &Bot::PauseUpdate, &Bot::PauseEnd, &Bot::PauseReq, 0.2f, true },
+	{ "DESTROY BREAKABLE", &Bot::DestroyBreakableStart, &Bot::DestroyBreakableUpdate, &Bot::DestroyBreakableEnd, &Bot::DestroyBreakableReq, 0.0f, false },
+	{ "PICKUP ITEM", &Bot::PickupStart, &Bot::PickupUpdate, &Bot::PickupEnd, &Bot::PickupReq, 0.0f, false },
+	{ "THROW HE GRENADE", &Bot::ThrowHEStart, &Bot::ThrowHEUpdate, &Bot::ThrowHEEnd, &Bot::ThrowHEReq, 0.0f, false },
+	{ "THROW FB GRENADE", &Bot::ThrowFBStart, &Bot::ThrowFBUpdate, &Bot::ThrowFBEnd, &Bot::ThrowFBReq, 0.0f, false },
+	{ "THROW SM GRENADE", &Bot::ThrowSMStart, &Bot::ThrowSMUpdate, &Bot::ThrowSMEnd, &Bot::ThrowSMReq, 0.0f, false },
+	{ "BLINDED", &Bot::BlindStart, &Bot::BlindUpdate, &Bot::BlindEnd, &Bot::BlindReq, 0.2f, false },
+	{ "JUMPING", &Bot::JumpStart, &Bot::JumpUpdate, &Bot::JumpEnd, &Bot::JumpReq, 0.0f, false }
+};
+
+static_assert(sizeof(s_processes) / sizeof(s_processes[0]) == static_cast<size_t>(Process::Jump) + 1, "process table doesn't match the Process enum");
+
+// movement buttons repeated on the ticks a process skips, toggles like zoom or reload must not repeat
+#define PROCESS_HELD_BUTTONS (IN_ATTACK | IN_DUCK)
+
+static inline const ProcessDescriptor* GetProcessDescriptor(const Process& process)
+{
+	const int index = static_cast<int>(process);
+	if (index < 0 || index >= static_cast<int>(sizeof(s_processes) / sizeof(s_processes[0])))
+		return nullptr;
+
+	return &s_processes[index];
+}
+
 Process Bot::GetCurrentState(void)
 {
 	return m_currentProcess;
@@ -36,237 +81,53 @@ bool Bot::SetProcess(const Process& process, const char* debugnote, const bool r
 
 void Bot::StartProcess(const Process& process)
 {
-	switch (process)
-	{
-	case Process::Default:
-	{
-		DefaultStart();
-		break;
-	}
-	case Process::Attack:
-	{
-		AttackStart();
-		break;
-	}
-	case Process::Defuse:
-	{
-		DefuseStart();
-		break;
-	}
-	case Process::Plant:
-	{
-		PlantStart();
-		break;
-	}
-	case Process::Escape:
-	{
-		EscapeStart();
-		break;
-	}
-	case Process::Pause:
-	{
-		PauseStart();
-		break;
-	}
-	case Process::DestroyBreakable:
-	{
-		DestroyBreakableStart();
-		break;
-	}
-	case Process::Pickup:
-	{
-		PickupStart();
-		break;
-	}
-	case Process::Camp:
-	{
-		CampStart();
-		break;
-	}
-	case Process::ThrowHE:
-	{
-		ThrowHEStart();
-		break;
-	}
-	case Process::ThrowFB:
-	{
-		ThrowFBStart();
-		break;
-	}
-	case Process::ThrowSM:
-	{
-		ThrowSMStart();
-		break;
-	}
-	case Process::Blind:
-	{
-		BlindStart();
-		break;
-	}
-	case Process::Jump:
-	{
-		JumpStart();
-		break;
-	}
-	}
+	// a new process always gets its first update right away
+	m_processUpdateTime = 0.0f;
+
+	const ProcessDescriptor* descriptor = GetProcessDescriptor(process);
+	if (descriptor && descriptor->start)
+		(this->*descriptor->start)();
 }
 
 void Bot::EndProcess(const Process& process)
 {
-	switch (process)
-	{
-	case Process::Default:
-	{
-		DefaultEnd();
-		break;
-	}
-	case Process::Attack:
-	{
-		AttackEnd();
-		break;
-	}
-	case Process::Defuse:
-	{
-		DefuseEnd();
-		break;
-	}
-	case Process::Plant:
-	{
-		PlantEnd();
-		break;
-	}
-	case Process::Escape:
-	{
-		EscapeEnd();
-		break;
-	}
-	case Process::Pause:
-	{
-		PauseEnd();
-		break;
-	}
-	case Process::DestroyBreakable:
-	{
-		DestroyBreakableEnd();
-		break;
-	}
-	case Process::Pickup:
-	{
-		PickupEnd();
-		break;
-	}
-	case Process::Camp:
-	{
-		CampEnd();
-		break;
-	}
-	case Process::ThrowHE:
-	{
-		ThrowHEEnd();
-		break;
-	}
-	case Process::ThrowFB:
-	{
-		ThrowFBEnd();
-		break;
-	}
-	case Process::ThrowSM:
-	{
-		ThrowSMEnd();
-		break;
-	}
-	case Process::Blind:
-	{
-		BlindEnd();
-		break;
-	}
-	case Process::Jump:
-	{
-		JumpEnd();
-		break;
-	}
-	}
+	const ProcessDescriptor* descriptor = GetProcessDescriptor(process);
+	if (descriptor && descriptor->end)
+		(this->*descriptor->end)();
 }
 
 void Bot::UpdateProcess(void)
 {
+	PROFILE_SCOPE(Profile_Process + static_cast<int>(m_currentProcess));
+
 	static float time;
 	time = engine->GetTime();
 
-	switch (m_currentProcess)
-	{
-	case Process::Default:
-	{
-		DefaultUpdate();
-		break;
-	}
-	case Process::Attack:
-	{
-		AttackUpdate();
-		break;
-	}
-	case Process::Defuse:
-	{
-		DefuseUpdate();
-		break;
-	}
-	case Process::Plant:
-	{
-		PlantUpdate();
-		break;
-	}
-	case Process::Escape:
-	{
-		EscapeUpdate();
-		break;
-	}
-	case Process::Pause:
-	{
-		PauseUpdate();
-		break;
-	}
-	case Process::DestroyBreakable:
-	{
-		DestroyBreakableUpdate();
-		break;
-	}
-	case Process::Pickup:
-	{
-		PickupUpdate();
-		break;
-	}
-	case Process::Camp:
-	{
-		CampUpdate();
-		break;
-	}
-	case Process::ThrowHE:
-	{
-		ThrowHEUpdate();
-		break;
-	}
-	case Process::ThrowFB:
-	{
-		ThrowFBUpdate();
-		break;
-	}
-	case Process::ThrowSM:
-	{
-		ThrowSMUpdate();
-		break;
-	}
-	case Process::Blind:
+	const ProcessDescriptor* descriptor = GetProcessDescriptor(m_currentProcess);
+	if (!descriptor || !descriptor->update)
+		SetProcess(Process::Default, "unknown process", true, time + 99999999.0f);
+	else if (descriptor->interval > 0.0f && m_processUpdateTime > time && m_navNode.IsEmpty() && !m_hasEnemiesNear)
 	{
-		BlindUpdate();
-		break;
+		// passive process between its updates, keep doing what the last update asked for
+		m_moveSpeed = m_processMoveSpeed;
+		m_strafeSpeed = m_processStrafeSpeed;
+		pev->buttons |= m_processButtons;
+
+		if (descriptor->interruptible)
+		{
+			FindFriendsAndEnemiens();
+			if (m_hasEnemiesNear)
+				m_processUpdateTime = 0.0f;
+		}
 	}
-	case Process::Jump:
+	else
 	{
-		JumpUpdate();
-		break;
-	}
-	default:
-		SetProcess(Process::Default, "unknown process", true, time + 99999999.0f);
+		(this->*descriptor->update)();
+
+		m_processUpdateTime = time + descriptor->interval;
+		m_processMoveSpeed = m_moveSpeed;
+		m_processStrafeSpeed = m_strafeSpeed;
+		m_processButtons = pev->buttons & PROCESS_HELD_BUTTONS;
 	}
 
 	if (m_currentProcess > Process::Default && m_currentProcessTime < time)
@@ -318,78 +179,18 @@ void Bot::FinishCurrentProcess(const char* debugNote)
 
 bool Bot::IsReadyForTheProcess(const Process& process)
 {
-	switch (process)
-	{
-	case Process::Default:
-		return DefaultReq();
-	case Process::Attack:
-		return AttackReq();
-	case Process::Defuse:
-		return DefuseReq();
-	case Process::Plant:
-		return PlantReq();
-	case Process::Escape:
-		return EscapeReq();
-	case Process::Pause:
-		return PauseReq();
-	case Process::DestroyBreakable:
-		return DestroyBreakableReq();
-	case Process::Pickup:
-		return PickupReq();
-	case Process::Camp:
-		return CampReq();
-	case Process::ThrowHE:
-		return ThrowHEReq();
-	case Process::ThrowFB:
-		return ThrowFBReq();
-	case Process::ThrowSM:
-		return ThrowSMReq();
-	case Process::Blind:
-		return BlindReq();
-	case Process::Jump:
-		return JumpReq();
-	}
+	const ProcessDescriptor* descriptor = GetProcessDescriptor(process);
+	if (descriptor && descriptor->req)
+		return (this->*descriptor->req)();
 
 	return true;
 }
 
 char* Bot::GetProcessName(const Process& process)
 {
-	switch (process)
-	{
-	case Process::Default:
-		return "DEFAULT";
-	case Process::Attack:
-		return "ATTACK";
-	case Process::Plant:
-		return "PLANT THE BOMB";
-	case Process::Defuse:
-		return "DEFUSE THE BOMB";
-	case Process::Escape:
-		return "ESCAPE FROM THE BOMB";
-	case Process::Hide:
-		return "HIDE FROM DANGER";
-	case Process::Pause:
-		return "PAUSE";
-	case Process::DestroyBreakable:
-		return "DESTROY BREAKABLE";
-	case Process::Pickup:
-		return "PICKUP ITEM";
-	case Process::Camp:
-		return "CAMP";
-	case Process::ThrowHE:
-		return "THROW HE GRENADE";
-	case Process::ThrowFB:
-		return "THROW FB GRENADE";
-	case Process::ThrowSM:
-		return "THROW SM GRENADE";
-	case Process::Blind:
-		return "BLINDED";
-	case Process::Jump:
-		return "JUMPING";
-	default:
-		return "UNKNOWN";
-	}
+	const ProcessDescriptor* descriptor = GetProcessDescriptor(process);
+	if (descriptor)
+		return const_cast<char*>(descriptor->name);
 
-	return "UNKNOWN";
-}
\ No newline at end of file
+	return const_cast<char*>("UNKNOWN");
+}
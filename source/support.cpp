@@ -23,6 +23,7 @@
 //
 
 #include <core.h>
+#include <chrono>
 
 //
 // TODO:
@@ -45,7 +46,13 @@ void TraceLine(const Vector& start, const Vector& end, const bool ignoreMonsters
 	// in ignoreEntity in order to ignore it as a possible obstacle.
 	// this is an overloaded prototype to add IGNORE_GLASS in the same way as IGNORE_MONSTERS work.
 
+#ifdef EBOT_NO_PROFILER
 	(*g_engfuncs.pfnTraceLine) (start, end, (ignoreMonsters ? 1 : 0) | (ignoreGlass ? 0x100 : 0), ignoreEntity, ptr);
+#else
+	const uint64_t begin = Profiler::Now();
+	(*g_engfuncs.pfnTraceLine) (start, end, (ignoreMonsters ? 1 : 0) | (ignoreGlass ? 0x100 : 0), ignoreEntity, ptr);
+	g_profiler.RecordEngine(Engine_TraceLine, Profiler::Now() - begin, ptr->flFraction, ptr->fStartSolid != 0);
+#endif
 }
 
 void TraceLine(const Vector& start, const Vector& end, const bool ignoreMonsters, edict_t* ignoreEntity, TraceResult* ptr)
@@ -58,7 +65,13 @@ void TraceLine(const Vector& start, const Vector& end, const bool ignoreMonsters
 	// whether the trace starts "inside" an entity's polygonal model, and if so, to specify that entity
 	// in ignoreEntity in order to ignore it as a possible obstacle.
 
+#ifdef EBOT_NO_PROFILER
+	(*g_engfuncs.pfnTraceLine) (start, end, ignoreMonsters ? 1 : 0, ignoreEntity, ptr);
+#else
+	const uint64_t begin = Profiler::Now();
 	(*g_engfuncs.pfnTraceLine) (start, end, ignoreMonsters ? 1 : 0, ignoreEntity, ptr);
+	g_profiler.RecordEngine(Engine_TraceLine, Profiler::Now() - begin, ptr->flFraction, ptr->fStartSolid != 0);
+#endif
 }
 
 void TraceHull(const Vector& start, const Vector& end, const bool ignoreMonsters, const int hullNumber, edict_t* ignoreEntity, TraceResult* ptr)
@@ -74,7 +87,13 @@ void TraceHull(const Vector& start, const Vector& end, const bool ignoreMonsters
 	// function allows to specify whether the trace starts "inside" an entity's polygonal model,
 	// and if so, to specify that entity in ignoreEntity in order to ignore it as an obstacle.
 
+#ifdef EBOT_NO_PROFILER
+	(*g_engfuncs.pfnTraceHull) (start, end, ignoreMonsters ? 1 : 0, hullNumber, ignoreEntity, ptr);
+#else
+	const uint64_t begin = Profiler::Now();
 	(*g_engfuncs.pfnTraceHull) (start, end, ignoreMonsters ? 1 : 0, hullNumber, ignoreEntity, ptr);
+	g_profiler.RecordEngine(Engine_TraceHull, Profiler::Now() - begin, ptr->flFraction, ptr->fStartSolid != 0, hullNumber);
+#endif
 }
 
 uint16_t FixedUnsigned16(const float value, const float scale)
@@ -87,6 +106,12 @@ int16_t FixedSigned16(const float value, const float scale)
 	return static_cast<int16_t>(cclamp(static_cast<int>(value * scale), -32768, 32767));
 }
 
+// monotonic wall clock in seconds, engine time doesn't move inside a frame
+double GetRealTime(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 bool IsAlive(const edict_t* ent)
 {
 	if (FNullEnt(ent))
@@ -546,6 +571,7 @@ void CreatePath(char* path)
 void RoundInit(void)
 {
 	g_roundEnded = false;
+	g_waypoint->ResetGroundChecks();
 
 	for (const auto& bot : g_botManager->m_bots)
 	{
@@ -1039,6 +1065,22 @@ bool IsDedicatedServer(void)
 	return (IS_DEDICATED_SERVER() > 0); // ask to engine for this
 }
 
+// false for anything that could leave addons/ebot, names given by commands and cvars go through this
+bool IsPlainFileName(const char* fileName)
+{
+	if (IsNullString(fileName))
+		return false;
+
+	const char* c;
+	for (c = fileName; *c; c++)
+	{
+		if (*c == '/' || *c == '\\' || *c == ':' || (c[0] == '.' && c[1] == '.'))
+			return false;
+	}
+
+	return true;
+}
+
 // this function tests if a file exists by attempting to open it
 bool TryFileOpen(char* fileName)
 {
@@ -1228,9 +1270,9 @@ char* GetEntityName(edict_t* entity)
 	if (FNullEnt(entity))
 		cstrcpy(entityName, "nullptr");
 	else if (IsValidPlayer(entity))
-		cstrncpy(entityName, STRING(entity->v.netname), sizeof(entityName));
+		cstrncpy(entityName, STRING(entity->v.netname), sizeof(entityName) - 1);
 	else
-		cstrncpy(entityName, STRING(entity->v.classname), sizeof(entityName));
+		cstrncpy(entityName, STRING(entity->v.classname), sizeof(entityName) - 1);
 
 	return &entityName[0];
 }
@@ -1239,7 +1281,7 @@ char* GetEntityName(edict_t* entity)
 const char* GetMapName(void)
 {
 	static char mapName[32]{};
-	cstrncpy(mapName, STRING(g_pGlobals->mapname), sizeof(mapName));
+	cstrncpy(mapName, STRING(g_pGlobals->mapname), sizeof(mapName) - 1);
 	return &mapName[0]; // and return a pointer to it
 }
 
@@ -1351,34 +1393,43 @@ void AddLogEntry(const Log logLevel, const char* format, ...)
 	{
 	case Log::Default:
 	{
-		cstrncpy(levelString, "Log: ", sizeof(levelString));
+		cstrncpy(levelString, "Log: ", sizeof(levelString) - 1);
 		break;
 	}
 	case Log::Warning:
 	{
-		cstrncpy(levelString, "Warning: ", sizeof(levelString));
+		cstrncpy(levelString, "Warning: ", sizeof(levelString) - 1);
 		break;
 	}
 	case Log::Error:
 	{
-		cstrncpy(levelString, "Error: ", sizeof(levelString));
+		cstrncpy(levelString, "Error: ", sizeof(levelString) - 1);
 		break;
 	}
 	case Log::Fatal:
 	{
-		cstrncpy(levelString, "Critical: ", sizeof(levelString));
+		cstrncpy(levelString, "Critical: ", sizeof(levelString) - 1);
 		break;
 	}
 	case Log::Memory:
 	{
-		cstrncpy(levelString, "Memory Error: ", sizeof(levelString));
-		ServerPrint("unexpected memory error");
+		cstrncpy(levelString, "Memory Error: ", sizeof(levelString) - 1);
 		break;
 	}
 	}
 
 	sprintf(logLine, "%s%s", levelString, buffer);
+	if (logLevel != Log::Fatal && !g_logWriter.Allow(logLine))
+		return;
+
+	if (logLevel == Log::Memory)
+		ServerPrint("unexpected memory error");
+
 	MOD_AddLogEntry(-1, logLine);
+
+	// nothing after a fatal error is guaranteed to run, get it on disk now
+	if (logLevel == Log::Fatal)
+		g_logWriter.Flush();
 }
 
 void MOD_AddLogEntry(const int mod, char* format)
@@ -1396,42 +1447,23 @@ void MOD_AddLogEntry(const int mod, char* format)
 	}
 
 	ServerPrintNoTag("[%s Log] %s", modName, format);
-	sprintf(buildVersionName, "%s_build_%u_%u_%u_%u.txt", modName, mod_bV16[0], mod_bV16[1], mod_bV16[2], mod_bV16[3]);
 
-	// if logs folder deleted, it will result a crash... so create it again before writing logs...
-	char buffer[1024];
-	FormatBuffer(buffer, "%s/addons/ebot/logs", GetModName());
-	CreatePath(buffer);
-
-	FormatBuffer(buffer, "%s/addons/ebot/logs/%s", GetModName(), buildVersionName);
-	File checkLogFP(buffer, "rb");
-
-	FormatBuffer(buffer, "%s/addons/ebot/logs/%s", GetModName(), buildVersionName);
-	File fp(buffer, "at");
-
-	if (!checkLogFP.IsValid())
+	// the writer thread owns the file, it only gets the name and header once
+	if (!g_logWriter.IsFileSet())
 	{
-		fp.Printf("---------- %s Log \n", modName);
-		fp.Printf("---------- %s Version: %u.%u  \n", modName, mod_bV16[0], mod_bV16[1]);
-		fp.Printf("---------- %s Build: %u.%u.%u.%u  \n", modName, mod_bV16[0], mod_bV16[1], mod_bV16[2], mod_bV16[3]);
-		fp.Printf("----------------------------- \n\n");
+		char buffer[1024], header[512];
+		sprintf(buildVersionName, "%s_build_%u_%u_%u_%u", modName, mod_bV16[0], mod_bV16[1], mod_bV16[2], mod_bV16[3]);
+		FormatBuffer(buffer, "%s/addons/ebot/logs/%s", GetModName(), buildVersionName);
+		sprintf(header, "---------- %s Log \n---------- %s Version: %u.%u  \n---------- %s Build: %u.%u.%u.%u  \n----------------------------- \n\n", modName, modName, mod_bV16[0], mod_bV16[1], modName, mod_bV16[0], mod_bV16[1], mod_bV16[2], mod_bV16[3]);
+		g_logWriter.SetFile(buffer, header);
 	}
 
-	checkLogFP.Close();
-	if (!fp.IsValid())
-		return;
-
-	time_t tickTime = time(&tickTime);
-	tm* time = localtime(&tickTime);
-
-	sprintf(logLine, "[%02d:%02d:%02d] %s", time->tm_hour, time->tm_min, time->tm_sec, format);
-	fp.Printf("%s\n", logLine);
-
 	if (mod != -1)
-		fp.Printf("E-BOT Build: %d \n", PRODUCT_VERSION);
+		snprintf(logLine, sizeof(logLine), "%s\nE-BOT Build: %s \n----------------------------- ", format, PRODUCT_VERSION);
+	else
+		snprintf(logLine, sizeof(logLine), "%s\n----------------------------- ", format);
 
-	fp.Printf("----------------------------- \n");
-	fp.Close();
+	g_logWriter.Write(logLine);
 }
 
 // this function finds nearest to to, player with set of parameters, like his
@@ -23,6 +23,8 @@
 //
 
 #include <core.h>
+#include <atomic>
+#include <thread>
 
 #ifdef PLATFORM_LINUX
 #include <cstdlib>
@@ -35,20 +37,64 @@ ConVar ebot_analyze_max_jump_height("ebot_analyze_max_jump_height", "62");
 ConVar ebot_analyze_goal_check_distance("ebot_analyze_goal_check_distance", "200");
 ConVar ebot_analyze_create_camp_waypoints("ebot_analyze_create_camp_waypoints", "1");
 ConVar ebot_analyzer_min_fps("ebot_analyzer_min_fps", "30.0");
+ConVar ebot_analyze_frame_ms("ebot_analyze_frame_ms", "2.0");
+ConVar ebot_analyze_checkpoint_time("ebot_analyze_checkpoint_time", "30.0");
 ConVar ebot_analyze_auto_start("ebot_analyze_auto_start", "1");
 ConVar ebot_download_waypoints("ebot_download_waypoints", "0");
 ConVar ebot_download_waypoints_from("ebot_download_waypoints_from", "");
+ConVar ebot_download_timeout("ebot_download_timeout", "30");
+ConVar ebot_download_cache("ebot_download_cache", "");
 ConVar ebot_waypoint_size("ebot_waypoint_size", "7");
 ConVar ebot_waypoint_r("ebot_waypoint_r", "0");
 ConVar ebot_waypoint_g("ebot_waypoint_g", "255");
 ConVar ebot_waypoint_b("ebot_waypoint_b", "0");
+ConVar ebot_path_matrix_max_waypoints("ebot_path_matrix_max_waypoints", "4096");
+ConVar ebot_path_matrix_build_ms("ebot_path_matrix_build_ms", "2");
+ConVar ebot_visibility_max_waypoints("ebot_visibility_max_waypoints", "4096");
+ConVar ebot_visibility_build_ms("ebot_visibility_build_ms", "0.5");
+ConVar ebot_cluster_size("ebot_cluster_size", "1024");
+ConVar ebot_hpa_min_waypoints("ebot_hpa_min_waypoints", "1024");
+ConVar ebot_hpa_refine_clusters("ebot_hpa_refine_clusters", "2");
+ConVar ebot_ground_cache_time("ebot_ground_cache_time", "10.0");
+ConVar ebot_waypoint_compress("ebot_waypoint_compress", "0");
+
+// analyzer pipeline, planning turns one expanded waypoint into candidate spots and execution
+// traces them on the main thread within a frame budget, waypoints are only ever appended so
+// everything before nextIndex is done and that index is all a checkpoint has to remember
+struct AnalyzeState
+{
+    int16_t nextIndex{};
+    Vector candidates[8]{};
+    int8_t candidateCount{};
+    int8_t candidatePos{};
+    float range{};
+    int16_t startIndex{};
+    double startTime{};
+    float checkpointTime{};
+    float hudTime{};
+    bool running{};
+};
+
+static AnalyzeState s_analyze;
 
 // this function initialize the waypoint structures..
 void Waypoint::Initialize(void)
 {
+    MEMORY_TAG(Mem_Waypoints);
+
+    DestroyPathMatrix();
+    DestroyVisibility();
+    DestroyClusters();
     m_paths.Destroy();
     g_numWaypoints = 0;
     m_lastWaypoint = nullvec;
+    m_hotDirty = true;
+    ResetGroundChecks();
+    BuildGrid();
+
+    // analyzer progress belongs to the previous map, its checkpoint stays on disk
+    s_analyze = AnalyzeState{};
+    g_analyzewaypoints = false;
 }
 
 void SetFlags(const char* className, const int index, const int flag, bool checkEffect = false)
@@ -135,141 +181,241 @@ void CreateWaypoint(Vector& Next, float range)
         g_waypoint->Add(isBreakable ? 1 : -1, g_analyzeputrequirescrouch ? Vector(TargetPosition.x, TargetPosition.y, (TargetPosition.z - 18.0f)) : TargetPosition);
 }
 
-void AnalyzeThread(void)
+// pure geometry, doesn't touch the engine or the waypoints so it can run anywhere
+static int8_t PlanAnalyzeCandidates(const Vector& origin, const float range, Vector* candidates)
 {
-    static bool* expanded{};
-    static float magicTimer{};
-    if (!FNullEnt(g_hostEntity))
+    static const float offsets[][3] =
     {
-        char message[] =
-            "+-----------------------------------------------+\n"
-            "| Analyzing the map for walkable places |\n"
-            "+-----------------------------------------------+\n";
+        { 1.0f, 0.0f, 0.0f },
+        { -1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 0.0f, -1.0f, 0.0f },
+        { 1.0f, 0.0f, 128.0f },
+        { -1.0f, 0.0f, 128.0f },
+        { 0.0f, 1.0f, 128.0f }
+    };
+
+    int8_t i;
+    const int8_t count = static_cast<int8_t>(sizeof(offsets) / sizeof(offsets[0]));
+    for (i = 0; i < count; i++)
+        candidates[i] = Vector(origin.x + offsets[i][0] * range, origin.y + offsets[i][1] * range, origin.z + offsets[i][2]);
+
+    return count;
+}
 
-        HudMessage(g_hostEntity, true, Color(255, 255, 255, 255), message);
-    }
-    else if (!IsDedicatedServer())
+static void ShowAnalyzeProgress(void)
+{
+    const float time = engine->GetTime();
+    if (s_analyze.hudTime > time)
         return;
 
-    int16_t i;
+    s_analyze.hudTime = time + 1.0f;
 
-    // guarantee to have it
-    if (!expanded)
-    {
-        safeloc(expanded, Const_MaxWaypoints);
-        for (i = 0; i < Const_MaxWaypoints; i++)
-            expanded[i] = false;
-    }
+    const int done = s_analyze.nextIndex - s_analyze.startIndex;
+    const int left = g_numWaypoints - s_analyze.nextIndex;
+    const double elapsed = GetRealTime() - s_analyze.startTime;
 
-    float range;
-    Vector WayVec, Next;
-    int8_t dir;
-    for (i = 0; i < g_numWaypoints; i++)
-    {
-        if (expanded[i])
-            continue;
+    // new waypoints keep coming in, so this is the time left for the ones known so far
+    int eta = -1;
+    if (done > 0 && elapsed > 0.0)
+        eta = static_cast<int>(static_cast<double>(left) * elapsed / static_cast<double>(done));
 
-        if (magicTimer > engine->GetTime())
-            return;
+    char message[256];
+    if (eta >= 0)
+        FormatBuffer(message, "Analyzing the map for walkable places\n%d / %d waypoints, about %d:%02d left\n", s_analyze.nextIndex, g_numWaypoints, eta / 60, eta % 60);
+    else
+        FormatBuffer(message, "Analyzing the map for walkable places\n%d / %d waypoints\n", s_analyze.nextIndex, g_numWaypoints);
+
+    if (!FNullEnt(g_hostEntity))
+        HudMessage(g_hostEntity, true, Color(255, 255, 255, 255), message);
+    else
+        ServerPrint("Analyzing %d / %d waypoints", s_analyze.nextIndex, g_numWaypoints);
+}
+
+static void FinishAnalyze(void)
+{
+    s_analyze.running = false;
+    g_analyzewaypoints = false;
+    g_waypointOn = false;
+    g_editNoclip = false;
+    g_waypoint->AnalyzeDeleteUselessWaypoints();
+    SetGoals();
+
+    // saving refreshes the derived data in place, so there is no reload from disk
+    if (g_waypoint->Save())
+        g_waypoint->RemoveAnalyzeCheckpoint();
+
+    ServerCommand("exec addons/ebot/ebot.cfg");
+    ServerCommand("ebot wp mdl off");
+}
+
+void AnalyzeThread(void)
+{
+    if (FNullEnt(g_hostEntity) && !IsDedicatedServer())
+        return;
+
+    if (!s_analyze.running)
+    {
+        s_analyze.running = true;
+        s_analyze.startIndex = s_analyze.nextIndex;
+        s_analyze.startTime = GetRealTime();
+        s_analyze.checkpointTime = engine->GetTime() + ebot_analyze_checkpoint_time.GetFloat();
+    }
 
-        if ((ebot_analyzer_min_fps.GetFloat() + g_pGlobals->frametime) < 1.0f / g_pGlobals->frametime)
-            magicTimer = engine->GetTime() + g_pGlobals->frametime * 0.066f;
+    const double deadline = GetRealTime() + static_cast<double>(cmaxf(ebot_analyze_frame_ms.GetFloat() * g_frameGovernor.GetScale(), 0.1f)) * 0.001;
 
-        WayVec = g_waypoint->GetPath(i)->origin;
-        range = ebot_analyze_distance.GetFloat();
-        for (dir = 1; dir < 8; dir++)
+    // below the minimum fps only a single spot is traced per frame
+    const bool slow = g_pGlobals->frametime > 0.0f && 1.0f / g_pGlobals->frametime < ebot_analyzer_min_fps.GetFloat();
+    do
+    {
+        if (s_analyze.candidatePos >= s_analyze.candidateCount)
         {
-            switch (dir)
-            {
-            case 1:
-            {
-                Next.x = WayVec.x + range;
-                Next.y = WayVec.y;
-                Next.z = WayVec.z;
-                break;
-            }
-            case 2:
-            {
-                Next.x = WayVec.x - range;
-                Next.y = WayVec.y;
-                Next.z = WayVec.z;
-                break;
-            }
-            case 3:
-            {
-                Next.x = WayVec.x;
-                Next.y = WayVec.y + range;
-                Next.z = WayVec.z;
-                break;
-            }
-            case 4:
-            {
-                Next.x = WayVec.x;
-                Next.y = WayVec.y - range;
-                Next.z = WayVec.z;
-                break;
-            }
-            case 5:
-            {
-                Next.x = WayVec.x + range;
-                Next.y = WayVec.y;
-                Next.z = WayVec.z + 128.0f;
-                break;
-            }
-            case 6:
-            {
-                Next.x = WayVec.x - range;
-                Next.y = WayVec.y;
-                Next.z = WayVec.z + 128.0f;
-                break;
-            }
-            case 7:
+            if (s_analyze.nextIndex >= g_numWaypoints)
             {
-                Next.x = WayVec.x;
-                Next.y = WayVec.y + range;
-                Next.z = WayVec.z + 128.0f;
-                break;
-            }
-            case 8:
-            {
-                Next.x = WayVec.x;
-                Next.y = WayVec.y - range;
-                Next.z = WayVec.z + 128.0f;
-                break;
-            }
+                FinishAnalyze();
+                return;
             }
 
-            CreateWaypoint(Next, range);
+            s_analyze.range = ebot_analyze_distance.GetFloat();
+            s_analyze.candidateCount = PlanAnalyzeCandidates(g_waypoint->GetPath(s_analyze.nextIndex)->origin, s_analyze.range, s_analyze.candidates);
+            s_analyze.candidatePos = 0;
+            s_analyze.nextIndex++;
         }
 
-        expanded[i] = true;
-    }
+        CreateWaypoint(s_analyze.candidates[s_analyze.candidatePos++], s_analyze.range);
+    } while (!slow && GetRealTime() < deadline);
 
-    if (magicTimer + 2.0f < engine->GetTime())
+    ShowAnalyzeProgress();
+
+    if (ebot_analyze_checkpoint_time.GetFloat() > 0.0f && s_analyze.checkpointTime < engine->GetTime())
     {
-        g_analyzewaypoints = false;
-        g_waypointOn = false;
-        g_editNoclip = false;
-        g_waypoint->AnalyzeDeleteUselessWaypoints();
-        SetGoals();
-        g_waypoint->Save();
-        g_waypoint->Load();
-        ServerCommand("exec addons/ebot/ebot.cfg");
-        ServerCommand("ebot wp mdl off");
-        safedel(expanded);
+        g_waypoint->SaveAnalyzeCheckpoint();
+        s_analyze.checkpointTime = engine->GetTime() + ebot_analyze_checkpoint_time.GetFloat();
     }
 }
 
 void Waypoint::Analyze(void)
 {
+    PROFILE_SCOPE(Profile_Analyze);
+    MEMORY_TAG(Mem_Waypoints);
+
     if (!g_numWaypoints)
         return;
 
     AnalyzeThread();
 }
 
+// resumes an unfinished run of this map when there is one
+void Waypoint::StartAnalyze(const bool createBasic)
+{
+    s_analyze = AnalyzeState{};
+    if (LoadAnalyzeCheckpoint())
+        ServerPrint("Resuming the analyzer from waypoint %d of %d", s_analyze.nextIndex, g_numWaypoints);
+    else if (createBasic)
+        CreateBasic();
+
+    g_analyzewaypoints = true;
+}
+
+const char* Waypoint::GetAnalyzeCheckpointFile(void)
+{
+    static char checkpointFilePath[1024]{};
+    FormatBuffer(checkpointFilePath, "%s%s.eac", GetWaypointDir(), GetMapName());
+    return &checkpointFilePath[0];
+}
+
+void Waypoint::SaveAnalyzeCheckpoint(void)
+{
+    AnalyzeCheckpointHeader header;
+    cstrcpy(header.header, FH_ANALYZE_CHECKPOINT);
+    cstrncpy(header.mapName, GetMapName(), sizeof(header.mapName) - 1);
+    header.fileVersion = FV_ANALYZE_CHECKPOINT;
+    header.pointNumber = g_numWaypoints;
+
+    // spots of the waypoint being expanded are not done yet
+    header.nextIndex = s_analyze.candidatePos < s_analyze.candidateCount ? s_analyze.nextIndex - 1 : s_analyze.nextIndex;
+
+    // written aside first, a crash while saving keeps the previous checkpoint
+    char partFile[1024];
+    FormatBuffer(partFile, "%s.part", GetAnalyzeCheckpointFile());
+
+    File fp(partFile, "wb");
+    if (!fp.IsValid())
+    {
+        AddLogEntry(Log::Error, "Error writing '%s' analyzer checkpoint", GetMapName());
+        return;
+    }
+
+    fp.Write(&header, sizeof(header), 1);
+
+    int i;
+    for (i = 0; i < g_numWaypoints; i++)
+        fp.Write(&m_paths[i], sizeof(Path), 1);
+
+    fp.Close();
+
+#ifdef PLATFORM_WIN32
+    unlink(GetAnalyzeCheckpointFile());
+#endif
+    rename(partFile, GetAnalyzeCheckpointFile());
+}
+
+bool Waypoint::LoadAnalyzeCheckpoint(void)
+{
+    File fp(GetAnalyzeCheckpointFile(), "rb");
+    if (!fp.IsValid())
+        return false;
+
+    AnalyzeCheckpointHeader header;
+    if (fp.Read(&header, sizeof(header)) != 1 || cstrncmp(header.header, FH_ANALYZE_CHECKPOINT, cstrlen(FH_ANALYZE_CHECKPOINT)) != 0 ||
+        header.fileVersion != FV_ANALYZE_CHECKPOINT || cstricmp(header.mapName, GetMapName()) != 0 ||
+        header.pointNumber < 1 || header.pointNumber > Const_MaxWaypoints || header.nextIndex < 0 || header.nextIndex > header.pointNumber)
+    {
+        fp.Close();
+        return false;
+    }
+
+    Initialize();
+    m_paths.Resize(header.pointNumber, true);
+
+    int i;
+    Path path;
+    for (i = 0; i < header.pointNumber; i++)
+    {
+        if (fp.Read(&path, sizeof(Path)) != 1)
+        {
+            fp.Close();
+            Initialize();
+            return false;
+        }
+
+        m_paths.Push(path);
+    }
+
+    fp.Close();
+    g_numWaypoints = header.pointNumber;
+    g_waypointsChanged = true;
+    m_hotDirty = true;
+    BuildGrid();
+
+    s_analyze.nextIndex = static_cast<int16_t>(header.nextIndex);
+    return true;
+}
+
+void Waypoint::RemoveAnalyzeCheckpoint(void)
+{
+    unlink(GetAnalyzeCheckpointFile());
+}
+
+// marks first and removes everything in one pass, deleting inside the scan shifted the indices every time
 void Waypoint::AnalyzeDeleteUselessWaypoints(void)
 {
+    if (g_numWaypoints < 1)
+        return;
+
+    bool* remove = nullptr;
+    safeloc(remove, g_numWaypoints);
+
     int16_t i;
     int8_t connections, j;
     for (i = 0; i < g_numWaypoints; i++)
@@ -280,19 +426,20 @@ void Waypoint::AnalyzeDeleteUselessWaypoints(void)
         {
             if (m_paths[i].index[j] != -1)
             {
-                if (m_paths[i].index[j] >= g_numWaypoints)
-                    DeleteByIndex(i);
-                else if (m_paths[i].index[j] == i)
-                    DeleteByIndex(i);
+                if (m_paths[i].index[j] >= g_numWaypoints || m_paths[i].index[j] == i)
+                    remove[i] = true;
                 else
                     connections++;
             }
         }
 
         if (!connections)
-            DeleteByIndex(i);
+            remove[i] = true;
     }
 
+    DeleteBatch(remove);
+    safedel(remove);
+
     CenterPrint("Waypoints are saved!");
 }
 
@@ -301,6 +448,8 @@ void Waypoint::AddPath(const int addIndex, const int pathIndex, const int type)
     if (!IsValidWaypoint(addIndex) || !IsValidWaypoint(pathIndex) || addIndex == pathIndex)
         return;
 
+    m_hotDirty = true;
+
     Path* path = &m_paths[addIndex];
 
     // don't allow paths get connected twice
@@ -366,186 +515,577 @@ void Waypoint::AddPath(const int addIndex, const int pathIndex, const int type)
     }
 }
 
-int Waypoint::FindFarest(const Vector& origin, const float maxDistance)
+// grid cell of an origin, outside of the grid is clamped to the border cells
+inline void GetGridCell(const Vector& origin, int& x, int& y)
 {
-    int i, index = -1;
-    float distance, maxDist = squaredf(maxDistance);
-    for (i = 0; i < g_numWaypoints; i++)
+    x = cclamp(static_cast<int>((origin.x + Const_WaypointGridCell * Const_WaypointGridSize * 0.5f) / Const_WaypointGridCell), 0, Const_WaypointGridSize - 1);
+    y = cclamp(static_cast<int>((origin.y + Const_WaypointGridCell * Const_WaypointGridSize * 0.5f) / Const_WaypointGridCell), 0, Const_WaypointGridSize - 1);
+}
+
+// calls back every waypoint in the cells at the given ring around the center cell
+template <typename Callback>
+inline void VisitGridRing(const int16_t* head, const int16_t* next, const int centerX, const int centerY, const int ring, Callback callback)
+{
+    const int minX = cmax(centerX - ring, 0), maxX = cmin(centerX + ring, Const_WaypointGridSize - 1);
+    const int minY = cmax(centerY - ring, 0), maxY = cmin(centerY + ring, Const_WaypointGridSize - 1);
+
+    int x, y;
+    int16_t index;
+    for (x = minX; x <= maxX; x++)
     {
-        distance = (m_paths[i].origin - origin).GetLengthSquared();
-        if (distance > maxDist)
+        // inner columns only have the top and bottom cell of the ring
+        const int step = (x == centerX - ring || x == centerX + ring) ? 1 : cmax(ring * 2, 1);
+        for (y = centerY - ring; y <= centerY + ring; y += step)
         {
-            index = i;
-            maxDist = distance;
+            if (y < minY || y > maxY)
+                continue;
+
+            for (index = head[x * Const_WaypointGridSize + y]; index != -1; index = next[index])
+                callback(index);
         }
     }
+}
 
-    return index;
+void Waypoint::AddToGrid(const int index)
+{
+    if (!IsValidWaypoint(index) || index >= Const_MaxWaypoints)
+        return;
+
+    int x, y;
+    GetGridCell(m_paths[index].origin, x, y);
+
+    int16_t& head = m_gridHead[x * Const_WaypointGridSize + y];
+    m_gridNext[index] = head;
+    head = static_cast<int16_t>(index);
 }
 
-int Waypoint::FindNearestInCircle(const Vector& origin, const float maxDistance)
+void Waypoint::RemoveFromGrid(const int index)
 {
-    int i, index = -1;
-    float distance, maxDist = squaredf(maxDistance);
-    for (i = 0; i < g_numWaypoints; i++)
+    if (!IsValidWaypoint(index) || index >= Const_MaxWaypoints)
+        return;
+
+    int x, y;
+    GetGridCell(m_paths[index].origin, x, y);
+
+    int16_t* link = &m_gridHead[x * Const_WaypointGridSize + y];
+    while (*link != -1)
     {
-        distance = (m_paths[i].origin - origin).GetLengthSquared();
-        if (distance < maxDist)
+        if (*link == index)
         {
-            index = i;
-            maxDist = distance;
+            *link = m_gridNext[index];
+            break;
         }
-    }
 
-    return index;
+        link = &m_gridNext[*link];
+    }
 }
 
-int Waypoint::FindNearest(const Vector& origin, const float minDistance, const int flags, edict_t* entity, int* findWaypointPoint, const int mode)
+void Waypoint::BuildGrid(void)
 {
- 
-    float squaredMinDistance = squaredf(minDistance);
-    const int checkPoint = 20;
-    float wpDistance[checkPoint];
-    int wpIndex[checkPoint];
-    float distance;
-    Vector dest;
-
-    int i, y, z;
-    for (i = 0; i < checkPoint; i++)
-    {
-        wpIndex[i] = -1;
-        wpDistance[i] = FLT_MAX;
-    }
+    int i;
+    for (i = 0; i < Const_WaypointGridSize * Const_WaypointGridSize; i++)
+        m_gridHead[i] = -1;
 
     for (i = 0; i < g_numWaypoints; i++)
-    {
-        if (flags != -1 && !(m_paths[i].flags & flags))
-            continue;
-
-        dest = m_paths[i].origin;
-        distance = (dest - origin).GetLengthSquared();
-        if (distance > squaredMinDistance)
-            continue;
-
-        if (((dest.z > origin.z + 62.0f || dest.z < origin.z - 100.0f) && !(m_paths[i].flags & WAYPOINT_LADDER)) && (dest - origin).GetLengthSquared2D() < squaredf(30.0f))
-            continue;
+        AddToGrid(i);
+}
 
-        for (y = 0; y < checkPoint; y++)
-        {
-            if (distance > wpDistance[y])
-                continue;
+void Waypoint::DestroyHotData(void)
+{
+    safedel(m_hot.block);
+    m_hot = WaypointHotData{};
+    m_hotDirty = true;
+}
 
-            for (z = checkPoint - 1; z > y; z--)
-            {
-                if (z == checkPoint - 1 || wpIndex[z] == -1)
-                    continue;
+// builds the struct of arrays copy of m_paths, connections are packed so the searches only walk valid ones
+void Waypoint::BuildHotData(void)
+{
+    MEMORY_TAG(Mem_Waypoints);
 
-                wpIndex[z + 1] = wpIndex[z];
-                wpDistance[z + 1] = wpDistance[z];
-            }
+    DestroyHotData();
+    m_hotDirty = false;
 
-            wpIndex[y] = i;
-            wpDistance[y] = distance;
-            y = checkPoint + 5;
+    const int count = cclamp(g_numWaypoints, 0, static_cast<int>(m_paths.Size()));
+    int i, j, edges = 0;
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < Const_MaxPathIndex; j++)
+        {
+            if (IsValidWaypoint(m_paths[i].index[j]))
+                edges++;
         }
     }
 
-    if (IsValidWaypoint(mode))
+    // every array starts on a 16 byte boundary inside one block
+    auto align = [](const size_t size) { return (size + 15) & ~static_cast<size_t>(15); };
+    const size_t floatSize = align(count * sizeof(float));
+    const size_t total = floatSize * 5 + align(count) + align((count + 1) * sizeof(int)) * 2 + align(edges * sizeof(int16_t)) * 2 + align(edges * sizeof(uint16_t)) + 15;
+
+    safeloc(m_hot.block, total);
+    m_hot.blockSize = total;
+
+    uint8_t* cursor = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(m_hot.block) + 15) & ~static_cast<uintptr_t>(15));
+    m_hot.originX = reinterpret_cast<float*>(cursor);
+    cursor += floatSize;
+    m_hot.originY = reinterpret_cast<float*>(cursor);
+    cursor += floatSize;
+    m_hot.originZ = reinterpret_cast<float*>(cursor);
+    cursor += floatSize;
+    m_hot.gravity = reinterpret_cast<float*>(cursor);
+    cursor += floatSize;
+    m_hot.flags = reinterpret_cast<uint32_t*>(cursor);
+    cursor += floatSize;
+    m_hot.radius = cursor;
+    cursor += align(count);
+    m_hot.edgeStart = reinterpret_cast<int*>(cursor);
+    cursor += align((count + 1) * sizeof(int));
+    m_hot.edgeTarget = reinterpret_cast<int16_t*>(cursor);
+    cursor += align(edges * sizeof(int16_t));
+    m_hot.edgeFlags = reinterpret_cast<uint16_t*>(cursor);
+    cursor += align(edges * sizeof(uint16_t));
+    m_hot.reverseStart = reinterpret_cast<int*>(cursor);
+    cursor += align((count + 1) * sizeof(int));
+    m_hot.reverseSource = reinterpret_cast<int16_t*>(cursor);
+    m_hot.size = count;
+
+    static uint32_t version = 0;
+    m_hot.version = ++version;
+
+    edges = 0;
+    for (i = 0; i < count; i++)
     {
-        int cdWPIndex[checkPoint];
-        float cdWPDistance[checkPoint];
-
-        for (i = 0; i < checkPoint; i++)
-        {
-            cdWPIndex[i] = -1;
-            cdWPDistance[i] = FLT_MAX;
-        }
+        const Path& path = m_paths[i];
+        m_hot.originX[i] = path.origin.x;
+        m_hot.originY[i] = path.origin.y;
+        m_hot.originZ[i] = path.origin.z;
+        m_hot.gravity[i] = path.gravity;
+        m_hot.flags[i] = path.flags;
+        m_hot.radius[i] = path.radius;
+        m_hot.edgeStart[i] = edges;
 
-        for (i = 0; i < checkPoint; i++)
+        for (j = 0; j < Const_MaxPathIndex; j++)
         {
-            if (!IsValidWaypoint(wpIndex[i]))
+            if (!IsValidWaypoint(path.index[j]))
                 continue;
 
-            distance = g_waypoint->GetPathDistance(wpIndex[i], mode);
-            for (y = 0; y < checkPoint; y++)
-            {
-                if (distance > cdWPDistance[y])
-                    continue;
+            m_hot.edgeTarget[edges] = path.index[j];
+            m_hot.edgeFlags[edges] = path.connectionFlags[j];
+            edges++;
+        }
+    }
 
-                for (z = checkPoint - 1; z >= y; z--)
-                {
-                    if (z == checkPoint - 1 || cdWPIndex[z] == -1)
-                        continue;
+    m_hot.edgeStart[count] = edges;
 
-                    cdWPIndex[z + 1] = cdWPIndex[z];
-                    cdWPDistance[z + 1] = cdWPDistance[z];
-                }
+    // incoming edges for the searches that run backwards from a goal
+    for (i = 0; i <= count; i++)
+        m_hot.reverseStart[i] = 0;
 
-                cdWPIndex[y] = wpIndex[i];
-                cdWPDistance[y] = distance;
-                y = checkPoint + 5;
-            }
-        }
+    for (i = 0; i < edges; i++)
+        m_hot.reverseStart[m_hot.edgeTarget[i]]++;
 
-        for (i = 0; i < checkPoint; i++)
-        {
-            wpIndex[i] = cdWPIndex[i];
-            wpDistance[i] = cdWPDistance[i];
-        }
-    }
+    // running sum leaves the end of each range, filling from the back moves it to the start
+    for (i = 1; i < count; i++)
+        m_hot.reverseStart[i] += m_hot.reverseStart[i - 1];
 
-    int firsIndex = -1;
-    if (!FNullEnt(entity))
+    for (i = 0; i < count; i++)
     {
-        for (i = 0; i < checkPoint; i++)
-        {
-            if (!IsValidWaypoint(wpIndex[i]))
-                continue;
-
-            // Use the path variable in the condition     
-            if (wpDistance[i] > squaredf(m_paths[wpIndex[i]].radius) && !Reachable(entity, wpIndex[i]))
-                continue;
+        for (j = m_hot.edgeStart[i]; j < m_hot.edgeStart[i + 1]; j++)
+            m_hot.reverseSource[--m_hot.reverseStart[m_hot.edgeTarget[j]]] = static_cast<int16_t>(i);
+    }
 
-            if (findWaypointPoint == reinterpret_cast<int*>(-2))
-                return wpIndex[i];
+    m_hot.reverseStart[count] = edges;
+}
 
-            if (firsIndex == -1)
-            {
-                firsIndex = wpIndex[i];
-                continue;
-            }
+void Waypoint::ResetGroundChecks(void)
+{
+    safedel(m_groundChecks);
+    m_groundCheckSize = 0;
+}
 
-            if (findWaypointPoint && findWaypointPoint != reinterpret_cast<int*>(-2))
-                *findWaypointPoint = wpIndex[i];
+// downward trace of a fall check waypoint shared by every bot, only ground on the world is trusted for long
+bool Waypoint::HasGround(const int index)
+{
+    if (!IsValidWaypoint(index))
+        return false;
 
-            return firsIndex;
-        }
+    if (m_groundCheckSize != g_numWaypoints)
+    {
+        ResetGroundChecks();
+        safeloc(m_groundChecks, g_numWaypoints);
+        m_groundCheckSize = g_numWaypoints;
     }
 
-    if (!IsValidWaypoint(firsIndex))
-        firsIndex = wpIndex[0];
+    WaypointGroundCheck& check = m_groundChecks[index];
+    const float time = engine->GetTime();
+    if (check.expireTime > time)
+        return check.hasGround;
+
+    TraceResult tr{};
+    const Vector origin = m_paths[index].origin;
+    TraceLine(origin, origin - Vector(0.0f, 0.0f, 60.0f), true, false, g_worldEdict, &tr);
+    check.hasGround = tr.flFraction < 1.0f;
 
-    return firsIndex;
+    // lifts, doors and breakables move or disappear, empty space may get a lift, so only share those for a moment
+    if (check.hasGround && FNullEnt(tr.pHit))
+        check.expireTime = time + cmaxf(ebot_ground_cache_time.GetFloat(), 0.0f);
+    else
+        check.expireTime = time + 0.25f;
+
+    return check.hasGround;
 }
 
-// returns all waypoints within radius from position
-void Waypoint::FindInRadius(const Vector& origin, const float radius, int* holdTab, int* count)
+void Waypoint::DestroyThreatField(void)
+{
+    int i;
+    for (i = 0; i < Team::Spectator; i++)
+    {
+        safedel(m_threats.zombies[i]);
+        safedel(m_threats.occupied[i]);
+        safedel(m_threats.shared[i]);
+        safedel(m_threats.humanUntil[i]);
+    }
+
+    m_threats = WaypointThreatField{};
+}
+
+// counts the zombies and players around each waypoint, only runs once a frame however many bots search
+void Waypoint::UpdateThreatField(void)
+{
+    MEMORY_TAG(Mem_Waypoints);
+
+    const float time = engine->GetTime();
+    if (m_threats.time == time && m_threats.size == g_numWaypoints)
+        return;
+
+    int i, team;
+    const int words = (g_numWaypoints + 31) / 32;
+    if (m_threats.size != g_numWaypoints)
+    {
+        DestroyThreatField();
+        for (i = 0; i < Team::Spectator; i++)
+        {
+            safeloc(m_threats.zombies[i], cmax(g_numWaypoints, 1));
+            safeloc(m_threats.occupied[i], cmax(words, 1));
+            safeloc(m_threats.shared[i], cmax(words, 1));
+            safeloc(m_threats.humanUntil[i], cmax(g_numWaypoints, 1));
+        }
+
+        m_threats.size = g_numWaypoints;
+    }
+    else
+    {
+        for (i = 0; i < Team::Spectator; i++)
+        {
+            cmemset(m_threats.zombies[i], 0, g_numWaypoints);
+            cmemset(m_threats.occupied[i], 0, words * sizeof(uint32_t));
+            cmemset(m_threats.shared[i], 0, words * sizeof(uint32_t));
+            m_threats.zombieCount[i] = 0;
+            m_threats.zombieSum[i] = nullvec;
+            m_threats.zombieSquaredSum[i] = 0.0f;
+        }
+    }
+
+    m_threats.time = time;
+
+    // adds one to the waypoints whose radius plus extra reaches origin
+    auto spread = [&](uint8_t* field, const Vector& origin, const int extra)
+    {
+        int x, y, ring;
+        const int rings = cmin((255 + extra) / static_cast<int>(Const_WaypointGridCell) + 1, Const_WaypointGridSize - 1);
+        GetGridCell(origin, x, y);
+        for (ring = 0; ring <= rings; ring++)
+        {
+            VisitGridRing(m_gridHead, m_gridNext, x, y, ring, [&](const int16_t index)
+            {
+                if (field[index] < 255 && (m_paths[index].origin - origin).GetLengthSquared() < squaredi(static_cast<int>(m_paths[index].radius) + extra))
+                    field[index]++;
+            });
+        }
+    };
+
+    // a bot marks the waypoints it stands on, just left and walks to, once each
+    auto mark = [&](const int team, const int index, int* marked, int& count)
+    {
+        if (!IsValidWaypoint(index))
+            return;
+
+        int j;
+        for (j = 0; j < count; j++)
+        {
+            if (marked[j] == index)
+                return;
+        }
+
+        marked[count++] = index;
+        const uint32_t bit = 1u << (index & 31);
+        if (m_threats.occupied[team][index >> 5] & bit)
+            m_threats.shared[team][index >> 5] |= bit;
+        else
+            m_threats.occupied[team][index >> 5] |= bit;
+    };
+
+    // humans are led by one think step, the reservation outlives them by half a second
+    extern ConVar ebot_think_fps;
+    const float lead = 1.0f / cmaxf(ebot_think_fps.GetFloat(), 1.0f);
+    auto reserve = [&](float* field, const Vector& origin)
+    {
+        int x, y, ring;
+        const int rings = cmin((255 + 54) / static_cast<int>(Const_WaypointGridCell) + 1, Const_WaypointGridSize - 1);
+        GetGridCell(origin, x, y);
+        for (ring = 0; ring <= rings; ring++)
+        {
+            VisitGridRing(m_gridHead, m_gridNext, x, y, ring, [&](const int16_t index)
+            {
+                if ((m_paths[index].origin - origin).GetLengthSquared() < squaredi(static_cast<int>(m_paths[index].radius) + 54))
+                    field[index] = time + 0.5f;
+            });
+        }
+    };
+
+    int marked[3], count;
+    Bot* bot;
+    for (i = 0; i < 32; i++)
+    {
+        const Clients& client = g_clients[i];
+        if (!(g_clientSnapshot.m_alive & (1u << i)))
+            continue;
+
+        if (client.team >= Team::Terrorist && client.team < Team::Spectator)
+        {
+            bot = g_botManager->GetBot(i);
+            if (bot && bot->m_isAlive)
+            {
+                count = 0;
+                mark(client.team, bot->m_currentWaypointIndex, marked, count);
+                mark(client.team, bot->m_prevWptIndex[0], marked, count);
+                if (!bot->m_navNode.IsEmpty())
+                    mark(client.team, bot->m_navNode.Last(), marked, count);
+            }
+            else
+                reserve(m_threats.humanUntil[client.team], g_clientSnapshot.GetOrigin(i) + g_clientSnapshot.GetVelocity(i) * lead);
+        }
+
+        if (!IsZombieEntity(client.ent))
+            continue;
+
+        const Vector origin = client.ent->v.origin + client.ent->v.velocity * g_pGlobals->frametime;
+        for (team = 0; team < Team::Spectator; team++)
+        {
+            if (team == client.team)
+                continue;
+
+            m_threats.zombieCount[team]++;
+            m_threats.zombieSum[team] += origin;
+            m_threats.zombieSquaredSum[team] += origin.GetLengthSquared();
+            spread(m_threats.zombies[team], origin, 128);
+        }
+    }
+}
+
+int Waypoint::FindFarest(const Vector& origin, const float maxDistance)
+{
+    int i, index = -1;
+    float distance, maxDist = squaredf(maxDistance);
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        distance = (m_paths[i].origin - origin).GetLengthSquared();
+        if (distance > maxDist)
+        {
+            index = i;
+            maxDist = distance;
+        }
+    }
+
+    return index;
+}
+
+int Waypoint::FindNearestInCircle(const Vector& origin, const float maxDistance)
+{
+    int index = -1;
+    float maxDist = squaredf(maxDistance);
+
+    int x, y, ring;
+    GetGridCell(origin, x, y);
+    for (ring = 0; ring < Const_WaypointGridSize; ring++)
+    {
+        // nothing in this ring can be closer than this
+        const float ringDistance = static_cast<float>(cmax(ring - 1, 0)) * Const_WaypointGridCell;
+        if (squaredf(ringDistance) > maxDist)
+            break;
+
+        VisitGridRing(m_gridHead, m_gridNext, x, y, ring, [&](const int16_t i)
+        {
+            const float distance = (m_paths[i].origin - origin).GetLengthSquared();
+            if (distance < maxDist)
+            {
+                index = i;
+                maxDist = distance;
+            }
+        });
+    }
+
+    return index;
+}
+
+int Waypoint::FindNearest(const Vector& origin, const float minDistance, const int flags, edict_t* entity, int* findWaypointPoint, const int mode)
+{
+    PROFILE_SCOPE(Profile_FindNearest);
+
+    float squaredMinDistance = squaredf(minDistance);
+    const int checkPoint = 20;
+    float wpDistance[checkPoint];
+    int wpIndex[checkPoint];
+    float distance;
+    Vector dest;
+
+    int i, y, z;
+    for (i = 0; i < checkPoint; i++)
+    {
+        wpIndex[i] = -1;
+        wpDistance[i] = FLT_MAX;
+    }
+
+    int cellX, cellY, ring;
+    GetGridCell(origin, cellX, cellY);
+    for (ring = 0; ring < Const_WaypointGridSize; ring++)
+    {
+        // the farthest candidate is closer than anything in this ring
+        const float ringDistance = squaredf(static_cast<float>(cmax(ring - 1, 0)) * Const_WaypointGridCell);
+        if (ringDistance > squaredMinDistance || (wpIndex[checkPoint - 1] != -1 && ringDistance > wpDistance[checkPoint - 1]))
+            break;
+
+        VisitGridRing(m_gridHead, m_gridNext, cellX, cellY, ring, [&](const int16_t i)
+        {
+            if (flags != -1 && !(m_paths[i].flags & flags))
+                return;
+
+            dest = m_paths[i].origin;
+            distance = (dest - origin).GetLengthSquared();
+            if (distance > squaredMinDistance)
+                return;
+
+            if (((dest.z > origin.z + 62.0f || dest.z < origin.z - 100.0f) && !(m_paths[i].flags & WAYPOINT_LADDER)) && (dest - origin).GetLengthSquared2D() < squaredf(30.0f))
+                return;
+
+            for (y = 0; y < checkPoint; y++)
+            {
+                if (distance > wpDistance[y])
+                    continue;
+
+                for (z = checkPoint - 1; z > y; z--)
+                {
+                    if (z == checkPoint - 1 || wpIndex[z] == -1)
+                        continue;
+
+                    wpIndex[z + 1] = wpIndex[z];
+                    wpDistance[z + 1] = wpDistance[z];
+                }
+
+                wpIndex[y] = i;
+                wpDistance[y] = distance;
+                y = checkPoint + 5;
+            }
+        });
+    }
+
+    if (IsValidWaypoint(mode))
+    {
+        int cdWPIndex[checkPoint];
+        float cdWPDistance[checkPoint];
+
+        for (i = 0; i < checkPoint; i++)
+        {
+            cdWPIndex[i] = -1;
+            cdWPDistance[i] = FLT_MAX;
+        }
+
+        for (i = 0; i < checkPoint; i++)
+        {
+            if (!IsValidWaypoint(wpIndex[i]))
+                continue;
+
+            distance = g_waypoint->GetPathDistance(wpIndex[i], mode);
+            for (y = 0; y < checkPoint; y++)
+            {
+                if (distance > cdWPDistance[y])
+                    continue;
+
+                for (z = checkPoint - 1; z >= y; z--)
+                {
+                    if (z == checkPoint - 1 || cdWPIndex[z] == -1)
+                        continue;
+
+                    cdWPIndex[z + 1] = cdWPIndex[z];
+                    cdWPDistance[z + 1] = cdWPDistance[z];
+                }
+
+                cdWPIndex[y] = wpIndex[i];
+                cdWPDistance[y] = distance;
+                y = checkPoint + 5;
+            }
+        }
+
+        for (i = 0; i < checkPoint; i++)
+        {
+            wpIndex[i] = cdWPIndex[i];
+            wpDistance[i] = cdWPDistance[i];
+        }
+    }
+
+    int firsIndex = -1;
+    if (!FNullEnt(entity))
+    {
+        for (i = 0; i < checkPoint; i++)
+        {
+            if (!IsValidWaypoint(wpIndex[i]))
+                continue;
+
+            // Use the path variable in the condition     
+            if (wpDistance[i] > squaredf(m_paths[wpIndex[i]].radius) && !Reachable(entity, wpIndex[i]))
+                continue;
+
+            if (findWaypointPoint == reinterpret_cast<int*>(-2))
+                return g_recorder.Nearest(origin, minDistance, flags, mode, entity, wpIndex[i]);
+
+            if (firsIndex == -1)
+            {
+                firsIndex = wpIndex[i];
+                continue;
+            }
+
+            if (findWaypointPoint && findWaypointPoint != reinterpret_cast<int*>(-2))
+                *findWaypointPoint = wpIndex[i];
+
+            return g_recorder.Nearest(origin, minDistance, flags, mode, entity, firsIndex);
+        }
+    }
+
+    if (!IsValidWaypoint(firsIndex))
+        firsIndex = wpIndex[0];
+
+    return g_recorder.Nearest(origin, minDistance, flags, mode, entity, firsIndex);
+}
+
+// returns all waypoints within radius from position
+void Waypoint::FindInRadius(const Vector& origin, const float radius, int* holdTab, int* count)
 {
     const int maxCount = *count;
     const float squared = squaredf(radius);
     *count = 0;
 
-    int i;
-    for (i = 0; i < g_numWaypoints; i++)
+    int x, y, ring;
+    const int rings = cmin(static_cast<int>(radius / Const_WaypointGridCell) + 1, Const_WaypointGridSize - 1);
+    GetGridCell(origin, x, y);
+    for (ring = 0; ring <= rings && *count < maxCount; ring++)
     {
-        if ((m_paths[i].origin - origin).GetLengthSquared() < squared)
+        VisitGridRing(m_gridHead, m_gridNext, x, y, ring, [&](const int16_t i)
         {
+            if (*count >= maxCount || (m_paths[i].origin - origin).GetLengthSquared() >= squared)
+                return;
+
             *holdTab++ = i;
             *count += 1;
-
-            if (*count >= maxCount)
-                break;
-        }
+        });
     }
 
     *count -= 1;
@@ -553,19 +1093,27 @@ void Waypoint::FindInRadius(const Vector& origin, const float radius, int* holdT
 
 void Waypoint::FindInRadius(MiniArray <int16_t>& queueID, const float& radius, const Vector& origin)
 {
-    int16_t i;
     const float squared = squaredf(radius);
-    for (i = 0; i < g_numWaypoints; i++)
+
+    int x, y, ring;
+    const int rings = cmin(static_cast<int>(radius / Const_WaypointGridCell) + 1, Const_WaypointGridSize - 1);
+    GetGridCell(origin, x, y);
+    for (ring = 0; ring <= rings; ring++)
     {
-        if ((m_paths[i].origin - origin).GetLengthSquared() > squared)
-            continue;
-        
-        queueID.Push(i);
+        VisitGridRing(m_gridHead, m_gridNext, x, y, ring, [&](const int16_t i)
+        {
+            if ((m_paths[i].origin - origin).GetLengthSquared() > squared)
+                return;
+
+            queueID.Push(i);
+        });
     }
 }
 
 void Waypoint::Add(const int flags, const Vector& waypointOrigin)
 {
+    MEMORY_TAG(Mem_Waypoints);
+
     int index = -1, i;
 
     Vector forward = nullvec;
@@ -586,6 +1134,7 @@ void Waypoint::Add(const int flags, const Vector& waypointOrigin)
         g_botManager->RemoveAll();
 
     g_waypointsChanged = true;
+    m_hotDirty = true;
 
     switch (flags)
     {
@@ -609,7 +1158,11 @@ void Waypoint::Add(const int flags, const Vector& waypointOrigin)
                     accumFlags += path->connectionFlags[i];
 
                 if (!accumFlags)
+                {
+                    RemoveFromGrid(index);
                     path->origin = (path->origin + GetEntityOrigin(g_hostEntity)) * 0.5f;
+                    AddToGrid(index);
+                }
             }
         }
         break;
@@ -648,6 +1201,8 @@ void Waypoint::Add(const int flags, const Vector& waypointOrigin)
             path->connectionFlags[i] = 0;
         }
 
+        AddToGrid(index);
+
         // store the last used waypoint for the auto waypoint code...
         m_lastWaypoint = GetEntityOrigin(g_hostEntity);
     }
@@ -860,43 +1415,127 @@ void Waypoint::Delete(void)
     DeleteByIndex(index);
 }
 
-void Waypoint::DeleteByIndex(const int index)
+// removes every waypoint marked in remove (sized g_numWaypoints) with a single remap of the links
+int Waypoint::DeleteBatch(const bool* remove)
 {
-    g_waypointsChanged = true;
-
     if (g_numWaypoints < 1)
-        return;
+        return 0;
 
-    if (g_botManager->GetBotsNum())
-        g_botManager->RemoveAll();
+    int16_t* remap = nullptr;
+    safeloc(remap, g_numWaypoints);
 
-    if (!IsValidWaypoint(index))
-        return;
+    int i, j, count = 0;
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        if (remove[i])
+            remap[i] = -1;
+        else
+            remap[i] = static_cast<int16_t>(count++);
+    }
 
-    Path* path = nullptr;
+    const int removed = g_numWaypoints - count;
+    if (!removed)
+    {
+        safedel(remap);
+        return 0;
+    }
 
-    int i, j;
-    for (i = 0; i < g_numWaypoints; i++) // delete all references to Node
+    if (g_botManager->GetBotsNum())
+        g_botManager->RemoveAll();
+
+    MiniArray <int16_t> dirty;
+    int16_t link;
+    bool recalculate;
+    for (i = 0; i < g_numWaypoints; i++)
     {
-        path = &m_paths[i];
-        if (!path)
+        if (remove[i])
             continue;
 
+        Path& path = m_paths[i];
+        recalculate = false;
         for (j = 0; j < Const_MaxPathIndex; j++)
         {
-            if (path->index[j] == index)
+            link = path.index[j];
+            if (link < 0 || link >= g_numWaypoints)
+                continue;
+
+            if (remove[link])
             {
-                path->index[j] = -1;  // unassign this path
-                path->connectionFlags[j] = 0;
+                // ladder and jump neighbours force a zero wayzone, losing one needs a new one
+                recalculate |= (m_paths[link].flags & (WAYPOINT_LADDER | WAYPOINT_JUMP)) != 0;
+                path.index[j] = -1;
+                path.connectionFlags[j] = 0;
             }
+            else
+                path.index[j] = remap[link];
         }
-    }
 
-    for (i = 0; i < g_numWaypoints; i++)
-    {
-        path = &m_paths[i];
-        if (!path)
-            continue;
+        if (recalculate)
+            dirty.Push(remap[i]);
+
+        // compacting forward never overwrites a waypoint that is still to be visited
+        if (remap[i] != i)
+        {
+            m_paths[remap[i]] = path;
+            if (m_waypointDisplayTime)
+                m_waypointDisplayTime[remap[i]] = m_waypointDisplayTime[i];
+        }
+    }
+
+    safedel(remap);
+
+    m_paths.Truncate(static_cast<int16_t>(count));
+    g_numWaypoints = count;
+    g_waypointsChanged = true;
+    m_hotDirty = true;
+    ResetGroundChecks();
+    BuildGrid();
+
+    for (i = 0; i < dirty.Size(); i++)
+        CalculateWayzone(dirty[i]);
+
+    PlaySound(g_hostEntity, "weapons/mine_activate.wav");
+    return removed;
+}
+
+void Waypoint::DeleteByIndex(const int index)
+{
+    g_waypointsChanged = true;
+    m_hotDirty = true;
+
+    if (g_numWaypoints < 1)
+        return;
+
+    if (g_botManager->GetBotsNum())
+        g_botManager->RemoveAll();
+
+    if (!IsValidWaypoint(index))
+        return;
+
+    Path* path = nullptr;
+
+    int i, j;
+    for (i = 0; i < g_numWaypoints; i++) // delete all references to Node
+    {
+        path = &m_paths[i];
+        if (!path)
+            continue;
+
+        for (j = 0; j < Const_MaxPathIndex; j++)
+        {
+            if (path->index[j] == index)
+            {
+                path->index[j] = -1;  // unassign this path
+                path->connectionFlags[j] = 0;
+            }
+        }
+    }
+
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        path = &m_paths[i];
+        if (!path)
+            continue;
 
         for (j = 0; j < Const_MaxPathIndex; j++)
         {
@@ -908,6 +1547,7 @@ void Waypoint::DeleteByIndex(const int index)
     m_paths.RemoveAt(index);
 
     g_numWaypoints--;
+    BuildGrid(); // indices above the deleted one are shifted
     if (m_waypointDisplayTime)
         m_waypointDisplayTime[index] = 0.0f;
 
@@ -921,6 +1561,7 @@ void Waypoint::DeleteFlags(void)
         return;
 
     m_paths[index].flags = 0;
+    m_hotDirty = true;
     PlaySound(g_hostEntity, "common/wpn_hudon.wav");
 }
 
@@ -945,6 +1586,8 @@ void Waypoint::ToggleFlags(const int toggleFlag)
         m_paths[index].flags |= toggleFlag;
     }
 
+    m_hotDirty = true;
+
     // play "done" sound...
     PlaySound(g_hostEntity, "common/wpn_hudon.wav");
 }
@@ -957,6 +1600,7 @@ void Waypoint::SetRadius(const int radius)
         return;
 
     m_paths[index].radius = static_cast<uint8_t>(cclamp(radius, 0, 255));
+    m_hotDirty = true;
     PlaySound(g_hostEntity, "common/wpn_hudon.wav");
 }
 
@@ -1077,6 +1721,7 @@ void Waypoint::CreatePath(const int dir)
 
     PlaySound(g_hostEntity, "common/wpn_hudon.wav");
     g_waypointsChanged = true;
+    m_hotDirty = true;
 }
 
 void Waypoint::TeleportWaypoint(void)
@@ -1117,6 +1762,7 @@ void Waypoint::DeletePath(void)
         if (m_paths[nodeFrom].index[index] == nodeTo)
         {
             g_waypointsChanged = true;
+            m_hotDirty = true;
 
             m_paths[nodeFrom].index[index] = -1; // unassign this path
             m_paths[nodeFrom].connectionFlags[index] = 0;
@@ -1136,6 +1782,7 @@ void Waypoint::DeletePath(void)
         if (m_paths[nodeFrom].index[index] == nodeTo)
         {
             g_waypointsChanged = true;
+            m_hotDirty = true;
 
             m_paths[nodeFrom].index[index] = -1; // unassign this path
             m_paths[nodeFrom].connectionFlags[index] = 0;
@@ -1162,6 +1809,7 @@ void Waypoint::DeletePathByIndex(int nodeFrom, int nodeTo)
         if (m_paths[nodeFrom].index[index] == nodeTo)
         {
             g_waypointsChanged = true;
+            m_hotDirty = true;
 
             m_paths[nodeFrom].index[index] = -1; // unassign this path
             m_paths[nodeFrom].connectionFlags[index] = 0;
@@ -1181,6 +1829,7 @@ void Waypoint::DeletePathByIndex(int nodeFrom, int nodeTo)
         if (m_paths[nodeFrom].index[index] == nodeTo)
         {
             g_waypointsChanged = true;
+            m_hotDirty = true;
 
             m_paths[nodeFrom].index[index] = -1; // unassign this path
             m_paths[nodeFrom].connectionFlags[index] = 0;
@@ -1213,6 +1862,8 @@ void Waypoint::CalculateWayzone(const int index)
     if (!IsValidWaypoint(index))
         return;
 
+    m_hotDirty = true;
+
     Path* path = &m_paths[index];
     if ((path->flags & (WAYPOINT_LADDER | WAYPOINT_GOAL | WAYPOINT_CAMP | WAYPOINT_RESCUE | WAYPOINT_CROUCH)) || m_learnJumpWaypoint)
     {
@@ -1329,8 +1980,40 @@ Vector Waypoint::GetBottomOrigin(const Path* waypoint)
 
 void Waypoint::InitTypes(void)
 {
+    MEMORY_TAG(Mem_Waypoints);
+
     int16_t i;
     uint32_t flags;
+
+    // count first so every list is sized with one allocation per map
+    int16_t counts[7]{};
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        flags = m_paths[i].flags;
+        if (flags & WAYPOINT_GOAL)
+            counts[0]++;
+        else if (flags & WAYPOINT_CAMP)
+            counts[1]++;
+        else if (flags & WAYPOINT_RESCUE)
+            counts[2]++;
+        else if (flags & WAYPOINT_ZMHMCAMP)
+            counts[3]++;
+        else if (flags & WAYPOINT_HMCAMPMESH)
+            counts[4]++;
+        else if (flags & WAYPOINT_TERRORIST)
+            counts[5]++;
+        else if (flags & WAYPOINT_COUNTER)
+            counts[6]++;
+    }
+
+    m_goalPoints.Reserve(counts[0]);
+    m_campPoints.Reserve(counts[1]);
+    m_rescuePoints.Reserve(counts[2]);
+    m_zmHmPoints.Reserve(counts[3]);
+    m_hmMeshPoints.Reserve(counts[4]);
+    m_terrorPoints.Reserve(counts[5]);
+    m_ctPoints.Reserve(counts[6]);
+
     for (i = 0; i < g_numWaypoints; i++)
     {
         flags = m_paths[i].flags;
@@ -1391,197 +2074,725 @@ void Waypoint::Sort(const int16_t self, int16_t index[], const int size)
     }
 }
 
-static int8_t tryDownload;
+
+// fnv-1a hash of a buffer, pass the previous hash to continue it
+static uint32_t HashBuffer(const uint8_t* buffer, const size_t size, uint32_t hash = 2166136261u)
+{
+    size_t i;
+    for (i = 0; i < size; i++)
+    {
+        hash ^= buffer[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// fnv-1a hash of the whole waypoint file
+static uint32_t HashWaypointFile(const char* fileName)
+{
+    uint32_t hash = 2166136261u;
+    File fp(fileName, "rb");
+    if (!fp.IsValid())
+        return 0;
+
+    uint8_t buffer[4096];
+    int count;
+    while ((count = fp.Read(buffer, 1, sizeof(buffer))) > 0)
+        hash = HashBuffer(buffer, static_cast<size_t>(count), hash);
+
+    fp.Close();
+    return hash;
+}
+
+enum class DownloadState : int8_t
+{
+    Running,
+    Done,
+    Failed
+};
+
+// one background download, owned by both the worker and the main thread until both let go of it
+// the worker must not call into the engine, everything it needs is copied in here
+struct WaypointDownload
+{
+    std::atomic<DownloadState> state{DownloadState::Running};
+    std::atomic<int> refs{1}; // the main thread's, the worker and its thread slot add theirs on launch
+    std::atomic<bool> cancel{}; // set by the main thread, the worker gives up at its next check
+    char url[1024]{};
+    char targetFile[1024]{};
+    char cacheDir[1024]{};
+    char mapName[64]{};
+    char error[256]{};
+    int timeout{};
+    double deadline{};
+    bool fromCache{};
+    bool launched{}; // main thread only, false while an earlier worker still holds the thread slot
+};
+
+static WaypointDownload* s_download;
+static std::thread s_downloadThread; // one worker at a time, joined once it is done and on unload
+static WaypointDownload* s_downloadWorker; // job of s_downloadThread, referenced until the thread is joined
+static char s_downloadFailed[64]; // map that gave up on downloading, falls back to the analyzer
+
+static void ReleaseDownload(WaypointDownload* job)
+{
+    if (job->refs.fetch_sub(1) == 1)
+        delete job;
+}
+
+// joins the worker once it has set its state, after that it only has its release left
+// false while it is still running, the main thread never waits on a transfer
+static bool ReapDownloadThread(void)
+{
+    if (!s_downloadThread.joinable())
+        return true;
+
+    if (s_downloadWorker->state.load() == DownloadState::Running)
+        return false;
+
+    s_downloadThread.join();
+    ReleaseDownload(s_downloadWorker);
+    s_downloadWorker = nullptr;
+    return true;
+}
+
+// replaces the destination, so other servers sharing the cache never see a half written file
+static bool MoveOver(const char* from, const char* to)
+{
+#ifdef PLATFORM_WIN32
+    unlink(to);
+#endif
+    return !rename(from, to);
+}
+
+static bool CopyWaypointFile(const char* from, const char* to)
+{
+    File in(from, "rb");
+    if (!in.IsValid())
+        return false;
+
+    char partFile[1024];
+    snprintf(partFile, sizeof(partFile), "%s.part", to);
+    File out(partFile, "wb");
+    if (!out.IsValid())
+        return false;
+
+    uint8_t buffer[4096];
+    int count;
+    bool written = true;
+    while ((count = in.Read(buffer, 1, sizeof(buffer))) > 0)
+    {
+        if (out.Write(buffer, count, 1) != 1)
+        {
+            written = false;
+            break;
+        }
+    }
+
+    in.Close();
+    out.Close();
+    if (!written || !MoveOver(partFile, to))
+    {
+        unlink(partFile);
+        return false;
+    }
+
+    return true;
+}
+
+// servers answer missing files with html pages, only accept something that looks like a waypoint file
+static bool IsWaypointFile(const char* fileName)
+{
+    File fp(fileName, "rb");
+    if (!fp.IsValid())
+        return false;
+
+    WaypointHeader header;
+    const bool valid = fp.Read(&header, sizeof(header)) == 1 && !cstrncmp(header.header, FH_WAYPOINT_NEW, cstrlen(FH_WAYPOINT_NEW)) &&
+        header.pointNumber > 0 && header.pointNumber <= Const_MaxWaypoints;
+    fp.Close();
+    return valid;
+}
+
 #ifdef PLATFORM_LINUX
 // the WriteCallback function is called by cURL when there is data to be written.
 // this is necessary for compatibility with older versions of cURL, which do not
-// support the CURLOPT_WRITEDATA option directly (linux)
+// support the CURLOPT_WRITEDATA option directly (linux), runs on the download thread
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, FILE* stream)
 {
-    const size_t written = fwrite(contents, size, nmemb, stream);
-    if (written < nmemb)
-        ServerPrint("Error: fwrite wrote fewer items than expected: %zu out of %zu", written, nmemb);
-    return written;
+    return fwrite(contents, size, nmemb, stream);
+}
+
+#ifdef CURL_AVAILABLE
+// a non zero return aborts the transfer, cURL calls this about once a second even on a stalled connection
+static int ProgressCallback(void* data, double, double, double, double)
+{
+    return static_cast<WaypointDownload*>(data)->cancel.load() ? 1 : 0;
 }
 #endif
+#endif
 
-bool Waypoint::Download(void)
+// blocking transfer, only called from the download thread
+static bool TransferFile(WaypointDownload* job, const char* fileName)
 {
-    tryDownload++;
 #ifdef PLATFORM_WIN32
     // could be missing or corrupted? then avoid crash...
     const HMODULE hUrlMon = LoadLibrary("urlmon.dll");
-    if (hUrlMon)
+    if (!hUrlMon)
     {
-        ServerPrint("UrlMon found on the machine");
-
-        typedef HRESULT(WINAPI* URLDownloadToFileFn)(LPUNKNOWN, LPCSTR, LPCSTR, DWORD, LPBINDSTATUSCALLBACK);
-        const URLDownloadToFileFn pURLDownloadToFile = reinterpret_cast<URLDownloadToFileFn>(GetProcAddress(hUrlMon, "URLDownloadToFileA"));
+        snprintf(job->error, sizeof(job->error), "Could not load UrlMon, could be missing or courrupted");
+        return false;
+    }
 
-        if (pURLDownloadToFile)
-        {
-            ServerPrint("UrlMon loaded successfully");
-            char tpath[1024];
-            FormatBuffer(tpath, "%s/%s.ewp", ebot_download_waypoints_from.GetString(), GetMapName());
-            if (SUCCEEDED(pURLDownloadToFile(nullptr, tpath, CheckSubfolderFile(), 0, nullptr)))
-            {
-                ServerPrint("UrlMon download successful");
-                FreeLibrary(hUrlMon);
-                return true;
-            }
-        }
-        else
-            ServerPrint("Error: Could not find URLDownloadToFileA in UrlMon, UrlMon is courrupted!");
+    typedef HRESULT(WINAPI* URLDownloadToFileFn)(LPUNKNOWN, LPCSTR, LPCSTR, DWORD, LPBINDSTATUSCALLBACK);
+    const URLDownloadToFileFn pURLDownloadToFile = reinterpret_cast<URLDownloadToFileFn>(GetProcAddress(hUrlMon, "URLDownloadToFileA"));
 
-        if (FreeLibrary(hUrlMon))
-            ServerPrint("UrlMon unloaded successfully");
-        else
-            ServerPrint("Cannot able to unload UrlMon!");
-    }
+    bool result = false;
+    if (!pURLDownloadToFile)
+        snprintf(job->error, sizeof(job->error), "Could not find URLDownloadToFileA in UrlMon, UrlMon is courrupted!");
+    else if (SUCCEEDED(pURLDownloadToFile(nullptr, job->url, fileName, 0, nullptr)))
+        result = true;
     else
-        ServerPrint("Error: Could not load UrlMon, could be missing or courrupted");
+        snprintf(job->error, sizeof(job->error), "UrlMon download failed");
+
+    FreeLibrary(hUrlMon);
+    return result;
 #else
 #ifdef CURL_AVAILABLE
-    if (curl_version_info(CURLVERSION_NOW))
+    CURL* curl = curl_easy_init();
+    if (!curl)
     {
-        CURL* curl;
-        CURLcode res;
+        snprintf(job->error, sizeof(job->error), "Could not initialize cURL handle");
+        return false;
+    }
 
-        curl_global_init(CURL_GLOBAL_ALL);
-        curl = curl_easy_init();
+    FILE* fp = fopen(fileName, "wb");
+    if (!fp)
+    {
+        snprintf(job->error, sizeof(job->error), "Could not open file for writing");
+        curl_easy_cleanup(curl);
+        return false;
+    }
 
-        if (curl)
-        {
-            char tpath[1024];
-            FormatBuffer(tpath, "%s/%s.ewp", ebot_download_waypoints_from.GetString(), GetMapName());
-            const char* downloadURL = &tpath;
-            curl_easy_setopt(curl, CURLOPT_URL, downloadURL);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-            ServerPrint("Downloading from cURL: %s", downloadURL);
+    curl_easy_setopt(curl, CURLOPT_URL, job->url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, ProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, job);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, static_cast<long>(cmin(job->timeout, 10)));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(job->timeout));
+
+    // give up on stalled transfers before the hard timeout
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, static_cast<long>(cmin(job->timeout, 10)));
+
+    const CURLcode res = curl_easy_perform(curl);
+    fclose(fp);
+
+    // check HTTP response code
+    long response_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK)
+    {
+        snprintf(job->error, sizeof(job->error), "curl_easy_perform() failed: %s", curl_easy_strerror(res));
+        return false;
+    }
 
-            // path to the 'cstrike/maps' directory
-            FormatBuffer(tpath, "%s/%s.ewp", GetWaypointDir(), GetMapName());
-            const char* filepath = &tpath;
-            FILE* fp = fopen(filepath, "wb");
-            if (!fp)
-            {
-                ServerPrint("Error: Could not open file for writing");
-                curl_easy_cleanup(curl);
-                curl_global_cleanup();
-                return false;
-            }
+    if (response_code != 200)
+    {
+        snprintf(job->error, sizeof(job->error), "HTTP response code is not 200, but %ld", response_code);
+        return false;
+    }
 
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
+    return true;
+#else
+    // check if wget is installed
+    if (system("which wget > /dev/null 2>&1"))
+    {
+        snprintf(job->error, sizeof(job->error), "Neither curl nor wget is available");
+        return false;
+    }
 
-            res = curl_easy_perform(curl);
+    char command[2200];
+    snprintf(command, sizeof(command), "wget -q -t 1 -T %d -O \"%s\" \"%s\"", job->timeout, fileName, job->url);
+    const int result = system(command);
+    if (result)
+    {
+        snprintf(job->error, sizeof(job->error), "wget command failed with code %d", result);
+        return false;
+    }
 
-            // check HTTP response code
-            long response_code;
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-            if (response_code != 200)
-            {
-                ServerPrint("Error: HTTP response code is not 200, but %ld", response_code);
-                fclose(fp);
-                curl_easy_cleanup(curl);
-                curl_global_cleanup();
-                return false;
-            }
+    return true;
+#endif
+#endif
+}
 
-            fclose(fp);
-            if (res != CURLE_OK)
-            {
-                ServerPrint("Error: curl_easy_perform() failed: %s", curl_easy_strerror(res));
-                curl_easy_cleanup(curl);
-                curl_global_cleanup();
-                return false;
-            }
+// cache layout: <hash>.ewp holds the content, <map>.ref names the hash, so identical files are stored once
+static bool FetchFromCache(WaypointDownload* job)
+{
+    char fileName[1024];
+    snprintf(fileName, sizeof(fileName), "%s%s.ref", job->cacheDir, job->mapName);
 
-            curl_easy_cleanup(curl);
-            ServerPrint("cURL download successful");
-            return true;
-        }
+    File fp(fileName, "rt");
+    if (!fp.IsValid())
+        return false;
 
-        ServerPrint("Error: Could not initialize cURL handle");
-        curl_global_cleanup();
-    }
+    char hash[16]{};
+    const bool valid = fp.GetBuffer(hash, sizeof(hash)) != nullptr;
+    fp.Close();
+    if (!valid)
+        return false;
+
+    const uint32_t expected = static_cast<uint32_t>(strtoul(hash, nullptr, 16));
+    snprintf(fileName, sizeof(fileName), "%s%08x.ewp", job->cacheDir, expected);
+
+    // a damaged or replaced blob is downloaded again
+    if (HashWaypointFile(fileName) != expected || !IsWaypointFile(fileName))
+        return false;
+
+    return CopyWaypointFile(fileName, job->targetFile);
+}
+
+static void StoreInCache(WaypointDownload* job, const char* fileName)
+{
+    const uint32_t hash = HashWaypointFile(fileName);
+
+    char blobFile[1024];
+    snprintf(blobFile, sizeof(blobFile), "%s%08x.ewp", job->cacheDir, hash);
+    if (HashWaypointFile(blobFile) != hash && !CopyWaypointFile(fileName, blobFile))
+        return;
+
+    char refFile[1024], partFile[1024];
+    snprintf(refFile, sizeof(refFile), "%s%s.ref", job->cacheDir, job->mapName);
+    snprintf(partFile, sizeof(partFile), "%s.part", refFile);
+
+    File fp(partFile, "wt");
+    if (!fp.IsValid())
+        return;
+
+    fp.Printf("%08x\n", hash);
+    fp.Close();
+    if (!MoveOver(partFile, refFile))
+        unlink(partFile);
+}
+
+static void DownloadThread(WaypointDownload* job)
+{
+    bool result = FetchFromCache(job);
+    if (result)
+        job->fromCache = true;
+    else if (job->cancel.load())
+        snprintf(job->error, sizeof(job->error), "cancelled");
     else
-        ServerPrint("Error: Could not find valid cURL version");
-#else
-    // check if wget is installed
-    if (!system("which wget"))
     {
-        // wget is installed
-        char downloadURL[1024];
-        snprintf(downloadURL, sizeof(downloadURL), "%s/%s.ewp", ebot_download_waypoints_from.GetString(), GetMapName());
+        char partFile[1024];
+        snprintf(partFile, sizeof(partFile), "%s.part", job->targetFile);
 
-        char tpath[1024];
-        FormatBuffer(tpath, "%s/%s.ewp", GetWaypointDir(), GetMapName());
-        const char* filepath = tpath;
+        result = TransferFile(job, partFile);
 
-        char command[1024];
-        snprintf(command, sizeof(command), "wget -O %s %s", filepath, downloadURL);
-        printf("Executing wget command: %s", command);
-        const int result = system(command);
+        // wget and UrlMon can't be interrupted, the main thread may have given up in the meantime
+        if (result && job->cancel.load())
+        {
+            snprintf(job->error, sizeof(job->error), "cancelled");
+            result = false;
+        }
 
-        if (!result)
+        if (result && !IsWaypointFile(partFile))
         {
-            ServerPrint("wget download successful");
-            return true;
+            snprintf(job->error, sizeof(job->error), "%s is not a waypoint file", job->url);
+            result = false;
         }
-        else
+
+        if (result)
         {
-            ServerPrint("Error: wget command failed with code %d", result);
-            return false;
+            StoreInCache(job, partFile);
+
+            // once cancelled the main thread has fallen back to the analyzer, don't install the file under it
+            if (job->cancel.load())
+            {
+                snprintf(job->error, sizeof(job->error), "cancelled");
+                result = false;
+            }
+            else
+            {
+                result = MoveOver(partFile, job->targetFile);
+                if (!result)
+                    snprintf(job->error, sizeof(job->error), "Could not move the file to %s", job->targetFile);
+            }
         }
+
+        if (!result)
+            unlink(partFile);
     }
-    else
-        ServerPrint("Error: Neither curl nor wget is available");
-#endif
-#endif
 
-    return false;
+    job->state = result ? DownloadState::Done : DownloadState::Failed;
+    ReleaseDownload(job);
 }
 
-static int8_t tryLoad;
-bool Waypoint::Load(void)
+// hands the job to a new worker if the thread slot is free
+static void LaunchDownload(WaypointDownload* job)
 {
-    Initialize();
-    safedel(m_waypointDisplayTime);
+    if (!ReapDownloadThread())
+        return;
 
-    int i;
-    const char* pathtofl = CheckSubfolderFile();
-    File fp(pathtofl, "rb");
-    if (fp.IsValid())
+    // the worker gets a little longer than the transfer timeout to finish the cache copy
+    job->deadline = GetRealTime() + static_cast<double>(job->timeout) + 5.0;
+    job->launched = true;
+    job->refs.fetch_add(2);
+    s_downloadWorker = job;
+    s_downloadThread = std::thread(DownloadThread, job);
+}
+
+// starts fetching the current map in the background, false when it can't be started
+bool Waypoint::StartDownload(void)
+{
+    const char* mapName = GetMapName();
+    if (s_download)
     {
-        WaypointHeader header;
-        fp.Read(&header, sizeof(header));
+        if (!cstrcmp(s_download->mapName, mapName))
+            return true;
 
-        if (header.fileVersion > static_cast<int32_t>(FV_WAYPOINT))
+        CancelDownload();
+    }
+
+    // a failed map is only tried again after another map
+    if (!cstrcmp(s_downloadFailed, mapName))
+        return false;
+
+    s_downloadFailed[0] = '\0';
+
+#ifdef CURL_AVAILABLE
+    // not thread safe, done once before the first worker
+    static bool curlReady;
+    if (!curlReady)
+    {
+        if (!curl_version_info(CURLVERSION_NOW) || curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK)
         {
-            g_numWaypoints = 0;
-            CenterPrint("Waypoint version is too high, update your ebot!");
-            sprintf(m_infoBuffer, "Waypoint version is too high, update your ebot!");
+            AddLogEntry(Log::Error, "Could not find valid cURL version");
+            return false;
         }
-        else if (header.fileVersion == static_cast<int32_t>(FV_WAYPOINT))
-        {
-            g_numWaypoints = header.pointNumber;
-            m_paths.Resize(g_numWaypoints, true);
 
-            Path paths[g_numWaypoints];
-            if (Compressor::Uncompress(pathtofl, sizeof(WaypointHeader), reinterpret_cast<uint8_t*>(paths), g_numWaypoints * sizeof(Path)) != -1)
-            {
-                for (i = 0; i < g_numWaypoints; i++)
-                {
-                    Sort(i, paths[i].index);
-                    m_paths.Push(paths[i]);
-                }
-            }
-        }
-        else if (header.fileVersion == static_cast<int32_t>(126))
-        {
-            g_numWaypoints = header.pointNumber;
-            m_paths.Resize(g_numWaypoints, true);
+        curlReady = true;
+    }
+#endif
+
+    WaypointDownload* job = new(std::nothrow) WaypointDownload;
+    if (!job)
+        return false;
+
+    // built from cvars, a path that doesn't fit is refused instead of cut, the worker
+    // still has to append ".part" and "<map>.ref.part" to the file and cache paths
+    const int urlLength = snprintf(job->url, sizeof(job->url), "%s/%s.ewp", ebot_download_waypoints_from.GetString(), mapName);
+    const int targetLength = snprintf(job->targetFile, sizeof(job->targetFile), "%s%s.ewp", GetWaypointDir(), mapName);
+    int cacheLength;
+    if (ebot_download_cache.GetString()[0])
+        cacheLength = snprintf(job->cacheDir, sizeof(job->cacheDir), "%s/", ebot_download_cache.GetString());
+    else
+        cacheLength = snprintf(job->cacheDir, sizeof(job->cacheDir), "%scache/", GetWaypointDir());
+
+    const int suffixLength = static_cast<int>(sizeof(job->mapName)) + 16;
+    if (urlLength < 0 || urlLength >= static_cast<int>(sizeof(job->url)) ||
+        targetLength < 0 || targetLength + suffixLength >= static_cast<int>(sizeof(job->targetFile)) ||
+        cacheLength < 0 || cacheLength + suffixLength >= static_cast<int>(sizeof(job->cacheDir)))
+    {
+        AddLogEntry(Log::Error, "Waypoint download url or path is too long");
+        delete job;
+        return false;
+    }
+
+    ::CreatePath(job->cacheDir);
+    cstrncpy(job->mapName, mapName, sizeof(job->mapName) - 1);
+    job->timeout = cmax(ebot_download_timeout.GetInt(), 1);
+
+    // a cancelled worker may still be finishing its transfer, UpdateDownload launches this one after it
+    s_download = job;
+    LaunchDownload(job);
+    ServerPrint("Downloading waypoints from %s", job->url);
+    return true;
+}
+
+bool Waypoint::IsDownloading(void)
+{
+    return s_download != nullptr;
+}
+
+// forgets the running download and tells the worker to stop, the worker frees the job when it returns
+void Waypoint::CancelDownload(void)
+{
+    if (!s_download)
+        return;
+
+    s_download->cancel.store(true);
+    ReleaseDownload(s_download);
+    s_download = nullptr;
+}
+
+// cancels and waits for the worker, nothing of the plugin may still run on it once it unloads
+// curl stops within a second, wget and UrlMon can't be interrupted and run until ebot_download_timeout
+void Waypoint::StopDownload(void)
+{
+    CancelDownload();
+    if (!s_downloadThread.joinable())
+        return;
+
+    s_downloadThread.join();
+    ReleaseDownload(s_downloadWorker);
+    s_downloadWorker = nullptr;
+}
+
+// polled every frame, swaps the waypoints in at the start of a frame once the file is there
+void Waypoint::UpdateDownload(void)
+{
+    if (!s_download)
+        return;
+
+    WaypointDownload* job = s_download;
+    if (!job->launched)
+    {
+        LaunchDownload(job);
+        return;
+    }
+
+    // the worker owns job->error until it leaves the running state
+    char timedOut[64];
+    const char* error = job->error;
+    const DownloadState state = job->state;
+    if (state == DownloadState::Running)
+    {
+        if (GetRealTime() < job->deadline)
+            return;
+
+        snprintf(timedOut, sizeof(timedOut), "timed out after %d seconds", job->timeout);
+        error = timedOut;
+    }
+
+    const bool result = state == DownloadState::Done;
+    if (!result)
+    {
+        AddLogEntry(Log::Error, "Downloading '%s' waypoint file failed: %s", job->mapName, error);
+        cstrncpy(s_downloadFailed, job->mapName, sizeof(s_downloadFailed) - 1);
+    }
+    else
+        ServerPrint("%s.ewp is %s", job->mapName, job->fromCache ? "copied from the download cache" : "downloaded from the internet");
+
+    const bool currentMap = !cstrcmp(job->mapName, GetMapName());
+    CancelDownload();
+
+    // someone might have started making waypoints in the meantime
+    if (!currentMap || g_numWaypoints > 0)
+        return;
+
+    // a failed download runs through load again for the analyzer fallback
+    Initialize();
+    if (Load() && result)
+        sprintf(m_infoBuffer, "%s.ewp is downloaded from the internet", GetMapName());
+
+    for (const auto& bot : g_botManager->m_bots)
+    {
+        if (bot)
+            bot->NewRound();
+    }
+}
+
+// maps a whole file read only, handle is needed to unmap it again
+static uint8_t* MapFile(const char* fileName, size_t& size, void*& handle)
+{
+    size = 0;
+    handle = nullptr;
+
+#ifdef PLATFORM_WIN32
+    const HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    size = static_cast<size_t>(GetFileSize(file, nullptr));
+    const HANDLE mapping = size ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (!mapping)
+        return nullptr;
+
+    uint8_t* data = reinterpret_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    handle = mapping;
+    return data;
+#else
+    const int file = open(fileName, O_RDONLY);
+    if (file == -1)
+        return nullptr;
+
+    struct stat info;
+    if (fstat(file, &info) == -1 || info.st_size <= 0)
+    {
+        close(file);
+        return nullptr;
+    }
+
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    return reinterpret_cast<uint8_t*>(mapping);
+#endif
+}
+
+static void UnmapFile(void* data, const size_t size, void* handle)
+{
+    if (!data)
+        return;
+
+#ifdef PLATFORM_WIN32
+    (void)size; // the view is unmapped whole
+    UnmapViewOfFile(data);
+    CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+    (void)handle; // mmap has no mapping handle to close
+    munmap(data, size);
+#endif
+}
+
+inline uint32_t AlignFileOffset(const size_t offset)
+{
+    return static_cast<uint32_t>((offset + 15) & ~static_cast<size_t>(15));
+}
+
+// version 128 files are mapped and validated, the links are already sorted so nodes go straight into m_paths
+bool Waypoint::LoadPaths(const char* fileName)
+{
+    size_t size;
+    void* handle;
+    uint8_t* data = MapFile(fileName, size, handle);
+    if (!data)
+        return false;
+
+    const size_t dataStart = sizeof(WaypointHeader) + sizeof(WaypointFileInfo);
+    const WaypointHeader* header = reinterpret_cast<const WaypointHeader*>(data);
+    const WaypointFileInfo* info = reinterpret_cast<const WaypointFileInfo*>(data + sizeof(WaypointHeader));
+
+    bool valid = size >= dataStart && header->pointNumber > 0 && header->pointNumber <= Const_MaxWaypoints && !(info->flags & ~WFILE_COMPRESSED);
+
+    // the sections must be exactly what Save lays out for that many waypoints, before anything is allocated from the header
+    const size_t count = valid ? static_cast<size_t>(header->pointNumber) : 0;
+    valid = valid && info->dataSize == AlignFileOffset(AlignFileOffset(dataStart) + count * sizeof(WaypointFileNode)) + count * sizeof(WaypointFileLinks) - dataStart;
+
+    // packed sections are unpacked to the heap, the offsets still describe the uncompressed layout
+    const uint8_t* sections = data + dataStart;
+    uint8_t* unpacked = nullptr;
+    if (valid && (info->flags & WFILE_COMPRESSED))
+    {
+        safeloc(unpacked, cmax(info->dataSize, 1u));
+        valid = StreamCodec::Unpack(sections, size - dataStart, unpacked, info->dataSize) == static_cast<int64_t>(info->dataSize);
+        sections = unpacked;
+    }
+    else if (valid)
+        valid = dataStart + info->dataSize == size;
+
+    if (valid)
+    {
+        const size_t end = dataStart + info->dataSize;
+        valid = info->nodeOffset >= dataStart && info->nodeOffset + count * sizeof(WaypointFileNode) <= end &&
+            info->linkOffset >= dataStart && info->linkOffset + count * sizeof(WaypointFileLinks) <= end &&
+            HashBuffer(sections, info->dataSize) == info->checksum;
+    }
+
+    if (!valid)
+    {
+        safedel(unpacked);
+        UnmapFile(data, size, handle);
+        AddLogEntry(Log::Error, "Waypoint file '%s' is damaged", fileName);
+        return false;
+    }
+
+    g_numWaypoints = header->pointNumber;
+    m_paths.Resize(g_numWaypoints, true);
+
+    const WaypointFileNode* nodes = reinterpret_cast<const WaypointFileNode*>(sections + info->nodeOffset - dataStart);
+    const WaypointFileLinks* links = reinterpret_cast<const WaypointFileLinks*>(sections + info->linkOffset - dataStart);
+
+    int i;
+    Path path;
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        path.origin = nodes[i].origin;
+        path.flags = nodes[i].flags;
+        path.gravity = nodes[i].gravity;
+        path.radius = nodes[i].radius;
+        path.mesh = nodes[i].mesh;
+        cmemcpy(path.index, links[i].index, sizeof(path.index));
+        cmemcpy(path.connectionFlags, links[i].connectionFlags, sizeof(path.connectionFlags));
+        m_paths.Push(path);
+    }
+
+    safedel(unpacked);
+    UnmapFile(data, size, handle);
+    return true;
+}
+
+static int8_t tryLoad;
+bool Waypoint::Load(void)
+{
+    MEMORY_TAG(Mem_Waypoints);
+
+    Initialize();
+    safedel(m_waypointDisplayTime);
+
+    int i;
+    bool convert = false;
+    const char* pathtofl = CheckSubfolderFile();
+    File fp(pathtofl, "rb");
+    if (fp.IsValid())
+    {
+        WaypointHeader header;
+        fp.Read(&header, sizeof(header));
+
+        if (header.fileVersion > static_cast<int32_t>(FV_WAYPOINT))
+        {
+            g_numWaypoints = 0;
+            CenterPrint("Waypoint version is too high, update your ebot!");
+            sprintf(m_infoBuffer, "Waypoint version is too high, update your ebot!");
+        }
+        else if (header.fileVersion == static_cast<int32_t>(FV_WAYPOINT))
+        {
+            if (!LoadPaths(pathtofl))
+                g_numWaypoints = 0;
+        }
+        else if (header.fileVersion == static_cast<int32_t>(FV_WAYPOINT_LZSS))
+        {
+            g_numWaypoints = cclamp(header.pointNumber, 0, Const_MaxWaypoints);
+            m_paths.Resize(g_numWaypoints, true);
+
+            // on the heap, big files overflowed the stack
+            Path* paths = nullptr;
+            safeloc(paths, cmax(g_numWaypoints, 1));
+            if (Compressor::Uncompress(pathtofl, sizeof(WaypointHeader), reinterpret_cast<uint8_t*>(paths), g_numWaypoints * sizeof(Path)) != -1)
+            {
+                for (i = 0; i < g_numWaypoints; i++)
+                {
+                    Sort(i, paths[i].index);
+                    m_paths.Push(paths[i]);
+                }
+            }
+            else
+                g_numWaypoints = 0;
+
+            safedel(paths);
+        }
+        else if (header.fileVersion == static_cast<int32_t>(126))
+        {
+            g_numWaypoints = header.pointNumber;
+            m_paths.Resize(g_numWaypoints, true);
 
             Path path;
             for (i = 0; i < g_numWaypoints; i++)
@@ -1679,8 +2890,6 @@ bool Waypoint::Load(void)
                 Sort(i, path.index);
                 m_paths.Push(path);
             }
-
-            Save();
         }
 
         if (cstrncmp(header.author, "EfeDursun125", 12) == 0)
@@ -1690,14 +2899,17 @@ bool Waypoint::Load(void)
 
         fp.Close();
         tryLoad = 0;
-        tryDownload = 0;
+
+        // convert older versions once, the next loads only map the file
+        convert = header.fileVersion < static_cast<int32_t>(FV_WAYPOINT) && g_numWaypoints > 0;
     }
-    else if (tryDownload < 5 && ebot_download_waypoints.GetBool() && Download())
+    else if (ebot_download_waypoints.GetBool() && StartDownload())
     {
-        Load();
-        sprintf(m_infoBuffer, "%s.ewp is downloaded from the internet", GetMapName());
+        // bots idle without waypoints until UpdateDownload swaps the file in
+        g_numWaypoints = 0;
         tryLoad = 0;
-        tryDownload = 0;
+        sprintf(m_infoBuffer, "%s.ewp is downloading from the internet", GetMapName());
+        return false;
     }
     else
     {
@@ -1720,10 +2932,8 @@ bool Waypoint::Load(void)
 
         if (tryLoad >= 5 && ebot_analyze_auto_start.GetBool())
         {
-            g_waypoint->CreateBasic();
-            g_analyzewaypoints = true;
+            StartAnalyze(true);
             tryLoad = 0;
-            tryDownload = 0;
         }
         else
         {
@@ -1734,6 +2944,24 @@ bool Waypoint::Load(void)
         return false;
     }
 
+    m_pathDisplayTime = 0.0f;
+    m_arrowDisplayTime = 0.0f;
+
+    // only in lan game
+    if (g_numWaypoints > 2 && !IsDedicatedServer())
+        safeloc(m_waypointDisplayTime, g_numWaypoints);
+
+    // a successful save refreshes everything itself
+    if (!convert || !Save())
+        RefreshDerivedData();
+
+    return true;
+}
+
+// rebuilds whatever is derived from the waypoints in place, only valid for what is on the disk
+// since the tables are keyed by the file hash, so edits go through Save instead of a reload
+void Waypoint::RefreshDerivedData(void)
+{
     m_terrorPoints.Destroy();
     m_ctPoints.Destroy();
     m_goalPoints.Destroy();
@@ -1742,24 +2970,31 @@ bool Waypoint::Load(void)
     m_zmHmPoints.Destroy();
     m_hmMeshPoints.Destroy();
 
+    DestroyPathMatrix();
+    DestroyVisibility();
+    DestroyClusters();
+    ResetGroundChecks();
+
     g_waypointsChanged = false;
-    m_pathDisplayTime = 0.0f;
-    m_arrowDisplayTime = 0.0f;
     g_botManager->InitQuota();
+    BuildGrid();
+    m_hotDirty = true;
 
     if (g_numWaypoints > 2)
     {
-        // only in lan game
-        if (!IsDedicatedServer())
-            safeloc(m_waypointDisplayTime, g_numWaypoints);
-
         InitTypes();
-    }
+        BuildClusters();
 
-    return true;
+        // derived tables are only rebuilt when the waypoint file is changed
+        m_waypointHash = HashWaypointFile(CheckSubfolderFile());
+        if (!LoadTables())
+            StartPathMatrix();
+
+        StartVisibility();
+    }
 }
 
-void Waypoint::Save(void)
+bool Waypoint::Save(void)
 {
     WaypointHeader header;
     cmemset(header.header, 0, sizeof(header.header));
@@ -1791,6 +3026,52 @@ void Waypoint::Save(void)
     header.fileVersion = FV_WAYPOINT;
     header.pointNumber = g_numWaypoints;
 
+    // nodes and links go to their own sections, links nearest first with their flags
+    WaypointFileInfo info;
+    const size_t dataStart = sizeof(WaypointHeader) + sizeof(WaypointFileInfo);
+    info.nodeOffset = AlignFileOffset(dataStart);
+    info.linkOffset = AlignFileOffset(info.nodeOffset + g_numWaypoints * sizeof(WaypointFileNode));
+    info.dataSize = static_cast<uint32_t>(info.linkOffset + g_numWaypoints * sizeof(WaypointFileLinks) - dataStart);
+
+    uint8_t* data = nullptr;
+    safeloc(data, info.dataSize);
+
+    WaypointFileNode* nodes = reinterpret_cast<WaypointFileNode*>(data + info.nodeOffset - dataStart);
+    WaypointFileLinks* links = reinterpret_cast<WaypointFileLinks*>(data + info.linkOffset - dataStart);
+
+    int i, j, k;
+    float distance[Const_MaxPathIndex];
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        const Path& path = m_paths[i];
+        nodes[i].origin = path.origin;
+        nodes[i].flags = path.flags;
+        nodes[i].gravity = path.gravity;
+        nodes[i].radius = path.radius;
+        nodes[i].mesh = path.mesh;
+
+        for (j = 0; j < Const_MaxPathIndex; j++)
+        {
+            // insertion sort, empty slots last
+            const int16_t index = path.index[j];
+            const float dist = IsValidWaypoint(index) ? (m_paths[index].origin - path.origin).GetLengthSquared() : FLT_MAX;
+            for (k = j; k > 0 && distance[k - 1] > dist; k--)
+            {
+                distance[k] = distance[k - 1];
+                links[i].index[k] = links[i].index[k - 1];
+                links[i].connectionFlags[k] = links[i].connectionFlags[k - 1];
+            }
+
+            distance[k] = dist;
+            links[i].index[k] = IsValidWaypoint(index) ? index : -1;
+            links[i].connectionFlags[k] = IsValidWaypoint(index) ? path.connectionFlags[j] : 0;
+        }
+    }
+
+    info.checksum = HashBuffer(data, info.dataSize);
+    if (ebot_waypoint_compress.GetBool())
+        info.flags |= WFILE_COMPRESSED;
+
     File fp(waypointFilePath, "wb");
 
     // file was opened
@@ -1798,17 +3079,22 @@ void Waypoint::Save(void)
     {
         // write the waypoint header to the file...
         fp.Write(&header, sizeof(header), 1);
+        fp.Write(&info, sizeof(info), 1);
 
-        int i;
-        Path paths[g_numWaypoints];
-        for (i = 0; i < g_numWaypoints; i++)
+        bool written;
+        if (info.flags & WFILE_COMPRESSED)
         {
-            paths[i] = m_paths[i];
-            Sort(i, paths[i].index);
+            StreamCompressor* stream = nullptr;
+            safeloc(stream, 1);
+            stream->Begin(&fp);
+            written = stream->Write(data, static_cast<int>(info.dataSize)) && stream->Finish();
+            safedel(stream);
         }
+        else
+            written = fp.Write(data, static_cast<int>(info.dataSize), 1) == 1;
 
-        i = Compressor::Compress(waypointFilePath, reinterpret_cast<uint8_t*>(&header), sizeof(WaypointHeader), reinterpret_cast<uint8_t*>(paths), g_numWaypoints * sizeof(Path));
-        if (i == 1)
+        fp.Close();
+        if (!written)
         {
             ServerPrint("Error: Cannot Save Waypoints");
             CenterPrint("Error: Cannot save waypoints!");
@@ -1820,10 +3106,107 @@ void Waypoint::Save(void)
             CenterPrint("Waypoints are saved!");
         }
 
-        fp.Close();
+        safedel(data);
+
+        // the file on disk is current again, no reload needed
+        if (written)
+            RefreshDerivedData();
+
+        return written;
     }
-    else
-        AddLogEntry(Log::Error, "Error writing '%s' waypoint file", GetMapName());
+
+    AddLogEntry(Log::Error, "Error writing '%s' waypoint file", GetMapName());
+    safedel(data);
+    return false;
+}
+
+// compares the old lzss codec with the stream codec on the loaded waypoints, through a scratch file like a real save
+void Waypoint::BenchmarkCompression(void)
+{
+    if (g_numWaypoints < 1)
+    {
+        ServerPrint("No waypoints to compress");
+        return;
+    }
+
+    char fileName[1024];
+    FormatBuffer(fileName, "%s%s.bench", GetWaypointDir(), GetMapName());
+
+    const int size = g_numWaypoints * static_cast<int>(sizeof(Path));
+    const int runs = 5;
+
+    uint8_t* source = nullptr;
+    uint8_t* check = nullptr;
+    safeloc(source, size);
+    safeloc(check, size);
+
+    int i;
+    for (i = 0; i < g_numWaypoints; i++)
+        cmemcpy(source + i * sizeof(Path), &m_paths[i], sizeof(Path));
+
+    WaypointHeader header;
+    double start, encodeTime = 0.0, decodeTime = 0.0;
+    int packed = 0;
+    bool valid = true;
+
+    for (i = 0; i < runs; i++)
+    {
+        start = GetRealTime();
+        Compressor::Compress(fileName, reinterpret_cast<uint8_t*>(&header), sizeof(header), source, size);
+        encodeTime += GetRealTime() - start;
+
+        start = GetRealTime();
+        valid &= Compressor::Uncompress(fileName, sizeof(header), check, size) == size;
+        decodeTime += GetRealTime() - start;
+    }
+
+    File fp(fileName, "rb");
+    packed = fp.IsValid() ? fp.GetSize() - static_cast<int>(sizeof(header)) : 0;
+    fp.Close();
+
+    const float megabytes = static_cast<float>(size) * static_cast<float>(runs) / (1024.0f * 1024.0f);
+    valid &= !cmemcmp(source, check, size);
+    ServerPrint("lzss: %d -> %d bytes (%.1f%%), encode %.2f MB/s, decode %.2f MB/s%s", size, packed, 100.0f * static_cast<float>(packed) / static_cast<float>(size),
+        megabytes / static_cast<float>(encodeTime), megabytes / static_cast<float>(decodeTime), valid ? "" : ", round trip failed");
+
+    StreamCompressor* encoder = nullptr;
+    StreamDecompressor* decoder = nullptr;
+    safeloc(encoder, 1);
+    safeloc(decoder, 1);
+
+    encodeTime = decodeTime = 0.0;
+    valid = true;
+
+    for (i = 0; i < runs; i++)
+    {
+        start = GetRealTime();
+        File out(fileName, "wb");
+        out.Write(&header, sizeof(header), 1);
+        encoder->Begin(&out);
+        valid &= encoder->Write(source, size) && encoder->Finish();
+        out.Close();
+        encodeTime += GetRealTime() - start;
+
+        cmemset(check, 0, size);
+        start = GetRealTime();
+        File in(fileName, "rb");
+        in.Seek(sizeof(header), SEEK_SET);
+        decoder->Begin(&in);
+        valid &= decoder->Read(check, size) == size;
+        in.Close();
+        decodeTime += GetRealTime() - start;
+    }
+
+    packed = static_cast<int>(encoder->GetPackedSize());
+    valid &= !cmemcmp(source, check, size);
+    ServerPrint("stream: %d -> %d bytes (%.1f%%), encode %.2f MB/s, decode %.2f MB/s%s", size, packed, 100.0f * static_cast<float>(packed) / static_cast<float>(size),
+        megabytes / static_cast<float>(encodeTime), megabytes / static_cast<float>(decodeTime), valid ? "" : ", round trip failed");
+
+    safedel(encoder);
+    safedel(decoder);
+    safedel(source);
+    safedel(check);
+    unlink(fileName);
 }
 
 const char* Waypoint::CheckSubfolderFile(void)
@@ -2117,6 +3500,8 @@ void Waypoint::Think(void)
     if (FNullEnt(g_hostEntity))
         return;
 
+    // waypoints can be edited in many ways from here, rebuild the hot data on the next search
+    m_hotDirty = true;
     ShowWaypointMsg();
 
     float nearestDistance = FLT_MAX;
@@ -2361,264 +3746,1271 @@ void Waypoint::ShowWaypointMsg(void)
             m_arrowDisplayTime = 0.0f;
     }
 
-    // create path pointer for faster access
-    Path* path = &m_paths[nearestIndex];
-    if (!path)
-        return;
+    // create path pointer for faster access
+    Path* path = &m_paths[nearestIndex];
+    if (!path)
+        return;
+
+    // draw a paths, camplines and danger directions for nearest waypoint
+    if (nearestDistance < squaredf(2048) && m_pathDisplayTime < engine->GetTime())
+    {
+        m_pathDisplayTime = engine->GetTime() + 1.0f;
+
+        // draw the connections
+        int i;
+        for (i = 0; i < Const_MaxPathIndex; i++)
+        {
+            if (path->index[i] == -1)
+                continue;
+
+            // jump connection
+            if (path->connectionFlags[i] & PATHFLAG_JUMP)
+                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(255, 0, 0, 255), 5, 0, 0, 10);
+            else if (path->connectionFlags[i] & PATHFLAG_DOUBLE) // boosting friend connection
+                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(0, 0, 255, 255), 5, 0, 0, 10);
+            else if (IsConnected(path->index[i], nearestIndex)) // twoway connection
+                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(255, 255, 0, 255), 5, 0, 0, 10);
+            else // oneway connection
+                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(250, 250, 250, 255), 5, 0, 0, 10);
+        }
+
+        // now look for oneway incoming connections
+        for (i = 0; i < g_numWaypoints; i++)
+        {
+            if (IsConnected(i, nearestIndex) && !IsConnected(nearestIndex, i))
+                engine->DrawLine(g_hostEntity, path->origin, m_paths[i].origin, Color(0, 192, 96, 255), 5, 0, 0, 10);
+        }
+
+        // draw the radius circle
+        const Vector origin = (path->flags & WAYPOINT_CROUCH) ? path->origin : path->origin - Vector(00.0f, 00.0f, 18.0f);
+
+        // if radius is nonzero, draw a square
+        if (path->radius > 4)
+        {
+            const float root = static_cast<float>(path->radius);
+            const Color& def = Color(0, 0, 255, 255);
+
+            engine->DrawLine(g_hostEntity, origin + Vector(root, root, 0.0f), origin + Vector(-root, root, 0.0f), def, 5, 0, 0, 10);
+            engine->DrawLine(g_hostEntity, origin + Vector(root, root, 0.0f), origin + Vector(root, -root, 0.0f), def, 5, 0, 0, 10);
+            engine->DrawLine(g_hostEntity, origin + Vector(-root, -root, 0.0f), origin + Vector(root, -root, 0.0f), def, 5, 0, 0, 10);
+            engine->DrawLine(g_hostEntity, origin + Vector(-root, -root, 0.0f), origin + Vector(-root, root, 0.0f), def, 5, 0, 0, 10);
+        }
+        else
+        {
+            const float root = 5.0f;
+            const Color& def = Color(0, 0, 255, 255);
+
+            engine->DrawLine(g_hostEntity, origin + Vector(root, -root, 0.0f), origin + Vector(-root, root, 0.0f), def, 5, 0, 0, 10);
+            engine->DrawLine(g_hostEntity, origin + Vector(-root, -root, 0.0f), origin + Vector(root, root, 0.0f), def, 5, 0, 0, 10);
+        }
+
+        // display some information
+        char tempMessage[4096];
+        int length;
+
+        // show the information about that point
+        if (path->flags & WAYPOINT_SPECIFICGRAVITY)
+        {
+            length = sprintf(tempMessage, "\n\n\n\n\n\n\n    Waypoint Information:\n\n"
+                "      Waypoint %d of %d, Radius: %d\n"
+                "      Flags: %s\n\n      %s %f\n      Waypoint Gravity: %f", nearestIndex, g_numWaypoints, path->radius, GetWaypointInfo(nearestIndex), "Your Gravity:", (g_hostEntity->v.gravity * 800.0f), path->gravity);
+        }
+        else if (path->flags & WAYPOINT_ZMHMCAMP || path->flags & WAYPOINT_HMCAMPMESH)
+        {
+            length = sprintf(tempMessage, "\n\n\n\n\n\n\n    Waypoint Information:\n\n"
+                "      Waypoint %d of %d, Radius: %d\n"
+                "      Flags: %s\n\n      %s %d\n", nearestIndex, g_numWaypoints, path->radius, GetWaypointInfo(nearestIndex), "Human Camp Mesh ID:", static_cast<int> (path->mesh));
+        }
+        else
+        {
+            length = sprintf(tempMessage, "\n\n\n\n\n\n\n    Waypoint Information:\n\n"
+                "      Waypoint %d of %d, Radius: %d\n"
+                "      Flags: %s\n\n", nearestIndex, g_numWaypoints, path->radius, GetWaypointInfo(nearestIndex));
+        }
+
+        // check if we need to show the cached point index
+        if (m_cacheWaypointIndex != -1)
+        {
+            length += sprintf(&tempMessage[length], "\n    Cached Waypoint Information:\n\n"
+                "      Waypoint %d of %d, Radius: %d\n"
+                "      Flags: %s\n", m_cacheWaypointIndex, g_numWaypoints, m_paths[m_cacheWaypointIndex].radius, GetWaypointInfo(m_cacheWaypointIndex), (!(m_paths[m_cacheWaypointIndex].flags & WAYPOINT_HMCAMPMESH) && !(m_paths[m_cacheWaypointIndex].flags & WAYPOINT_ZMHMCAMP)) ? "" : "Mesh ID: %d", static_cast<int>(m_paths[m_cacheWaypointIndex].mesh));
+        }
+
+        // check if we need to show the facing point index, only if no menu to show
+        if (m_facingAtIndex != -1 && !g_clients[ENTINDEX(g_hostEntity) - 1].menu)
+        {
+            length += sprintf(&tempMessage[length], "\n    Facing Waypoint Information:\n\n"
+                "      Waypoint %d of %d, Radius: %d\n"
+                "      Flags: %s\n", m_facingAtIndex, g_numWaypoints, m_paths[m_facingAtIndex].radius, GetWaypointInfo(m_facingAtIndex));
+        }
+
+        // draw entire message
+        MESSAGE_BEGIN(MSG_ONE_UNRELIABLE, SVC_TEMPENTITY, nullptr, g_hostEntity);
+        WRITE_BYTE(TE_TEXTMESSAGE);
+        WRITE_BYTE(4); // channel
+        WRITE_SHORT(FixedSigned16(0, 1 << 13)); // x
+        WRITE_SHORT(FixedSigned16(0, 1 << 13)); // y
+        WRITE_BYTE(0); // effect
+        WRITE_BYTE(255); // r1
+        WRITE_BYTE(255); // g1
+        WRITE_BYTE(255); // b1
+        WRITE_BYTE(1); // a1
+        WRITE_BYTE(255); // r2
+        WRITE_BYTE(255); // g2
+        WRITE_BYTE(255); // b2
+        WRITE_BYTE(255); // a2
+        WRITE_SHORT(0); // fadeintime
+        WRITE_SHORT(0); // fadeouttime
+        WRITE_SHORT(FixedUnsigned16(1.1f, 1 << 8)); // holdtime
+        WRITE_STRING(tempMessage);
+        MESSAGE_END();
+    }
+    else if (m_pathDisplayTime + 2.0f > engine->GetTime()) // what???
+        m_pathDisplayTime = 0.0f;
+}
+
+bool Waypoint::IsConnected(const int index)
+{
+    int i;
+    int j;
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        if (i != index)
+        {
+            for (j = 0; j < Const_MaxPathIndex; j++)
+            {
+                if (m_paths[i].index[j] == index)
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool Waypoint::NodesValid(void)
+{
+    int terrPoints = 0;
+    int ctPoints = 0;
+    int goalPoints = 0;
+    int rescuePoints = 0;
+    int connections;
+    int i, j, k;
+
+    bool haveError = false;
+
+    for (i = 0; i < g_numWaypoints; i++)
+    {
+        connections = 0;
+
+        for (j = 0; j < Const_MaxPathIndex; j++)
+        {
+            if (m_paths[i].index[j] != -1)
+            {
+                if (m_paths[i].index[j] > g_numWaypoints)
+                {
+                    AddLogEntry(Log::Warning, "Waypoint %d connected with invalid Waypoint #%d!", i, m_paths[i].index[j]);
+                    (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
+                    haveError = true;
+                }
+
+                connections++;
+                break;
+            }
+        }
+
+        if (!connections)
+        {
+            if (!IsConnected(i))
+            {
+                AddLogEntry(Log::Warning, "Waypoint %d isn't connected with any other Waypoint!", i);
+                (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
+                haveError = true;
+            }
+        }
+
+        if (GetGameMode() == GameMode::Original)
+        {
+            if (m_paths[i].flags & WAYPOINT_TERRORIST)
+                terrPoints++;
+            else if (m_paths[i].flags & WAYPOINT_COUNTER)
+                ctPoints++;
+            else if (m_paths[i].flags & WAYPOINT_GOAL)
+                goalPoints++;
+            else if (m_paths[i].flags & WAYPOINT_RESCUE)
+                rescuePoints++;
+        }
+
+        for (k = 0; k < Const_MaxPathIndex; k++)
+        {
+            if (m_paths[i].index[k] != -1)
+            {
+                if (m_paths[i].index[k] >= g_numWaypoints || m_paths[i].index[k] < -1)
+                {
+                    AddLogEntry(Log::Warning, "Waypoint %d - Pathindex %d out of Range!", i, k);
+                    (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
+
+                    g_waypointOn = true;
+                    g_editNoclip = true;
+
+                    haveError = true;
+                }
+                else if (m_paths[i].index[k] == i)
+                {
+                    AddLogEntry(Log::Warning, "Waypoint %d - Pathindex %d points to itself!", i, k);
+                    (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
+
+                    g_waypointOn = true;
+                    g_editNoclip = true;
+
+                    haveError = true;
+                }
+            }
+        }
+    }
+
+    if (g_mapType == MAP_CS && GetGameMode() == GameMode::Original)
+    {
+        if (!rescuePoints)
+        {
+            AddLogEntry(Log::Warning, "You didn't set a Rescue Point!");
+            haveError = true;
+        }
+    }
+
+    if (!terrPoints && GetGameMode() == GameMode::Original)
+    {
+        AddLogEntry(Log::Warning, "You didn't set any Terrorist Important Point!");
+        haveError = true;
+    }
+    else if (!ctPoints && GetGameMode() == GameMode::Original)
+    {
+        AddLogEntry(Log::Warning, "You didn't set any CT Important Point!");
+        haveError = true;
+    }
+    else if (!goalPoints && GetGameMode() == GameMode::Original)
+    {
+        AddLogEntry(Log::Warning, "You didn't set any Goal Point!");
+        haveError = true;
+    }
+
+    CenterPrint("Waypoints are saved!");
+    return haveError ? false : true;
+}
+
+// returns squared travel distance, uses the path matrix if we have one, straight line otherwise
+float Waypoint::GetPathDistance(const int srcIndex, const int destIndex)
+{
+    if (srcIndex == -1 || destIndex == -1)
+        return FLT_MAX;
+
+    if (HasPathMatrix())
+    {
+        const uint16_t distance = m_distMatrix[srcIndex * m_matrixSize + destIndex];
+        if (distance == Const_MatrixUnreachable)
+            return FLT_MAX;
+
+        return squaredf(static_cast<float>(distance) / Const_MatrixScale);
+    }
+
+    return (m_paths[srcIndex].origin - m_paths[destIndex].origin).GetLengthSquared();
+}
+
+// returns the first waypoint on the shortest path from source to destination, -1 if not reachable
+int Waypoint::GetNextHop(const int srcIndex, const int destIndex)
+{
+    if (!HasPathMatrix() || !IsValidWaypoint(srcIndex) || !IsValidWaypoint(destIndex))
+        return -1;
+
+    return m_nextHop[srcIndex * m_matrixSize + destIndex];
+}
+
+bool Waypoint::HasPathMatrix(void)
+{
+    return m_distMatrix && m_nextHop && m_matrixSize == g_numWaypoints && !g_waypointsChanged;
+}
+
+struct MatrixHeapNode
+{
+    float cost;
+    int16_t index;
+};
+
+// binary min heap helpers shared by the table builders
+inline void HeapPush(MatrixHeapNode* heap, int& heapSize, const float cost, const int16_t index)
+{
+    int current = heapSize++;
+    int parent;
+    heap[current].cost = cost;
+    heap[current].index = index;
+    while (current)
+    {
+        parent = (current - 1) / 2;
+        if (heap[parent].cost <= heap[current].cost)
+            break;
+
+        cswap(heap[parent], heap[current]);
+        current = parent;
+    }
+}
+
+inline MatrixHeapNode HeapPop(MatrixHeapNode* heap, int& heapSize)
+{
+    const MatrixHeapNode node = heap[0];
+    heap[0] = heap[--heapSize];
+
+    int current = 0;
+    int child;
+    while ((child = current * 2 + 1) < heapSize)
+    {
+        if (child + 1 < heapSize && heap[child + 1].cost < heap[child].cost)
+            child++;
+
+        if (heap[current].cost <= heap[child].cost)
+            break;
+
+        cswap(heap[current], heap[child]);
+        current = child;
+    }
+
+    return node;
+}
+
+// a path matrix being built by the workers, they only ever see this copy of the graph
+struct MatrixBuild
+{
+    int size{};
+    Vector* origin{};
+    int16_t* links{}; // Const_MaxPathIndex for each waypoint
+    uint16_t* dist{};
+    int16_t* nextHop{};
+    std::atomic <int> nextRow{};
+    std::atomic <int> rowsDone{};
+    std::atomic <bool> cancel{};
+    std::atomic <bool> failed{};
+    int refs{}; // main thread and every worker job, only touched on the main thread
+};
+
+static MatrixBuild* s_matrixBuild;
+
+static void ReleaseMatrixBuild(MatrixBuild* build)
+{
+    if (--build->refs > 0)
+        return;
+
+    safedel(build->origin);
+    safedel(build->links);
+    safedel(build->dist);
+    safedel(build->nextHop);
+    delete build;
+}
+
+// runs dijkstra for rows nobody took yet, until they run out, the deadline passes or the build is cancelled
+// safe on any thread, it never leaves the build
+static void BuildMatrixRows(MatrixBuild* build, const double deadline)
+{
+    const int size = build->size;
+    const int heapCapacity = size * Const_MaxPathIndex + 1;
+
+    // every edge can push once, so this is enough for lazy deletion
+    MatrixHeapNode* heap = new(std::nothrow) MatrixHeapNode[heapCapacity];
+    float* cost = new(std::nothrow) float[size];
+    int16_t* firstHop = new(std::nothrow) int16_t[size];
+    if (!heap || !cost || !firstHop)
+    {
+        build->failed.store(true);
+        safedel(heap);
+        safedel(cost);
+        safedel(firstHop);
+        return;
+    }
+
+    int src, i, j, heapSize;
+    int16_t self;
+    float f;
+    MatrixHeapNode node;
+    const int16_t* links;
+    while (!build->cancel.load(std::memory_order_relaxed))
+    {
+        src = build->nextRow.fetch_add(1);
+        if (src >= size)
+            break;
+
+        for (i = 0; i < size; i++)
+        {
+            cost[i] = FLT_MAX;
+            firstHop[i] = -1;
+        }
+
+        cost[src] = 0.0f;
+        firstHop[src] = static_cast<int16_t>(src);
+        heap[0].cost = 0.0f;
+        heap[0].index = static_cast<int16_t>(src);
+        heapSize = 1;
+
+        while (heapSize)
+        {
+            node = HeapPop(heap, heapSize);
+
+            // outdated entry
+            if (node.cost > cost[node.index])
+                continue;
+
+            links = build->links + node.index * Const_MaxPathIndex;
+            for (j = 0; j < Const_MaxPathIndex; j++)
+            {
+                self = links[j];
+                if (self < 0 || self >= size)
+                    continue;
+
+                f = node.cost + (build->origin[self] - build->origin[node.index]).GetLength();
+                if (f >= cost[self] || heapSize >= heapCapacity)
+                    continue;
+
+                cost[self] = f;
+                firstHop[self] = (node.index == src) ? self : firstHop[node.index];
+                HeapPush(heap, heapSize, f, self);
+            }
+        }
+
+        const size_t row = static_cast<size_t>(src) * static_cast<size_t>(size);
+        for (i = 0; i < size; i++)
+        {
+            if (cost[i] == FLT_MAX)
+                build->dist[row + i] = Const_MatrixUnreachable;
+            else
+                build->dist[row + i] = static_cast<uint16_t>(cclamp(static_cast<int>(cost[i] * Const_MatrixScale), 0, Const_MatrixUnreachable - 1));
+
+            build->nextHop[row + i] = firstHop[i];
+        }
+
+        build->rowsDone.fetch_add(1, std::memory_order_release);
+        if (deadline > 0.0 && GetRealTime() > deadline)
+            break;
+    }
+
+    safedel(heap);
+    safedel(cost);
+    safedel(firstHop);
+}
+
+static void MatrixBuildJob(void* data)
+{
+    BuildMatrixRows(static_cast<MatrixBuild*>(data), 0.0);
+}
+
+static void MatrixBuildFinish(void* data)
+{
+    ReleaseMatrixBuild(static_cast<MatrixBuild*>(data));
+}
+
+void Waypoint::DestroyPathMatrix(void)
+{
+    // workers still running on it stop at their next row, the last finish frees it
+    if (s_matrixBuild)
+    {
+        s_matrixBuild->cancel.store(true);
+        ReleaseMatrixBuild(s_matrixBuild);
+        s_matrixBuild = nullptr;
+    }
+
+    if (m_tableMapping)
+    {
+        UnmapFile(m_tableMapping, m_tableMappingSize, m_tableMappingHandle);
+        m_tableMapping = nullptr;
+        m_tableMappingHandle = nullptr;
+        m_tableMappingSize = 0;
+
+        // tables were pointing into the mapping
+        m_distMatrix = nullptr;
+        m_nextHop = nullptr;
+    }
+    else
+    {
+        safedel(m_distMatrix);
+        safedel(m_nextHop);
+    }
+
+    m_matrixSize = 0;
+}
+
+bool Waypoint::IsBuildingPathMatrix(void)
+{
+    return s_matrixBuild != nullptr;
+}
+
+// copies the graph and hands the rows to the job pool, UpdatePathMatrix picks up the result
+void Waypoint::StartPathMatrix(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    DestroyPathMatrix();
+    if (g_numWaypoints < 2 || g_numWaypoints > ebot_path_matrix_max_waypoints.GetInt())
+        return;
+
+    const int size = g_numWaypoints;
+    const size_t cells = static_cast<size_t>(size) * static_cast<size_t>(size);
+
+    // this can be huge, don't loop forever like safeloc does when we are out of memory
+    MatrixBuild* build = new(std::nothrow) MatrixBuild;
+    if (!build)
+    {
+        AddLogEntry(Log::Memory, "unable to allocate path matrix for %d waypoints", size);
+        return;
+    }
+
+    build->size = size;
+    build->refs = 1;
+    build->origin = new(std::nothrow) Vector[size];
+    build->links = new(std::nothrow) int16_t[size * Const_MaxPathIndex];
+    build->dist = new(std::nothrow) uint16_t[cells];
+    build->nextHop = new(std::nothrow) int16_t[cells];
+    if (!build->origin || !build->links || !build->dist || !build->nextHop)
+    {
+        ReleaseMatrixBuild(build);
+        AddLogEntry(Log::Memory, "unable to allocate path matrix for %d waypoints", size);
+        return;
+    }
+
+    int i, j;
+    for (i = 0; i < size; i++)
+    {
+        build->origin[i] = m_paths[i].origin;
+        for (j = 0; j < Const_MaxPathIndex; j++)
+            build->links[i * Const_MaxPathIndex + j] = m_paths[i].index[j];
+    }
+
+    s_matrixBuild = build;
+
+    // without workers UpdatePathMatrix does the rows itself within the frame budget
+    Job job;
+    job.run = MatrixBuildJob;
+    job.finish = MatrixBuildFinish;
+    job.data = build;
+
+    const int workers = g_jobPool.GetWorkerCount();
+    for (i = 0; i < workers; i++)
+    {
+        build->refs++;
+        g_jobPool.Submit(job);
+    }
+}
+
+// installs the matrix once every row is done and saves the tables
+void Waypoint::UpdatePathMatrix(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    MatrixBuild* build = s_matrixBuild;
+    if (!build)
+        return;
+
+    // waypoints are edited, the rows we have are useless now
+    if (g_waypointsChanged)
+    {
+        DestroyPathMatrix();
+        return;
+    }
+
+    if (!g_jobPool.GetWorkerCount())
+        BuildMatrixRows(build, GetRealTime() + static_cast<double>(cmaxf(ebot_path_matrix_build_ms.GetFloat() * g_frameGovernor.GetScale(), 0.1f)) * 0.001);
+
+    if (build->failed.load())
+    {
+        DestroyPathMatrix();
+        AddLogEntry(Log::Memory, "unable to allocate path matrix for %d waypoints", g_numWaypoints);
+        return;
+    }
+
+    if (build->rowsDone.load(std::memory_order_acquire) < build->size)
+        return;
+
+    m_distMatrix = build->dist;
+    m_nextHop = build->nextHop;
+    m_matrixSize = build->size;
+    build->dist = nullptr;
+    build->nextHop = nullptr;
+
+    ReleaseMatrixBuild(build);
+    s_matrixBuild = nullptr;
+    SaveTables();
+}
+
+const char* Waypoint::GetTableFile(void)
+{
+    static char tableFilePath[1024]{};
+    FormatBuffer(tableFilePath, "%s%s.ewt", GetWaypointDir(), GetMapName());
+    return &tableFilePath[0];
+}
+
+// maps the table file and points the tables into it, fails if it was made for another waypoint file
+bool Waypoint::LoadTables(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    DestroyPathMatrix();
+    if (g_numWaypoints < 2)
+        return false;
+
+    size_t size;
+    uint8_t* data = MapFile(GetTableFile(), size, m_tableMappingHandle);
+    if (!data)
+        return false;
+
+    m_tableMapping = data;
+    m_tableMappingSize = size;
+
+    if (size < sizeof(WaypointTableHeader))
+    {
+        DestroyPathMatrix();
+        return false;
+    }
+
+    const WaypointTableHeader* header = reinterpret_cast<const WaypointTableHeader*>(data);
+    if (cstrncmp(header->header, FH_WAYPOINT_TABLE, cstrlen(FH_WAYPOINT_TABLE)) != 0 || header->fileVersion != FV_WAYPOINT_TABLE || header->waypointHash != m_waypointHash || header->pointNumber != g_numWaypoints)
+    {
+        DestroyPathMatrix();
+        return false;
+    }
+
+    const size_t cells = static_cast<size_t>(g_numWaypoints) * static_cast<size_t>(g_numWaypoints);
+    size_t offset = sizeof(WaypointTableHeader);
+    int i;
+    for (i = 0; i < header->numTables; i++)
+    {
+        if (offset + sizeof(WaypointTableEntry) > size)
+            break;
+
+        const WaypointTableEntry* entry = reinterpret_cast<const WaypointTableEntry*>(data + offset);
+        offset += sizeof(WaypointTableEntry);
+        if (entry->size < 0 || offset + static_cast<size_t>(entry->size) > size)
+            break;
+
+        if (entry->type == WTABLE_DISTANCE && static_cast<size_t>(entry->size) == cells * sizeof(uint16_t))
+            m_distMatrix = reinterpret_cast<uint16_t*>(data + offset);
+        else if (entry->type == WTABLE_NEXTHOP && static_cast<size_t>(entry->size) == cells * sizeof(int16_t))
+            m_nextHop = reinterpret_cast<int16_t*>(data + offset);
+
+        offset += static_cast<size_t>(entry->size);
+    }
+
+    if (!m_distMatrix || !m_nextHop)
+    {
+        DestroyPathMatrix();
+        return false;
+    }
+
+    m_matrixSize = g_numWaypoints;
+    return true;
+}
+
+void Waypoint::SaveTables(void)
+{
+    if (!HasPathMatrix() || m_tableMapping)
+        return;
+
+    File fp(GetTableFile(), "wb");
+    if (!fp.IsValid())
+    {
+        AddLogEntry(Log::Error, "Error writing '%s' waypoint table file", GetMapName());
+        return;
+    }
+
+    WaypointTableHeader header;
+    cstrcpy(header.header, FH_WAYPOINT_TABLE);
+    header.fileVersion = FV_WAYPOINT_TABLE;
+    header.waypointHash = m_waypointHash;
+    header.pointNumber = m_matrixSize;
+    header.numTables = 2;
+    fp.Write(&header, sizeof(header));
+
+    const int32_t size = m_matrixSize * m_matrixSize * static_cast<int32_t>(sizeof(uint16_t));
+    WaypointTableEntry entry;
+
+    entry.type = WTABLE_DISTANCE;
+    entry.size = size;
+    fp.Write(&entry, sizeof(entry));
+    fp.Write(m_distMatrix, size);
+
+    entry.type = WTABLE_NEXTHOP;
+    entry.size = size;
+    fp.Write(&entry, sizeof(entry));
+    fp.Write(m_nextHop, size);
+
+    fp.Close();
+}
+
+// bit of a waypoint pair, a row only holds the waypoints after it since both ways see the same
+inline size_t GetVisibilityBit(const int size, int srcIndex, int destIndex)
+{
+    if (srcIndex > destIndex)
+        cswap(srcIndex, destIndex);
+
+    return static_cast<size_t>(srcIndex) * static_cast<size_t>(2 * size - srcIndex - 1) / 2 + static_cast<size_t>(destIndex - srcIndex - 1);
+}
+
+// eyes of a player standing or crouching on the waypoint, crouch waypoints are already at crouch height
+inline Vector GetVisibilityEye(const Path& path, const bool crouch)
+{
+    if (path.flags & WAYPOINT_CROUCH)
+        return path.origin + Vector(0.0f, 0.0f, 12.0f);
+
+    return path.origin + Vector(0.0f, 0.0f, crouch ? -6.0f : 17.0f);
+}
+
+bool Waypoint::HasVisibility(void)
+{
+    return m_visibility && m_visibilitySize == g_numWaypoints && m_visibilityRow >= m_visibilitySize && !g_waypointsChanged;
+}
+
+// true if the two waypoints can see each other, false as well while the table isn't built
+bool Waypoint::IsVisibleWaypoint(const int srcIndex, const int destIndex, const bool crouch)
+{
+    if (!HasVisibility() || !IsValidWaypoint(srcIndex) || !IsValidWaypoint(destIndex))
+        return false;
+
+    if (srcIndex == destIndex)
+        return true;
+
+    const size_t bit = GetVisibilityBit(m_visibilitySize, srcIndex, destIndex);
+    const uint8_t* table = crouch ? m_visibility + m_visibilityBytes : m_visibility;
+    return (table[bit >> 3] & (1 << (bit & 7))) != 0;
+}
+
+bool Waypoint::IsBuildingVisibility(void)
+{
+    return m_visibility && m_visibilityRow < m_visibilitySize;
+}
+
+void Waypoint::DestroyVisibility(void)
+{
+    safedel(m_visibility);
+    m_visibilityBytes = 0;
+    m_visibilitySize = 0;
+    m_visibilityRow = 0;
+    m_visibilityColumn = 0;
+}
+
+// allocates the table and resumes it from the visibility file, UpdateVisibility traces whatever is left
+void Waypoint::StartVisibility(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    DestroyVisibility();
+    if (g_numWaypoints < 2 || g_numWaypoints > ebot_visibility_max_waypoints.GetInt())
+        return;
+
+    const size_t pairs = static_cast<size_t>(g_numWaypoints) * static_cast<size_t>(g_numWaypoints - 1) / 2;
+    const size_t bytes = (pairs + 7) / 8;
+    m_visibility = new(std::nothrow) uint8_t[bytes * 2];
+    if (!m_visibility)
+    {
+        AddLogEntry(Log::Memory, "unable to allocate visibility table for %d waypoints", g_numWaypoints);
+        return;
+    }
+
+    cmemset(m_visibility, 0, bytes * 2);
+    m_visibilityBytes = bytes;
+    m_visibilitySize = g_numWaypoints;
+    m_visibilityRow = 0;
+    m_visibilityColumn = 1;
+    m_visibilitySaveTime = engine->GetTime() + 60.0f;
+    LoadVisibility();
+}
+
+// traces waypoint pairs within the frame budget, rows are done in order so a saved table can resume
+void Waypoint::UpdateVisibility(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    // waypoints are edited, the bits we have are useless now
+    if (g_waypointsChanged || m_visibilitySize != g_numWaypoints)
+    {
+        DestroyVisibility();
+        return;
+    }
+
+    const double deadline = GetRealTime() + static_cast<double>(cmaxf(ebot_visibility_build_ms.GetFloat() * g_frameGovernor.GetScale(), 0.1f)) * 0.001;
+    const int size = m_visibilitySize;
+    uint8_t* crouchTable = m_visibility + m_visibilityBytes;
+
+    TraceResult tr{};
+    Vector stand, crouch;
+    size_t rowBit, bit;
+    int traced = 0;
+    while (m_visibilityRow < size - 1)
+    {
+        stand = GetVisibilityEye(m_paths[m_visibilityRow], false);
+        crouch = GetVisibilityEye(m_paths[m_visibilityRow], true);
+        rowBit = GetVisibilityBit(size, m_visibilityRow, m_visibilityRow + 1);
+
+        for (; m_visibilityColumn < size; m_visibilityColumn++)
+        {
+            // the clock is only read every few pairs
+            if (!(++traced & 15) && GetRealTime() > deadline)
+                return;
+
+            bit = rowBit + static_cast<size_t>(m_visibilityColumn - m_visibilityRow - 1);
+            const Path& path = m_paths[m_visibilityColumn];
+
+            TraceLine(stand, GetVisibilityEye(path, false), true, true, g_worldEdict, &tr);
+            if (tr.flFraction >= 1.0f)
+                m_visibility[bit >> 3] |= static_cast<uint8_t>(1 << (bit & 7));
+
+            TraceLine(crouch, GetVisibilityEye(path, true), true, true, g_worldEdict, &tr);
+            if (tr.flFraction >= 1.0f)
+                crouchTable[bit >> 3] |= static_cast<uint8_t>(1 << (bit & 7));
+        }
+
+        m_visibilityRow++;
+        m_visibilityColumn = m_visibilityRow + 1;
+
+        // big maps take a while, don't lose everything on a map change
+        if (m_visibilitySaveTime < engine->GetTime())
+        {
+            SaveVisibility();
+            m_visibilitySaveTime = engine->GetTime() + 60.0f;
+        }
+    }
+
+    m_visibilityRow = size;
+    SaveVisibility();
+}
+
+const char* Waypoint::GetVisibilityFile(void)
+{
+    static char visibilityFilePath[1024]{};
+    FormatBuffer(visibilityFilePath, "%s%s.ewv", GetWaypointDir(), GetMapName());
+    return &visibilityFilePath[0];
+}
+
+// reads the finished rows of the visibility file into the table, fails if it was made for another waypoint file
+bool Waypoint::LoadVisibility(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    File fp(GetVisibilityFile(), "rb");
+    if (!fp.IsValid())
+        return false;
+
+    WaypointTableHeader header;
+    if (fp.Read(&header, sizeof(header)) != 1 || cstrncmp(header.header, FH_WAYPOINT_VISIBILITY, cstrlen(FH_WAYPOINT_VISIBILITY)) != 0 ||
+        header.fileVersion != FV_WAYPOINT_VISIBILITY || header.waypointHash != m_waypointHash || header.pointNumber != m_visibilitySize)
+    {
+        fp.Close();
+        return false;
+    }
+
+    const int bytes = static_cast<int>(m_visibilityBytes);
+    int32_t rows = -1;
+    bool stand = false, crouch = false;
+
+    int i;
+    WaypointTableEntry entry;
+    for (i = 0; i < header.numTables; i++)
+    {
+        if (fp.Read(&entry, sizeof(entry)) != 1)
+            break;
+
+        if (entry.type == WTABLE_VISIBILITY_ROWS && entry.size == static_cast<int32_t>(sizeof(rows)))
+        {
+            if (fp.Read(&rows, sizeof(rows)) != 1)
+                break;
+        }
+        else if (entry.type == WTABLE_VISIBILITY_STAND && entry.size == bytes)
+            stand = fp.Read(m_visibility, bytes) == 1;
+        else if (entry.type == WTABLE_VISIBILITY_CROUCH && entry.size == bytes)
+            crouch = fp.Read(m_visibility + bytes, bytes) == 1;
+        else if (entry.size < 0 || !fp.Seek(entry.size, SEEK_CUR))
+            break;
+    }
+
+    fp.Close();
+    if (!stand || !crouch || rows < 0 || rows > m_visibilitySize)
+    {
+        cmemset(m_visibility, 0, m_visibilityBytes * 2);
+        return false;
+    }
+
+    m_visibilityRow = rows;
+    m_visibilityColumn = rows + 1;
+    return true;
+}
+
+void Waypoint::SaveVisibility(void)
+{
+    if (!m_visibility || !m_visibilityRow || g_waypointsChanged)
+        return;
+
+    // written aside first, a crash while saving keeps the previous file
+    char partFile[1024];
+    FormatBuffer(partFile, "%s.part", GetVisibilityFile());
+
+    File fp(partFile, "wb");
+    if (!fp.IsValid())
+    {
+        AddLogEntry(Log::Error, "Error writing '%s' waypoint visibility file", GetMapName());
+        return;
+    }
+
+    WaypointTableHeader header;
+    cstrcpy(header.header, FH_WAYPOINT_VISIBILITY);
+    header.fileVersion = FV_WAYPOINT_VISIBILITY;
+    header.waypointHash = m_waypointHash;
+    header.pointNumber = m_visibilitySize;
+    header.numTables = 3;
+    fp.Write(&header, sizeof(header));
+
+    int32_t rows = m_visibilityRow;
+    WaypointTableEntry entry;
+
+    entry.type = WTABLE_VISIBILITY_ROWS;
+    entry.size = sizeof(rows);
+    fp.Write(&entry, sizeof(entry));
+    fp.Write(&rows, sizeof(rows));
+
+    entry.type = WTABLE_VISIBILITY_STAND;
+    entry.size = static_cast<int32_t>(m_visibilityBytes);
+    fp.Write(&entry, sizeof(entry));
+    fp.Write(m_visibility, entry.size);
+
+    entry.type = WTABLE_VISIBILITY_CROUCH;
+    fp.Write(&entry, sizeof(entry));
+    fp.Write(m_visibility + m_visibilityBytes, entry.size);
+
+    fp.Close();
+
+#ifdef PLATFORM_WIN32
+    unlink(GetVisibilityFile());
+#endif
+    rename(partFile, GetVisibilityFile());
+}
+
+struct ClusterEdge
+{
+    int16_t from;
+    int16_t to;
+    float cost;
+};
+
+// abstract search scratch, stamped so a search doesn't have to clear it
+static MatrixHeapNode* s_clusterHeap;
+static float* s_clusterCost;
+static int16_t* s_clusterParent;
+static uint32_t* s_clusterStamp;
+static int16_t* s_clusterPath;
+static uint32_t s_clusterGeneration;
+static int s_clusterHeapCapacity;
+
+static void FreeClusterScratch(void)
+{
+    safedel(s_clusterHeap);
+    safedel(s_clusterCost);
+    safedel(s_clusterParent);
+    safedel(s_clusterStamp);
+    safedel(s_clusterPath);
+    s_clusterGeneration = 0;
+    s_clusterHeapCapacity = 0;
+}
+
+// starts a search over the scratch buffers, returns false if they are missing
+static bool BeginClusterSearch(const int size)
+{
+    if (!s_clusterStamp)
+        return false;
+
+    if (++s_clusterGeneration == 0)
+    {
+        cmemset(s_clusterStamp, 0, sizeof(uint32_t) * size);
+        s_clusterGeneration = 1;
+    }
+
+    return true;
+}
+
+inline float& GetClusterCost(const int16_t index)
+{
+    if (s_clusterStamp[index] != s_clusterGeneration)
+    {
+        s_clusterStamp[index] = s_clusterGeneration;
+        s_clusterCost[index] = FLT_MAX;
+        s_clusterParent[index] = -1;
+    }
+
+    return s_clusterCost[index];
+}
+
+void Waypoint::DestroyClusters(void)
+{
+    FreeClusterScratch();
+    safedel(m_clusterId);
+    safedel(m_clusterEdgeStart);
+    safedel(m_clusterEdgeTarget);
+    safedel(m_clusterEdgeCost);
+    m_numClusters = 0;
+    m_clusterWaypoints = 0;
+    m_clusterVersion = 0;
+}
+
+int Waypoint::GetClusterId(const int index)
+{
+    if (!m_clusterId || m_clusterWaypoints != g_numWaypoints || m_clusterVersion != GetHotData().version || !IsValidWaypoint(index))
+        return -1;
+
+    return m_clusterId[index];
+}
+
+// splits waypoints into connected groups inside grid cells, then links the cluster entrances
+void Waypoint::BuildClusters(void)
+{
+    MEMORY_TAG(Mem_Tables);
+
+    DestroyClusters();
 
-    // draw a paths, camplines and danger directions for nearest waypoint
-    if (nearestDistance < squaredf(2048) && m_pathDisplayTime < engine->GetTime())
-    {
-        m_pathDisplayTime = engine->GetTime() + 1.0f;
+    const int size = g_numWaypoints;
+    if (size < 2)
+        return;
 
-        // draw the connections
-        int i;
-        for (i = 0; i < Const_MaxPathIndex; i++)
-        {
-            if (path->index[i] == -1)
-                continue;
+    const float cellSize = cmaxf(ebot_cluster_size.GetFloat(), 128.0f);
+    safeloc(m_clusterId, size);
 
-            // jump connection
-            if (path->connectionFlags[i] & PATHFLAG_JUMP)
-                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(255, 0, 0, 255), 5, 0, 0, 10);
-            else if (path->connectionFlags[i] & PATHFLAG_DOUBLE) // boosting friend connection
-                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(0, 0, 255, 255), 5, 0, 0, 10);
-            else if (IsConnected(path->index[i], nearestIndex)) // twoway connection
-                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(255, 255, 0, 255), 5, 0, 0, 10);
-            else // oneway connection
-                engine->DrawLine(g_hostEntity, path->origin, m_paths[path->index[i]].origin, Color(250, 250, 250, 255), 5, 0, 0, 10);
-        }
+    int i, j, head, tail, heapSize;
+    int16_t self, current;
+    for (i = 0; i < size; i++)
+        m_clusterId[i] = -1;
 
-        // now look for oneway incoming connections
-        for (i = 0; i < g_numWaypoints; i++)
-        {
-            if (IsConnected(i, nearestIndex) && !IsConnected(nearestIndex, i))
-                engine->DrawLine(g_hostEntity, path->origin, m_paths[i].origin, Color(0, 192, 96, 255), 5, 0, 0, 10);
-        }
+    // flood fill each cell, waypoints that can't reach each other get their own cluster
+    int16_t* queue = safeloc<int16_t>(size);
+    for (i = 0; i < size; i++)
+    {
+        if (m_clusterId[i] != -1)
+            continue;
 
-        // draw the radius circle
-        const Vector origin = (path->flags & WAYPOINT_CROUCH) ? path->origin : path->origin - Vector(00.0f, 00.0f, 18.0f);
+        const int cellX = static_cast<int>(floorf(m_paths[i].origin.x / cellSize));
+        const int cellY = static_cast<int>(floorf(m_paths[i].origin.y / cellSize));
 
-        // if radius is nonzero, draw a square
-        if (path->radius > 4)
+        m_clusterId[i] = static_cast<int16_t>(m_numClusters);
+        queue[0] = static_cast<int16_t>(i);
+        head = 0;
+        tail = 1;
+        while (head < tail)
         {
-            const float root = static_cast<float>(path->radius);
-            const Color& def = Color(0, 0, 255, 255);
+            current = queue[head++];
+            for (j = 0; j < Const_MaxPathIndex; j++)
+            {
+                self = m_paths[current].index[j];
+                if (!IsValidWaypoint(self) || m_clusterId[self] != -1)
+                    continue;
 
-            engine->DrawLine(g_hostEntity, origin + Vector(root, root, 0.0f), origin + Vector(-root, root, 0.0f), def, 5, 0, 0, 10);
-            engine->DrawLine(g_hostEntity, origin + Vector(root, root, 0.0f), origin + Vector(root, -root, 0.0f), def, 5, 0, 0, 10);
-            engine->DrawLine(g_hostEntity, origin + Vector(-root, -root, 0.0f), origin + Vector(root, -root, 0.0f), def, 5, 0, 0, 10);
-            engine->DrawLine(g_hostEntity, origin + Vector(-root, -root, 0.0f), origin + Vector(-root, root, 0.0f), def, 5, 0, 0, 10);
-        }
-        else
-        {
-            const float root = 5.0f;
-            const Color& def = Color(0, 0, 255, 255);
+                if (static_cast<int>(floorf(m_paths[self].origin.x / cellSize)) != cellX || static_cast<int>(floorf(m_paths[self].origin.y / cellSize)) != cellY)
+                    continue;
 
-            engine->DrawLine(g_hostEntity, origin + Vector(root, -root, 0.0f), origin + Vector(-root, root, 0.0f), def, 5, 0, 0, 10);
-            engine->DrawLine(g_hostEntity, origin + Vector(-root, -root, 0.0f), origin + Vector(root, root, 0.0f), def, 5, 0, 0, 10);
+                m_clusterId[self] = static_cast<int16_t>(m_numClusters);
+                queue[tail++] = self;
+            }
         }
 
-        // display some information
-        char tempMessage[4096];
-        int length;
+        m_numClusters++;
+    }
 
-        // show the information about that point
-        if (path->flags & WAYPOINT_SPECIFICGRAVITY)
-        {
-            length = sprintf(tempMessage, "\n\n\n\n\n\n\n    Waypoint Information:\n\n"
-                "      Waypoint %d of %d, Radius: %d\n"
-                "      Flags: %s\n\n      %s %f\n      Waypoint Gravity: %f", nearestIndex, g_numWaypoints, path->radius, GetWaypointInfo(nearestIndex), "Your Gravity:", (g_hostEntity->v.gravity * 800.0f), path->gravity);
-        }
-        else if (path->flags & WAYPOINT_ZMHMCAMP || path->flags & WAYPOINT_HMCAMPMESH)
-        {
-            length = sprintf(tempMessage, "\n\n\n\n\n\n\n    Waypoint Information:\n\n"
-                "      Waypoint %d of %d, Radius: %d\n"
-                "      Flags: %s\n\n      %s %d\n", nearestIndex, g_numWaypoints, path->radius, GetWaypointInfo(nearestIndex), "Human Camp Mesh ID:", static_cast<int> (path->mesh));
-        }
-        else
-        {
-            length = sprintf(tempMessage, "\n\n\n\n\n\n\n    Waypoint Information:\n\n"
-                "      Waypoint %d of %d, Radius: %d\n"
-                "      Flags: %s\n\n", nearestIndex, g_numWaypoints, path->radius, GetWaypointInfo(nearestIndex));
-        }
+    safedel(queue);
 
-        // check if we need to show the cached point index
-        if (m_cacheWaypointIndex != -1)
+    // connections between clusters make both ends entrances
+    Array <ClusterEdge> edges;
+    bool* entrance = safeloc<bool>(size);
+    ClusterEdge edge;
+    for (i = 0; i < size; i++)
+    {
+        for (j = 0; j < Const_MaxPathIndex; j++)
         {
-            length += sprintf(&tempMessage[length], "\n    Cached Waypoint Information:\n\n"
-                "      Waypoint %d of %d, Radius: %d\n"
-                "      Flags: %s\n", m_cacheWaypointIndex, g_numWaypoints, m_paths[m_cacheWaypointIndex].radius, GetWaypointInfo(m_cacheWaypointIndex), (!(m_paths[m_cacheWaypointIndex].flags & WAYPOINT_HMCAMPMESH) && !(m_paths[m_cacheWaypointIndex].flags & WAYPOINT_ZMHMCAMP)) ? "" : "Mesh ID: %d", static_cast<int>(m_paths[m_cacheWaypointIndex].mesh));
-        }
+            self = m_paths[i].index[j];
+            if (!IsValidWaypoint(self) || m_clusterId[self] == m_clusterId[i])
+                continue;
 
-        // check if we need to show the facing point index, only if no menu to show
-        if (m_facingAtIndex != -1 && !g_clients[ENTINDEX(g_hostEntity) - 1].menu)
-        {
-            length += sprintf(&tempMessage[length], "\n    Facing Waypoint Information:\n\n"
-                "      Waypoint %d of %d, Radius: %d\n"
-                "      Flags: %s\n", m_facingAtIndex, g_numWaypoints, m_paths[m_facingAtIndex].radius, GetWaypointInfo(m_facingAtIndex));
-        }
+            entrance[i] = true;
+            entrance[self] = true;
 
-        // draw entire message
-        MESSAGE_BEGIN(MSG_ONE_UNRELIABLE, SVC_TEMPENTITY, nullptr, g_hostEntity);
-        WRITE_BYTE(TE_TEXTMESSAGE);
-        WRITE_BYTE(4); // channel
-        WRITE_SHORT(FixedSigned16(0, 1 << 13)); // x
-        WRITE_SHORT(FixedSigned16(0, 1 << 13)); // y
-        WRITE_BYTE(0); // effect
-        WRITE_BYTE(255); // r1
-        WRITE_BYTE(255); // g1
-        WRITE_BYTE(255); // b1
-        WRITE_BYTE(1); // a1
-        WRITE_BYTE(255); // r2
-        WRITE_BYTE(255); // g2
-        WRITE_BYTE(255); // b2
-        WRITE_BYTE(255); // a2
-        WRITE_SHORT(0); // fadeintime
-        WRITE_SHORT(0); // fadeouttime
-        WRITE_SHORT(FixedUnsigned16(1.1f, 1 << 8)); // holdtime
-        WRITE_STRING(tempMessage);
-        MESSAGE_END();
+            edge.from = static_cast<int16_t>(i);
+            edge.to = self;
+            edge.cost = (m_paths[self].origin - m_paths[i].origin).GetLength();
+            edges.Push(edge);
+        }
     }
-    else if (m_pathDisplayTime + 2.0f > engine->GetTime()) // what???
-        m_pathDisplayTime = 0.0f;
-}
 
-bool Waypoint::IsConnected(const int index)
-{
-    int i;
-    int j;
-    for (i = 0; i < g_numWaypoints; i++)
+    s_clusterHeapCapacity = size * Const_MaxPathIndex + 1;
+    safeloc(s_clusterHeap, s_clusterHeapCapacity);
+    safeloc(s_clusterCost, size);
+    safeloc(s_clusterParent, size);
+    safeloc(s_clusterStamp, size);
+    safeloc(s_clusterPath, size);
+
+    // travel cost between the entrances of the same cluster
+    MatrixHeapNode node;
+    float f;
+    for (i = 0; i < size; i++)
     {
-        if (i != index)
+        if (!entrance[i] || !BeginClusterSearch(size))
+            continue;
+
+        GetClusterCost(static_cast<int16_t>(i)) = 0.0f;
+        heapSize = 0;
+        HeapPush(s_clusterHeap, heapSize, 0.0f, static_cast<int16_t>(i));
+        while (heapSize)
         {
+            node = HeapPop(s_clusterHeap, heapSize);
+            if (node.cost > GetClusterCost(node.index))
+                continue;
+
+            if (node.index != i && entrance[node.index])
+            {
+                edge.from = static_cast<int16_t>(i);
+                edge.to = node.index;
+                edge.cost = node.cost;
+                edges.Push(edge);
+            }
+
             for (j = 0; j < Const_MaxPathIndex; j++)
             {
-                if (m_paths[i].index[j] == index)
-                    return true;
+                self = m_paths[node.index].index[j];
+                if (!IsValidWaypoint(self) || m_clusterId[self] != m_clusterId[i])
+                    continue;
+
+                f = node.cost + (m_paths[self].origin - m_paths[node.index].origin).GetLength();
+                if (f >= GetClusterCost(self) || heapSize >= s_clusterHeapCapacity)
+                    continue;
+
+                GetClusterCost(self) = f;
+                HeapPush(s_clusterHeap, heapSize, f, self);
             }
         }
     }
 
-    return false;
-}
+    safedel(entrance);
 
-bool Waypoint::NodesValid(void)
-{
-    int terrPoints = 0;
-    int ctPoints = 0;
-    int goalPoints = 0;
-    int rescuePoints = 0;
-    int connections;
-    int i, j, k;
+    // pack the abstract graph by source waypoint
+    const int numEdges = edges.GetElementNumber();
+    safeloc(m_clusterEdgeStart, size + 1);
+    safeloc(m_clusterEdgeTarget, cmax(numEdges, 1));
+    safeloc(m_clusterEdgeCost, cmax(numEdges, 1));
 
-    bool haveError = false;
+    for (i = 0; i < numEdges; i++)
+        m_clusterEdgeStart[edges[i].from + 1]++;
 
-    for (i = 0; i < g_numWaypoints; i++)
+    for (i = 0; i < size; i++)
+        m_clusterEdgeStart[i + 1] += m_clusterEdgeStart[i];
+
+    int* fill = safeloc<int>(size);
+    for (i = 0; i < numEdges; i++)
     {
-        connections = 0;
+        j = m_clusterEdgeStart[edges[i].from] + fill[edges[i].from]++;
+        m_clusterEdgeTarget[j] = edges[i].to;
+        m_clusterEdgeCost[j] = edges[i].cost;
+    }
 
-        for (j = 0; j < Const_MaxPathIndex; j++)
-        {
-            if (m_paths[i].index[j] != -1)
-            {
-                if (m_paths[i].index[j] > g_numWaypoints)
-                {
-                    AddLogEntry(Log::Warning, "Waypoint %d connected with invalid Waypoint #%d!", i, m_paths[i].index[j]);
-                    (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
-                    haveError = true;
-                }
+    safedel(fill);
+    m_clusterWaypoints = size;
+    m_clusterVersion = GetHotData().version;
+}
 
-                connections++;
-                break;
-            }
-        }
+// plans over the cluster graph and returns the waypoint where the detailed search should stop for now
+int Waypoint::GetClusterWaypoint(const int srcIndex, const int destIndex)
+{
+    // edited since the clusters were built, plan over the plain waypoints until they are rebuilt
+    if (!m_clusterEdgeStart || m_clusterWaypoints != g_numWaypoints || m_clusterVersion != GetHotData().version || g_waypointsChanged || g_numWaypoints < ebot_hpa_min_waypoints.GetInt())
+        return destIndex;
+
+    if (!IsValidWaypoint(srcIndex) || !IsValidWaypoint(destIndex))
+        return destIndex;
+
+    const int16_t srcCluster = m_clusterId[srcIndex];
+    const int16_t destCluster = m_clusterId[destIndex];
+    if (srcCluster == destCluster || !BeginClusterSearch(g_numWaypoints))
+        return destIndex;
+
+    const Vector& goal = m_paths[destIndex].origin;
+    int heapSize = 0, j;
+    int16_t self, found = -1;
+    float f;
+    MatrixHeapNode node;
+
+    GetClusterCost(static_cast<int16_t>(srcIndex)) = 0.0f;
+    HeapPush(s_clusterHeap, heapSize, (m_paths[srcIndex].origin - goal).GetLength(), static_cast<int16_t>(srcIndex));
+    while (heapSize)
+    {
+        node = HeapPop(s_clusterHeap, heapSize);
 
-        if (!connections)
+        // reached the goal cluster, the detailed search handles the rest
+        if (m_clusterId[node.index] == destCluster)
         {
-            if (!IsConnected(i))
-            {
-                AddLogEntry(Log::Warning, "Waypoint %d isn't connected with any other Waypoint!", i);
-                (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
-                haveError = true;
-            }
+            found = node.index;
+            break;
         }
 
-        if (GetGameMode() == GameMode::Original)
-        {
-            if (m_paths[i].flags & WAYPOINT_TERRORIST)
-                terrPoints++;
-            else if (m_paths[i].flags & WAYPOINT_COUNTER)
-                ctPoints++;
-            else if (m_paths[i].flags & WAYPOINT_GOAL)
-                goalPoints++;
-            else if (m_paths[i].flags & WAYPOINT_RESCUE)
-                rescuePoints++;
-        }
+        const float cost = GetClusterCost(node.index);
 
-        for (k = 0; k < Const_MaxPathIndex; k++)
+        // walk normally inside the start cluster until we find its entrances
+        if (m_clusterId[node.index] == srcCluster)
         {
-            if (m_paths[i].index[k] != -1)
+            for (j = 0; j < Const_MaxPathIndex; j++)
             {
-                if (m_paths[i].index[k] >= g_numWaypoints || m_paths[i].index[k] < -1)
-                {
-                    AddLogEntry(Log::Warning, "Waypoint %d - Pathindex %d out of Range!", i, k);
-                    (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
+                self = m_paths[node.index].index[j];
+                if (!IsValidWaypoint(self) || m_clusterId[self] != srcCluster)
+                    continue;
 
-                    g_waypointOn = true;
-                    g_editNoclip = true;
+                f = cost + (m_paths[self].origin - m_paths[node.index].origin).GetLength();
+                if (f >= GetClusterCost(self) || heapSize >= s_clusterHeapCapacity)
+                    continue;
 
-                    haveError = true;
-                }
-                else if (m_paths[i].index[k] == i)
-                {
-                    AddLogEntry(Log::Warning, "Waypoint %d - Pathindex %d points to itself!", i, k);
-                    (*g_engfuncs.pfnSetOrigin) (g_hostEntity, m_paths[i].origin);
+                GetClusterCost(self) = f;
+                s_clusterParent[self] = node.index;
+                HeapPush(s_clusterHeap, heapSize, f + (m_paths[self].origin - goal).GetLength(), self);
+            }
+        }
 
-                    g_waypointOn = true;
-                    g_editNoclip = true;
+        for (j = m_clusterEdgeStart[node.index]; j < m_clusterEdgeStart[node.index + 1]; j++)
+        {
+            self = m_clusterEdgeTarget[j];
+            f = cost + m_clusterEdgeCost[j];
+            if (f >= GetClusterCost(self) || heapSize >= s_clusterHeapCapacity)
+                continue;
 
-                    haveError = true;
-                }
-            }
+            GetClusterCost(self) = f;
+            s_clusterParent[self] = node.index;
+            HeapPush(s_clusterHeap, heapSize, f + (m_paths[self].origin - goal).GetLength(), self);
         }
     }
 
-    if (g_mapType == MAP_CS && GetGameMode() == GameMode::Original)
+    if (found == -1)
+        return destIndex;
+
+    int length = 0;
+    for (self = found; self != -1 && length < g_numWaypoints; self = s_clusterParent[self])
+        s_clusterPath[length++] = self;
+
+    // only refine the first few clusters, the rest is planned again when we get there
+    const int maxClusters = cmax(ebot_hpa_refine_clusters.GetInt(), 1);
+    int clusters = 1, target = srcIndex;
+    int16_t lastCluster = srcCluster;
+    for (j = length - 1; j >= 0; j--)
     {
-        if (!rescuePoints)
+        self = s_clusterPath[j];
+        if (m_clusterId[self] != lastCluster)
         {
-            AddLogEntry(Log::Warning, "You didn't set a Rescue Point!");
-            haveError = true;
+            lastCluster = m_clusterId[self];
+            if (++clusters > maxClusters)
+                break;
         }
-    }
 
-    if (!terrPoints && GetGameMode() == GameMode::Original)
-    {
-        AddLogEntry(Log::Warning, "You didn't set any Terrorist Important Point!");
-        haveError = true;
-    }
-    else if (!ctPoints && GetGameMode() == GameMode::Original)
-    {
-        AddLogEntry(Log::Warning, "You didn't set any CT Important Point!");
-        haveError = true;
-    }
-    else if (!goalPoints && GetGameMode() == GameMode::Original)
-    {
-        AddLogEntry(Log::Warning, "You didn't set any Goal Point!");
-        haveError = true;
+        target = self;
     }
 
-    CenterPrint("Waypoints are saved!");
-    return haveError ? false : true;
-}
+    if (lastCluster == destCluster && clusters <= maxClusters)
+        return destIndex;
 
-float Waypoint::GetPathDistance(const int srcIndex, const int destIndex)
-{
-    if (srcIndex == -1 || destIndex == -1)
-        return FLT_MAX;
+    if (target == srcIndex)
+        return destIndex;
 
-    return (m_paths[srcIndex].origin - m_paths[destIndex].origin).GetLengthSquared();
+    return target;
 }
 
 // this function creates basic waypoint types on map - raeyid was here :)
@@ -2817,6 +5209,7 @@ void Waypoint::SetFindIndex(const int index)
 
 Waypoint::Waypoint(void)
 {
+    BuildGrid();
     m_endJumpPoint = false;
     m_learnJumpWaypoint = false;
     m_timeJumpStarted = 0.0f;
@@ -2845,6 +5238,13 @@ Waypoint::Waypoint(void)
 
 Waypoint::~Waypoint(void)
 {
+    StopDownload();
+    DestroyPathMatrix();
+    DestroyVisibility();
+    DestroyClusters();
+    DestroyHotData();
+    DestroyThreatField();
+    ResetGroundChecks();
     m_pathDisplayTime = 0.0f;
     m_arrowDisplayTime = 0.0f;
 
@@ -2854,4 +5254,38 @@ Waypoint::~Waypoint(void)
     m_campPoints.Destroy();
     m_rescuePoints.Destroy();
     safedel(m_waypointDisplayTime);
+}
+
+// bytes held for the waypoints and for the tables derived from them, mapped tables are reported apart
+void Waypoint::GetMemoryUsage(size_t& waypoints, size_t& tables, size_t& mapped)
+{
+    waypoints = static_cast<size_t>(m_paths.Capacity()) * sizeof(Path);
+    waypoints += static_cast<size_t>(m_terrorPoints.Capacity() + m_ctPoints.Capacity() + m_goalPoints.Capacity() + m_campPoints.Capacity() + m_rescuePoints.Capacity() + m_zmHmPoints.Capacity() + m_hmMeshPoints.Capacity()) * sizeof(int16_t);
+    waypoints += m_hot.blockSize;
+    waypoints += static_cast<size_t>(m_groundCheckSize) * sizeof(WaypointGroundCheck);
+    waypoints += static_cast<size_t>(m_threats.size) * Team::Spectator * (sizeof(uint8_t) + sizeof(float)) + static_cast<size_t>((m_threats.size + 31) / 32) * Team::Spectator * sizeof(uint32_t) * 2;
+    if (m_waypointDisplayTime)
+        waypoints += static_cast<size_t>(g_numWaypoints) * sizeof(float);
+
+    const size_t cells = static_cast<size_t>(m_matrixSize) * static_cast<size_t>(m_matrixSize);
+    mapped = m_tableMapping ? m_tableMappingSize : 0;
+    tables = m_tableMapping ? 0 : cells * (sizeof(uint16_t) + sizeof(int16_t));
+
+    // a matrix being built holds its own copy of the links and the finished rows
+    if (s_matrixBuild)
+    {
+        const size_t size = static_cast<size_t>(s_matrixBuild->size);
+        tables += size * (sizeof(Vector) + Const_MaxPathIndex * sizeof(int16_t));
+        if (s_matrixBuild->dist)
+            tables += size * size * (sizeof(uint16_t) + sizeof(int16_t));
+    }
+
+    if (m_visibility)
+        tables += m_visibilityBytes * 2;
+
+    if (m_clusterId && m_clusterEdgeStart)
+    {
+        tables += static_cast<size_t>(m_clusterWaypoints) * sizeof(int16_t) + static_cast<size_t>(m_clusterWaypoints + 1) * sizeof(int);
+        tables += static_cast<size_t>(m_clusterEdgeStart[m_clusterWaypoints]) * (sizeof(int16_t) + sizeof(float));
+    }
 }
\ No newline at end of file